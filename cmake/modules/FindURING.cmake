@@ -0,0 +1,37 @@
+# Find the URING includes and library.
+# 
+# This module defines
+# URING_INCLUDE_DIR, where to locate liburing.h
+# URING_LIBRARIES, the libraries to link against to use URING
+# URING_FOUND.  If false, you cannot build anything that requires URING.
+
+if(URING_INCLUDE_DIR)
+  set(URING_FIND_QUIETLY 1)
+endif()
+set(URING_FOUND 0)
+
+find_path(URING_INCLUDE_DIR liburing.h
+  $ENV{URING_DIR}/include
+  /usr/local/include
+  /opt/liburing/include
+  DOC "Specify the directory containing liburing.h"
+)
+
+find_library(URING_LIBRARY NAMES uring PATHS
+  $ENV{URING_DIR}/lib
+  /usr/local/lib
+  /usr/lib
+  /opt/liburing/lib
+  DOC "Specify the liburing library here."
+)
+
+if(URING_INCLUDE_DIR AND URING_LIBRARY)
+  set(URING_FOUND 1 )
+  if(NOT URING_FIND_QUIETLY)
+     message(STATUS "Found URING includes at ${URING_INCLUDE_DIR}")
+     message(STATUS "Found URING library at ${URING_LIBRARY}")
+  endif()
+endif()
+
+set(URING_LIBRARIES ${URING_LIBRARY})
+mark_as_advanced(URING_FOUND URING_LIBRARY URING_INCLUDE_DIR)
@@ -338,6 +338,9 @@ set(haspthread ${has${CMAKE_USE_PTHREADS_INIT}})
 set(hasxft ${has${xft}})
 set(hascling ${has${cling}})
 set(haslzmacompression ${has${lzma}})
+set(haslz4 ${has${lz4}})
+set(haszstd ${has${zstd}})
+set(hasuring ${has${uring}})
 set(hascocoa ${has${cocoa}})
 set(hasvc ${has${vc}})
 set(usec++11 ${has${cxx11}})
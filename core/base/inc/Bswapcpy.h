@@ -32,6 +32,15 @@
 //                                                                      //
 // For arrays of short type (2 bytes in size) use bswapcpy16().         //
 // For arrays of of 4-byte types (int, float) use bswapcpy32().         //
+// For arrays of of 8-byte types (long long, double) use bswapcpy64().  //
+//                                                                      //
+// On x86_64 the routines swap 16 (SSE2) or 32 (AVX2) bytes per         //
+// instruction. The AVX2 kernels are only used when the cpu supports    //
+// them, which is checked once at run time, so the library does not     //
+// need to be compiled with -mavx2. In that case R__BSWAPCPY_SIMD is    //
+// defined and the per instruction set kernels (bswapcpy32_sse2(),      //
+// bswapcpy32_avx2(), ...) can be called directly, e.g. to benchmark    //
+// them against each other.                                             //
 //                                                                      //
 //                                                                      //
 // Author: Alexandre V. Vaniachine <AVVaniachine@lbl.gov>               //
@@ -42,6 +51,8 @@
 #include <sys/types.h>
 #endif
 
+#if defined(__i386__)
+
 extern inline void * bswapcpy16(void * to, const void * from, size_t n)
 {
 int d0, d1, d2, d3;
@@ -78,4 +89,212 @@ __asm__ __volatile__(
         :"memory");
 return (to);
 }
+
+extern inline void * bswapcpy64(void * to, const void * from, size_t n)
+{
+int d0, d1, d2, d3, d4;
+__asm__ __volatile__(
+        "cld\n"
+        "1:\tlodsl\n\t"
+        "movl %%eax, %%edx\n\t"
+        "lodsl\n\t"
+#if !defined __i486__ && !defined __pentium__ && !defined __pentiumpro__ && \
+    !defined __pentium4__ && !defined __x86_64__
+        "rorw $8, %%ax\n\t"
+        "rorl $16, %%eax\n\t"
+        "rorw $8, %%ax\n\t"
+        "stosl\n\t"
+        "movl %%edx, %%eax\n\t"
+        "rorw $8, %%ax\n\t"
+        "rorl $16, %%eax\n\t"
+        "rorw $8, %%ax\n\t"
+#else
+        "bswap %%eax\n\t"
+        "stosl\n\t"
+        "movl %%edx, %%eax\n\t"
+        "bswap %%eax\n\t"
+#endif
+        "stosl\n\t"
+        "loop 1b\n\t"
+        :"=&c" (d0), "=&D" (d1), "=&S" (d2), "=&a" (d3), "=&d" (d4)
+        :"0" (n), "1" ((long) to),"2" ((long) from)
+        :"memory");
+return (to);
+}
+
+#elif defined(__x86_64__) && defined(__GNUC__) && !defined(__CINT__) && \
+      !defined(__INTEL_COMPILER) && \
+      ((defined(__clang__) && defined(__apple_build_version__) && \
+        __clang_major__ >= 8) || \
+       (defined(__clang__) && !defined(__apple_build_version__) && \
+        (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+       (!defined(__clang__) && \
+        (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+
+#define R__BSWAPCPY_SIMD
+
+#include <string.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// Scalar kernels, used for the elements left over by the vector loops.
+
+static inline void bswapcpy16_scalar(char *to, const char *from, size_t n)
+{
+   unsigned short x;
+   for (size_t i = 0; i < n; ++i, to += 2, from += 2) {
+      memcpy(&x, from, 2);
+      x = (unsigned short)((x << 8) | (x >> 8));
+      memcpy(to, &x, 2);
+   }
+}
+
+static inline void bswapcpy32_scalar(char *to, const char *from, size_t n)
+{
+   unsigned int x;
+   for (size_t i = 0; i < n; ++i, to += 4, from += 4) {
+      memcpy(&x, from, 4);
+      x = __builtin_bswap32(x);
+      memcpy(to, &x, 4);
+   }
+}
+
+static inline void bswapcpy64_scalar(char *to, const char *from, size_t n)
+{
+   unsigned long long x;
+   for (size_t i = 0; i < n; ++i, to += 8, from += 8) {
+      memcpy(&x, from, 8);
+      x = __builtin_bswap64(x);
+      memcpy(to, &x, 8);
+   }
+}
+
+// SSE2 has no byte shuffle: swap the 16-bit words with pshuflw/pshufhw
+// (and the 32-bit words with pshufd) then the bytes within each word
+// with shifts. SSE2 is part of the x86_64 baseline.
+
+static inline __m128i bswap16_sse2(__m128i v)
+{
+   return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i bswap32_sse2(__m128i v)
+{
+   v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+   return bswap16_sse2(v);
+}
+
+static inline __m128i bswap64_sse2(__m128i v)
+{
+   return bswap32_sse2(_mm_shuffle_epi32(v, 0xB1));
+}
+
+#define R__BSWAPCPY_SSE2(bits)                                              \
+static inline void * bswapcpy##bits##_sse2(void * to, const void * from,    \
+                                           size_t n)                        \
+{                                                                           \
+   const size_t nvec = 16/(bits/8);                                         \
+   char *dst = (char *)to;                                                  \
+   const char *src = (const char *)from;                                    \
+   size_t i = 0;                                                            \
+   for (; i + 2*nvec <= n; i += 2*nvec, dst += 32, src += 32) {             \
+      __m128i v0 = _mm_loadu_si128((const __m128i *)src);                   \
+      __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));            \
+      _mm_storeu_si128((__m128i *)dst, bswap##bits##_sse2(v0));             \
+      _mm_storeu_si128((__m128i *)(dst + 16), bswap##bits##_sse2(v1));      \
+   }                                                                        \
+   for (; i + nvec <= n; i += nvec, dst += 16, src += 16) {                 \
+      __m128i v = _mm_loadu_si128((const __m128i *)src);                    \
+      _mm_storeu_si128((__m128i *)dst, bswap##bits##_sse2(v));              \
+   }                                                                        \
+   bswapcpy##bits##_scalar(dst, src, n - i);                                \
+   return (to);                                                             \
+}
+
+R__BSWAPCPY_SSE2(16)
+R__BSWAPCPY_SSE2(32)
+R__BSWAPCPY_SSE2(64)
+
+#undef R__BSWAPCPY_SSE2
+
+// AVX2 kernels: a single vpshufb per 32 bytes. They are compiled for the
+// avx2 target independently of the flags used for the rest of the file.
+
+#define R__BSWAPCPY_AVX2(bits, m0, m1, m2, m3, m4, m5, m6, m7,                \
+                              m8, m9, m10, m11, m12, m13, m14, m15)         \
+__attribute__((target("avx2")))                                             \
+static inline void * bswapcpy##bits##_avx2(void * to, const void * from,    \
+                                           size_t n)                        \
+{                                                                           \
+   const size_t nvec = 32/(bits/8);                                         \
+   const __m256i mask = _mm256_setr_epi8(m0, m1, m2, m3, m4, m5, m6, m7,    \
+                                         m8, m9, m10, m11, m12, m13, m14,   \
+                                         m15, m0, m1, m2, m3, m4, m5, m6,   \
+                                         m7, m8, m9, m10, m11, m12, m13,    \
+                                         m14, m15);                         \
+   char *dst = (char *)to;                                                  \
+   const char *src = (const char *)from;                                    \
+   size_t i = 0;                                                            \
+   for (; i + 2*nvec <= n; i += 2*nvec, dst += 64, src += 64) {             \
+      __m256i v0 = _mm256_loadu_si256((const __m256i *)src);                \
+      __m256i v1 = _mm256_loadu_si256((const __m256i *)(src + 32));         \
+      _mm256_storeu_si256((__m256i *)dst, _mm256_shuffle_epi8(v0, mask));   \
+      _mm256_storeu_si256((__m256i *)(dst + 32),                            \
+                          _mm256_shuffle_epi8(v1, mask));                   \
+   }                                                                        \
+   for (; i + nvec <= n; i += nvec, dst += 32, src += 32) {                 \
+      __m256i v = _mm256_loadu_si256((const __m256i *)src);                 \
+      _mm256_storeu_si256((__m256i *)dst, _mm256_shuffle_epi8(v, mask));    \
+   }                                                                        \
+   bswapcpy##bits##_scalar(dst, src, n - i);                                \
+   return (to);                                                             \
+}
+
+R__BSWAPCPY_AVX2(16, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+R__BSWAPCPY_AVX2(32, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+R__BSWAPCPY_AVX2(64, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8)
+
+#undef R__BSWAPCPY_AVX2
+
+static inline int bswapcpy_simdlevel()
+{
+   // Return the instruction set used by bswapcpy16/32/64: 2 for AVX2,
+   // 1 for SSE2. The cpu is only queried on the first call.
+
+   static int level = -1;
+   if (level < 0) {
+      __builtin_cpu_init();
+      level = __builtin_cpu_supports("avx2") ? 2 : 1;
+   }
+   return level;
+}
+
+// Short arrays are not worth the dispatch, they go through the scalar loop.
+
+static inline void * bswapcpy16(void * to, const void * from, size_t n)
+{
+   if (n < 16) bswapcpy16_scalar((char *)to, (const char *)from, n);
+   else if (bswapcpy_simdlevel() > 1) bswapcpy16_avx2(to, from, n);
+   else bswapcpy16_sse2(to, from, n);
+   return (to);
+}
+
+static inline void * bswapcpy32(void * to, const void * from, size_t n)
+{
+   if (n < 8) bswapcpy32_scalar((char *)to, (const char *)from, n);
+   else if (bswapcpy_simdlevel() > 1) bswapcpy32_avx2(to, from, n);
+   else bswapcpy32_sse2(to, from, n);
+   return (to);
+}
+
+static inline void * bswapcpy64(void * to, const void * from, size_t n)
+{
+   if (n < 4) bswapcpy64_scalar((char *)to, (const char *)from, n);
+   else if (bswapcpy_simdlevel() > 1) bswapcpy64_avx2(to, from, n);
+   else bswapcpy64_sse2(to, from, n);
+   return (to);
+}
+
+#endif
+
 #endif
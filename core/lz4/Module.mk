@@ -0,0 +1,49 @@
+# Module.mk for lz4 module
+# Copyright (c) 2014 Rene Brun and Fons Rademakers
+#
+# The LZ4 library itself is not included in ROOT, it is found by configure.
+
+MODNAME      := lz4
+MODDIR       := $(ROOT_SRCDIR)/core/$(MODNAME)
+MODDIRS      := $(MODDIR)/src
+MODDIRI      := $(MODDIR)/inc
+
+LZ4DIR       := $(MODDIR)
+LZ4DIRS      := $(LZ4DIR)/src
+LZ4DIRI      := $(LZ4DIR)/inc
+
+##### ZipLZ4, part of libCore #####
+LZ4H         := $(MODDIRI)/ZipLZ4.h
+LZ4S         := $(MODDIRS)/ZipLZ4.c
+LZ4O         := $(call stripsrc,$(LZ4S:.c=.o))
+
+LZ4DEP       := $(LZ4O:.o=.d)
+
+# used in the main Makefile
+ALLHDRS      += $(patsubst $(MODDIRI)/%.h,include/%.h,$(LZ4H))
+
+# include all dependency files
+INCLUDEFILES += $(LZ4DEP)
+
+##### local rules #####
+.PHONY:         all-$(MODNAME) clean-$(MODNAME) distclean-$(MODNAME)
+
+include/%.h:    $(LZ4DIRI)/%.h
+		cp $< $@
+
+all-$(MODNAME): $(LZ4O)
+
+clean-$(MODNAME):
+		@rm -f $(LZ4O)
+
+clean::         clean-$(MODNAME)
+
+distclean-$(MODNAME): clean-$(MODNAME)
+		@rm -f $(LZ4DEP)
+
+distclean::     distclean-$(MODNAME)
+
+##### extra rules ######
+ifeq ($(BUILDLZ4),yes)
+$(LZ4O): CFLAGS += $(LZ4INCDIR:%=-I%)
+endif
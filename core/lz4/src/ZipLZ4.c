@@ -0,0 +1,123 @@
+// @(#)root/lz4:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2014, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#include "ZipLZ4.h"
+#include "RConfigure.h"
+#ifdef R__HAS_LZ4
+#include "lz4.h"
+#include "lz4hc.h"
+#endif
+#include <stdio.h>
+#if defined(_MSC_VER) && !defined(R__HAS_LZ4)
+#include <intrin.h>
+#endif
+
+static const int kHeaderSize = 9;
+
+#ifndef R__HAS_LZ4
+/* Set *flag to 1 and return its previous value, atomically. */
+static long R__TestAndSet(volatile long *flag)
+{
+#if defined(_MSC_VER)
+   return _InterlockedExchange(flag, 1);
+#elif defined(__GNUC__)
+   return __sync_lock_test_and_set(flag, 1);
+#else
+   long old = *flag;
+   *flag = 1;
+   return old;
+#endif
+}
+#endif
+
+/* Levels 1 to 3 use the fast LZ4 compressor, levels 4 to 9 the slower
+   LZ4 HC compressor which gives a better ratio for the same (very fast)
+   decompression speed. */
+static const int kMinHCLevel = 4;
+
+void R__zipLZ4(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep)
+{
+#ifdef R__HAS_LZ4
+   int out_size;                  /* compressed size */
+   int out_max = *tgtsize - kHeaderSize; /* room left after the header */
+   unsigned in_size = (unsigned) (*srcsize);
+
+   *irep = 0;
+
+   if (out_max <= 0) {
+      return;
+   }
+
+   if (*srcsize > 0xffffff || *srcsize < 0) {
+      return;
+   }
+
+   if (cxlevel > 9) cxlevel = 9;
+   if (cxlevel < kMinHCLevel) {
+      out_size = LZ4_compress_default(src, &tgt[kHeaderSize], *srcsize, out_max);
+   } else {
+      out_size = LZ4_compress_HC(src, &tgt[kHeaderSize], *srcsize, out_max, cxlevel);
+   }
+   if (out_size <= 0 || out_size > 0xffffff) {
+      /* No need to print an error message. We simply abandon the compression
+         the buffer cannot be compressed or compressed buffer would be larger than original buffer
+      */
+      return;
+   }
+
+   tgt[0] = 'L';  /* Signature of LZ4 */
+   tgt[1] = '4';
+   tgt[2] = 1;
+
+   tgt[3] = (char)(out_size & 0xff);
+   tgt[4] = (char)((out_size >> 8) & 0xff);
+   tgt[5] = (char)((out_size >> 16) & 0xff);
+
+   tgt[6] = (char)(in_size & 0xff);         /* decompressed size */
+   tgt[7] = (char)((in_size >> 8) & 0xff);
+   tgt[8] = (char)((in_size >> 16) & 0xff);
+
+   *irep = out_size + kHeaderSize;
+#else
+   static volatile long warned = 0;
+   (void)cxlevel; (void)srcsize; (void)src; (void)tgtsize; (void)tgt;
+   *irep = 0;
+   /* Baskets may be compressed by several threads: warn only once. */
+   if (R__TestAndSet(&warned) == 0) {
+      fprintf(stderr,
+              "R__zipLZ4: ROOT was built without LZ4 support, the data are written uncompressed\n");
+   }
+#endif
+}
+
+void R__unzipLZ4(int *srcsize, unsigned char *src, int *tgtsize, unsigned char *tgt, int *irep)
+{
+#ifdef R__HAS_LZ4
+   int out_size;
+
+   *irep = 0;
+
+   out_size = LZ4_decompress_safe((const char *)(&src[kHeaderSize]), (char *)tgt,
+                                  *srcsize - kHeaderSize, *tgtsize);
+   if (out_size < 0) {
+      fprintf(stderr,
+              "R__unzipLZ4: error %d in LZ4_decompress_safe\n",
+              out_size);
+      return;
+   }
+
+   *irep = out_size;
+#else
+   (void)srcsize; (void)src; (void)tgtsize; (void)tgt;
+   *irep = 0;
+   fprintf(stderr,
+           "R__unzipLZ4: ROOT was built without LZ4 support, cannot decompress the buffer\n");
+#endif
+}
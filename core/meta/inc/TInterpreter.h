@@ -101,6 +101,7 @@ public:
    virtual Int_t    AutoLoad(const std::type_info& typeinfo) = 0;
    virtual void     ClearFileBusy() = 0;
    virtual void     ClearStack() = 0; // Delete existing temporary values
+   virtual Long_t   CompileFunction(const char *name, const char *signature, const char *body, const char *headers = 0) = 0;
    virtual void     EnableAutoLoading() = 0;
    virtual void     EndOfLineAction() = 0;
    virtual Int_t    GetExitCode() const = 0;
@@ -1553,6 +1553,58 @@ void TCling::ClearStack()
    // No-op for cling due to StoredValueRef.
 }
 
+//______________________________________________________________________________
+Long_t TCling::CompileFunction(const char *name, const char *signature, const char *body, const char *headers)
+{
+   // Compile a function and return its address (0 if it could not be
+   // compiled). 'signature' is the declaration of the function, in which
+   // its name is written $name, and 'body' the statements between its
+   // braces. The function is named after 'name' followed by a number.
+   // 'headers' is a blank separated list of the headers to include before
+   // compiling the function.
+   // A function is compiled only once for a given name, signature, headers
+   // and body; later calls return the address of the first compilation (or
+   // 0 if it failed). This is used for the code generated at run time by
+   // TFormula, TTreeFormula and the streamer actions.
+
+   R__LOCKGUARD2(gInterpreterMutex);
+
+   std::string key(name);
+   key += '\n';
+   key += signature;
+   key += '\n';
+   if (headers) key += headers;
+   key += '\n';
+   key += body;
+   std::map<std::string,Long_t>::iterator iter = fCompiledFunctions.find(key);
+   if (iter != fCompiledFunctions.end()) return iter->second;
+
+   TString fname = TString::Format("%s%d", name, (Int_t)fCompiledFunctions.size());
+   TString source(signature);
+   source.ReplaceAll("$name", fname);
+   source += "\n{\n";
+   source += body;
+   source += "}\n";
+
+   EErrorCode err = kNoError;
+   TString include;
+   Ssiz_t from = 0;
+   TString list(headers ? headers : "");
+   while (err == kNoError && list.Tokenize(include, from, " ")) {
+      ProcessLine(TString::Format("#include \"%s\"", include.Data()), &err);
+   }
+   Long_t address = 0;
+   if (err == kNoError) ProcessLine(source, &err);
+   if (err == kNoError) address = Calc(TString::Format("(long)&%s", fname.Data()), &err);
+   if (err != kNoError) address = 0;
+   if (gDebug > 0) {
+      Info("CompileFunction", "%s %s as:\n%s",
+           address ? "compiled" : "could not compile", fname.Data(), source.Data());
+   }
+   fCompiledFunctions[key] = address;
+   return address;
+}
+
 //______________________________________________________________________________
 void TCling::EnableAutoLoading()
 {
@@ -31,6 +31,7 @@
 #include <set>
 #include <typeinfo>
 #include <map>
+#include <string>
 #include <vector>
 
 #ifndef WIN32
@@ -120,6 +121,7 @@ private: // Data Members
    ModuleForHeader_t fModuleForHeader; // Which module a header is in. Assumes string storage in dictionary.
    std::set<TClass*> fModTClasses;
    void* fAutoLoadCallBack;
+   std::map<std::string,Long_t> fCompiledFunctions; // Address of the functions compiled by CompileFunction, by name, signature, headers and body.
 
    DeclId_t GetDeclId(const llvm::GlobalValue *gv) const;
 
@@ -137,6 +139,7 @@ public: // Public Interface
    Bool_t  IsAutoLoadNamespaceCandidate(const char* name);
    void    ClearFileBusy();
    void    ClearStack(); // Delete existing temporary values
+   Long_t  CompileFunction(const char *name, const char *signature, const char *body, const char *headers = 0);
    void    EnableAutoLoading();
    void    EndOfLineAction();
    Int_t   GetExitCode() const { return fExitCode; }
@@ -15,6 +15,8 @@
 #include "zlib.h"
 #include "RConfigure.h"
 #include "ZipLZMA.h"
+#include "ZipLZ4.h"
+#include "ZipZSTD.h"
 
 #include <stdio.h>
 
@@ -150,6 +152,8 @@ ulg R__bits_sent;   /* bit length of the compressed data */
    and when R__zipMultipleAlgorithm is called with its last argument set to 0.
    R__ZipMode = 1 : ZLIB compression algorithm is used (default)
    R__ZipMode = 2 : LZMA compression algorithm is used
+   R__ZipMode = 4 : LZ4 compression algorithm is used
+   R__ZipMode = 5 : Zstandard compression algorithm is used
    R__ZipMode = 0 or 3 : a very old compression algorithm is used
    (the very old algorithm is supported for backward compatibility)
    The LZMA algorithm requires the external XZ package be installed when linking
@@ -421,6 +425,8 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
      /*                      1 = zlib */
      /*                      2 = lzma */
      /*                      3 = old */
+     /*                      4 = lz4 */
+     /*                      5 = zstd */
 {
   int err;
   int method   = Z_DEFLATED;
@@ -440,6 +446,18 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
     return;
   }
 
+  // The LZ4 compression algorithm (fast decompression)
+  if (compressionAlgorithm == 4) {
+    R__zipLZ4(cxlevel, srcsize, src, tgtsize, tgt, irep);
+    return;
+  }
+
+  // The Zstandard compression algorithm
+  if (compressionAlgorithm == 5) {
+    R__zipZSTD(cxlevel, srcsize, src, tgtsize, tgt, irep);
+    return;
+  }
+
   // The very old algorithm for backward compatibility
   // 0 for selecting with R__ZipMode in a backward compatible way
   // 3 for selecting in other cases
@@ -495,14 +513,21 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
   // algorithm setting
   } else {
 
+    /* This branch only uses local state (no error_flag, in_size or out_size)
+       so that several buffers can be compressed concurrently, see
+       TTree::FlushBaskets */
     z_stream stream;
+    unsigned zin_size, zout_size;
     *irep = 0;
 
-    error_flag   = 0;
-    if (*tgtsize <= 0) R__error("target buffer too small");
-    if (error_flag != 0) return;
-    if (*srcsize > 0xffffff) R__error("source buffer too big");
-    if (error_flag != 0) return;
+    if (*tgtsize <= 0) {
+       if (verbose) fprintf(stderr,"R__zip: target buffer too small\n");
+       return;
+    }
+    if (*srcsize > 0xffffff) {
+       if (verbose) fprintf(stderr,"R__zip: source buffer too big\n");
+       return;
+    }
 
 
     stream.next_in   = (Bytef*)src;
@@ -538,15 +563,15 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
     tgt[1] = 'L';
     tgt[2] = (char) method;
 
-    in_size   = (unsigned) (*srcsize);
-    out_size  = stream.total_out;             /* compressed size */
-    tgt[3] = (char)(out_size & 0xff);
-    tgt[4] = (char)((out_size >> 8) & 0xff);
-    tgt[5] = (char)((out_size >> 16) & 0xff);
+    zin_size  = (unsigned) (*srcsize);
+    zout_size = stream.total_out;             /* compressed size */
+    tgt[3] = (char)(zout_size & 0xff);
+    tgt[4] = (char)((zout_size >> 8) & 0xff);
+    tgt[5] = (char)((zout_size >> 16) & 0xff);
 
-    tgt[6] = (char)(in_size & 0xff);         /* decompressed size */
-    tgt[7] = (char)((in_size >> 8) & 0xff);
-    tgt[8] = (char)((in_size >> 16) & 0xff);
+    tgt[6] = (char)(zin_size & 0xff);         /* decompressed size */
+    tgt[7] = (char)((zin_size >> 8) & 0xff);
+    tgt[8] = (char)((zin_size >> 16) & 0xff);
 
     *irep = stream.total_out + HDRSIZE;
     return;
@@ -25,6 +25,13 @@ namespace ROOT {
    // in greater compression factors, but takes more CPU time
    // and memory when compressing.  LZMA memory usage is particularly
    // high for compression levels 8 and 9.
+   // The LZ4 algorithm (levels 1 to 3: fast compressor, 4 to 9:
+   // high compression mode) trades compression factor for very fast
+   // decompression and suits the branches which are read often.
+   // The Zstandard algorithm gives compression factors close
+   // to ZLIB at a much higher compression and decompression speed.
+   // LZ4 and Zstandard require ROOT to be built with the lz4 and
+   // zstd options; otherwise the buffers are written uncompressed.
    //
    // The current algorithms support level 1 to 9. The higher
    // the level the greater the compression and more CPU time
@@ -34,6 +41,8 @@ namespace ROOT {
                                 kZLIB,
                                 kLZMA,
                                 kOldCompressionAlgo,
+                                kLZ4,
+                                kZSTD,
                                 // if adding new algorithm types,
                                 // keep this enum value last
                                 kUndefinedCompressionAlgorithm
@@ -0,0 +1,116 @@
+// @(#)root/zstd:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2014, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#include "ZipZSTD.h"
+#include "RConfigure.h"
+#ifdef R__HAS_ZSTD
+#include "zstd.h"
+#endif
+#include <stdio.h>
+#if defined(_MSC_VER) && !defined(R__HAS_ZSTD)
+#include <intrin.h>
+#endif
+
+static const int kHeaderSize = 9;
+
+#ifndef R__HAS_ZSTD
+/* Set *flag to 1 and return its previous value, atomically. */
+static long R__TestAndSet(volatile long *flag)
+{
+#if defined(_MSC_VER)
+   return _InterlockedExchange(flag, 1);
+#elif defined(__GNUC__)
+   return __sync_lock_test_and_set(flag, 1);
+#else
+   long old = *flag;
+   *flag = 1;
+   return old;
+#endif
+}
+#endif
+
+void R__zipZSTD(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep)
+{
+#ifdef R__HAS_ZSTD
+   size_t out_size;               /* compressed size */
+   int out_max = *tgtsize - kHeaderSize; /* room left after the header */
+   unsigned in_size = (unsigned) (*srcsize);
+
+   *irep = 0;
+
+   if (out_max <= 0) {
+      return;
+   }
+
+   if (*srcsize > 0xffffff || *srcsize < 0) {
+      return;
+   }
+
+   /* The ROOT levels 1 to 9 are mapped one to one onto the Zstandard
+      levels; the higher Zstandard levels are too slow for our use case. */
+   if (cxlevel > 9) cxlevel = 9;
+   out_size = ZSTD_compress(&tgt[kHeaderSize], (size_t)out_max,
+                            src, (size_t)(*srcsize), cxlevel);
+   if (ZSTD_isError(out_size) || out_size > 0xffffff) {
+      /* No need to print an error message. We simply abandon the compression
+         the buffer cannot be compressed or compressed buffer would be larger than original buffer
+      */
+      return;
+   }
+
+   tgt[0] = 'Z';  /* Signature of Zstandard */
+   tgt[1] = 'S';
+   tgt[2] = 1;
+
+   tgt[3] = (char)(out_size & 0xff);
+   tgt[4] = (char)((out_size >> 8) & 0xff);
+   tgt[5] = (char)((out_size >> 16) & 0xff);
+
+   tgt[6] = (char)(in_size & 0xff);         /* decompressed size */
+   tgt[7] = (char)((in_size >> 8) & 0xff);
+   tgt[8] = (char)((in_size >> 16) & 0xff);
+
+   *irep = (int)out_size + kHeaderSize;
+#else
+   static volatile long warned = 0;
+   (void)cxlevel; (void)srcsize; (void)src; (void)tgtsize; (void)tgt;
+   *irep = 0;
+   /* Baskets may be compressed by several threads: warn only once. */
+   if (R__TestAndSet(&warned) == 0) {
+      fprintf(stderr,
+              "R__zipZSTD: ROOT was built without Zstandard support, the data are written uncompressed\n");
+   }
+#endif
+}
+
+void R__unzipZSTD(int *srcsize, unsigned char *src, int *tgtsize, unsigned char *tgt, int *irep)
+{
+#ifdef R__HAS_ZSTD
+   size_t out_size;
+
+   *irep = 0;
+
+   out_size = ZSTD_decompress(tgt, (size_t)(*tgtsize),
+                              &src[kHeaderSize], (size_t)(*srcsize - kHeaderSize));
+   if (ZSTD_isError(out_size)) {
+      fprintf(stderr,
+              "R__unzipZSTD: error in ZSTD_decompress: %s\n",
+              ZSTD_getErrorName(out_size));
+      return;
+   }
+
+   *irep = (int)out_size;
+#else
+   (void)srcsize; (void)src; (void)tgtsize; (void)tgt;
+   *irep = 0;
+   fprintf(stderr,
+           "R__unzipZSTD: ROOT was built without Zstandard support, cannot decompress the buffer\n");
+#endif
+}
@@ -202,6 +202,7 @@ public:
    virtual void     DrawF1(const char *formula, Double_t xmin, Double_t xmax, Option_t *option="");
    virtual Double_t Eval(Double_t x, Double_t y=0, Double_t z=0, Double_t t=0) const;
    virtual Double_t EvalPar(const Double_t *x, const Double_t *params=0);
+   virtual void     EvalParVec(Int_t n, const Double_t *x, Double_t *result, const Double_t *params=0, Int_t stride=0);
    // for using TF1 as a callable object (functor)
    virtual Double_t operator()(Double_t x, Double_t y=0, Double_t z = 0, Double_t t = 0) const; 
    virtual Double_t operator()(const Double_t *x, const Double_t *params=0);  
@@ -95,6 +95,12 @@ protected:
    TFormulaPrimitive  **fPredefined;      //![fNPar] predefined function  
    TFuncG               fOptimal; //!pointer to optimal function
 
+   // Compiled expression
+   void                *fJitFunc;        //!function compiled by JitCompile
+   void               **fJitPrimitives;  //![fNOperOptimized] primitive functions called by fJitFunc
+   Bool_t               fJitChecked;     //!true if JitCompile was already tried
+   static Int_t         fgJit;           //switch to compile the formulas (see SetJit)
+
    Int_t             PreCompile();
    virtual Bool_t    CheckOperands(Int_t operation, Int_t &err);
    virtual Bool_t    CheckOperands(Int_t leftoperand, Int_t rightoperartion, Int_t &err);
@@ -233,6 +239,7 @@ public:
    virtual Double_t    Eval(Double_t x, Double_t y=0, Double_t z=0, Double_t t=0) const;
    virtual Double_t    EvalParOld(const Double_t *x, const Double_t *params=0);
    virtual Double_t    EvalPar(const Double_t *x, const Double_t *params=0){return ((*this).*fOptimal)(x,params);};
+   virtual void        EvalParVec(Int_t n, const Double_t *x, Double_t *result, const Double_t *params=0, Int_t stride=0);
    virtual const TObject *GetLinearPart(Int_t i);
    virtual Int_t       GetNdim() const {return fNdim;}
    virtual Int_t       GetNpar() const {return fNpar;}
@@ -245,7 +252,10 @@ public:
    virtual const char *GetParName(Int_t ipar) const;
    virtual Int_t       GetParNumber(const char *name) const;
    virtual Bool_t      IsLinear() {return TestBit(kLinear);}
+   Bool_t              IsJitted() const {return fJitFunc != 0;}
+   static Bool_t       IsJitEnabled();
    virtual Bool_t      IsNormalized() {return TestBit(kNormalized);}
+   Bool_t              JitCompile();
    virtual void        Print(Option_t *option="") const; // *MENU*
    virtual void        ProcessLinear(TString &replaceformula);
    virtual void        SetNumber(Int_t number) {fNumber = number;}
@@ -262,6 +272,7 @@ public:
                                    *name8="p8",const char *name9="p9",const char *name10="p10"); // *MENU*
    virtual void        Update() {;}
 
+   static  void        SetJit(Bool_t enable=kTRUE);
    static  void        SetMaxima(Int_t maxop=1000, Int_t maxpar=1000, Int_t maxconst=1000);
    
    ClassDef(TFormula,8)  //The formula base class  f(x,y,z,par)
@@ -75,10 +75,14 @@ class TList;
 class TCollection;
 class TVirtualFFT;
 class TVirtualHistPainter;
+class TVirtualMutex;
+class TH1ConcurrentFill;
 
 
 class TH1 : public TNamed, public TAttLine, public TAttFill, public TAttMarker {
 
+   friend class TH1ConcurrentFill;
+
 public: 
 
    // enumeration specifying type of statistics for bin errors
@@ -123,6 +127,7 @@ protected:
     Double_t     *fIntegral;        //!Integral of bins used by GetRandom
     TVirtualHistPainter *fPainter;  //!pointer to histogram painter
     EBinErrorOpt  fBinStatErrOpt;   //option for bin statistical errors 
+    TH1ConcurrentFill *fConcurrentFill; //!per thread fill buffers (see SetConcurrentFill)
     static Int_t  fgBufferSize;     //!default buffer size for automatic histograms
     static Bool_t fgAddDirectory;   //!flag to add histograms to the directory
     static Bool_t fgStatOverflows;  //!flag to use under/overflows in statistics
@@ -146,6 +151,9 @@ protected:
    TH1(const char *name,const char *title,Int_t nbinsx,const Double_t *xbins);
    virtual void     Copy(TObject &hnew) const;
    virtual Int_t    BufferFill(Double_t x, Double_t w);
+           Bool_t   ConcurrentFill(Int_t nargs, Double_t a0, Double_t a1=0, Double_t a2=0, Double_t a3=0);
+   virtual void     FillFromThreadBuffer(Int_t nargs, const Double_t *args);
+   TVirtualMutex   *GetConcurrentFillMutex() const;
    virtual Bool_t   FindNewAxisLimits(const TAxis* axis, const Double_t point, Double_t& newMin, Double_t &newMax);
    virtual void     SavePrimitiveHelp(std::ostream &out, const char *hname, Option_t *option = "");
    static Bool_t    RecomputeAxisLimits(TAxis& destAxis, const TAxis& anAxis);
@@ -182,6 +190,11 @@ public:
    enum { 
       kNstat       = 13  // size of statistics data (up to TProfile3D)
    };
+   // number of entries whose bins are looked up together by FillN
+   // (see TAxis::FindFixBins)
+   enum {
+      kNFillNBlock = 256
+   };
 
 
    virtual ~TH1();
@@ -227,6 +240,7 @@ public:
    virtual Int_t    FindLastBinAbove (Double_t threshold=0, Int_t axis=1) const;
    virtual TObject *FindObject(const char *name) const;
    virtual TObject *FindObject(const TObject *obj) const;
+           void     FlushConcurrentFill();
    virtual TFitResultPtr    Fit(const char *formula ,Option_t *option="" ,Option_t *goption="", Double_t xmin=0, Double_t xmax=0); // *MENU*
    virtual TFitResultPtr    Fit(TF1 *f1 ,Option_t *option="" ,Option_t *goption="", Double_t xmin=0, Double_t xmax=0);
    virtual void     FitPanel(); // *MENU*
@@ -322,6 +336,7 @@ public:
    virtual Double_t Interpolate(Double_t x, Double_t y, Double_t z);
            Bool_t   IsBinOverflow(Int_t bin) const;
            Bool_t   IsBinUnderflow(Int_t bin) const;
+           Bool_t   IsConcurrentFill() const { return fConcurrentFill != 0; }
    virtual Double_t KolmogorovTest(const TH1 *h2, Option_t *option="") const;
    virtual void     LabelsDeflate(Option_t *axis="X");
    virtual void     LabelsInflate(Option_t *axis="X");
@@ -363,6 +378,7 @@ public:
    virtual void     SetBinErrorOption(EBinErrorOpt type) { fBinStatErrOpt = type; }
    virtual void     SetBuffer(Int_t buffersize, Option_t *option="");
    virtual UInt_t   SetCanExtend(UInt_t extendBitMask);
+           void     SetConcurrentFill(Bool_t enable = kTRUE, Int_t buffersize = 1000);
    virtual void     SetContent(const Double_t *content);
    virtual void     SetContour(Int_t nlevels, const Double_t *levels=0);
    virtual void     SetContourLevel(Int_t level, Double_t value);
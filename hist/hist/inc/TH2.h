@@ -54,6 +54,7 @@ protected:
                                          ,Int_t nbinsy,const Float_t  *ybins);
 
    virtual Int_t     BufferFill(Double_t x, Double_t y, Double_t w);
+   virtual void      FillFromThreadBuffer(Int_t nargs, const Double_t *args);
    virtual TH1D     *DoProjection(bool onX, const char *name, Int_t firstbin, Int_t lastbin, Option_t *option) const;
    virtual TProfile *DoProfile(bool onX, const char *name, Int_t firstbin, Int_t lastbin, Option_t *option) const;
    virtual TH1D     *DoQuantiles(bool onX, const char *name, Double_t prob) const;
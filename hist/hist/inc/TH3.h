@@ -54,6 +54,7 @@ protected:
                                          ,Int_t nbinsy,const Double_t *ybins
                                          ,Int_t nbinsz,const Double_t *zbins);
    virtual Int_t    BufferFill(Double_t x, Double_t y, Double_t z, Double_t w);
+   virtual void     FillFromThreadBuffer(Int_t nargs, const Double_t *args);
 
    void DoFillProfileProjection(TProfile2D * p2, const TAxis & a1, const TAxis & a2, const TAxis & a3, Int_t bin1, Int_t bin2, Int_t bin3, Int_t inBin, Bool_t useWeights) const;
 
@@ -65,6 +66,8 @@ protected:
    Int_t    Fill(Double_t,const char*,Double_t) {return Fill(0);} //MayNotUse
    Int_t    Fill(const char*,Double_t,Double_t) {return Fill(0);} //MayNotUse
    Int_t    Fill(const char*,const char*,Double_t) {return Fill(0);} //MayNotUse
+   virtual void     FillN(Int_t, const Double_t *, const Double_t *, Int_t) {;} //MayNotUse
+   virtual void     FillN(Int_t, const Double_t *, const Double_t *, const Double_t *, Int_t) {;} //MayNotUse
 
 private: 
 
@@ -84,6 +87,7 @@ public:
    virtual Int_t    Fill(Double_t x, const char *namey, const char *namez, Double_t w);
    virtual Int_t    Fill(Double_t x, const char *namey, Double_t z, Double_t w);
    virtual Int_t    Fill(Double_t x, Double_t y, const char *namez, Double_t w);
+   virtual void     FillN(Int_t ntimes, const Double_t *x, const Double_t *y, const Double_t *z, const Double_t *w, Int_t stride=1);
 
    virtual void     FillRandom(const char *fname, Int_t ntimes=5000);
    virtual void     FillRandom(TH1 *h, Int_t ntimes=5000);
@@ -237,7 +237,7 @@ private:
       return (THnBase*)ProjectionAny(ndim, dim, kTRUE /*wantNDim*/, option);
    }
 
-   Long64_t   Merge(TCollection* list);
+   virtual Long64_t Merge(TCollection* list);
 
    void Scale(Double_t c);
    void Add(const THnBase* h, Double_t c=1.);
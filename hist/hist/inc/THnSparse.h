@@ -47,16 +47,18 @@
 #include "TArrayC.h"
 #endif
 
+class THnSparseBinIndex;
 class THnSparseCompactBinCoord;
+class TVirtualMutex;
 
 class THnSparse: public THnBase {
  private:
    Int_t      fChunkSize;    // number of entries for each chunk
    Long64_t   fFilledBins;   // number of filled bins
    TObjArray  fBinContent;   // array of THnSparseArrayChunk
-   TExMap     fBins;         //! filled bins
-   TExMap     fBinsContinued;//! filled bins for non-unique hashes, containing pairs of (bin index 0, bin index 1)
+   THnSparseBinIndex *fBinIndex; //! filled bins: hash table from the compact coordinate to the bin index
    THnSparseCompactBinCoord *fCompactCoord; //! compact coordinate
+   TVirtualMutex *fMergeMutex;   //! serializes concurrent calls to Merge()
 
    THnSparse(const THnSparse&); // Not implemented
    THnSparse& operator=(const THnSparse&); // Not implemented
@@ -73,7 +75,7 @@ class THnSparse: public THnBase {
 
    THnSparseArrayChunk* AddChunk();
    void Reserve(Long64_t nbins);
-   void FillExMap();
+   void FillBinIndex();
    virtual TArray* GenerateArray() const = 0;
    Long64_t GetBinIndexForCurrentBin(Bool_t allocate);
    void FillBin(Long64_t bin, Double_t w) {
@@ -104,6 +106,9 @@ class THnSparse: public THnBase {
 
    ROOT::THnBaseBinIter* CreateIter(Bool_t respectAxisRange) const;
 
+   void FillN(Int_t nentries, const Double_t* x, const Double_t* w = 0);
+   virtual Long64_t Merge(TCollection* list);
+
    Long64_t GetNbins() const { return fFilledBins; }
    void SetFilledBins(Long64_t nbins) { fFilledBins = nbins; }
 
@@ -50,6 +50,7 @@ static Bool_t   fgApproximate;    //bin error approximation option
 
    virtual Int_t    BufferFill(Double_t, Double_t) {return -2;} //may not use
    virtual Int_t    BufferFill(Double_t x, Double_t y, Double_t w);
+   virtual void     FillFromThreadBuffer(Int_t nargs, const Double_t *args);
 
    // helper methods for the Merge unification in TProfileHelper
    void SetBins(const Int_t* nbins, const Double_t* range) { SetBins(nbins[0], range[0], range[1]); };
@@ -371,6 +371,75 @@ Int_t TAxis::FindFixBin(Double_t x) const
    return bin;
 }
 
+//______________________________________________________________________________
+void TAxis::FindFixBins(Int_t n, const Double_t *x, Int_t *bins, Int_t stride) const
+{
+   // Find the bin numbers corresponding to the n abscissas x[0], x[stride],
+   // ..., x[(n-1)*stride] and store them in bins[0], ..., bins[n-1].
+   //
+   // The result is identical to calling FindFixBin for each abscissa (no
+   // attempt is made to extend the axis), but the loops are written without
+   // branches so that they can be vectorized by the compiler:
+   //  - for fix bins the bin is computed with the same arithmetic as
+   //    FindFixBin, underflows, overflows and NaNs being selected afterwards;
+   //  - for variable bin sizes a branch free binary search is run on a
+   //    block of abscissas at a time, all the searches of the block moving
+   //    one level down the array of bin edges together. This hides the
+   //    latency of the memory accesses and avoids the branch
+   //    mispredictions of TMath::BinarySearch.
+
+   if (n <= 0) return;
+   const Double_t xmin = fXmin;
+   const Double_t xmax = fXmax;
+   const Int_t nbins = fNbins;
+
+   if (!fXbins.fN) {        //*-* fix bins
+      const Double_t width = xmax-xmin;
+      for (Int_t i = 0; i < n; i++) {
+         const Double_t xi = x[i*stride];
+         // move the out of range values (and NaN) inside the axis to keep
+         // the conversion to int defined
+         const Double_t xc = (xi >= xmin && xi < xmax) ? xi : xmin;
+         const Int_t bin = 1 + int (nbins*(xc-xmin)/width);
+         bins[i] = (xi < xmin) ? 0 : ((xi < xmax) ? bin : nbins+1);
+      }
+      return;
+   }
+
+   //*-* variable bin sizes
+   // Branch free equivalent of TMath::BinarySearch (std::lower_bound) for
+   // the abscissas in range. The edges array is fNbins+1 long.
+   const Double_t *edges = fXbins.fArray;
+   const Int_t nedges = fXbins.fN;
+   const Int_t kBlock = 64;
+   Int_t base[kBlock];
+   Double_t xb[kBlock];
+   for (Int_t first = 0; first < n; first += kBlock) {
+      const Int_t nb = TMath::Min(kBlock, n-first);
+      const Double_t *xf = x + first*stride;
+      for (Int_t j = 0; j < nb; j++) {
+         xb[j] = xf[j*stride];
+         base[j] = 0;
+      }
+      Int_t len = nedges;
+      while (len > 1) {
+         const Int_t half = len/2;
+         for (Int_t j = 0; j < nb; j++) {
+            base[j] = (edges[base[j]+half] < xb[j]) ? base[j]+half : base[j];
+         }
+         len -= half;
+      }
+      Int_t *bf = bins + first;
+      for (Int_t j = 0; j < nb; j++) {
+         const Double_t xj = xb[j];
+         // lower_bound position and BinarySearch result
+         const Int_t lb = base[j] + (edges[base[j]] < xj);
+         const Int_t pos = (lb < nedges && edges[TMath::Min(lb,nedges-1)] == xj) ? lb : lb-1;
+         bf[j] = (xj < xmin) ? 0 : ((xj < xmax) ? 1 + pos : nbins+1);
+      }
+   }
+}
+
 //______________________________________________________________________________
 const char *TAxis::GetBinLabel(Int_t bin) const
 {
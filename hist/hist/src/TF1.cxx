@@ -1333,6 +1333,29 @@ Double_t TF1::EvalPar(const Double_t *x, const Double_t *params)
 }
 
 
+//______________________________________________________________________________
+void TF1::EvalParVec(Int_t n, const Double_t *x, Double_t *result, const Double_t *params, Int_t stride)
+{
+   // Evaluate function at n points in one call: result[i] is the value at
+   // the point x[i*stride], x[i*stride+1], ... (stride defaults to the
+   // dimension of the function). If params is 0, fParams is used.
+   //
+   // Functions defined by an expression (fType=0) use TFormula::EvalParVec,
+   // which can run the loop in a compiled version of the expression (see
+   // TFormula::JitCompile). The other functions are evaluated with EvalPar
+   // point by point.
+
+   fgCurrent = this;
+
+   if (fType == 0) {
+      TFormula::EvalParVec(n, x, result, params, stride);
+      return;
+   }
+   if (stride <= 0) stride = fNdim > 0 ? fNdim : 1;
+   for (Int_t i = 0; i < n; ++i, x += stride) result[i] = EvalPar(x, params);
+}
+
+
 //______________________________________________________________________________
 void TF1::ExecuteEvent(Int_t event, Int_t px, Int_t py)
 {
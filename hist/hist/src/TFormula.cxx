@@ -10,6 +10,7 @@
  *************************************************************************/
 
 #include <math.h>
+#include <vector>
 
 #include "Riostream.h"
 #include "TROOT.h"
@@ -23,6 +24,7 @@
 #include "TError.h"
 #include "TFormulaPrimitive.h"
 #include "TInterpreter.h"
+#include "TEnv.h"
 
 #ifdef WIN32
 #pragma optimize("",off)
@@ -32,6 +34,8 @@ static Int_t gMAXOP=1000,gMAXPAR=1000,gMAXCONST=1000;
 const Int_t  gMAXSTRINGFOUND = 10;
 const UInt_t kOptimizationError = BIT(19);
 
+Int_t TFormula::fgJit = -1;
+
 ClassImp(TFormula)
 
 //______________________________________________________________________________
@@ -150,6 +154,9 @@ TFormula::TFormula(): TNamed()
    fOperOffset     = 0;
    fPredefined     = 0;
    fOptimal        = (TFormulaPrimitive::TFuncG)&TFormula::EvalParOld;
+   fJitFunc        = 0;
+   fJitPrimitives  = 0;
+   fJitChecked     = kFALSE;
 }
 
 //______________________________________________________________________________
@@ -179,6 +186,9 @@ TFormula::TFormula(const char *name,const char *expression) :
    fOperOffset     = 0;
    fPredefined     = 0;
    fOptimal        = (TFormulaPrimitive::TFuncG)&TFormula::EvalParOld;
+   fJitFunc        = 0;
+   fJitPrimitives  = 0;
+   fJitChecked     = kFALSE;
 
    if (!expression || !*expression) {
       Error("TFormula", "expression may not be 0 or have 0 length");
@@ -286,6 +296,9 @@ TFormula::TFormula(const TFormula &formula) : TNamed()
    fOperOffset     = 0;
    fExprOptimized  = 0;
    fOperOptimized  = 0;
+   fJitFunc        = 0;
+   fJitPrimitives  = 0;
+   fJitChecked     = kFALSE;
 
    ((TFormula&)formula).TFormula::Copy(*this);
 }
@@ -2235,6 +2248,9 @@ void TFormula::ClearFormula(Option_t * /*option*/ )
    if (fOperOffset)    { delete [] fOperOffset;    fOperOffset    = 0;}
    if (fExprOptimized) { delete [] fExprOptimized; fExprOptimized = 0;}
    if (fOperOptimized) { delete [] fOperOptimized; fOperOptimized = 0;}
+   if (fJitPrimitives) { delete [] fJitPrimitives; fJitPrimitives = 0;}
+   fJitFunc    = 0;
+   fJitChecked = kFALSE;
    // should we also remove the object from the list?
    // gROOT->GetListOfFunctions()->Remove(this);
    // if we don't, what happens if it fails the new compilation?
@@ -3765,6 +3781,10 @@ void TFormula::Optimize()
    if (fOperOffset)    { delete [] fOperOffset;    fOperOffset    = 0;}
    if (fExprOptimized) { delete [] fExprOptimized; fExprOptimized = 0;}
    if (fOperOptimized) { delete [] fOperOptimized; fOperOptimized = 0;}
+   // The compiled version of the previous optimized expression is stale.
+   if (fJitPrimitives) { delete [] fJitPrimitives; fJitPrimitives = 0;}
+   fJitFunc    = 0;
+   fJitChecked = kFALSE;
 
    fExprOptimized   = new TString[fNoper];
    fOperOptimized   = new Int_t[fNoper];
@@ -4418,6 +4438,407 @@ Double_t TFormula::EvalParFast(const Double_t *x, const Double_t *uparams)
 
 }
 
+//______________________________________________________________________________
+void TFormula::EvalParVec(Int_t n, const Double_t *x, Double_t *result, const Double_t *params, Int_t stride)
+{
+   // Evaluate this formula at n points in one call.
+   //
+   // The coordinates of the point i are x[i*stride], x[i*stride+1], ...
+   // (stride defaults to the dimension of the formula) and its value is
+   // stored in result[i]. If params is 0, fParams is used.
+   //
+   // When the formula is compiled (see JitCompile), the whole loop runs in
+   // the compiled function, which the compiler can vectorize. Otherwise,
+   // EvalPar is called for each point. Both give the same values.
+
+   if (n <= 0) return;
+   if (stride <= 0) stride = fNdim > 0 ? fNdim : 1;
+   if (!params) params = fParams;
+
+   if (!fJitChecked) {
+      fJitChecked = kTRUE;
+      if (IsJitEnabled()) JitCompile();
+   }
+   if (fJitFunc) {
+      typedef void (*JitFunc_t)(Int_t, const Double_t*, Int_t, const Double_t*, void * const *, Bool_t, Double_t*);
+      ((JitFunc_t)fJitFunc)(n, x, stride, params, fJitPrimitives, IsNormalized(), result);
+      return;
+   }
+   for (Int_t i = 0; i < n; ++i, x += stride) result[i] = EvalPar(x, params);
+}
+
+//______________________________________________________________________________
+Bool_t TFormula::IsJitEnabled()
+{
+   // Return true if the formulas are compiled by the interpreter JIT on their
+   // first evaluation by EvalParVec. The default is taken from the resource
+   // TFormula.Jit (default: no) and can be changed with SetJit.
+
+   if (fgJit < 0) fgJit = gEnv->GetValue("TFormula.Jit", 0) ? 1 : 0;
+   return fgJit > 0;
+}
+
+//______________________________________________________________________________
+void TFormula::SetJit(Bool_t enable)
+{
+   // Enable or disable the compilation of the formulas by the interpreter
+   // JIT (see JitCompile). This affects the formulas not yet evaluated
+   // by EvalParVec.
+
+   fgJit = enable ? 1 : 0;
+}
+
+//______________________________________________________________________________
+static Bool_t R__JitData(Int_t type, Int_t offset, const Double_t *consts, TString &out)
+{
+   // Expression reading the operand (type,offset) of an optimized operation
+   // in the function generated by TFormula::JitCompile.
+
+   switch (type) {
+      case TOperOffset::kVariable:  out.Form("x[%d]", offset); return kTRUE;
+      case TOperOffset::kParameter: out.Form("p[%d]", offset); return kTRUE;
+      case TOperOffset::kConstant:
+         if (!TMath::Finite(consts[offset])) return kFALSE;
+         out.Form("(%.17g)", consts[offset]);
+         return kTRUE;
+   }
+   return kFALSE;
+}
+
+//______________________________________________________________________________
+static const char *R__JitPrimitive(const char *name)
+{
+   // Inline expression equivalent to the basic primitive 'name' (see
+   // TFormulaPrimitive::BuildBasicFormulas), $0, $1 and $2 being its
+   // arguments. Returns 0 if the primitive must be called through its
+   // function pointer.
+
+   static const char *const kInline[][2] = {
+      { "PlusXY",  "$0 + $1" },
+      { "MinusXY", "$0 - $1" },
+      { "MultXY",  "$0 * $1" },
+      { "DivXY",   "(TMath::Abs($1) > 0) ? $0 / $1 : 0" },
+      { "XpYpZ",   "$0 + $1 + $2" },
+      { "XxYxZ",   "$0 * $1 * $2" },
+      { "XxYpZ",   "$0 * ($1 + $2)" },
+      { "XpYxZ",   "$0 + ($1 * $2)" },
+      { "XandY",   "($0 * $1 > 0.1) ? 1 : 0" },
+      { "XorY",    "($0 + $1 > 0.1) ? 1 : 0" },
+      { "XgY",     "($0 >  $1) ? 1 : 0" },
+      { "XgeY",    "($0 >= $1) ? 1 : 0" },
+      { "XlY",     "($0 <  $1) ? 1 : 0" },
+      { "XleY",    "($0 <= $1) ? 1 : 0" },
+      { "XeY",     "($0 == $1) ? 1 : 0" },
+      { "XneY",    "($0 != $1) ? 1 : 0" },
+      { "XNot",    "($0 < 0.1) ? 1 : 0" },
+      { "Pow2",    "$0 * $0" },
+      { "Pow3",    "$0 * $0 * $0" },
+      { "Pow4",    "$0 * $0 * $0 * $0" },
+      { "Pow5",    "$0 * $0 * $0 * $0 * $0" },
+      { "sq",      "$0 * $0" },
+      { "sqrt",    "($0 > 0) ? sqrt($0) : 0" },
+      { "pow",     "TMath::Power($0,$1)" },
+      { "cos",     "cos($0)" },   { "TMath::Cos",   "cos($0)" },
+      { "sin",     "sin($0)" },   { "TMath::Sin",   "sin($0)" },
+      { "tan",     "tan($0)" },   { "TMath::Tan",   "tan($0)" },
+      { "acos",    "acos($0)" },  { "TMath::ACos",  "acos($0)" },
+      { "asin",    "asin($0)" },  { "TMath::ASin",  "asin($0)" },
+      { "atan",    "atan($0)" },  { "TMath::ATan",  "atan($0)" },
+      { "atan2",   "atan2($0,$1)" }, { "TMath::ATan2", "atan2($0,$1)" },
+      { "cosh",    "cosh($0)" },  { "TMath::CosH",  "cosh($0)" },
+      { "sinh",    "sinh($0)" },  { "TMath::SinH",  "sinh($0)" },
+      { "tanh",    "tanh($0)" },  { "TMath::TanH",  "tanh($0)" },
+      { "log",     "log($0)" },
+      { "exp",     "exp($0)" },
+      { "log10",   "log10($0)" }
+   };
+   if (!name) return 0;
+   for (UInt_t i = 0; i < sizeof(kInline)/sizeof(kInline[0]); ++i) {
+      if (!strcmp(name, kInline[i][0])) return kInline[i][1];
+   }
+   return 0;
+}
+
+//______________________________________________________________________________
+Bool_t TFormula::JitCompile()
+{
+   // Translate the optimized operation list of the formula (see Optimize)
+   // into a C++ function evaluating the formula for an array of points, and
+   // compile it with the interpreter JIT. Once compiled, EvalParVec calls
+   // this function instead of calling EvalPar for each point.
+   //
+   // The generated code follows EvalParFast operation by operation: the
+   // stack slots become local variables, the jumps become gotos and the
+   // basic primitives (arithmetic, comparisons, cos, exp, ...) are inlined,
+   // the other ones being called through their function pointer. The
+   // function is compiled without floating point contraction, so it returns
+   // exactly the same values as EvalPar.
+   // Formulas which are not optimized, use strings, external function calls
+   // or an operation unknown to the translator are not compiled.
+   // Identical operation lists share the same compiled function.
+   //
+   // Returns true if the formula is now evaluated by a compiled function.
+
+   if (fJitFunc) return kTRUE;
+   if (!gInterpreter || !fOperOptimized || fNOperOptimized < 1) return kFALSE;
+   if (fOptimal == (TFormulaPrimitive::TFuncG)&TFormula::EvalParOld) return kFALSE;
+
+   const Int_t nop = fNOperOptimized;
+   // Jump targets and stack depth at these targets.
+   std::vector<Int_t> depthAt(nop+1,-1);
+   TString body;
+   TString d0, d1, d2;
+   Int_t pos = 0;
+   Int_t maxpos = 0;
+   Bool_t reachable = kTRUE;
+
+   for (Int_t i = 0; i < nop; ++i) {
+      if (depthAt[i] >= 0) {
+         if (!reachable) pos = depthAt[i];
+         body += TString::Format("L%d: ;\n", i);
+         reachable = kTRUE;
+      }
+      if (!reachable) continue;
+
+      const Int_t oper = fOperOptimized[i];
+      const Int_t action = oper >> kTFOperShift;
+      const Int_t param = oper & kTFOperMask;
+      const TOperOffset &off = fOperOffset[i];
+      TString a = TString::Format("t%d", pos-2);
+      TString b = TString::Format("t%d", pos-1);
+      const char *unary = 0;
+      const char *binary = 0;
+      Int_t nargs = 0;
+
+      switch (action) {
+         case kData:
+            if (!R__JitData(off.fType0, off.fOffset0, fConst, d0)) return kFALSE;
+            body += TString::Format("      t%d = %s;\n", pos, d0.Data());
+            ++pos;
+            break;
+         case kPlusD:
+         case kMultD:
+            if (pos < 1 || !R__JitData(off.fType0, off.fOffset0, fConst, d0)) return kFALSE;
+            body += TString::Format("      t%d %s= %s;\n", pos-1, action == kPlusD ? "+" : "*", d0.Data());
+            break;
+
+         case kUnary:
+         case kBinary:
+         case kThree: {
+            nargs = action - kUnary + 1;
+            if (!R__JitData(off.fType0, off.fOffset0, fConst, d0)) return kFALSE;
+            if (nargs > 1 && !R__JitData(off.fType1, off.fOffset1, fConst, d1)) return kFALSE;
+            if (nargs > 2 && !R__JitData(off.fType2, off.fOffset2, fConst, d2)) return kFALSE;
+            ++pos;
+            break;
+         }
+         case kFD1: nargs = 1; break;
+         case kFD2: nargs = 2; break;
+         case kFD3: nargs = 3; break;
+         case kFDM:
+            if (!fPredefined[i]) return kFALSE;
+            body += TString::Format("      t%d = ((FG_t)fn[%d])(x + %d, p + %d);\n", pos, i, off.fType0, off.fOffset0);
+            ++pos;
+            break;
+
+         case kAdd        : binary = "$a + $b"; break;
+         case kSubstract  : binary = "$a - $b"; break;
+         case kMultiply   : binary = "$a * $b"; break;
+         case kDivide     : binary = "($b == 0) ? 0 : $a / $b"; break;
+         case kModulo     : binary = "Double_t(((Long64_t)$a) % ((Long64_t)$b))"; break;
+         case kfmod       : binary = "fmod($a,$b)"; break;
+         case kpow        : binary = "TMath::Power($a,$b)"; break;
+         // The left operand was already checked by kBoolOptimizeAnd/Or.
+         case kAnd        : binary = "$b ? 1 : 0"; break;
+         case kOr         : binary = "$b ? 1 : 0"; break;
+         case kEqual      : binary = "($a == $b) ? 1 : 0"; break;
+         case kNotEqual   : binary = "($a != $b) ? 1 : 0"; break;
+         case kBitAnd     : binary = "((Int_t) $a) & ((Int_t) $b)"; break;
+         case kBitOr      : binary = "((Int_t) $a) | ((Int_t) $b)"; break;
+         case kLeftShift  : binary = "((Int_t) $a) << ((Int_t) $b)"; break;
+         case kRightShift : binary = "((Int_t) $a) >> ((Int_t) $b)"; break;
+
+         case kabs    : unary = "($b < 0) ? -$b : $b"; break;
+         case ksign   : unary = "($b < 0) ? -1 : 1"; break;
+         case kint    : unary = "Double_t(Int_t($b))"; break;
+         case kSignInv: unary = "-1 * $b"; break;
+         case kNot    : unary = "($b != 0) ? 0 : 1"; break;
+
+         case kpi   : body += TString::Format("      t%d = TMath::ACos(-1);\n", pos); ++pos; break;
+         case krndm : body += TString::Format("      t%d = gRandom->Rndm(1);\n", pos); ++pos; break;
+
+         case kBoolOptimizeAnd:
+         case kBoolOptimizeOr: {
+            Int_t target = TMath::Min(Int_t(off.fToJump) + 1, nop);
+            if (pos < 1) return kFALSE;
+            depthAt[target] = pos;
+            body += TString::Format("      if (%st%d) goto L%d;\n", action == kBoolOptimizeAnd ? "!" : "",
+                                    pos-1, target);
+            break;
+         }
+         case kBoolOptimize: {
+            // && skips its right part if the left part is false, || if it is true.
+            Int_t op = param % 10;
+            Int_t target = TMath::Min(i + param / 10 + 1, nop);
+            if (op != 1 && op != 2) break;
+            if (pos < 1) return kFALSE;
+            depthAt[target] = pos;
+            body += TString::Format("      if (%st%d) { t%d = %d; goto L%d; }\n",
+                                    op == 1 ? "!" : "", pos-1, pos-1, op == 1 ? 0 : 1, target);
+            break;
+         }
+         case kJump: {
+            Int_t target = TMath::Min(param + 1, nop);
+            depthAt[target] = pos;
+            body += TString::Format("      goto L%d;\n", target);
+            reachable = kFALSE;
+            break;
+         }
+         case kJumpIf: {
+            Int_t target = TMath::Min(param + 1, nop);
+            --pos;
+            if (pos < 0) return kFALSE;
+            depthAt[target] = pos;
+            body += TString::Format("      if (!t%d) goto L%d;\n", pos, target);
+            break;
+         }
+
+         case kxexpo:
+         case kyexpo:
+         case kzexpo:
+            body += TString::Format("      t%d = TMath::Exp(p[%d]+p[%d]*x[%d]);\n",
+                                    pos, param, param+1, action - kxexpo);
+            ++pos;
+            break;
+         case kxyexpo:
+            body += TString::Format("      t%d = TMath::Exp(p[%d]+p[%d]*x[0]+p[%d]*x[1]);\n",
+                                    pos, param, param+1, param+2);
+            ++pos;
+            break;
+         case kxgaus:
+         case kygaus:
+         case kzgaus:
+            body += TString::Format("      t%d = p[%d]*TMath::Gaus(x[%d],p[%d],p[%d],norm);\n",
+                                    pos, param, action - kxgaus, param+1, param+2);
+            ++pos;
+            break;
+         case kxygaus:
+            body += TString::Format("      {\n"
+                                    "         Double_t u1 = (p[%d] == 0) ? 1e10 : Double_t((x[0]-p[%d])/p[%d]);\n"
+                                    "         Double_t u2 = (p[%d] == 0) ? 1e10 : Double_t((x[1]-p[%d])/p[%d]);\n"
+                                    "         t%d = p[%d]*TMath::Exp(-0.5*(u1*u1+u2*u2));\n"
+                                    "      }\n",
+                                    param+2, param+1, param+2, param+4, param+3, param+4, pos, param);
+            ++pos;
+            break;
+         case kxlandau:
+         case kylandau:
+         case kzlandau:
+            body += TString::Format("      t%d = p[%d]*TMath::Landau(x[%d],p[%d],p[%d],norm);\n",
+                                    pos, param, action - kxlandau, param+1, param+2);
+            ++pos;
+            break;
+         case kxylandau:
+            body += TString::Format("      t%d = p[%d]*TMath::Landau(x[0],p[%d],p[%d],norm)"
+                                    "*TMath::Landau(x[1],p[%d],p[%d],norm);\n",
+                                    pos, param, param+1, param+2, param+3, param+4);
+            ++pos;
+            break;
+         case kxpol:
+         case kypol:
+         case kzpol: {
+            Int_t degree = param/100;
+            Int_t first = param - degree*100 - 1;
+            body += TString::Format("      t%d = 0;\n      {\n         Double_t u = 1;\n", pos);
+            for (Int_t j = 0; j <= degree; ++j) {
+               body += TString::Format("         t%d += u*p[%d]; u *= x[%d];\n", pos, first + j, action - kxpol);
+            }
+            body += "      }\n";
+            ++pos;
+            break;
+         }
+
+         default:
+            // Strings, function calls, defined variables, ...
+            return kFALSE;
+      }
+      if (nargs) {
+         // Primitive function: inline it if possible.
+         TFormulaPrimitive *prim = fPredefined[i];
+         if (!prim) return kFALSE;
+         TString args[3];
+         TString target;
+         if (action >= kUnary && action <= kThree) {
+            args[0] = d0; args[1] = d1; args[2] = d2;
+            target.Form("t%d", pos-1);
+         } else {
+            pos -= nargs - 1;
+            if (pos < 1) return kFALSE;
+            for (Int_t k = 0; k < nargs; ++k) args[k].Form("t%d", pos-1+k);
+            target.Form("t%d", pos-1);
+         }
+         TString expr;
+         const char *inlined = R__JitPrimitive(prim->GetName());
+         if (inlined) {
+            expr = inlined;
+         } else {
+            static const char *const kCall[3] = { "((F1_t)fn[%d])($0)", "((F2_t)fn[%d])($0,$1)",
+                                                  "((F3_t)fn[%d])($0,$1,$2)" };
+            expr.Form(kCall[nargs-1], i);
+         }
+         if ((expr.Contains("$1") && nargs < 2) || (expr.Contains("$2") && nargs < 3)) return kFALSE;
+         expr.ReplaceAll("$0", args[0]);
+         expr.ReplaceAll("$1", args[1]);
+         expr.ReplaceAll("$2", args[2]);
+         body += TString::Format("      %s = %s;\n", target.Data(), expr.Data());
+      } else if (binary) {
+         if (pos < 2) return kFALSE;
+         TString expr(binary);
+         expr.ReplaceAll("$a", a);
+         expr.ReplaceAll("$b", b);
+         body += TString::Format("      %s = %s;\n", a.Data(), expr.Data());
+         --pos;
+      } else if (unary) {
+         if (pos < 1) return kFALSE;
+         TString expr(unary);
+         expr.ReplaceAll("$b", b);
+         body += TString::Format("      %s = %s;\n", b.Data(), expr.Data());
+      }
+      if (pos < 0) return kFALSE;
+      if (pos > maxpos) maxpos = pos;
+   }
+   if (depthAt[nop] >= 0) body += TString::Format("L%d: ;\n", nop);
+   if (maxpos == 0) return kFALSE;
+
+   TString decl("      Double_t t0 = 0");
+   for (Int_t k = 1; k < maxpos; ++k) decl += TString::Format(", t%d = 0", k);
+   decl += ";\n";
+   body.Prepend(decl);
+   body += "      result[i] = t0;\n";
+
+   // The primitive functions are passed to the compiled function, which can
+   // then be shared by formulas calling different primitives.
+   if (fJitPrimitives) delete [] fJitPrimitives;
+   fJitPrimitives = new void*[nop];
+   for (Int_t i = 0; i < nop; ++i) fJitPrimitives[i] = fPredefined[i] ? (void*)fPredefined[i]->fFuncG : 0;
+
+   // Each distinct operation list is compiled only once (see TInterpreter::CompileFunction).
+   TString code = TString::Format("#pragma STDC FP_CONTRACT OFF\n"
+                                  "   typedef Double_t (*F1_t)(Double_t);\n"
+                                  "   typedef Double_t (*F2_t)(Double_t,Double_t);\n"
+                                  "   typedef Double_t (*F3_t)(Double_t,Double_t,Double_t);\n"
+                                  "   typedef Double_t (*FG_t)(const Double_t*,const Double_t*);\n"
+                                  "   for (Int_t i = 0; i < n; ++i, x += stride) {\n"
+                                  "%s   }\n",
+                                  body.Data());
+   fJitFunc = (void*)gInterpreter->CompileFunction("R__TFormula_jit",
+                                                   "void $name(Int_t n, const Double_t *x, Int_t stride, const Double_t *p,\n"
+                                                   "   void * const *fn, Bool_t norm, Double_t *result)",
+                                                   code, "TMath.h TRandom.h");
+   if (gDebug > 0 && !fJitFunc) Info("JitCompile", "could not compile formula %s", GetTitle());
+   return fJitFunc != 0;
+}
+
 
 //______________________________________________________________________________
 Int_t TFormula::PreCompile()
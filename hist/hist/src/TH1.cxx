@@ -13,6 +13,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <map>
+#include <vector>
 
 #include "Riostream.h"
 #include "TROOT.h"
@@ -38,6 +40,8 @@
 #include "TVirtualHistPainter.h"
 #include "TVirtualFFT.h"
 #include "TSystem.h"
+#include "TVirtualMutex.h"
+#include "ThreadLocalStorage.h"
 
 #include "HFitInterface.h"
 #include "Fit/DataRange.h"
@@ -541,6 +545,159 @@ class DifferentAxisLimits: public std::exception {};
 class DifferentBinLimits: public std::exception {};
 class DifferentLabels: public std::exception {};
 
+//______________________________________________________________________________
+//
+// TH1ConcurrentFill
+//
+// Fill buffers of a histogram filled from several threads at the same time
+// (see TH1::SetConcurrentFill). Each thread filling the histogram appends
+// its entries to its own buffer; the buffers are replayed into the
+// histogram, one thread at a time, when they are full and when the
+// histogram is read.
+// The buffers belong to the histogram and are deleted with it. A thread
+// only keeps, in thread local storage, its number and the last buffer it
+// used.
+//
+class TH1ConcurrentFill {
+public:
+   enum { kEntrySize = 5 };              // nargs and up to 4 arguments per entry
+
+   struct Buffer_t {
+      TVirtualMutex         *fMutex;     // protects fEntries (owner thread and flushes)
+      std::vector<Double_t>  fEntries;   // entries not yet in the histogram
+   };
+   struct ThreadState_t {
+      Long64_t                 fThread;   // number of this thread, 0 until it fills a histogram
+      Long64_t                 fLastId;   // session of fLast
+      Buffer_t                *fLast;     // last buffer used by this thread
+      const TH1ConcurrentFill *fFlushing; // session being flushed by this thread
+   };
+
+   TVirtualMutex                *fMutex;        // serializes the updates of the histogram
+   TVirtualMutex                *fBuffersMutex; // protects fBuffers
+   std::map<Long64_t,Buffer_t*>  fBuffers;      // buffer of each filling thread, by thread number
+   Long64_t                      fId;           // unique identifier of this fill session
+   UInt_t                        fSize;         // number of entries in a buffer before it is flushed
+
+   TH1ConcurrentFill(Int_t buffersize);
+   ~TH1ConcurrentFill();
+
+   Buffer_t              *GetBuffer(ThreadState_t *state);
+   void                   Flush(TH1 *h, Buffer_t *buffer = 0);
+   static ThreadState_t  *GetThreadState();
+};
+
+TTHREAD_TLS_DECLARE(TH1ConcurrentFill::ThreadState_t,gH1FillState);
+
+//______________________________________________________________________________
+TH1ConcurrentFill::TH1ConcurrentFill(Int_t buffersize)
+{
+   // Create the fill buffers. The thread library must be initialized.
+
+   static Long64_t lastId = 0;
+
+   fMutex        = gGlobalMutex->Factory(kTRUE);
+   fBuffersMutex = gGlobalMutex->Factory(kFALSE);
+   fSize         = buffersize > 0 ? buffersize : 1;
+   R__LOCKGUARD(gGlobalMutex);
+   fId = ++lastId;
+}
+
+//______________________________________________________________________________
+TH1ConcurrentFill::~TH1ConcurrentFill()
+{
+   // Delete the buffers. The entries not yet flushed are lost.
+
+   std::map<Long64_t,Buffer_t*>::iterator iter;
+   for (iter = fBuffers.begin(); iter != fBuffers.end(); ++iter) {
+      delete iter->second->fMutex;
+      delete iter->second;
+   }
+   delete fBuffersMutex;
+   delete fMutex;
+}
+
+//______________________________________________________________________________
+TH1ConcurrentFill::ThreadState_t *TH1ConcurrentFill::GetThreadState()
+{
+   // Return the state of the calling thread, which is released with the
+   // thread. The cached buffer of a deleted histogram is never used again
+   // since the session identifiers are not reused.
+
+   TTHREAD_TLS_INIT(ThreadState_t,gH1FillState,ThreadState_t());
+   ThreadState_t *state = &TTHREAD_TLS_GET(ThreadState_t,gH1FillState);
+   if (!state->fThread) {
+      static Long64_t lastThread = 0;
+      R__LOCKGUARD(gGlobalMutex);
+      state->fThread = ++lastThread;
+   }
+   return state;
+}
+
+//______________________________________________________________________________
+TH1ConcurrentFill::Buffer_t *TH1ConcurrentFill::GetBuffer(ThreadState_t *state)
+{
+   // Return the buffer of the calling thread, creating it on first use.
+
+   if (state->fLastId == fId) return state->fLast;
+   Buffer_t *buffer = 0;
+   {
+      R__LOCKGUARD(fBuffersMutex);
+      Buffer_t *&entry = fBuffers[state->fThread];
+      if (!entry) {
+         entry = new Buffer_t;
+         entry->fMutex = gGlobalMutex->Factory(kFALSE);
+         entry->fEntries.reserve(kEntrySize*fSize);
+      }
+      buffer = entry;
+   }
+   state->fLastId = fId;
+   state->fLast   = buffer;
+   return buffer;
+}
+
+//______________________________________________________________________________
+void TH1ConcurrentFill::Flush(TH1 *h, Buffer_t *buffer)
+{
+   // Replay the entries of the given buffer (by default of all the buffers)
+   // into the histogram. The buffers are swapped out under their own lock
+   // so that their threads can keep on filling during the replay.
+
+   R__LOCKGUARD(fMutex);
+   ThreadState_t *state = GetThreadState();
+   // Filling the histogram from the replay itself (e.g. a Reset while
+   // extending an axis) must not flush again.
+   if (state->fFlushing == this) return;
+   const TH1ConcurrentFill *previous = state->fFlushing;
+   state->fFlushing = this;
+
+   // The buffers are only deleted with the histogram, their list can be
+   // released while replaying them.
+   std::vector<Buffer_t*> buffers;
+   if (buffer) {
+      buffers.push_back(buffer);
+   } else {
+      R__LOCKGUARD(fBuffersMutex);
+      std::map<Long64_t,Buffer_t*>::iterator iter;
+      for (iter = fBuffers.begin(); iter != fBuffers.end(); ++iter) buffers.push_back(iter->second);
+   }
+
+   std::vector<Double_t> entries;
+   for (UInt_t i = 0; i < buffers.size(); ++i) {
+      Buffer_t *b = buffers[i];
+      {
+         R__LOCKGUARD(b->fMutex);
+         if (b->fEntries.empty()) continue;
+         entries.swap(b->fEntries);
+      }
+      const Double_t *e = &entries[0];
+      const Double_t *end = e + entries.size();
+      for (; e < end; e += kEntrySize) h->FillFromThreadBuffer((Int_t)e[0], e+1);
+      entries.clear();
+   }
+   state->fFlushing = previous;
+}
+
 ClassImp(TH1)
 
 
@@ -562,6 +719,7 @@ TH1::TH1(): TNamed(), TAttLine(), TAttFill(), TAttMarker()
    fBufferSize    = 0;
    fBuffer        = 0;
    fBinStatErrOpt = kNormal;
+   fConcurrentFill = 0;
    fXaxis.SetName("xaxis");
    fYaxis.SetName("yaxis");
    fZaxis.SetName("zaxis");
@@ -584,6 +742,8 @@ TH1::~TH1()
    fIntegral = 0;
    delete[] fBuffer;
    fBuffer = 0;
+   delete fConcurrentFill;
+   fConcurrentFill = 0;
    if (fFunctions) {
       fFunctions->SetBit(kInvalidObject);
       TObject* obj = 0;
@@ -697,6 +857,7 @@ TH1::TH1(const TH1 &h) : TNamed(), TAttLine(), TAttFill(), TAttMarker()
    // Copy constructor.
    // The list of functions is not copied. (Use Clone if needed)
 
+   fConcurrentFill = 0;
    ((TH1&)h).Copy(*this);
 }
 
@@ -735,6 +896,7 @@ void TH1::Build()
    fBufferSize    = 0;
    fBuffer        = 0;
    fBinStatErrOpt = kNormal;
+   fConcurrentFill = 0;
    fXaxis.SetName("xaxis");
    fYaxis.SetName("yaxis");
    fZaxis.SetName("zaxis");
@@ -793,7 +955,7 @@ Bool_t TH1::Add(TF1 *f1, Double_t c1, Option_t *option)
    if (fDimension < 3) ncellsz = 1;
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    //   - Add statistics
    Double_t s1[10];
@@ -868,7 +1030,7 @@ Bool_t TH1::Add(const TH1 *h1, Double_t c1)
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    try {
       CheckConsistency(this,h1);
@@ -1006,7 +1168,7 @@ Bool_t TH1::Add(const TH1 *h1, const TH1 *h2, Double_t c1, Double_t c2)
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    Bool_t normWidth = kFALSE;
    if (h1 == h2 && c2 < 0) {c2 = 0; normWidth = kTRUE;}
@@ -1197,6 +1359,9 @@ Int_t TH1::BufferEmpty(Int_t action)
    //             larger than the buffer size
    //
 
+   // fill first the entries of the concurrent fill buffers
+   if (fConcurrentFill) FlushConcurrentFill();
+
    // do we need to compute the bin size?
    if (!fBuffer) return 0;
    Int_t nbentries = (Int_t)fBuffer[0];
@@ -1292,6 +1457,111 @@ Int_t TH1::BufferFill(Double_t x, Double_t w)
    return -2;
 }
 
+//______________________________________________________________________________
+Bool_t TH1::ConcurrentFill(Int_t nargs, Double_t a0, Double_t a1, Double_t a2, Double_t a3)
+{
+   // Append a Fill call with nargs arguments to the fill buffer of the
+   // calling thread (see SetConcurrentFill). The buffer is flushed into the
+   // histogram when it is full.
+   // Returns false if the entry must be filled directly, i.e. when the
+   // calling thread is replaying the buffers into this histogram.
+
+   TH1ConcurrentFill::ThreadState_t *state = TH1ConcurrentFill::GetThreadState();
+   if (state->fFlushing == fConcurrentFill) return kFALSE;
+   TH1ConcurrentFill::Buffer_t *buffer = fConcurrentFill->GetBuffer(state);
+   Bool_t full;
+   {
+      R__LOCKGUARD(buffer->fMutex);
+      std::vector<Double_t> &entries = buffer->fEntries;
+      entries.push_back(nargs);
+      entries.push_back(a0);
+      entries.push_back(a1);
+      entries.push_back(a2);
+      entries.push_back(a3);
+      full = entries.size() >= TH1ConcurrentFill::kEntrySize*fConcurrentFill->fSize;
+   }
+   if (full) fConcurrentFill->Flush(this, buffer);
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+void TH1::FillFromThreadBuffer(Int_t nargs, const Double_t *args)
+{
+   // Fill the histogram with an entry of a thread fill buffer, made by the
+   // Fill call with nargs arguments (see ConcurrentFill).
+
+   if (nargs == 1) Fill(args[0]);
+   else            Fill(args[0], args[1]);
+}
+
+//______________________________________________________________________________
+void TH1::FlushConcurrentFill()
+{
+   // Fill the histogram with the entries waiting in the fill buffers of all
+   // the threads (see SetConcurrentFill). This is done automatically when
+   // the histogram is read (GetBinContent, GetEntries, GetMean, Draw,
+   // Write, ...).
+
+   if (fConcurrentFill) fConcurrentFill->Flush(this);
+}
+
+//______________________________________________________________________________
+TVirtualMutex *TH1::GetConcurrentFillMutex() const
+{
+   // Return the mutex serializing the updates of the histogram when it is
+   // filled concurrently, 0 otherwise.
+
+   return fConcurrentFill ? fConcurrentFill->fMutex : 0;
+}
+
+//______________________________________________________________________________
+void TH1::SetConcurrentFill(Bool_t enable, Int_t buffersize)
+{
+   // Allow (enable=kTRUE) or forbid the filling of this histogram from
+   // several threads at the same time.
+   //
+   // In this mode, Fill and FillN do not update the histogram: they append
+   // the entry to a fill buffer owned by the calling thread, which does not
+   // require any synchronization with the other threads. When a buffer
+   // holds buffersize entries, it is replayed into the histogram, one
+   // thread at a time. The buffers of all the threads are also replayed
+   // before the histogram is read (GetBinContent, GetEntries, GetMean, Fit,
+   // Draw, Write, ...) or by calling FlushConcurrentFill. The Fill calls
+   // are replayed as they were made, so the bin contents and the
+   // statistics (fEntries, fTsumw, fTsumwx, ...) are exact and no Merge of
+   // per thread copies is needed. Fill returns -2 for a buffered entry,
+   // as with SetBuffer.
+   // The histogram should be read once the filling threads are done (or at
+   // least from the filling threads), since a read concurrent with a Fill
+   // sees the entries flushed so far only.
+   //
+   // The thread library must be initialized (TThread::Initialize()) before
+   // enabling this mode. It is supported by TH1, TH2, TH3 and TProfile
+   // and their derived classes (except TProfile2D, TProfile3D and TH2Poly).
+   // The automatic buffer (SetBuffer) cannot be used at the same time.
+   //
+   // Disabling the mode flushes the buffers.
+
+   if (!enable) {
+      if (!fConcurrentFill) return;
+      FlushConcurrentFill();
+      delete fConcurrentFill;
+      fConcurrentFill = 0;
+      return;
+   }
+   if (fConcurrentFill) return;
+   if (InheritsFrom("TProfile2D") || InheritsFrom("TProfile3D") || InheritsFrom("TH2Poly")) {
+      Error("SetConcurrentFill", "concurrent filling is not supported for %s", IsA()->GetName());
+      return;
+   }
+   if (!gGlobalMutex) {
+      Error("SetConcurrentFill", "the thread library is not initialized, call TThread::Initialize() first");
+      return;
+   }
+   if (fBuffer) BufferEmpty(1);
+   fConcurrentFill = new TH1ConcurrentFill(buffersize);
+}
+
 
 //______________________________________________________________________________
 bool TH1::CheckBinLimits(const TAxis* a1, const TAxis * a2)
@@ -2349,6 +2619,7 @@ void TH1::Copy(TObject &obj) const
    // Note that this function does not copy the list of associated functions.
    // Use TObject::Clone to make a full copy of an histogram.
 
+   if (fConcurrentFill) ((TH1*)this)->FlushConcurrentFill();
    if (((TH1&)obj).fDirectory) {
       // We are likely to change the hash value of this object
       // with TNamed::Copy, to keep things correct, we need to
@@ -2471,7 +2742,7 @@ Bool_t TH1::Divide(TF1 *f1, Double_t c1)
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    Int_t nx = GetNbinsX() + 2; // normal bins + uf / of
    Int_t ny = GetNbinsY() + 2;
@@ -2540,7 +2811,7 @@ Bool_t TH1::Divide(const TH1 *h1)
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    try {
       CheckConsistency(this,h1);
@@ -2613,7 +2884,7 @@ Bool_t TH1::Divide(const TH1 *h1, const TH1 *h2, Double_t c1, Double_t c2, Optio
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    try {
       CheckConsistency(h1,h2);
@@ -2846,7 +3117,7 @@ void TH1::Eval(TF1 *f1, Option_t *option)
    else                   range = 0;
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    Int_t nbinsx  = fXaxis.GetNbins();
    Int_t nbinsy  = fYaxis.GetNbins();
@@ -2990,6 +3261,7 @@ Int_t TH1::Fill(Double_t x)
    //
    //    The function returns the corresponding bin number which has its content incremented by 1
 
+   if (fConcurrentFill && ConcurrentFill(1,x)) return -2;
    if (fBuffer) return BufferFill(x,1);
 
    Int_t bin;
@@ -3023,6 +3295,7 @@ Int_t TH1::Fill(Double_t x, Double_t w)
    //
    //    The function returns the corresponding bin number which has its content incremented by w
 
+   if (fConcurrentFill && ConcurrentFill(2,x,w)) return -2;
    if (fBuffer) return BufferFill(x,w);
 
    Int_t bin;
@@ -3059,6 +3332,7 @@ Int_t TH1::Fill(const char *namex, Double_t w)
    // The function returns the corresponding bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t bin;
    fEntries++;
    bin =fXaxis.FindBin(namex);
@@ -3105,25 +3379,38 @@ void TH1::FillN(Int_t ntimes, const Double_t *x, const Double_t *w, Int_t stride
    //   return;
    //}
 
+   if (ntimes > 0 && fConcurrentFill && ConcurrentFill(2,x[0],w ? w[0] : 1)) {
+      for (i=1;i<ntimes;i++) ConcurrentFill(2,x[i*stride],w ? w[i*stride] : 1);
+      return;
+   }
    fEntries += ntimes;
    Double_t ww = 1;
    Int_t nbins   = fXaxis.GetNbins();
+   // if the axis cannot be extended, the bins of a block of entries are
+   // found at once with TAxis::FindFixBins
+   Bool_t batch = !fXaxis.CanExtend();
+   Int_t bins[kNFillNBlock];
+   Int_t first, last, k;
    ntimes *= stride;
-   for (i=0;i<ntimes;i+=stride) {
-      bin =fXaxis.FindBin(x[i]);
-      if (bin <0) continue;
-      if (w) ww = w[i];
-      if (!fSumw2.fN && ww != 1.0)  Sumw2();
-      if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
-      AddBinContent(bin, ww);
-      if (bin == 0 || bin > nbins) {
-         if (!fgStatOverflows) continue;
+   for (first=0;first<ntimes;first=last) {
+      last = TMath::Min(ntimes, first + kNFillNBlock*stride);
+      if (batch) fXaxis.FindFixBins((last-first+stride-1)/stride, x+first, bins, stride);
+      for (i=first,k=0;i<last;i+=stride,k++) {
+         bin = batch ? bins[k] : fXaxis.FindBin(x[i]);
+         if (bin <0) continue;
+         if (w) ww = w[i];
+         if (!fSumw2.fN && ww != 1.0)  Sumw2();
+         if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
+         AddBinContent(bin, ww);
+         if (bin == 0 || bin > nbins) {
+            if (!fgStatOverflows) continue;
+         }
+         Double_t z= ww;
+         fTsumw   += z;
+         fTsumw2  += z*z;
+         fTsumwx  += z*x[i];
+         fTsumwx2 += z*x[i]*x[i];
       }
-      Double_t z= ww;
-      fTsumw   += z;
-      fTsumw2  += z*z;
-      fTsumwx  += z*x[i];
-      fTsumwx2 += z*x[i]*x[i];
    }
 }
 
@@ -3709,7 +3996,7 @@ TFitResultPtr TH1::Fit(TF1 *f1 ,Option_t *option ,Option_t *goption, Double_t xx
 
    // need to empty the buffer before
    // (t.b.d. do a ML unbinned fit with buffer data)
-   if (fBuffer) BufferEmpty();
+   if (fBuffer || fConcurrentFill) BufferEmpty();
 
    return ROOT::Fit::FitObject(this, f1 , fitOption , minOption, goption, range);
 }
@@ -3798,9 +4085,9 @@ TH1 *TH1::GetAsymmetry(TH1* h2, Double_t c2, Double_t dc2)
    Int_t   ymax = asym->GetNbinsY();
    Int_t   zmax = asym->GetNbinsZ();
 
-   if (h1->fBuffer) h1->BufferEmpty(1);
-   if (h2->fBuffer) h2->BufferEmpty(1);
-   if (bottom->fBuffer) bottom->BufferEmpty(1);
+   if (h1->fBuffer || h1->fConcurrentFill) h1->BufferEmpty(1);
+   if (h2->fBuffer || h2->fConcurrentFill) h2->BufferEmpty(1);
+   if (bottom->fBuffer || bottom->fConcurrentFill) bottom->BufferEmpty(1);
 
    // now loop over bins to calculate the correct errors
    // the reason this error calculation looks complex is because of c2
@@ -3862,6 +4149,7 @@ Double_t TH1::GetEntries() const
 {
    // return the current number of entries
 
+   if (fConcurrentFill) ((TH1*)this)->FlushConcurrentFill();
    if (fBuffer) {
       Int_t nentries = (Int_t) fBuffer[0];
       if (nentries > 0) return nentries;
@@ -4432,7 +4720,7 @@ Double_t TH1::GetBinContent(Int_t bin) const
    //      returns a global/linearized bin number. This global bin is useful
    //      to access the bin information independently of the dimension.
 
-   if (fBuffer) const_cast<TH1*>(this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) const_cast<TH1*>(this)->BufferEmpty();
    if (bin < 0) bin = 0;
    if (bin >= fNcells) bin = fNcells-1;
 
@@ -5359,7 +5647,7 @@ Bool_t TH1::Multiply(TF1 *f1, Double_t c1)
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    Int_t nx = GetNbinsX() + 2; // normal bins + uf / of (cells)
    Int_t ny = GetNbinsY() + 2;
@@ -5422,7 +5710,7 @@ Bool_t TH1::Multiply(const TH1 *h1)
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    try {
       CheckConsistency(this,h1);
@@ -5485,7 +5773,7 @@ Bool_t TH1::Multiply(const TH1 *h1, const TH1 *h2, Double_t c1, Double_t c2, Opt
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    try {
       CheckConsistency(h1,h2);
@@ -5899,7 +6187,7 @@ void TH1::Scale(Double_t c1, Option_t *option)
    TString opt = option; opt.ToLower();
    if (opt.Contains("width")) Add(this, this, c1, -1);
    else {
-      if (fBuffer) BufferEmpty(1);
+      if (fBuffer || fConcurrentFill) BufferEmpty(1);
       for(Int_t i = 0; i < fNcells; ++i) UpdateBinContent(i, c1 * RetrieveBinContent(i));
       if (fSumw2.fN) for(Int_t i = 0; i < fNcells; ++i) fSumw2.fArray[i] *= (c1 * c1); // update errors
       SetMinimum(); SetMaximum(); // minimum and maximum value will be recalculated the next time
@@ -6220,7 +6508,7 @@ void  TH1::Smooth(Int_t ntimes, Option_t *option)
    }
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    Int_t firstbin = 1, lastbin = nbins;
    TString opt = option;
@@ -6326,6 +6614,7 @@ void TH1::Streamer(TBuffer &b)
       b.CheckByteCount(R__s, R__c, TH1::IsA());
 
    } else {
+      if (fConcurrentFill) FlushConcurrentFill();
       b.WriteClassBuffer(TH1::Class(),this);
    }
 }
@@ -6457,6 +6746,7 @@ void TH1::Reset(Option_t *option)
    // BufferEmpty will update contents that later will be
    // reset in calling TH1D::Reset. For this we need to reset the stats afterwards
    // It may be needed for computing the axis limits....
+   if (fConcurrentFill) FlushConcurrentFill();
    if (fBuffer) {BufferEmpty(); fBuffer[0] = 0;}
 
    // need to reset also the statistics
@@ -7031,7 +7321,7 @@ void TH1::GetStats(Double_t *stats) const
    //  call the static function TH1::StatOverflows(kTRUE) before filling
    //  the histogram.
 
-   if (fBuffer) ((TH1*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TH1*)this)->BufferEmpty();
 
    // Loop on bins (possibly including underflows/overflows)
    Int_t bin, binx;
@@ -7528,6 +7818,11 @@ void TH1::SetBuffer(Int_t buffersize, Option_t * /*option*/)
       fBufferSize = 0;
       return;
    }
+   if (fConcurrentFill) {
+      Warning("SetBuffer", "the histogram is filled concurrently, no buffer is used");
+      fBufferSize = 0;
+      return;
+   }
    if (buffersize < 100) buffersize = 100;
    fBufferSize = 1 + buffersize*(fDimension+1);
    fBuffer = new Double_t[fBufferSize];
@@ -8053,7 +8348,7 @@ Double_t TH1::GetBinError(Int_t bin) const
 
    if (bin < 0) bin = 0;
    if (bin >= fNcells) bin = fNcells-1;
-   if (fBuffer) ((TH1*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TH1*)this)->BufferEmpty();
    if (fSumw2.fN) return TMath::Sqrt(fSumw2.fArray[bin]);
 
    return TMath::Sqrt(TMath::Abs(RetrieveBinContent(bin)));
@@ -8071,7 +8366,7 @@ Double_t TH1::GetBinErrorLow(Int_t bin) const
    if (fBinStatErrOpt == kNormal || fSumw2.fN) return GetBinError(bin);
    if (bin < 0) bin = 0;
    if (bin >= fNcells) bin = fNcells-1;
-   if (fBuffer) ((TH1*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TH1*)this)->BufferEmpty();
 
    Double_t alpha = 1.- 0.682689492;
    if (fBinStatErrOpt == kPoisson2) alpha = 0.05;
@@ -8100,7 +8395,7 @@ Double_t TH1::GetBinErrorUp(Int_t bin) const
    if (fBinStatErrOpt == kNormal || fSumw2.fN) return GetBinError(bin);
    if (bin < 0) bin = 0;
    if (bin >= fNcells) bin = fNcells-1;
-   if (fBuffer) ((TH1*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TH1*)this)->BufferEmpty();
 
    Double_t alpha = 1.- 0.682689492;
    if (fBinStatErrOpt == kPoisson2) alpha = 0.05;
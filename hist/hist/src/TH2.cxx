@@ -24,6 +24,7 @@
 #include "TMath.h"
 #include "TObjString.h"
 #include "TVirtualHistPainter.h"
+#include "TVirtualMutex.h"
 
 
 ClassImp(TH2)
@@ -162,6 +163,9 @@ Int_t TH2::BufferEmpty(Int_t action)
    //             The buffer is automatically deleted when the number of entries
    //             in the buffer is greater than the number of entries in the histogram
 
+   // fill first the entries of the concurrent fill buffers
+   if (fConcurrentFill) FlushConcurrentFill();
+
    // do we need to compute the bin size?
    if (!fBuffer) return 0;
    Int_t nbentries = (Int_t)fBuffer[0];
@@ -256,6 +260,16 @@ Int_t TH2::BufferFill(Double_t x, Double_t y, Double_t w)
    return -3;
 }
 
+//______________________________________________________________________________
+void TH2::FillFromThreadBuffer(Int_t nargs, const Double_t *args)
+{
+   // Fill the histogram with an entry of a thread fill buffer, made by the
+   // Fill call with nargs arguments (see TH1::SetConcurrentFill).
+
+   if (nargs == 2) Fill(args[0], args[1]);
+   else            Fill(args[0], args[1], args[2]);
+}
+
 
 //______________________________________________________________________________
 void TH2::Copy(TObject &obj) const
@@ -297,6 +311,7 @@ Int_t TH2::Fill(Double_t x,Double_t y)
    // The function returns the corresponding global bin number which has its content
    // incremented by 1
 
+   if (fConcurrentFill && ConcurrentFill(2,x,y)) return -2;
    if (fBuffer) return BufferFill(x,y,1);
 
    Int_t binx, biny, bin;
@@ -341,6 +356,7 @@ Int_t TH2::Fill(Double_t x, Double_t y, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   if (fConcurrentFill && ConcurrentFill(3,x,y,w)) return -2;
    if (fBuffer) return BufferFill(x,y,w);
 
    Int_t binx, biny, bin;
@@ -387,6 +403,7 @@ Int_t TH2::Fill(const char *namex, const char *namey, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, bin;
    fEntries++;
    binx = fXaxis.FindBin(namex);
@@ -429,6 +446,7 @@ Int_t TH2::Fill(const char *namex, Double_t y, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, bin;
    fEntries++;
    binx = fXaxis.FindBin(namex);
@@ -472,6 +490,7 @@ Int_t TH2::Fill(Double_t x, const char *namey, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, bin;
    fEntries++;
    binx = fXaxis.FindBin(x);
@@ -516,33 +535,54 @@ void TH2::FillN(Int_t ntimes, const Double_t *x, const Double_t *y, const Double
    //
    // NB: function only valid for a TH2x object
 
+   if (ntimes > 0 && fConcurrentFill && ConcurrentFill(3,x[0],y[0],w ? w[0] : 1)) {
+      for (Int_t k=1;k<ntimes;k++) ConcurrentFill(3,x[k*stride],y[k*stride],w ? w[k*stride] : 1);
+      return;
+   }
    Int_t binx, biny, bin, i;
    fEntries += ntimes;
    Double_t ww = 1;
+   // if no axis can be extended, the bins of a block of entries are
+   // found at once with TAxis::FindFixBins
+   Bool_t batch = !fXaxis.CanExtend() && !fYaxis.CanExtend();
+   Int_t binsx[kNFillNBlock], binsy[kNFillNBlock];
+   Int_t first, last, k;
    ntimes *= stride;
-   for (i=0;i<ntimes;i+=stride) {
-      binx = fXaxis.FindBin(x[i]);
-      biny = fYaxis.FindBin(y[i]);
-      if (binx <0 || biny <0) continue;
-      bin  = biny*(fXaxis.GetNbins()+2) + binx;
-      if (w) ww = w[i];
-      if (!fSumw2.fN && ww != 1.0)  Sumw2();
-      if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
-      AddBinContent(bin,ww);
-      if (binx == 0 || binx > fXaxis.GetNbins()) {
-         if (!fgStatOverflows) continue;
+   for (first=0;first<ntimes;first=last) {
+      last = TMath::Min(ntimes, first + kNFillNBlock*stride);
+      if (batch) {
+         fXaxis.FindFixBins((last-first+stride-1)/stride, x+first, binsx, stride);
+         fYaxis.FindFixBins((last-first+stride-1)/stride, y+first, binsy, stride);
       }
-      if (biny == 0 || biny > fYaxis.GetNbins()) {
-         if (!fgStatOverflows) continue;
+      for (i=first,k=0;i<last;i+=stride,k++) {
+         if (batch) {
+            binx = binsx[k];
+            biny = binsy[k];
+         } else {
+            binx = fXaxis.FindBin(x[i]);
+            biny = fYaxis.FindBin(y[i]);
+         }
+         if (binx <0 || biny <0) continue;
+         bin  = biny*(fXaxis.GetNbins()+2) + binx;
+         if (w) ww = w[i];
+         if (!fSumw2.fN && ww != 1.0)  Sumw2();
+         if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
+         AddBinContent(bin,ww);
+         if (binx == 0 || binx > fXaxis.GetNbins()) {
+            if (!fgStatOverflows) continue;
+         }
+         if (biny == 0 || biny > fYaxis.GetNbins()) {
+            if (!fgStatOverflows) continue;
+         }
+         Double_t z= ww; //(ww > 0 ? ww : -ww);
+         fTsumw   += z;
+         fTsumw2  += z*z;
+         fTsumwx  += z*x[i];
+         fTsumwx2 += z*x[i]*x[i];
+         fTsumwy  += z*y[i];
+         fTsumwy2 += z*y[i]*y[i];
+         fTsumwxy += z*x[i]*y[i];
       }
-      Double_t z= ww; //(ww > 0 ? ww : -ww);
-      fTsumw   += z;
-      fTsumw2  += z*z;
-      fTsumwx  += z*x[i];
-      fTsumwx2 += z*x[i]*x[i];
-      fTsumwy  += z*y[i];
-      fTsumwy2 += z*y[i]*y[i];
-      fTsumwxy += z*x[i]*y[i];
    }
 }
 
@@ -1080,7 +1120,7 @@ void TH2::GetStats(Double_t *stats) const
    //  call the static function TH1::StatOverflows(kTRUE) before filling
    //  the histogram.
 
-   if (fBuffer) ((TH2*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TH2*)this)->BufferEmpty();
 
    if ((fTsumw == 0 && fEntries > 0) || fXaxis.TestBit(TAxis::kAxisRange) || fYaxis.TestBit(TAxis::kAxisRange)) {
       std::fill(stats, stats + 7, 0);
@@ -25,6 +25,224 @@
 #include <stdio.h>
 #include <ctype.h>
 #include "Riostream.h"
+#include <algorithm>
+#include <vector>
+
+
+//______________________________________________________________________________
+//
+// TH2PolyIndex
+//
+// Bounding volume hierarchy over the bounding boxes of the bins of a
+// TH2Poly. The vertices of the polygons of the bins are copied in two
+// contiguous arrays, so that the point in polygon tests do not go through
+// the TGraph/TMultiGraph objects. A point is located by descending only the
+// nodes whose box contains it, making the cost of Fill and FindBin grow like
+// the logarithm of the number of bins.
+// The index is transient. It is deleted when a bin is added and built again
+// by the next Fill or FindBin.
+
+class TH2PolyIndex {
+public:
+   TH2PolyIndex(TList *bins);
+   TH2PolyBin *Find(Double_t x, Double_t y) const;
+
+private:
+   struct Node_t {
+      Double_t fXmin, fXmax, fYmin, fYmax; // box of the node
+      Int_t    fFirst;                     // first item of a leaf, first child of a node
+      Int_t    fCount;                     // number of items of a leaf, 0 for a node
+      Int_t    fMinBin;                    // smallest bin number below the node
+   };
+   struct Item_t {
+      Double_t    fXmin, fXmax, fYmin, fYmax; // box of the bin
+      Int_t       fFirstRing;                 // first polygon of the bin in fRings
+      Int_t       fNRings;                    // number of polygons, -1 to use TH2PolyBin::IsInside
+      Int_t       fNumber;                    // bin number
+      TH2PolyBin *fBin;
+   };
+   struct ItemLess_t {
+      Bool_t fAlongX;
+      ItemLess_t(Bool_t alongx) : fAlongX(alongx) {}
+      bool operator()(const Item_t &a, const Item_t &b) const {
+         return fAlongX ? a.fXmin+a.fXmax < b.fXmin+b.fXmax : a.fYmin+a.fYmax < b.fYmin+b.fYmax;
+      }
+   };
+   enum { kLeafSize = 4, kMaxDepth = 128 };
+
+   std::vector<Node_t>   fNodes;
+   std::vector<Item_t>   fItems;
+   std::vector<Int_t>    fRings;  // offset in fX and fY of the polygons, and end of the last one
+   std::vector<Double_t> fX;      // x coordinates of the vertices of all the polygons
+   std::vector<Double_t> fY;      // y coordinates of the vertices of all the polygons
+
+   void   AddRing(TGraph *g);
+   void   Build(Int_t node, Int_t first, Int_t last, Int_t depth);
+   Bool_t IsInside(const Item_t &item, Double_t x, Double_t y) const;
+};
+
+
+//______________________________________________________________________________
+TH2PolyIndex::TH2PolyIndex(TList *bins)
+{
+   // Build the index of the bins in the list.
+
+   fRings.push_back(0);
+   if (!bins) return;
+   fItems.reserve(bins->GetSize());
+
+   TIter next(bins);
+   TH2PolyBin *bin;
+   while ((bin = (TH2PolyBin*)next())) {
+      Item_t item;
+      item.fXmin      = bin->GetXMin();
+      item.fXmax      = bin->GetXMax();
+      item.fYmin      = bin->GetYMin();
+      item.fYmax      = bin->GetYMax();
+      item.fFirstRing = fRings.size()-1;
+      item.fNRings    = 0;
+      item.fNumber    = bin->GetBinNumber();
+      item.fBin       = bin;
+
+      // Copy the polygons handled by TH2PolyBin::IsInside. Graphs of a
+      // class deriving from TGraph may have their own IsInside: such
+      // bins are tested with TH2PolyBin::IsInside.
+      TObject *poly = bin->GetPolygon();
+      if (poly && poly->IsA() == TGraph::Class()) {
+         AddRing((TGraph*)poly);
+         item.fNRings = 1;
+      } else if (poly && poly->IsA() == TMultiGraph::Class()) {
+         TList *gl = ((TMultiGraph*)poly)->GetListOfGraphs();
+         TIter nextg(gl);
+         TGraph *g;
+         while (gl && (g = (TGraph*)nextg())) {
+            if (g->IsA() != TGraph::Class()) {
+               item.fNRings = -1;
+               break;
+            }
+            AddRing(g);
+            item.fNRings++;
+         }
+      } else if (poly) {
+         item.fNRings = -1;
+      }
+      fItems.push_back(item);
+   }
+   if (fItems.empty()) return;
+
+   fNodes.reserve(2*fItems.size()/kLeafSize+1);
+   fNodes.resize(1);
+   Build(0, 0, fItems.size(), 0);
+}
+
+
+//______________________________________________________________________________
+void TH2PolyIndex::AddRing(TGraph *g)
+{
+   // Append the vertices of the graph g to the polygon arrays.
+
+   Int_t n = g->GetN();
+   fX.insert(fX.end(), g->GetX(), g->GetX()+n);
+   fY.insert(fY.end(), g->GetY(), g->GetY()+n);
+   fRings.push_back(fX.size());
+}
+
+
+//______________________________________________________________________________
+void TH2PolyIndex::Build(Int_t node, Int_t first, Int_t last, Int_t depth)
+{
+   // Fill the node covering the items first to last-1. The items are split
+   // at the median of the centers of their boxes along the longest side of
+   // the box of the node.
+
+   Node_t nd;
+   nd.fXmin = fItems[first].fXmin;
+   nd.fXmax = fItems[first].fXmax;
+   nd.fYmin = fItems[first].fYmin;
+   nd.fYmax = fItems[first].fYmax;
+   nd.fMinBin = fItems[first].fNumber;
+   for (Int_t i = first+1; i < last; i++) {
+      const Item_t &item = fItems[i];
+      nd.fXmin = TMath::Min(nd.fXmin, item.fXmin);
+      nd.fXmax = TMath::Max(nd.fXmax, item.fXmax);
+      nd.fYmin = TMath::Min(nd.fYmin, item.fYmin);
+      nd.fYmax = TMath::Max(nd.fYmax, item.fYmax);
+      nd.fMinBin = TMath::Min(nd.fMinBin, item.fNumber);
+   }
+
+   // the depth is bounded since the split is done at the median
+   if (last-first <= kLeafSize || depth >= kMaxDepth/2-1) {
+      nd.fFirst = first;
+      nd.fCount = last-first;
+      fNodes[node] = nd;
+      return;
+   }
+
+   Int_t middle = first + (last-first)/2;
+   std::nth_element(fItems.begin()+first, fItems.begin()+middle, fItems.begin()+last,
+                    ItemLess_t(nd.fXmax-nd.fXmin >= nd.fYmax-nd.fYmin));
+   nd.fFirst = fNodes.size();
+   nd.fCount = 0;
+   fNodes[node] = nd;
+   fNodes.resize(fNodes.size()+2);
+   Build(nd.fFirst,   first,  middle, depth+1);
+   Build(nd.fFirst+1, middle, last,   depth+1);
+}
+
+
+//______________________________________________________________________________
+Bool_t TH2PolyIndex::IsInside(const Item_t &item, Double_t x, Double_t y) const
+{
+   // Return kTRUE if (x,y) is inside the bin of the item. The test is the
+   // one of TGraph::IsInside on the copied vertices.
+
+   if (item.fNRings < 0) return item.fBin->IsInside(x, y);
+   for (Int_t r = item.fFirstRing; r < item.fFirstRing+item.fNRings; r++) {
+      Int_t off = fRings[r];
+      Double_t *px = const_cast<Double_t*>(&fX[0]) + off;
+      Double_t *py = const_cast<Double_t*>(&fY[0]) + off;
+      if (TMath::IsInside(x, y, fRings[r+1]-off, px, py)) return kTRUE;
+   }
+   return kFALSE;
+}
+
+
+//______________________________________________________________________________
+TH2PolyBin *TH2PolyIndex::Find(Double_t x, Double_t y) const
+{
+   // Return the bin containing (x,y), 0 if there is none. If several bins
+   // contain the point, the one with the smallest bin number (the first
+   // added) is returned, like with the partition cells.
+
+   if (fNodes.empty()) return 0;
+
+   Int_t stack[kMaxDepth];
+   Int_t nstack = 0;
+   Int_t best = kMaxInt;
+   TH2PolyBin *found = 0;
+   stack[nstack++] = 0;
+   while (nstack) {
+      const Node_t &nd = fNodes[stack[--nstack]];
+      if (nd.fMinBin >= best) continue;
+      if (x < nd.fXmin || x > nd.fXmax || y < nd.fYmin || y > nd.fYmax) continue;
+      if (nd.fCount) {
+         for (Int_t i = nd.fFirst; i < nd.fFirst+nd.fCount; i++) {
+            const Item_t &item = fItems[i];
+            if (item.fNumber >= best) continue;
+            if (x < item.fXmin || x > item.fXmax || y < item.fYmin || y > item.fYmax) continue;
+            if (IsInside(item, x, y)) {
+               best  = item.fNumber;
+               found = item.fBin;
+            }
+         }
+      } else {
+         stack[nstack++] = nd.fFirst+1;
+         stack[nstack++] = nd.fFirst;
+      }
+   }
+   return found;
+}
+
 
 ClassImp(TH2Poly)
 
@@ -142,6 +360,16 @@ filling, it also adds a constant time delay into the code. When <tt>Fill()</tt>
 is to be called many times, it is more efficient to divide the histogram into
 a large number cells. However, if the histogram is to be filled only a few
 times, it is better to divide into a small number of cells.
+
+<h3>Bin Index</h3>
+For histograms with many bins, looping over the bins of a partition cell is
+still slow. <tt>Fill()</tt>, <tt>FillN()</tt> and <tt>FindBin()</tt> therefore
+locate the bins with an index: a bounding volume hierarchy (a binary tree of
+nested boxes) of the bounding boxes of the bins, holding a contiguous copy of
+the polygon vertices. Only the bins whose box contains the point are tested,
+so the cost of a fill grows like the logarithm of the number of bins. The
+index is built automatically at the first fill following the addition of
+bins, and gives the same bins as the partition cells.
 End_Html */
 
 
@@ -194,6 +422,7 @@ TH2Poly::~TH2Poly()
    delete[] fCells;
    delete[] fIsEmpty;
    delete[] fCompletelyInside;
+   delete fIndex;
 }
 
 
@@ -243,6 +472,10 @@ Int_t TH2Poly::AddBin(TObject *poly)
    fBins->Add((TObject*) bin);
    SetNewBinAdded(kTRUE);
 
+   // The bin index is built again at the next Fill or FindBin
+   delete fIndex;
+   fIndex = 0;
+
    // Adds the bin to the partition matrix
    AddBinToPartition(bin);
 
@@ -527,34 +760,30 @@ Int_t TH2Poly::FindBin(Double_t x, Double_t y, Double_t)
    else if (x > fXaxis.GetXmin()) overflow += -1;
    if (overflow != -5) return overflow;
 
-   // Finds the cell (x,y) coordinates belong to
-   Int_t n = (Int_t)(floor((x-fXaxis.GetXmin())/fStepX));
-   Int_t m = (Int_t)(floor((y-fYaxis.GetXmin())/fStepY));
-
-   // Make sure the array indices are correct.
-   if (n>=fCellX) n = fCellX-1;
-   if (m>=fCellY) m = fCellY-1;
-   if (n<0)       n = 0;
-   if (m<0)       m = 0;
-
-   if (fIsEmpty[n+fCellX*m]) return -5;
-
-   TH2PolyBin *bin;
-
-   TIter next(&fCells[n+fCellX*m]);
-   TObject *obj;
-
-   // Search for the bin in the cell
-   while ((obj=next())) {
-      bin  = (TH2PolyBin*)obj;
-      if (bin->IsInside(x,y)) return bin->GetBinNumber();
-   }
+   // Search for the bin in the index
+   TH2PolyBin *bin = FindPolyBin(x, y);
+   if (bin) return bin->GetBinNumber();
 
    // If the search has not returned a bin, the point must be on "the sea"
    return -5;
 }
 
 
+//______________________________________________________________________________
+TH2PolyBin *TH2Poly::FindPolyBin(Double_t x, Double_t y)
+{
+   // Returns the bin containing (x,y), or 0 if the point is in "the sea".
+   // (x,y) must be inside the histogram limits.
+   // The bins are looked up in a bounding volume hierarchy of their
+   // bounding boxes (see TH2PolyIndex), built at the first call following
+   // the addition of a bin. The cost is logarithmic in the number of bins.
+   // When bins overlap, the first bin added containing the point is returned.
+
+   if (!fIndex) fIndex = new TH2PolyIndex(fBins);
+   return fIndex->Find(x, y);
+}
+
+
 //______________________________________________________________________________
 Int_t TH2Poly::Fill(Double_t x, Double_t y)
 {
@@ -583,43 +812,23 @@ Int_t TH2Poly::Fill(Double_t x, Double_t y, Double_t w)
       return 0;
    }
 
-   // Finds the cell (x,y) coordinates belong to
-   Int_t n = (Int_t)(floor((x-fXaxis.GetXmin())/fStepX));
-   Int_t m = (Int_t)(floor((y-fYaxis.GetXmin())/fStepY));
+   TH2PolyBin *bin = FindPolyBin(x, y);
+   if (bin) {
+      Int_t bi = bin->GetBinNumber()-1;
+      bin->Fill(w);
 
-   // Make sure the array indices are correct.
-   if (n>=fCellX) n = fCellX-1;
-   if (m>=fCellY) m = fCellY-1;
-   if (n<0)       n = 0;
-   if (m<0)       m = 0;
+      // Statistics
+      fTsumw   = fTsumw + w;
+      fTsumwx  = fTsumwx + w*x;
+      fTsumwx2 = fTsumwx2 + w*x*x;
+      fTsumwy  = fTsumwy + w*y;
+      fTsumwy2 = fTsumwy2 + w*y*y;
+      if (fSumw2.fN) fSumw2.fArray[bi] += w*w;
+      fEntries++;
 
-   if (fIsEmpty[n+fCellX*m]) return 0;
+      SetBinContentChanged(kTRUE);
 
-   TH2PolyBin *bin;
-   Int_t bi;
-
-   TIter next(&fCells[n+fCellX*m]);
-   TObject *obj;
-
-   while ((obj=next())) {
-      bin  = (TH2PolyBin*)obj;
-      bi = bin->GetBinNumber()-1;
-      if (bin->IsInside(x,y)) {
-         bin->Fill(w);
-
-         // Statistics
-         fTsumw   = fTsumw + w;
-         fTsumwx  = fTsumwx + w*x;
-         fTsumwx2 = fTsumwx2 + w*x*x;
-         fTsumwy  = fTsumwy + w*y;
-         fTsumwy2 = fTsumwy2 + w*y*y;
-         if (fSumw2.fN) fSumw2.fArray[bi] += w*w;
-         fEntries++;
-
-         SetBinContentChanged(kTRUE);
-
-         return bin->GetBinNumber();
-      }
+      return bin->GetBinNumber();
    }
 
    fOverflow[4]++;
@@ -664,9 +873,15 @@ void TH2Poly::FillN(Int_t ntimes, const Double_t* x, const Double_t* y,
    // y:       array of y values to be histogrammed
    // w:       array of weights
    // stride:  step size through arrays x, y and w
-
-   for (int i = 0; i < ntimes; i += stride) {
-      Fill(x[i], y[i], w[i]);
+   //
+   // If w is NULL each entry is assumed a weight=1.
+   // The bins are located with the index used by Fill, built once for all
+   // the entries.
+
+   if (ntimes <= 0 || fNcells == 0) return;
+   if (!fIndex) fIndex = new TH2PolyIndex(fBins);
+   for (Int_t i = 0; i < ntimes; i++) {
+      Fill(x[i*stride], y[i*stride], w ? w[i*stride] : 1.);
    }
 }
 
@@ -924,6 +1139,7 @@ void TH2Poly::Initialize(Double_t xlow, Double_t xup,
 
    fBins   = 0;
    fNcells = 0;
+   fIndex  = 0;
 
    // Sets the boundaries of the histogram
    fXaxis.Set(100, xlow, xup);
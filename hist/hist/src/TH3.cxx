@@ -23,6 +23,7 @@
 #include "TError.h"
 #include "TMath.h"
 #include "TObjString.h"
+#include "TVirtualMutex.h"
 
 ClassImp(TH3)
 
@@ -160,6 +161,9 @@ Int_t TH3::BufferEmpty(Int_t action)
    //             The buffer is automatically deleted when the number of entries
    //             in the buffer is greater than the number of entries in the histogram
 
+   // fill first the entries of the concurrent fill buffers
+   if (fConcurrentFill) FlushConcurrentFill();
+
    // do we need to compute the bin size?
    if (!fBuffer) return 0;
    Int_t nbentries = (Int_t)fBuffer[0];
@@ -257,6 +261,16 @@ Int_t TH3::BufferFill(Double_t x, Double_t y, Double_t z, Double_t w)
    return -3;
 }
 
+//______________________________________________________________________________
+void TH3::FillFromThreadBuffer(Int_t nargs, const Double_t *args)
+{
+   // Fill the histogram with an entry of a thread fill buffer, made by the
+   // Fill call with nargs arguments (see TH1::SetConcurrentFill).
+
+   if (nargs == 3) Fill(args[0], args[1], args[2]);
+   else            Fill(args[0], args[1], args[2], args[3]);
+}
+
 
 //______________________________________________________________________________
 Int_t TH3::Fill(Double_t )
@@ -275,6 +289,7 @@ Int_t TH3::Fill(Double_t x, Double_t y, Double_t z)
    // The function returns the corresponding global bin number which has its content
    // incremented by 1
 
+   if (fConcurrentFill && ConcurrentFill(3,x,y,z)) return -2;
    if (fBuffer) return BufferFill(x,y,z,1);
 
    Int_t binx, biny, binz, bin;
@@ -323,6 +338,7 @@ Int_t TH3::Fill(Double_t x, Double_t y, Double_t z, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   if (fConcurrentFill && ConcurrentFill(4,x,y,z,w)) return -2;
    if (fBuffer) return BufferFill(x,y,z,w);
 
    Int_t binx, biny, binz, bin;
@@ -370,6 +386,7 @@ Int_t TH3::Fill(const char *namex, const char *namey, const char *namez, Double_
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, binz, bin;
    fEntries++;
    binx = fXaxis.FindBin(namex);
@@ -413,6 +430,7 @@ Int_t TH3::Fill(const char *namex, Double_t y, const char *namez, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, binz, bin;
    fEntries++;
    binx = fXaxis.FindBin(namex);
@@ -457,6 +475,7 @@ Int_t TH3::Fill(const char *namex, const char *namey, Double_t z, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, binz, bin;
    fEntries++;
    binx = fXaxis.FindBin(namex);
@@ -501,6 +520,7 @@ Int_t TH3::Fill(Double_t x, const char *namey, const char *namez, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, binz, bin;
    fEntries++;
    binx = fXaxis.FindBin(x);
@@ -545,6 +565,7 @@ Int_t TH3::Fill(Double_t x, const char *namey, Double_t z, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, binz, bin;
    fEntries++;
    binx = fXaxis.FindBin(x);
@@ -590,6 +611,7 @@ Int_t TH3::Fill(Double_t x, Double_t y, const char *namez, Double_t w)
    // The function returns the corresponding global bin number which has its content
    // incremented by w
 
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t binx, biny, binz, bin;
    fEntries++;
    binx = fXaxis.FindBin(x);
@@ -624,6 +646,88 @@ Int_t TH3::Fill(Double_t x, Double_t y, const char *namez, Double_t w)
 }
 
 
+//______________________________________________________________________________
+void TH3::FillN(Int_t ntimes, const Double_t *x, const Double_t *y, const Double_t *z, const Double_t *w, Int_t stride)
+{
+   // Fill a 3-D histogram with an array of values and weights.
+   //
+   // ntimes:  number of entries in arrays x, y, z and w (array size must be ntimes*stride)
+   // x:       array of x values to be histogrammed
+   // y:       array of y values to be histogrammed
+   // z:       array of z values to be histogrammed
+   // w:       array of weights
+   // stride:  step size through arrays x, y, z and w
+   //
+   //  If the weight is not equal to 1, the storage of the sum of squares of
+   //   weights is automatically triggered and the sum of the squares of weights is incremented
+   //   by w[i]^2 in the cell corresponding to x[i],y[i],z[i].
+   //  If w is NULL each entry is assumed a weight=1
+
+   if (ntimes > 0 && fConcurrentFill && ConcurrentFill(4,x[0],y[0],z[0],w ? w[0] : 1)) {
+      for (Int_t k=1;k<ntimes;k++) ConcurrentFill(4,x[k*stride],y[k*stride],z[k*stride],w ? w[k*stride] : 1);
+      return;
+   }
+   if (fBuffer) {
+      for (Int_t k=0;k<ntimes;k++) Fill(x[k*stride],y[k*stride],z[k*stride],w ? w[k*stride] : 1);
+      return;
+   }
+   Int_t binx, biny, binz, bin, i;
+   fEntries += ntimes;
+   Double_t ww = 1;
+   // if no axis can be extended, the bins of a block of entries are
+   // found at once with TAxis::FindFixBins
+   Bool_t batch = !fXaxis.CanExtend() && !fYaxis.CanExtend() && !fZaxis.CanExtend();
+   Int_t binsx[kNFillNBlock], binsy[kNFillNBlock], binsz[kNFillNBlock];
+   Int_t first, last, k;
+   ntimes *= stride;
+   for (first=0;first<ntimes;first=last) {
+      last = TMath::Min(ntimes, first + kNFillNBlock*stride);
+      if (batch) {
+         fXaxis.FindFixBins((last-first+stride-1)/stride, x+first, binsx, stride);
+         fYaxis.FindFixBins((last-first+stride-1)/stride, y+first, binsy, stride);
+         fZaxis.FindFixBins((last-first+stride-1)/stride, z+first, binsz, stride);
+      }
+      for (i=first,k=0;i<last;i+=stride,k++) {
+         if (batch) {
+            binx = binsx[k];
+            biny = binsy[k];
+            binz = binsz[k];
+         } else {
+            binx = fXaxis.FindBin(x[i]);
+            biny = fYaxis.FindBin(y[i]);
+            binz = fZaxis.FindBin(z[i]);
+         }
+         if (binx <0 || biny <0 || binz<0) continue;
+         bin  =  binx + (fXaxis.GetNbins()+2)*(biny + (fYaxis.GetNbins()+2)*binz);
+         if (w) ww = w[i];
+         if (!fSumw2.fN && ww != 1.0)  Sumw2();   // must be called before AddBinContent
+         if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
+         AddBinContent(bin,ww);
+         if (binx == 0 || binx > fXaxis.GetNbins()) {
+            if (!fgStatOverflows) continue;
+         }
+         if (biny == 0 || biny > fYaxis.GetNbins()) {
+            if (!fgStatOverflows) continue;
+         }
+         if (binz == 0 || binz > fZaxis.GetNbins()) {
+            if (!fgStatOverflows) continue;
+         }
+         fTsumw   += ww;
+         fTsumw2  += ww*ww;
+         fTsumwx  += ww*x[i];
+         fTsumwx2 += ww*x[i]*x[i];
+         fTsumwy  += ww*y[i];
+         fTsumwy2 += ww*y[i]*y[i];
+         fTsumwxy += ww*x[i]*y[i];
+         fTsumwz  += ww*z[i];
+         fTsumwz2 += ww*z[i]*z[i];
+         fTsumwxz += ww*x[i]*z[i];
+         fTsumwyz += ww*y[i]*z[i];
+      }
+   }
+}
+
+
 //______________________________________________________________________________
 void TH3::FillRandom(const char *fname, Int_t ntimes)
 {
@@ -1113,7 +1217,7 @@ void TH3::GetStats(Double_t *stats) const
    // stats[9] = sumwxz
    // stats[10]= sumwyz
 
-   if (fBuffer) ((TH3*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TH3*)this)->BufferEmpty();
 
    Int_t bin, binx, biny, binz;
    Double_t w,err;
@@ -15,6 +15,8 @@
 #include "TClass.h"
 #include "TDataMember.h"
 #include "TDataType.h"
+#include "TMath.h"
+#include "TVirtualMutex.h"
 
 namespace {
 //______________________________________________________________________________
@@ -408,6 +410,99 @@ THnSparseCompactBinCoord::~THnSparseCompactBinCoord()
    delete [] fCurrentBin;
 }
 
+//______________________________________________________________________________
+//
+// THnSparseBinIndex is used internally by THnSparse. It is an open
+// addressing hash table with linear probing, mapping the hash of the compact
+// coordinate of each filled bin to its linear index (plus one, 0 marking an
+// empty slot). The hash is stored in the slot next to the index: if the
+// compact coordinate fits into a Long64_t the hash is the compact coordinate
+// itself, so that a lookup never needs to access the chunks. Colliding
+// hashes (possible only for larger coordinates) simply occupy the next
+// slots. A slot takes 16 bytes and the table is kept at most 3/4 full.
+//______________________________________________________________________________
+
+class THnSparseBinIndex {
+public:
+   struct Slot_t {
+      ULong64_t fHash;  // hash of the compact bin coordinate
+      Long64_t  fIndex; // linear bin index + 1; 0 if the slot is empty
+   };
+
+   THnSparseBinIndex(): fSlots(0), fMask(-1), fSize(0) {}
+   ~THnSparseBinIndex() { delete [] fSlots; }
+
+   Long64_t      GetCapacity() const { return fMask + 1; }
+   Long64_t      GetSize() const { return fSize; }
+   const Slot_t &GetSlot(Long64_t pos) const { return fSlots[pos]; }
+   Long64_t      FirstPos(ULong64_t hash) const { return Mix(hash) & fMask; }
+   Long64_t      NextPos(Long64_t pos) const { return (pos + 1) & fMask; }
+
+   Long64_t Add(Long64_t pos, ULong64_t hash, Long64_t index) {
+      // Store index for hash in the empty slot pos, found by probing for
+      // hash. If the table has to be expanded the slot is looked up again.
+      // Return the slot used.
+      if (4 * (fSize + 1) > 3 * GetCapacity()) {
+         Expand(fSize + 1);
+         pos = FirstPos(hash);
+         while (fSlots[pos].fIndex) pos = NextPos(pos);
+      }
+      fSlots[pos].fHash = hash;
+      fSlots[pos].fIndex = index;
+      ++fSize;
+      return pos;
+   }
+
+   void Clear() {
+      // Remove all entries, keeping the allocated slots.
+      if (fSlots) memset(fSlots, 0, sizeof(Slot_t) * GetCapacity());
+      fSize = 0;
+   }
+
+   void Expand(Long64_t nbins) {
+      // Make room for nbins entries (keeping the table at most 3/4 full),
+      // re-inserting the existing ones.
+      Long64_t capacity = 16;
+      while (4 * nbins > 3 * capacity) capacity *= 2;
+      if (capacity <= GetCapacity()) return;
+
+      Slot_t *old = fSlots;
+      Long64_t oldCapacity = GetCapacity();
+      fSlots = new Slot_t[capacity];
+      memset(fSlots, 0, sizeof(Slot_t) * capacity);
+      fMask = capacity - 1;
+      for (Long64_t i = 0; i < oldCapacity; ++i) {
+         if (!old[i].fIndex) continue;
+         Long64_t pos = FirstPos(old[i].fHash);
+         while (fSlots[pos].fIndex) pos = NextPos(pos);
+         fSlots[pos] = old[i];
+      }
+      delete [] old;
+   }
+
+private:
+   // intentionally not implemented
+   THnSparseBinIndex(const THnSparseBinIndex&);
+   // intentionally not implemented
+   THnSparseBinIndex& operator=(const THnSparseBinIndex&);
+
+   static ULong64_t Mix(ULong64_t h) {
+      // Scramble the bits of the hash: compact coordinates differ mostly in
+      // a few bits, which would otherwise cluster in the table.
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+   }
+
+   Slot_t   *fSlots; // [fMask + 1] slots
+   Long64_t  fMask;  // number of slots - 1 (a power of 2 - 1)
+   Long64_t  fSize;  // number of used slots
+};
+
+
 //______________________________________________________________________________
 //
 // THnSparseArrayChunk is used internally by THnSparse.
@@ -567,21 +662,27 @@ void THnSparseArrayChunk::Sumw2()
 // the chunks is done by GetBin(). It creates a hash from the compacted bin
 // coordinates (the hash of a bin coordinate is the compacted coordinate itself
 // if it takes less than 8 bytes, the size of a Long64_t.
-// This hash is used to lookup the linear index in the TExMap member fBins;
-// the coordinates of the entry fBins points to is compared to the coordinates
-// passed to GetBin(). If they do not match, these two coordinates have the same
-// hash - which is extremely unlikely but (for the case where the compact bin
-// coordinates are larger than 4 bytes) possible. In this case, fBinsContinued
-// contains a chain of linear indexes with the same hash. Iterating through this
-// chain and comparing each bin coordinates with the one passed to GetBin() will
-// retrieve the matching bin.
+// This hash is used to lookup the linear index in the open addressing hash
+// table fBinIndex (see THnSparseBinIndex), whose slots hold the hash next to
+// the linear index. If the compact coordinate is larger than 8 bytes, two
+// coordinates can have the same hash - which is extremely unlikely but
+// possible. The coordinates of the bin found are then compared to the ones
+// passed to GetBin(), and the probing continues with the next slots until
+// the matching bin (or an empty slot) is found.
+//
+// * Batched Filling and Merging
+// FillN() fills a set of points at once: the bins of each axis are looked up
+// for the whole set with TAxis::FindFixBins(). Merge() adds histograms with
+// the same binning chunk by chunk, directly through their compact
+// coordinates; several threads can merge their own histograms into the same
+// target concurrently.
 
 
 ClassImp(THnSparse);
 
 //______________________________________________________________________________
 THnSparse::THnSparse():
-   fChunkSize(1024), fFilledBins(0), fCompactCoord(0)
+   fChunkSize(1024), fFilledBins(0), fBinIndex(0), fCompactCoord(0), fMergeMutex(0)
 {
    // Construct an empty THnSparse.
    fBinContent.SetOwner();
@@ -592,7 +693,7 @@ THnSparse::THnSparse(const char* name, const char* title, Int_t dim,
                      const Int_t* nbins, const Double_t* xmin, const Double_t* xmax,
                      Int_t chunksize):
    THnBase(name, title, dim, nbins, xmin, xmax),
-   fChunkSize(chunksize), fFilledBins(0), fCompactCoord(0)
+   fChunkSize(chunksize), fFilledBins(0), fBinIndex(0), fCompactCoord(0), fMergeMutex(0)
 {
    // Construct a THnSparse with "dim" dimensions,
    // with chunksize as the size of the chunks.
@@ -610,6 +711,8 @@ THnSparse::~THnSparse() {
    // Destruct a THnSparse
 
    delete fCompactCoord;
+   delete fBinIndex;
+   delete fMergeMutex;
 }
 
 //______________________________________________________________________________
@@ -643,34 +746,61 @@ void THnSparse::InitStorage(Int_t* nbins, Int_t chunkSize)
 }
 
 //______________________________________________________________________________
-void THnSparse::FillExMap()
+void THnSparse::FillN(Int_t nentries, const Double_t* x, const Double_t* w /*= 0*/)
 {
-   //We have been streamed; set up fBins
+   // Fill the histogram with nentries points. x holds the coordinates of
+   // the points one after the other (nentries * GetNdimensions() values),
+   // w their weights; all weights are 1 if w is 0.
+   // The bins of each axis are looked up for blocks of points at once with
+   // TAxis::FindFixBins(). The result is the same as calling Fill(x, w) for
+   // each point.
+
+   if (nentries <= 0) return;
+   const Int_t kBlock = 256;
+   Int_t* coords = new Int_t[kBlock * fNdimensions];
+   Int_t* bins = new Int_t[kBlock];
+   THnSparseCompactBinCoord* cc = GetCompactCoord();
+   for (Int_t first = 0; first < nentries; first += kBlock) {
+      const Int_t nb = TMath::Min(kBlock, nentries - first);
+      const Double_t* xb = x + (Long64_t)first * fNdimensions;
+      for (Int_t d = 0; d < fNdimensions; ++d) {
+         GetAxis(d)->FindFixBins(nb, xb + d, bins, fNdimensions);
+         for (Int_t j = 0; j < nb; ++j)
+            coords[j * fNdimensions + d] = bins[j];
+      }
+      for (Int_t j = 0; j < nb; ++j) {
+         const Double_t wj = w ? w[first + j] : 1.;
+         UpdateXStat(xb + j * fNdimensions, wj);
+         cc->SetCoord(coords + j * fNdimensions);
+         FillBin(GetBinIndexForCurrentBin(kTRUE), wj);
+      }
+   }
+   delete [] bins;
+   delete [] coords;
+}
+
+//______________________________________________________________________________
+void THnSparse::FillBinIndex()
+{
+   //We have been streamed; set up fBinIndex
    TIter iChunk(&fBinContent);
    THnSparseArrayChunk* chunk = 0;
    THnSparseCoordCompression compactCoord(*GetCompactCoord());
    Long64_t idx = 0;
-   if (2 * GetNbins() > fBins.Capacity())
-      fBins.Expand(3 * GetNbins());
+   if (!fBinIndex) fBinIndex = new THnSparseBinIndex();
+   fBinIndex->Clear();
+   fBinIndex->Expand(GetNbins());
    while ((chunk = (THnSparseArrayChunk*) iChunk())) {
       const Int_t chunkSize = chunk->GetEntries();
       Char_t* buf = chunk->fCoordinates;
       const Int_t singleCoordSize = chunk->fSingleCoordinateSize;
       const Char_t* endbuf = buf + singleCoordSize * chunkSize;
       for (; buf < endbuf; buf += singleCoordSize, ++idx) {
-         Long64_t hash = compactCoord.GetHashFromBuffer(buf);
-         Long64_t linidx = fBins.GetValue(hash);
-         if (linidx) {
-            Long64_t nextidx = linidx;
-            while (nextidx) {
-               // must be a collision, so go to fBinsContinued.
-               linidx = nextidx;
-               nextidx = fBinsContinued.GetValue(linidx);
-            }
-            fBinsContinued.Add(linidx, idx + 1);
-         } else {
-            fBins.Add(hash, idx + 1);
-         }
+         ULong64_t hash = compactCoord.GetHashFromBuffer(buf);
+         // bins are unique: no need to compare, just find a free slot
+         Long64_t pos = fBinIndex->FirstPos(hash);
+         while (fBinIndex->GetSlot(pos).fIndex) pos = fBinIndex->NextPos(pos);
+         fBinIndex->Add(pos, hash, idx + 1);
       }
    }
 }
@@ -678,12 +808,10 @@ void THnSparse::FillExMap()
 //______________________________________________________________________________
 void THnSparse::Reserve(Long64_t nbins) {
    // Initialize storage for nbins
-   if (!fBins.GetSize() && fBinContent.GetSize()) {
-      FillExMap();
-   }
-   if (2 * nbins > fBins.Capacity()) {
-      fBins.Expand(3 * nbins);
+   if (!fBinIndex || (!fBinIndex->GetSize() && fBinContent.GetSize())) {
+      FillBinIndex();
    }
+   fBinIndex->Expand(nbins);
 }
 
 //______________________________________________________________________________
@@ -781,19 +909,22 @@ Long64_t THnSparse::GetBinIndexForCurrentBin(Bool_t allocate)
 
    THnSparseCompactBinCoord* cc = GetCompactCoord();
    ULong64_t hash = cc->GetHash();
-   if (fBinContent.GetSize() && !fBins.GetSize())
-      FillExMap();
-   Long64_t linidx = (Long64_t) fBins.GetValue(hash);
-   while (linidx) {
-      // fBins stores index + 1!
-      THnSparseArrayChunk* chunk = GetChunk((linidx - 1)/ fChunkSize);
-      if (chunk->Matches((linidx - 1) % fChunkSize, cc->GetBuffer()))
-         return linidx - 1; // we store idx+1, 0 is "TExMap: not found"
-
-      Long64_t nextlinidx = fBinsContinued.GetValue(linidx);
-      if (!nextlinidx) break;
-
-      linidx = nextlinidx;
+   // Up to 8 bytes the hash is the compact coordinate itself: the same hash
+   // is the same bin, without comparing with the coordinate in the chunk.
+   Bool_t hashIsCoord = cc->GetBufferSize() <= 8;
+   if (!fBinIndex || (fBinContent.GetSize() && !fBinIndex->GetSize()))
+      FillBinIndex();
+   // fBinIndex stores index + 1!
+   Long64_t pos = fBinIndex->FirstPos(hash);
+   Long64_t linidx;
+   while ((linidx = fBinIndex->GetSlot(pos).fIndex)) {
+      if (fBinIndex->GetSlot(pos).fHash == hash) {
+         if (hashIsCoord) return linidx - 1;
+         THnSparseArrayChunk* chunk = GetChunk((linidx - 1)/ fChunkSize);
+         if (chunk->Matches((linidx - 1) % fChunkSize, cc->GetBuffer()))
+            return linidx - 1;
+      }
+      pos = fBinIndex->NextPos(pos);
    }
    if (!allocate) return -1;
 
@@ -808,18 +939,9 @@ Long64_t THnSparse::GetBinIndexForCurrentBin(Bool_t allocate)
    }
    chunk->AddBin(newidx, cc->GetBuffer());
 
-   // store translation between hash and bin
+   // store translation between hash and bin in the free slot found
    newidx += (fBinContent.GetEntriesFast() - 1) * fChunkSize;
-   if (!linidx) {
-      // fBins didn't find it
-      if (2 * GetNbins() > fBins.Capacity())
-         fBins.Expand(3 * GetNbins());
-      fBins.Add(hash, newidx + 1);
-   } else {
-      // fBins contains one, but it's the wrong one;
-      // add entry to fBinsContinued.
-      fBinsContinued.Add(linidx, newidx + 1);
-   }
+   fBinIndex->Add(pos, hash, newidx + 1);
    return newidx;
 }
 
@@ -871,7 +993,8 @@ Double_t THnSparse::GetSparseFractionMem() const {
 
    Double_t size = 0.;
    size += fBinContent.GetEntries() * (GetChunkSize() * sizePerChunkElement + sizeof(THnSparseArrayChunk));
-   size += + 3 * sizeof(Long64_t) * fBins.GetSize() /* TExMap */;
+   if (fBinIndex)
+      size += sizeof(THnSparseBinIndex::Slot_t) * fBinIndex->GetCapacity(); /* THnSparseBinIndex */
 
    Double_t nbinsTotal = 1.;
    for (Int_t d = 0; d < fNdimensions; ++d)
@@ -888,6 +1011,71 @@ ROOT::THnBaseBinIter* THnSparse::CreateIter(Bool_t respectAxisRange) const
    return new THnSparseBinIter(respectAxisRange, this);
 }
 
+//______________________________________________________________________________
+Long64_t THnSparse::Merge(TCollection* list)
+{
+   // Merge this with a list of THnBase's. All THnBase's provided
+   // in the list must have the same bin layout!
+   //
+   // The bins of the THnSparse's of the list are added chunk by chunk,
+   // looked up directly through their compact coordinates; other THnBase's
+   // are added with THnBase::Add().
+   //
+   // Merge() can be called by several threads on the same histogram at the
+   // same time, e.g. by worker threads each adding its own histogram to a
+   // common one at the end of the processing: the calls are serialized.
+   // The histograms of the list must not be modified during the merge.
+
+   if (!list) return 0;
+   R__LOCKGUARD2(fMergeMutex);
+   if (list->IsEmpty()) return (Long64_t)GetEntries();
+
+   Long64_t sumNbins = GetNbins();
+   TIter iter(list);
+   const TObject* addMeObj = 0;
+   while ((addMeObj = iter())) {
+      const THnBase* addMe = dynamic_cast<const THnBase*>(addMeObj);
+      if (addMe) {
+         sumNbins += addMe->GetNbins();
+      }
+   }
+   Reserve(sumNbins);
+
+   THnSparseCompactBinCoord* cc = GetCompactCoord();
+   iter.Reset();
+   while ((addMeObj = iter())) {
+      const THnBase* addMe = dynamic_cast<const THnBase*>(addMeObj);
+      const THnSparse* addMeSparse = dynamic_cast<const THnSparse*>(addMeObj);
+      if (!addMe) {
+         Error("Merge", "Object named %s is not THnBase! Skipping it.",
+               addMeObj->GetName());
+      } else if (!addMeSparse) {
+         Add(addMe);
+      } else if (CheckConsistency(addMe, "Merge")) {
+         // Trigger error calculation if addMe has it
+         if (!GetCalculateErrors() && addMe->GetCalculateErrors())
+            Sumw2();
+         Bool_t haveErrors = GetCalculateErrors();
+         for (Int_t i = 0; i < addMeSparse->GetNChunks(); ++i) {
+            THnSparseArrayChunk* chunk = addMeSparse->GetChunk(i);
+            const Int_t nbins = chunk->GetEntries();
+            const Int_t singleCoordSize = chunk->fSingleCoordinateSize;
+            for (Int_t j = 0; j < nbins; ++j) {
+               cc->SetBuffer(chunk->fCoordinates + j * singleCoordSize);
+               Long64_t bin = GetBinIndexForCurrentBin(kTRUE);
+               Double_t v = chunk->fContent->GetAt(j);
+               if (haveErrors)
+                  AddBinError2(bin, chunk->fSumw2 ? chunk->fSumw2->GetAt(j) : v);
+               // only _after_ error calculation, like in THnBase::Add()
+               AddBinContent(bin, v);
+            }
+         }
+         SetEntries(GetEntries() + addMe->GetEntries());
+      }
+   }
+   return (Long64_t)GetEntries();
+}
+
 //______________________________________________________________________________
 void THnSparse::SetBinContent(Long64_t bin, Double_t v)
 {
@@ -951,8 +1139,7 @@ void THnSparse::Reset(Option_t *option /*= ""*/)
 {
    // Clear the histogram
    fFilledBins = 0;
-   fBins.Delete();
-   fBinsContinued.Clear();
+   if (fBinIndex) fBinIndex->Clear();
    fBinContent.Delete();
    ResetBase(option);
 }
@@ -17,6 +17,7 @@
 #include "TVirtualPad.h"
 #include "TError.h"
 #include "TClass.h"
+#include "TVirtualMutex.h"
 
 #include "TProfileHelper.h"
 
@@ -335,6 +336,9 @@ Int_t TProfile::BufferEmpty(Int_t action)
 //             The buffer is automatically deleted when the number of entries
 //             in the buffer is greater than the number of entries in the histogram
 
+   // fill first the entries of the concurrent fill buffers
+   if (fConcurrentFill) FlushConcurrentFill();
+
    // do we need to compute the bin size?
    if (!fBuffer) return 0;
    Int_t nbentries = (Int_t)fBuffer[0];
@@ -414,6 +418,16 @@ Int_t TProfile::BufferFill(Double_t x, Double_t y, Double_t w)
    return -2;
 }
 
+//______________________________________________________________________________
+void TProfile::FillFromThreadBuffer(Int_t nargs, const Double_t *args)
+{
+   // Fill the histogram with an entry of a thread fill buffer, made by the
+   // Fill call with nargs arguments (see TH1::SetConcurrentFill).
+
+   if (nargs == 2) Fill(args[0], args[1]);
+   else            Fill(args[0], args[1], args[2]);
+}
+
 //______________________________________________________________________________
 void TProfile::Copy(TObject &obj) const
 {
@@ -476,7 +490,7 @@ Bool_t TProfile::Divide(const TH1 *h1)
    TProfile *p1 = (TProfile*)h1;
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
 
    Int_t nbinsx = GetNbinsX();
@@ -566,7 +580,7 @@ Bool_t TProfile::Divide(const TH1 *h1, const TH1 *h2, Double_t c1, Double_t c2,
    TProfile *p2 = (TProfile*)h2;
 
    // delete buffer if it is there since it will become invalid
-   if (fBuffer) BufferEmpty(1);
+   if (fBuffer || fConcurrentFill) BufferEmpty(1);
 
    Int_t nbinsx = GetNbinsX();
 //*-*- Check histogram compatibility
@@ -650,6 +664,7 @@ Int_t TProfile::Fill(Double_t x, Double_t y)
 //*-*-*-*-*-*-*-*-*-*-*Fill a Profile histogram (no weights)*-*-*-*-*-*-*-*
 //*-*                  =====================================
 
+   if (fConcurrentFill && ConcurrentFill(2,x,y)) return -2;
    if (fBuffer) return BufferFill(x,y,1);
 
    Int_t bin;
@@ -680,6 +695,7 @@ Int_t TProfile::Fill(const char *namex, Double_t y)
 {
 // Fill a Profile histogram (no weights)
 //
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t bin;
    if (fYmin != fYmax) {
       if (y <fYmin || y> fYmax || TMath::IsNaN(y) ) return -1;
@@ -710,6 +726,7 @@ Int_t TProfile::Fill(Double_t x, Double_t y, Double_t w)
 //*-*-*-*-*-*-*-*-*-*-*Fill a Profile histogram with weights*-*-*-*-*-*-*-*
 //*-*                  =====================================
 
+   if (fConcurrentFill && ConcurrentFill(3,x,y,w)) return -2;
    if (fBuffer) return BufferFill(x,y,w);
 
    Int_t bin;
@@ -742,6 +759,7 @@ Int_t TProfile::Fill(const char *namex, Double_t y, Double_t w)
 {
 // Fill a Profile histogram with weights
 //
+   R__LOCKGUARD(GetConcurrentFillMutex());
    Int_t bin;
 
    if (fYmin != fYmax) {
@@ -775,6 +793,10 @@ void TProfile::FillN(Int_t ntimes, const Double_t *x, const Double_t *y, const D
 {
 //*-*-*-*-*-*-*-*-*-*-*Fill a Profile histogram with weights*-*-*-*-*-*-*-*
 //*-*                  =====================================
+   if (ntimes > 0 && fConcurrentFill && ConcurrentFill(3,x[0],y[0],w ? w[0] : 1)) {
+      for (Int_t k=1;k<ntimes;k++) ConcurrentFill(3,x[k*stride],y[k*stride],w ? w[k*stride] : 1);
+      return;
+   }
    Int_t bin,i;
    ntimes *= stride;
    for (i=0;i<ntimes;i+=stride) {
@@ -808,7 +830,7 @@ Double_t TProfile::GetBinContent(Int_t bin) const
 //*-*-*-*-*-*-*Return bin content of a Profile histogram*-*-*-*-*-*-*-*-*-*
 //*-*          =========================================
 
-   if (fBuffer) ((TProfile*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TProfile*)this)->BufferEmpty();
 
    if (bin < 0 || bin >= fNcells) return 0;
    if (fBinEntries.fArray[bin] == 0) return 0;
@@ -822,7 +844,7 @@ Double_t TProfile::GetBinEntries(Int_t bin) const
 //*-*-*-*-*-*-*Return bin entries of a Profile histogram*-*-*-*-*-*-*-*-*-*
 //*-*          =========================================
 
-   if (fBuffer) ((TProfile*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TProfile*)this)->BufferEmpty();
 
    if (bin < 0 || bin >= fNcells) return 0;
    return fBinEntries.fArray[bin];
@@ -907,7 +929,7 @@ void TProfile::GetStats(Double_t *stats) const
    // If a sub-range is specified, the function recomputes these quantities
    // from the bin contents in the current axis range.
 
-   if (fBuffer) ((TProfile*)this)->BufferEmpty();
+   if (fBuffer || fConcurrentFill) ((TProfile*)this)->BufferEmpty();
 
    // Loop on bins
    Int_t bin, binx;
@@ -27,6 +27,10 @@ IODEP        := $(IOO:.o=.d) $(IODO:.o=.d)
 IOLIB        := $(LPATH)/libRIO.$(SOEXT)
 IOMAP        := $(IOLIB:.$(SOEXT)=.rootmap)
 
+ifeq ($(BUILDURING),yes)
+IOLIBEXTRA   += $(URINGLIBDIR) $(URINGCLILIB)
+endif
+
 # used in the main Makefile
 ALLHDRS      += $(patsubst $(MODDIRI)/%.h,include/%.h,$(IOH))
 ALLLIBS      += $(IOLIB)
@@ -70,3 +74,6 @@ distclean-$(MODNAME): clean-$(MODNAME)
 distclean::     distclean-$(MODNAME)
 
 ##### extra rules ######
+ifeq ($(BUILDURING),yes)
+$(call stripsrc,$(IODIRS)/TFile.o): CXXFLAGS += $(URINGINCDIR:%=-I%)
+endif
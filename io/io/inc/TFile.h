@@ -40,6 +40,7 @@ class TFileCacheWrite;
 class TProcessID;
 class TStopwatch;
 class TFilePrefetch;
+class TMutex;
 
 class TFile : public TDirectoryFile {
   friend class TDirectoryFile;
@@ -88,6 +89,12 @@ protected:
    Bool_t           fIsArchive;      //!True if this is a pure archive file
    Bool_t           fNoAnchorInName; //!True if we don't want to force the anchor to be appended to the file name
    Bool_t           fIsRootFile;     //!True is this is a ROOT file, raw file otherwise
+   char            *fMapAddress;     //!Start of the read-only memory map of the file (0 if not mapped)
+   Long64_t         fMapSize;        //!Number of bytes in the memory map
+   void            *fReadRing;       //!io_uring of the vectored reads, created on first use (0 if none)
+   Bool_t           fReadRingTried;  //!True if the creation of fReadRing was attempted
+   TMutex          *fReadRingMutex;  //!Serializes the use of fReadRing by several threads
+   Bool_t           fVectoredReads;  //!True if ReadBuffers may use vectored reads (TFile.VectoredReads)
    Bool_t           fInitDone;       //!True if the file has been initialized
    Bool_t           fMustFlush;      //!True if the file buffers must be flushed
    TFileOpenHandle *fAsyncHandle;    //!For proper automatic cleanup
@@ -115,6 +122,11 @@ protected:
    virtual void  Init(Bool_t create);
    Bool_t        FlushWriteCache();
    Int_t         ReadBufferViaCache(char *buf, Int_t len);
+   Bool_t        ReadBuffersVectored(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf);
+   Bool_t        CreateReadRing();
+   void          ReleaseReadRing();
+   Bool_t        MapMemory();
+   void          UnmapMemory();
    Int_t         WriteBufferViaCache(const char *buf, Int_t len);
 
    // Creating projects
@@ -190,6 +202,7 @@ public:
    virtual Int_t       GetErrno() const;
    virtual void        ResetErrno() const;
    Int_t               GetFd() const { return fD; }
+   const char         *GetMappedBuffer(Long64_t pos, Int_t len);
    virtual const TUrl *GetEndpointUrl() const { return &fUrl; }
    TObjArray          *GetListOfProcessIDs() const {return fProcessIDs;}
    TList              *GetListOfFree() const { return fFree; }
@@ -214,6 +227,7 @@ public:
    virtual void        IncrementProcessIDs() { fNProcessIDs++; }
    virtual Bool_t      IsArchive() const { return fIsArchive; }
            Bool_t      IsBinary() const { return TestBit(kBinaryFile); }
+           Bool_t      IsMapped() const { return fMapAddress != 0 && !IsWritable(); }
            Bool_t      IsRaw() const { return !fIsRootFile; }
    virtual Bool_t      IsOpen() const;
    virtual void        ls(Option_t *option="") const;
@@ -84,6 +84,7 @@ protected:
    Bool_t         fBIsTransferred;
 
    void SetEnablePrefetchingImpl(Bool_t setPrefetching = kFALSE); // Can not be virtual as it is called from the constructor.
+   Bool_t SubmitPrefetch();                                        // Hand the registered blocks to the prefetching thread
    
 private:
    TFileCacheRead(const TFileCacheRead &);            //cannot be copied
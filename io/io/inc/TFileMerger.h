@@ -65,8 +65,10 @@ protected:
    TString        fObjectNames;     // List of object names to be either merged exclusively or skipped
    TList         *fMergeList;       // list of TObjString containing the name of the files need to be merged
    TList         *fExcessFiles;     //! List of TObjString containing the name of the files not yet added to fFileList due to user or system limitiation on the max number of files opened.
+   Int_t          fNThreads;        //! Number of threads merging groups of input files concurrently (0: sequential, default)
 
    Bool_t         OpenExcessFiles();
+   Bool_t         MergeGroups(Int_t type, Int_t ngroups);
    virtual Bool_t AddFile(TFile *source, Bool_t own, Bool_t cpProgress);
    virtual Bool_t MergeRecursive(TDirectory *target, TList *sourcelist, Int_t type = kRegular | kAll);
 
@@ -94,6 +96,8 @@ public:
    TFile      *GetOutputFile() const { return fOutputFile; }
    Int_t       GetMaxOpenedFies() const { return fMaxOpenedFiles; }
    void        SetMaxOpenedFiles(Int_t newmax);
+   Int_t       GetNThreads() const { return fNThreads; }
+   void        SetNThreads(Int_t nthreads = -1);
    const char *GetMsgPrefix() const { return fMsgPrefix; }
    void        SetMsgPrefix(const char *prefix);
    void        AddObjectNames(const char *name) {fObjectNames += name; fObjectNames += " ";}
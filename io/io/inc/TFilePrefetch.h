@@ -26,6 +26,10 @@
 // enabled by the user. Both capabilities are disabled by default       //
 // and must be explicitly enabled by the user.                          //
 //                                                                      //
+// The requesting thread may ask for blocks ahead of the one it is      //
+// using (see TTreeCache): up to GetLookAhead() blocks are kept ready   //
+// in memory, within the limit given by SetMemoryBudget().              //
+//                                                                      //
 //////////////////////////////////////////////////////////////////////////
 
 #ifndef ROOT_TFile
@@ -80,12 +84,30 @@ private:
    TSemaphore *fSemMasterWorker;   // semaphore used to kill the consumer thread
    TSemaphore *fSemWorkerMaster;   // semaphore used to notify the master that worker is killed
    TSemaphore *fSemChangeFile;     // semaphore used when changin a file in TChain
+   TCondition *fBlockConsumed;     // signal that the consumer moved to a new block or is waiting
+   TFPBlock   *fReadingBlock;      // block being read by the worker thread
    TString     fPathCache;         // path to the cache directory
    TStopwatch  fWaitTime;          // time wating to prefetch a buffer (in usec)
    Bool_t      fThreadJoined;      // mark if async thread was joined
+   Int_t       fLookAhead;         // number of blocks requested ahead of the one being used
+   Int_t       fNConsumed;         // number of blocks at the head of the read list already used
+   Long64_t    fMemoryBudget;      // maximum size of the blocks kept in the read list (0 for no limit)
+   Long64_t    fReadBytes;         // size of the blocks in the read list
+   Bool_t      fConsumerWaiting;   // the consumer is waiting for a block to be read
+   Bool_t      fInterrupt;         // the worker must not wait for memory (file change or termination)
+   Long64_t    fNReadRequests;     // number of buffers requested by the consumer
+   Long64_t    fNStalls;           // number of requests which had to wait for their block
+   Long64_t    fNCoveredBlocks;    // number of blocks not read because already requested
+   Long64_t    fNMemoryWaits;      // number of times the worker waited for memory to be released
 
    static TThread::VoidRtnFunc_t ThreadProc(void*);  //create a joinable worker thread
 
+   Bool_t    CanRemoveFirstReadBlock() const;
+   Bool_t    IsCovered(TFPBlock*, Long64_t, Int_t) const;
+   Bool_t    IsRequested(Long64_t*, Int_t*, Int_t);
+   TFPBlock *RemoveFirstReadBlock();
+   void      WaitForMemory(TFPBlock*);
+
 public:
    TFilePrefetch(TFile*);
    virtual ~TFilePrefetch();
@@ -118,6 +140,15 @@ public:
    TCondition* GetCondNewBlock() const { return fNewBlockAdded; };
    void      WaitFinishPrefetch();
 
+   Int_t     GetLookAhead() const { return fLookAhead; }
+   Long64_t  GetMemoryBudget() const { return fMemoryBudget; }
+   Long64_t  GetNReadRequests() const { return fNReadRequests; }
+   Long64_t  GetNStalls() const { return fNStalls; }
+   Long64_t  GetNCoveredBlocks() const { return fNCoveredBlocks; }
+   Long64_t  GetNMemoryWaits() const { return fNMemoryWaits; }
+   void      SetLookAhead(Int_t nblocks);
+   void      SetMemoryBudget(Long64_t bytes);
+
    ClassDef(TFilePrefetch, 0);  // File block prefetcher
 };
 
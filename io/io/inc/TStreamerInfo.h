@@ -111,6 +111,7 @@ private:
 
    static  Int_t     fgCount;            //Number of TStreamerInfo instances
    static TStreamerElement *fgElement;   //Pointer to current TStreamerElement
+   static  Int_t     fgJit;              //Number of uses before compiling the action sequences (see SetJit)
    static Double_t   GetValueAux(Int_t type, void *ladd, int k, Int_t len);
    static void       PrintValueAux(char *ladd, Int_t atype, TStreamerElement * aElement, Int_t aleng, Int_t *count);
 
@@ -275,6 +276,8 @@ public:
    virtual TClassStreamer *GenExplicitClassStreamer( const ::ROOT::TCollectionProxyInfo &info, TClass *cl );
 
    static TStreamerElement   *GetCurrentElement();
+   static Int_t        GetJit();
+   static void         SetJit(Int_t nuses=1);
 
 
 #ifdef R__BROKEN_FUNCTION_TEMPLATES
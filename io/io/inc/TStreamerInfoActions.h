@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "TStreamerInfo.h"
+#include "TAtomicCount.h"
 #include <assert.h>
 
 namespace TStreamerInfoActions {
@@ -121,10 +122,13 @@ namespace TStreamerInfoActions {
    };
    
    typedef std::vector<TConfiguredAction> ActionContainer_t;
+
+   typedef Int_t (*TStreamerInfoFusedAction_t)(TBuffer &buf, void *obj, const TConfiguredAction *actions);
    class TActionSequence : public TObject {
-      TActionSequence() {};
+      TActionSequence() : fFusedAction(0), fFuseTried(kFALSE), fNApplied(0) {};
+      TStreamerInfoFusedAction_t CompileFused() const;
    public:
-      TActionSequence(TVirtualStreamerInfo *info, UInt_t maxdata) : fStreamerInfo(info), fLoopConfig(0) { fActions.reserve(maxdata); };
+      TActionSequence(TVirtualStreamerInfo *info, UInt_t maxdata) : fStreamerInfo(info), fLoopConfig(0), fFusedAction(0), fFuseTried(kFALSE), fNApplied(0) { fActions.reserve(maxdata); };
       ~TActionSequence() { 
          delete fLoopConfig; 
       }
@@ -140,8 +144,12 @@ namespace TStreamerInfoActions {
       TVirtualStreamerInfo *fStreamerInfo; // StreamerInfo used to derive these actions.
       TLoopConfiguration   *fLoopConfig;   // If this is a bundle of memberwise streaming action, this configures the looping
       ActionContainer_t     fActions;
+      TStreamerInfoFusedAction_t fFusedAction; //! Compiled equivalent of the object wise loop on fActions (see Fuse)
+      Bool_t                fFuseTried;    //! True once Fuse compiled (or failed to compile) fFusedAction, protected by gInterpreterMutex
+      TAtomicCount          fNApplied;     //! Number of object wise applications before the call to Fuse, -1 once fFusedAction is final
 
       void AddToOffset(Int_t delta);
+      Bool_t Fuse();
       
       TActionSequence *CreateCopy();      
       static TActionSequence *CreateReadMemberWiseActions(TVirtualStreamerInfo *info, TVirtualCollectionProxy &proxy);
@@ -37,13 +37,12 @@
 #include "TStreamerInfoActions.h"
 #include "TArrayC.h"
 
-#if (defined(__linux) || defined(__APPLE__)) && defined(__i386__) && \
-     defined(__GNUC__)
+#if (defined(__linux) || defined(__APPLE__)) && defined(__GNUC__) && \
+    (defined(__i386__) || defined(__x86_64__))
+#include "Bswapcpy.h"
+#if defined(__i386__) || defined(R__BSWAPCPY_SIMD)
 #define USE_BSWAPCPY
 #endif
-
-#ifdef USE_BSWAPCPY
-#include "Bswapcpy.h"
 #endif
 
 
@@ -55,6 +54,7 @@ const UInt_t kMaxMapCount       = 0x3FFFFFFE;  // last valid fMapCount and byte
 const Version_t kByteCountVMask = 0x4000;      // OR the version byte count with this
 const Version_t kMaxVersion     = 0x3FFF;      // highest possible version number
 const Int_t  kMapOffset         = 2;   // first 2 map entries are taken by null obj and self obj
+const Int_t  kFloat16Chunk      = 256; // elements converted per bulk byte swap of Float16_t/Double32_t arrays
 
 Int_t TBufferFile::fgMapSize   = kMapSize;
 
@@ -820,8 +820,13 @@ Int_t TBufferFile::ReadArray(Long64_t *&ll)
    if (!ll) ll = new Long64_t[n];
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(ll, fBufCur, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       frombuf(fBufCur, &ll[i]);
+# endif
 #else
    memcpy(ll, fBufCur, l);
    fBufCur += l;
@@ -881,8 +886,13 @@ Int_t TBufferFile::ReadArray(Double_t *&d)
    if (!d) d = new Double_t[n];
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(d, fBufCur, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       frombuf(fBufCur, &d[i]);
+# endif
 #else
    memcpy(d, fBufCur, l);
    fBufCur += l;
@@ -1090,8 +1100,13 @@ Int_t TBufferFile::ReadStaticArray(Long64_t *ll)
    if (!ll) return 0;
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(ll, fBufCur, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       frombuf(fBufCur, &ll[i]);
+# endif
 #else
    memcpy(ll, fBufCur, l);
    fBufCur += l;
@@ -1149,8 +1164,13 @@ Int_t TBufferFile::ReadStaticArray(Double_t *d)
    if (!d) return 0;
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(d, fBufCur, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       frombuf(fBufCur, &d[i]);
+# endif
 #else
    memcpy(d, fBufCur, l);
    fBufCur += l;
@@ -1327,8 +1347,13 @@ void TBufferFile::ReadFastArray(Long64_t *ll, Int_t n)
    if (l <= 0 || l > fBufSize) return;
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(ll, fBufCur, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       frombuf(fBufCur, &ll[i]);
+# endif
 #else
    memcpy(ll, fBufCur, l);
    fBufCur += l;
@@ -1366,8 +1391,13 @@ void TBufferFile::ReadFastArray(Double_t *d, Int_t n)
    if (l <= 0 || l > fBufSize) return;
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(d, fBufCur, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       frombuf(fBufCur, &d[i]);
+# endif
 #else
    memcpy(d, fBufCur, l);
    fBufCur += l;
@@ -1384,33 +1414,11 @@ void TBufferFile::ReadFastArrayFloat16(Float_t *f, Int_t n, TStreamerElement *el
 
    if (ele && ele->GetFactor() != 0) {
       //a range was specified. We read an integer and convert it back to a float
-      Double_t xmin = ele->GetXmin();
-      Double_t factor = ele->GetFactor();
-      for (int j=0;j < n; j++) {
-         UInt_t aint; *this >> aint; f[j] = (Float_t)(aint/factor + xmin);
-      }
+      TBufferFile::ReadFastArrayWithFactor(f, n, ele->GetFactor(), ele->GetXmin());
    } else {
-      Int_t i;
       Int_t nbits = 0;
       if (ele) nbits = (Int_t)ele->GetXmin();
-      if (!nbits) nbits = 12;
-      //we read the exponent and the truncated mantissa of the float
-      //and rebuild the new float.
-      union {
-         Float_t fFloatValue;
-         Int_t   fIntValue;
-      };
-      UChar_t  theExp;
-      UShort_t theMan;
-      for (i = 0; i < n; i++) {
-         *this >> theExp;
-         *this >> theMan;
-         fIntValue = theExp;
-         fIntValue <<= 23;
-         fIntValue |= (theMan & ((1<<(nbits+1))-1)) <<(23-nbits);
-         if(1<<(nbits+1) & theMan) fFloatValue = -fFloatValue;
-         f[i] = fFloatValue;
-      }
+      TBufferFile::ReadFastArrayWithNbits(f, n, nbits);
    }
 }
 
@@ -1422,9 +1430,13 @@ void TBufferFile::ReadFastArrayWithFactor(Float_t *ptr, Int_t n, Double_t factor
 
    if (n <= 0 || 3*n > fBufSize) return;
 
-   //a range was specified. We read an integer and convert it back to a float
-   for (int j=0;j < n; j++) {
-      UInt_t aint; *this >> aint; ptr[j] = (Float_t)(aint/factor + minvalue);
+   //a range was specified. We read the integers by chunks, so that they are
+   //byte swapped in bulk, and convert them back to floats.
+   UInt_t aint[kFloat16Chunk];
+   for (Int_t j = 0; j < n; j += kFloat16Chunk) {
+      Int_t m = n-j < kFloat16Chunk ? n-j : kFloat16Chunk;
+      TBufferFile::ReadFastArray(aint, m);
+      for (Int_t k = 0; k < m; k++) ptr[j+k] = (Float_t)(aint[k]/factor + minvalue);
    }
 }
 
@@ -1438,22 +1450,22 @@ void TBufferFile::ReadFastArrayWithNbits(Float_t *ptr, Int_t n, Int_t nbits)
 
    if (!nbits) nbits = 12;
    //we read the exponent and the truncated mantissa of the float
-   //and rebuild the new float.
+   //and rebuild the new float. The exponent (UChar_t) and the mantissa
+   //(big endian UShort_t) are decoded directly from the buffer.
    union {
       Float_t fFloatValue;
       Int_t   fIntValue;
    };
-   UChar_t  theExp;
-   UShort_t theMan;
-   for (Int_t i = 0; i < n; i++) {
-      *this >> theExp;
-      *this >> theMan;
-      fIntValue = theExp;
+   const UChar_t *buf = (const UChar_t *)fBufCur;
+   for (Int_t i = 0; i < n; i++, buf += 3) {
+      UShort_t theMan = (UShort_t)((buf[1] << 8) | buf[2]);
+      fIntValue = buf[0];
       fIntValue <<= 23;
       fIntValue |= (theMan & ((1<<(nbits+1))-1)) <<(23-nbits);
       if(1<<(nbits+1) & theMan) fFloatValue = -fFloatValue;
       ptr[i] = fFloatValue;
    }
+   fBufCur = (char *)buf;
 }
 
 //______________________________________________________________________________
@@ -1466,41 +1478,11 @@ void TBufferFile::ReadFastArrayDouble32(Double_t *d, Int_t n, TStreamerElement *
 
    if (ele && ele->GetFactor() != 0) {
       //a range was specified. We read an integer and convert it back to a double.
-      Double_t xmin = ele->GetXmin();
-      Double_t factor = ele->GetFactor();
-      for (int j=0;j < n; j++) {
-         UInt_t aint; *this >> aint; d[j] = (Double_t)(aint/factor + xmin);
-      }
+      TBufferFile::ReadFastArrayWithFactor(d, n, ele->GetFactor(), ele->GetXmin());
    } else {
-      Int_t i;
       Int_t nbits = 0;
       if (ele) nbits = (Int_t)ele->GetXmin();
-      if (!nbits) {
-         //we read a float and convert it to double
-         Float_t afloat;
-         for (i = 0; i < n; i++) {
-            *this >> afloat;
-            d[i] = (Double_t)afloat;
-         }
-      } else {
-         //we read the exponent and the truncated mantissa of the float
-         //and rebuild the double.
-         union {
-            Float_t fFloatValue;
-            Int_t   fIntValue;
-         };
-         UChar_t  theExp;
-         UShort_t theMan;
-         for (i = 0; i < n; i++) {
-            *this >> theExp;
-            *this >> theMan;
-            fIntValue = theExp;
-            fIntValue <<= 23;
-            fIntValue |= (theMan & ((1<<(nbits+1))-1)) <<(23-nbits);
-            if (1<<(nbits+1) & theMan) fFloatValue = -fFloatValue;
-            d[i] = (Double_t)fFloatValue;
-         }
-      }
+      TBufferFile::ReadFastArrayWithNbits(d, n, nbits);
    }
 }
 
@@ -1512,9 +1494,13 @@ void TBufferFile::ReadFastArrayWithFactor(Double_t *d, Int_t n, Double_t factor,
 
    if (n <= 0 || 3*n > fBufSize) return;
 
-   //a range was specified. We read an integer and convert it back to a double.
-   for (int j=0;j < n; j++) {
-      UInt_t aint; *this >> aint; d[j] = (Double_t)(aint/factor + minvalue);
+   //a range was specified. We read the integers by chunks, so that they are
+   //byte swapped in bulk, and convert them back to doubles.
+   UInt_t aint[kFloat16Chunk];
+   for (Int_t j = 0; j < n; j += kFloat16Chunk) {
+      Int_t m = n-j < kFloat16Chunk ? n-j : kFloat16Chunk;
+      TBufferFile::ReadFastArray(aint, m);
+      for (Int_t k = 0; k < m; k++) d[j+k] = (Double_t)(aint[k]/factor + minvalue);
    }
 }
 
@@ -1527,30 +1513,32 @@ void TBufferFile::ReadFastArrayWithNbits(Double_t *d, Int_t n, Int_t nbits)
    if (n <= 0 || 3*n > fBufSize) return;
 
    if (!nbits) {
-      //we read a float and convert it to double
-      Float_t afloat;
-      for (Int_t i = 0; i < n; i++) {
-         *this >> afloat;
-         d[i] = (Double_t)afloat;
+      //we read the floats by chunks, byte swapped in bulk, and convert
+      //them to double
+      Float_t afloat[kFloat16Chunk];
+      for (Int_t j = 0; j < n; j += kFloat16Chunk) {
+         Int_t m = n-j < kFloat16Chunk ? n-j : kFloat16Chunk;
+         TBufferFile::ReadFastArray(afloat, m);
+         for (Int_t k = 0; k < m; k++) d[j+k] = (Double_t)afloat[k];
       }
    } else {
       //we read the exponent and the truncated mantissa of the float
-      //and rebuild the double.
+      //and rebuild the double. The exponent (UChar_t) and the mantissa
+      //(big endian UShort_t) are decoded directly from the buffer.
       union {
          Float_t fFloatValue;
          Int_t   fIntValue;
       };
-      UChar_t  theExp;
-      UShort_t theMan;
-      for (Int_t i = 0; i < n; i++) {
-         *this >> theExp;
-         *this >> theMan;
-         fIntValue = theExp;
+      const UChar_t *buf = (const UChar_t *)fBufCur;
+      for (Int_t i = 0; i < n; i++, buf += 3) {
+         UShort_t theMan = (UShort_t)((buf[1] << 8) | buf[2]);
+         fIntValue = buf[0];
          fIntValue <<= 23;
          fIntValue |= (theMan & ((1<<(nbits+1))-1)) <<(23-nbits);
          if (1<<(nbits+1) & theMan) fFloatValue = -fFloatValue;
          d[i] = (Double_t)fFloatValue;
       }
+      fBufCur = (char *)buf;
    }
 }
 
@@ -1797,8 +1785,13 @@ void TBufferFile::WriteArray(const Long64_t *ll, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(fBufCur, ll, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       tobuf(fBufCur, ll[i]);
+# endif
 #else
    memcpy(fBufCur, ll, l);
    fBufCur += l;
@@ -1852,8 +1845,13 @@ void TBufferFile::WriteArray(const Double_t *d, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(fBufCur, d, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       tobuf(fBufCur, d[i]);
+# endif
 #else
    memcpy(fBufCur, d, l);
    fBufCur += l;
@@ -2041,8 +2039,13 @@ void TBufferFile::WriteFastArray(const Long64_t *ll, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(fBufCur, ll, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       tobuf(fBufCur, ll[i]);
+# endif
 #else
    memcpy(fBufCur, ll, l);
    fBufCur += l;
@@ -2084,8 +2087,13 @@ void TBufferFile::WriteFastArray(const Double_t *d, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
+# ifdef USE_BSWAPCPY
+   bswapcpy64(fBufCur, d, n);
+   fBufCur += l;
+# else
    for (int i = 0; i < n; i++)
       tobuf(fBufCur, d[i]);
+# endif
 #else
    memcpy(fBufCur, d, l);
    fBufCur += l;
@@ -2107,14 +2115,20 @@ void TBufferFile::WriteFastArrayFloat16(const Float_t *f, Int_t n, TStreamerElem
       //A range is specified. We normalize the float to the range and
       //convert it to an integer using a scaling factor that is a function of nbits.
       //see TStreamerElement::GetRange.
+      //The integers are converted by chunks and byte swapped in bulk.
       Double_t factor = ele->GetFactor();
       Double_t xmin = ele->GetXmin();
       Double_t xmax = ele->GetXmax();
-      for (int j = 0; j < n; j++) {
-         Float_t x = f[j];
-         if (x < xmin) x = xmin;
-         if (x > xmax) x = xmax;
-         UInt_t aint = UInt_t(0.5+factor*(x-xmin)); *this << aint;
+      UInt_t aint[kFloat16Chunk];
+      for (Int_t j = 0; j < n; j += kFloat16Chunk) {
+         Int_t m = n-j < kFloat16Chunk ? n-j : kFloat16Chunk;
+         for (Int_t k = 0; k < m; k++) {
+            Float_t x = f[j+k];
+            if (x < xmin) x = xmin;
+            if (x > xmax) x = xmax;
+            aint[k] = UInt_t(0.5+factor*(x-xmin));
+         }
+         TBufferFile::WriteFastArray(aint, m);
       }
    } else {
       Int_t nbits = 0;
@@ -2125,11 +2139,13 @@ void TBufferFile::WriteFastArrayFloat16(const Float_t *f, Int_t n, TStreamerElem
       //a range is not specified, but nbits is.
       //In this case we truncate the mantissa to nbits and we stream
       //the exponent as a UChar_t and the mantissa as a UShort_t.
+      //Both are encoded directly into the buffer (already expanded above).
       union {
          Float_t fFloatValue;
          Int_t   fIntValue;
       };
-      for (i = 0; i < n; i++) {
+      UChar_t *buf = (UChar_t *)fBufCur;
+      for (i = 0; i < n; i++, buf += 3) {
          fFloatValue = f[i];
          UChar_t  theExp = (UChar_t)(0x000000ff & ((fIntValue<<1)>>24));
          UShort_t theMan = ((1<<(nbits+1))-1) & (fIntValue>>(23-nbits-1));
@@ -2137,9 +2153,11 @@ void TBufferFile::WriteFastArrayFloat16(const Float_t *f, Int_t n, TStreamerElem
          theMan = theMan>>1;
          if (theMan&1<<nbits) theMan = (1<<nbits) - 1;
          if (fFloatValue < 0) theMan |= 1<<(nbits+1);
-         *this << theExp;
-         *this << theMan;
+         buf[0] = theExp;
+         buf[1] = (UChar_t)(theMan >> 8);
+         buf[2] = (UChar_t)(theMan & 0xff);
       }
+      fBufCur = (char *)buf;
    }
 }
 
@@ -2158,14 +2176,20 @@ void TBufferFile::WriteFastArrayDouble32(const Double_t *d, Int_t n, TStreamerEl
       //A range is specified. We normalize the double to the range and
       //convert it to an integer using a scaling factor that is a function of nbits.
       //see TStreamerElement::GetRange.
+      //The integers are converted by chunks and byte swapped in bulk.
       Double_t factor = ele->GetFactor();
       Double_t xmin = ele->GetXmin();
       Double_t xmax = ele->GetXmax();
-      for (int j = 0; j < n; j++) {
-         Double_t x = d[j];
-         if (x < xmin) x = xmin;
-         if (x > xmax) x = xmax;
-         UInt_t aint = UInt_t(0.5+factor*(x-xmin)); *this << aint;
+      UInt_t aint[kFloat16Chunk];
+      for (Int_t j = 0; j < n; j += kFloat16Chunk) {
+         Int_t m = n-j < kFloat16Chunk ? n-j : kFloat16Chunk;
+         for (Int_t k = 0; k < m; k++) {
+            Double_t x = d[j+k];
+            if (x < xmin) x = xmin;
+            if (x > xmax) x = xmax;
+            aint[k] = UInt_t(0.5+factor*(x-xmin));
+         }
+         TBufferFile::WriteFastArray(aint, m);
       }
    } else {
       Int_t nbits = 0;
@@ -2174,19 +2198,24 @@ void TBufferFile::WriteFastArrayDouble32(const Double_t *d, Int_t n, TStreamerEl
       Int_t i;
       if (!nbits) {
          //if no range and no bits specified, we convert from double to float
-         for (i = 0; i < n; i++) {
-            Float_t afloat = (Float_t)d[i];
-            *this << afloat;
+         //by chunks and byte swap the floats in bulk
+         Float_t afloat[kFloat16Chunk];
+         for (Int_t j = 0; j < n; j += kFloat16Chunk) {
+            Int_t m = n-j < kFloat16Chunk ? n-j : kFloat16Chunk;
+            for (Int_t k = 0; k < m; k++) afloat[k] = (Float_t)d[j+k];
+            TBufferFile::WriteFastArray(afloat, m);
          }
       } else {
          //a range is not specified, but nbits is.
          //In this case we truncate the mantissa to nbits and we stream
          //the exponent as a UChar_t and the mantissa as a UShort_t.
+         //Both are encoded directly into the buffer (already expanded above).
          union {
             Float_t fFloatValue;
             Int_t   fIntValue;
          };
-         for (i = 0; i < n; i++) {
+         UChar_t *buf = (UChar_t *)fBufCur;
+         for (i = 0; i < n; i++, buf += 3) {
             fFloatValue = (Float_t)d[i];
             UChar_t  theExp = (UChar_t)(0x000000ff & ((fIntValue<<1)>>24));
             UShort_t theMan = ((1<<(nbits+1))-1) & (fIntValue>>(23-nbits-1));
@@ -2194,9 +2223,11 @@ void TBufferFile::WriteFastArrayDouble32(const Double_t *d, Int_t n, TStreamerEl
             theMan = theMan>>1;
             if(theMan&1<<nbits) theMan = (1<<nbits) - 1;
             if (fFloatValue < 0) theMan |= 1<<(nbits+1);
-            *this << theExp;
-            *this << theMan;
+            buf[0] = theExp;
+            buf[1] = (UChar_t)(theMan >> 8);
+            buf[2] = (UChar_t)(theMan & 0xff);
          }
+         fBufCur = (char *)buf;
       }
    }
 }
@@ -3838,6 +3869,17 @@ Int_t TBufferFile::ApplySequence(const TStreamerInfoActions::TActionSequence &se
       }
 
    } else {
+      // The compiled sequence calls the TBufferFile streaming functions
+      // directly, it can not be used by the derived classes.
+      // fFusedAction is only read once fNApplied is negative (see Fuse).
+      if ((sequence.fNApplied < 0 || TStreamerInfo::GetJit() > 0) && IsA() == TBufferFile::Class()) {
+         TStreamerInfoActions::TActionSequence &seq = const_cast<TStreamerInfoActions::TActionSequence&>(sequence);
+         if (seq.fNApplied >= 0) {
+            ++seq.fNApplied;
+            if (seq.fNApplied >= TStreamerInfo::GetJit()) seq.Fuse();
+         }
+         if (seq.fNApplied < 0 && seq.fFusedAction) return seq.fFusedAction(*this,obj,&seq.fActions[0]);
+      }
       //loop on all active members
       TStreamerInfoActions::ActionContainer_t::const_iterator end = sequence.fActions.end();
       for(TStreamerInfoActions::ActionContainer_t::const_iterator iter = sequence.fActions.begin();
@@ -70,11 +70,16 @@
 #include <sys/stat.h>
 #ifndef WIN32
 #   include <unistd.h>
+#   include <sys/mman.h>
 #else
 #   define ssize_t int
 #   include <io.h>
 #   include <sys/types.h>
 #endif
+#ifdef R__LINUX
+#   include <sys/uio.h>
+#   include <vector>
+#endif
 
 #include "Bytes.h"
 #include "Compression.h"
@@ -108,6 +113,7 @@
 #include "TEnv.h"
 #include "TVirtualMonitoring.h"
 #include "TVirtualMutex.h"
+#include "TMutex.h"
 #include "TMathBase.h"
 #include "TObjString.h"
 #include "TStopwatch.h"
@@ -118,6 +124,10 @@
 #include "TSchemaRuleSet.h"
 #include "TThreadSlots.h"
 
+#ifdef R__HAS_URING
+#include <liburing.h>
+#endif
+
 using std::sqrt;
 
 Long64_t TFile::fgBytesRead  = 0;
@@ -165,6 +175,12 @@ TFile::TFile() : TDirectoryFile(), fInfoCache(0)
    fNoAnchorInName  = kFALSE;
    fIsRootFile      = kTRUE;
    fIsArchive       = kFALSE;
+   fMapAddress      = 0;
+   fMapSize         = 0;
+   fReadRing        = 0;
+   fReadRingTried   = kFALSE;
+   fReadRingMutex   = 0;
+   fVectoredReads   = kFALSE;
    fInitDone        = kFALSE;
    fMustFlush       = kTRUE;
    fAsyncHandle     = 0;
@@ -210,6 +226,12 @@ TFile::TFile(const char *fname1, Option_t *option, const char *ftitle, Int_t com
    //           = UPDATE          open an existing file for writing.
    //                             if no file exists, it is created.
    //           = READ            open an existing file for reading (default).
+   //           = MMAP            open an existing local file for reading and
+   //                             map it read-only in memory. The baskets of
+   //                             uncompressed branches then use the mapped
+   //                             bytes in place instead of a copy (see
+   //                             GetMappedBuffer). If the file cannot be
+   //                             mapped it is simply opened for reading.
    //           = NET             used by derived remote file access
    //                             classes, not a user callable option
    //           = WEB             used by derived remote http access
@@ -346,6 +368,16 @@ TFile::TFile(const char *fname1, Option_t *option, const char *ftitle, Int_t com
    fCacheReadMap = new TMap();
    fCacheWrite   = 0;
    fReadCalls    = 0;
+   fMapAddress   = 0;
+   fMapSize      = 0;
+   fReadRing     = 0;
+   fReadRingTried = kFALSE;
+#ifdef R__HAS_URING
+   fReadRingMutex = new TMutex();
+#else
+   fReadRingMutex = 0;
+#endif
+   fVectoredReads = gEnv->GetValue("TFile.VectoredReads", 1) != 0;
    SetBit(kBinaryFile, kTRUE);
 
    fOption.ToUpper();
@@ -376,6 +408,12 @@ TFile::TFile(const char *fname1, Option_t *option, const char *ftitle, Int_t com
    if (fOption == "NEW")
       fOption = "CREATE";
 
+   Bool_t mapped = kFALSE;
+   if (fOption == "MMAP") {
+      mapped  = kTRUE;
+      fOption = "READ";
+   }
+
    Bool_t create   = (fOption == "CREATE") ? kTRUE : kFALSE;
    Bool_t recreate = (fOption == "RECREATE") ? kTRUE : kFALSE;
    Bool_t update   = (fOption == "UPDATE") ? kTRUE : kFALSE;
@@ -475,6 +513,8 @@ TFile::TFile(const char *fname1, Option_t *option, const char *ftitle, Int_t com
          goto zombie;
       }
       fWritable = kFALSE;
+      if (mapped)
+         MapMemory();
    }
 
    Init(create);
@@ -505,6 +545,9 @@ TFile::~TFile()
    // File destructor.
 
    Close();
+   UnmapMemory();
+   ReleaseReadRing();
+   SafeDelete(fReadRingMutex);
 
    SafeDelete(fAsyncHandle);
    SafeDelete(fCacheRead);
@@ -863,6 +906,8 @@ void TFile::Close(Option_t *option)
 
    if (fIsArchive || !fIsRootFile) {
       FlushWriteCache();
+      UnmapMemory();
+      ReleaseReadRing();
       SysClose(fD);
       fD = -1;
 
@@ -914,6 +959,8 @@ void TFile::Close(Option_t *option)
    }
 
    if (IsOpen()) {
+      UnmapMemory();
+      ReleaseReadRing();
       SysClose(fD);
       fD = -1;
    }
@@ -1157,6 +1204,76 @@ TFileCacheWrite *TFile::GetCacheWrite() const
    return fCacheWrite;
 }
 
+//______________________________________________________________________________
+const char *TFile::GetMappedBuffer(Long64_t pos, Int_t len)
+{
+   // Return the address of the len bytes at the offset 'pos' in the file
+   // if the file was opened with option "MMAP", 0 otherwise (or if the
+   // bytes are not in the mapped range). The bytes are read-only and stay
+   // valid until the file is closed. They are counted as read from the
+   // file, but no read call is issued.
+   // Once the file is writable (ReOpen("UPDATE")) the map is not used
+   // anymore, since it does not see the data held by the write cache.
+
+   if (!IsMapped() || pos < 0 || len <= 0)
+      return 0;
+   pos += fArchiveOffset;
+   if (pos + len > fMapSize)
+      return 0;
+
+   fBytesRead  += len;
+   fgBytesRead += len;
+   return fMapAddress + pos;
+}
+
+//______________________________________________________________________________
+Bool_t TFile::MapMemory()
+{
+   // Map the whole file read-only in memory (option "MMAP" of the
+   // constructor). The mapping is shared, so several processes reading the
+   // same file share the page cache instead of each holding a copy of the
+   // data. Returns kFALSE if the file could not be mapped, in which case
+   // it is read with the usual system calls.
+
+#ifndef WIN32
+   struct stat sbuf;
+   if (fD < 0 || fstat(fD, &sbuf) < 0 || sbuf.st_size <= 0)
+      return kFALSE;
+   if ((Long64_t)(size_t)sbuf.st_size != (Long64_t)sbuf.st_size) {
+      Warning("MapMemory", "file %s is too large to be mapped, reading it with system calls",
+              GetName());
+      return kFALSE;
+   }
+   void *addr = mmap(0, (size_t)sbuf.st_size, PROT_READ, MAP_SHARED, fD, 0);
+   if (addr == MAP_FAILED) {
+      SysError("MapMemory", "cannot map file %s in memory, reading it with system calls",
+               GetName());
+      return kFALSE;
+   }
+   fMapAddress = (char *)addr;
+   fMapSize    = sbuf.st_size;
+   return kTRUE;
+#else
+   Warning("MapMemory", "memory mapped files are not supported on this platform, "
+           "reading %s with system calls", GetName());
+   return kFALSE;
+#endif
+}
+
+//______________________________________________________________________________
+void TFile::UnmapMemory()
+{
+   // Release the memory map of the file, if any. The buffers previously
+   // returned by GetMappedBuffer must not be used anymore.
+
+#ifndef WIN32
+   if (fMapAddress)
+      munmap(fMapAddress, (size_t)fMapSize);
+#endif
+   fMapAddress = 0;
+   fMapSize    = 0;
+}
+
 //______________________________________________________________________________
 Int_t TFile::GetRecordHeader(char *buf, Long64_t first, Int_t maxbytes, Int_t &nbytes, Int_t &objlen, Int_t &keylen)
 {
@@ -1566,6 +1683,261 @@ Bool_t TFile::ReadBuffer(char *buf, Int_t len)
    return kTRUE;
 }
 
+#ifdef R__LINUX
+namespace {
+
+   // Largest hole between two requested blocks read (and dropped) by the
+   // vectored reads instead of starting a new read.
+   const Int_t kVectoredMaxGap = 4096;
+   // Maximum number of buffers of one vectored read (IOV_MAX is 1024 on Linux).
+   const Int_t kVectoredMaxIov = 1024;
+   // Maximum number of reads in flight in the io_uring submission queue.
+   const Int_t kVectoredQueueDepth = 64;
+
+   struct TVectoredRead {
+      Long64_t fOffset;    // position in the file
+      Long64_t fLen;       // number of bytes, holes included
+      Int_t    fFirstIov;  // first buffer in the iovec array
+      Int_t    fNiov;      // number of buffers
+   };
+
+   //___________________________________________________________________________
+   Int_t R__PreadvAll(Int_t fd, const struct iovec *iov, Int_t niov, Long64_t offset)
+   {
+      // Read the full extent described by the niov buffers, retrying on
+      // interruption and on short reads. Returns 0 or the errno value.
+
+      std::vector<struct iovec> left(iov, iov + niov);
+      struct iovec *cur = &left[0];
+      while (niov > 0) {
+         ssize_t siz = preadv(fd, cur, niov, offset);
+         if (siz < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+         }
+         if (siz == 0) return EIO; // unexpected end of file
+         offset += siz;
+         while (niov > 0 && (size_t)siz >= cur->iov_len) {
+            siz -= cur->iov_len;
+            ++cur;
+            --niov;
+         }
+         if (niov > 0) {
+            cur->iov_base = (char*)cur->iov_base + siz;
+            cur->iov_len -= siz;
+         }
+      }
+      return 0;
+   }
+
+#ifdef R__HAS_URING
+   //___________________________________________________________________________
+   Int_t R__ReadVectoredUring(struct io_uring &ring, Int_t fd, std::vector<TVectoredRead> &reads,
+                              std::vector<struct iovec> &iov, Long64_t archiveOffset)
+   {
+      // Submit all the reads to the io_uring and collect them in whatever
+      // order they complete. Returns 0 or the errno value of a failed read.
+      // The ring is empty again on return.
+
+      Int_t nreads = reads.size();
+      Int_t depth = kVectoredQueueDepth;
+
+      Int_t err = 0;
+      Int_t submitted = 0, completed = 0, inflight = 0;
+      while (completed < nreads) {
+         while (!err && submitted < nreads && inflight < depth) {
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+            if (!sqe) break;
+            const TVectoredRead &r = reads[submitted];
+            io_uring_prep_readv(sqe, fd, &iov[r.fFirstIov], r.fNiov, r.fOffset + archiveOffset);
+            io_uring_sqe_set_data(sqe, (void*)(Long_t)submitted);
+            ++submitted;
+            ++inflight;
+         }
+         if (inflight == 0) break;
+         Int_t rc = io_uring_submit_and_wait(&ring, 1);
+         if (rc < 0 && rc != -EINTR) { err = -rc; break; }
+
+         struct io_uring_cqe *cqe = 0;
+         while (io_uring_peek_cqe(&ring, &cqe) == 0 && cqe) {
+            const TVectoredRead &r = reads[(Long_t)io_uring_cqe_get_data(cqe)];
+            Int_t res = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+            --inflight;
+            ++completed;
+            if (err) continue;
+            if (res == -EINTR || res == -EAGAIN) res = 0;
+            if (res < 0) {
+               err = -res;
+            } else if (res < r.fLen) {
+               // Short read: finish this one synchronously
+               std::vector<struct iovec> rest(iov.begin() + r.fFirstIov,
+                                              iov.begin() + r.fFirstIov + r.fNiov);
+               Int_t done = res, k = 0;
+               while (done >= (Int_t)rest[k].iov_len) done -= rest[k++].iov_len;
+               rest[k].iov_base = (char*)rest[k].iov_base + done;
+               rest[k].iov_len -= done;
+               err = R__PreadvAll(fd, &rest[k], r.fNiov - k, r.fOffset + archiveOffset + res);
+            }
+         }
+      }
+      // Do not leave the kernel writing into the buffers after we return
+      while (inflight > 0) {
+         struct io_uring_cqe *cqe = 0;
+         if (io_uring_wait_cqe(&ring, &cqe) < 0) break;
+         io_uring_cqe_seen(&ring, cqe);
+         --inflight;
+      }
+      return err;
+   }
+#endif
+}
+#endif
+
+//______________________________________________________________________________
+Bool_t TFile::CreateReadRing()
+{
+   // Set up the io_uring used by ReadBuffersVectored, the first time it is
+   // needed. The ring is kept until the file is closed. Returns kFALSE if
+   // io_uring is not available (built without R__HAS_URING, or too old
+   // kernel), in which case the reads are done with preadv; the creation
+   // is then not attempted again for this file.
+   // Must be called with fReadRingMutex locked.
+
+#ifdef R__HAS_URING
+   if (!fReadRing && !fReadRingTried) {
+      fReadRingTried = kTRUE;
+      struct io_uring *ring = new struct io_uring;
+      if (io_uring_queue_init(kVectoredQueueDepth, ring, 0) < 0)
+         delete ring;
+      else
+         fReadRing = ring;
+   }
+   return fReadRing != 0;
+#else
+   return kFALSE;
+#endif
+}
+
+//______________________________________________________________________________
+void TFile::ReleaseReadRing()
+{
+   // Tear down the io_uring of the vectored reads, if any.
+
+   R__LOCKGUARD(fReadRingMutex);
+#ifdef R__HAS_URING
+   if (fReadRing) {
+      struct io_uring *ring = (struct io_uring*)fReadRing;
+      io_uring_queue_exit(ring);
+      delete ring;
+   }
+#endif
+   fReadRing      = 0;
+   fReadRingTried = kFALSE;
+}
+
+//______________________________________________________________________________
+Bool_t TFile::ReadBuffersVectored(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
+{
+   // Read the nbuf blocks with vectored reads on the local file descriptor,
+   // without moving the file pointer. Blocks separated by small holes are
+   // read together by one preadv(), the holes being dropped; all the reads
+   // are submitted at once to io_uring when available (R__HAS_URING) and
+   // completed in any order, otherwise they are issued one after the other.
+   // The ring of the file is used by one thread at a time (e.g. the main
+   // thread and the TFilePrefetch thread); a thread finding it busy uses
+   // preadv instead of waiting.
+   // Returns kTRUE in case of failure.
+
+#ifdef R__LINUX
+   Double_t start = 0;
+   if (gPerfStats != 0) start = TTimeStamp();
+
+   // The content of the holes is not used, they all go to this buffer.
+   std::vector<char> holeBuffer;
+
+   std::vector<TVectoredRead> reads;
+   std::vector<struct iovec> iov;
+   iov.reserve(nbuf);
+   Long64_t requested = 0, holes = 0;
+   Long64_t k = 0;
+   for (Int_t i = 0; i < nbuf; i++) {
+      Bool_t extend = !reads.empty();
+      Long64_t gap = 0;
+      if (extend) {
+         TVectoredRead &last = reads.back();
+         gap = pos[i] - (last.fOffset + last.fLen);
+         extend = gap >= 0 && gap <= kVectoredMaxGap && last.fNiov + 2 <= kVectoredMaxIov;
+      }
+      if (!extend) {
+         TVectoredRead r;
+         r.fOffset = pos[i];
+         r.fLen = 0;
+         r.fFirstIov = iov.size();
+         r.fNiov = 0;
+         reads.push_back(r);
+         gap = 0;
+      }
+      TVectoredRead &r = reads.back();
+      struct iovec v;
+      if (gap > 0) {
+         if (holeBuffer.empty()) holeBuffer.resize(kVectoredMaxGap);
+         v.iov_base = &holeBuffer[0];
+         v.iov_len = gap;
+         iov.push_back(v);
+         r.fNiov++;
+         r.fLen += gap;
+         holes += gap;
+      }
+      v.iov_base = buf + k;
+      v.iov_len = len[i];
+      iov.push_back(v);
+      r.fNiov++;
+      r.fLen += len[i];
+      k += len[i];
+      requested += len[i];
+   }
+
+   Int_t err = -1;
+#ifdef R__HAS_URING
+   if (reads.size() > 1) {
+      if (fReadRingMutex->TryLock() == 0) {
+         if (CreateReadRing())
+            err = R__ReadVectoredUring(*(struct io_uring*)fReadRing, fD, reads, iov, fArchiveOffset);
+         fReadRingMutex->UnLock();
+      }
+   }
+#endif
+   if (err < 0) {
+      err = 0;
+      for (UInt_t r = 0; !err && r < reads.size(); r++)
+         err = R__PreadvAll(fD, &iov[reads[r].fFirstIov], reads[r].fNiov,
+                            reads[r].fOffset + fArchiveOffset);
+   }
+   if (err) {
+      errno = err;
+      SysError("ReadBuffers", "error reading from file %s", GetName());
+      return kTRUE;
+   }
+
+   fBytesRead      += requested;
+   fgBytesRead     += requested;
+   fBytesReadExtra += holes;
+   fReadCalls      += reads.size();
+   fgReadCalls     += reads.size();
+
+   if (gMonitoringWriter)
+      gMonitoringWriter->SendFileReadProgress(this);
+   if (gPerfStats != 0) {
+      gPerfStats->FileReadEvent(this, requested, start);
+   }
+   return kFALSE;
+#else
+   (void) buf; (void) pos; (void) len; (void) nbuf;
+   return kTRUE;
+#endif
+}
+
 //______________________________________________________________________________
 Bool_t TFile::ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
 {
@@ -1585,6 +1957,13 @@ Bool_t TFile::ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
       return kFALSE;
    }
 
+#ifdef R__LINUX
+   // Plain local files (not specializations with their own SysRead) are
+   // read with vectored reads, unless data may still be in the write cache.
+   if (fVectoredReads && IsA() == TFile::Class() && fD >= 0 && !(fWritable && fCacheWrite))
+      return ReadBuffersVectored(buf, pos, len, nbuf);
+#endif
+
    Int_t k = 0;
    Bool_t result = kTRUE;
    TFileCacheRead *old = fCacheRead;
@@ -1942,7 +2321,8 @@ Int_t TFile::ReOpen(Option_t *mode)
    } else {
       // switch to UPDATE mode
 
-      // close readonly file
+      // close readonly file (a memory map stays valid, its pages
+      // reflect what is written in update mode)
       if (IsOpen()) {
          SysClose(fD);
          fD = -1;
@@ -3743,6 +4123,10 @@ TFile *TFile::Open(const char *url, Option_t *options, const char *ftitle,
    //                If the download fails, it will be opened remotely.
    //                The file will be downloaded to the directory specified by
    //                SetCacheFileDir().
+   //
+   // For local files there is the option:
+   //  MMAP          opens an existing file for reading and maps it read-only
+   //                in memory, see the TFile constructor.
 
    TPluginHandler *h;
    TFile *f = 0;
@@ -332,6 +332,9 @@ void TFileCacheRead::Print(Option_t *option) const
    if (fPrefetch){
      printf("Prefetching .......................: %lli blocks\n", fPrefetchedBlocks);
      printf("Prefetching Wait Time..............: %f seconds\n", fPrefetch->GetWaitTime() / 1e+6);
+     printf("Prefetching Look Ahead.............: %d blocks, memory budget: %lld bytes\n", fPrefetch->GetLookAhead(), fPrefetch->GetMemoryBudget());
+     printf("Prefetching Stalls.................: %lld out of %lld requests\n", fPrefetch->GetNStalls(), fPrefetch->GetNReadRequests());
+     printf("Prefetching Blocks Read Ahead......: %lld, waits for memory: %lld\n", fPrefetch->GetNCoveredBlocks(), fPrefetch->GetNMemoryWaits());
    }
 
    if (!opt.Contains("a")) return;
@@ -381,24 +384,36 @@ Int_t TFileCacheRead::ReadBufferExt(char *buf, Long64_t pos, Int_t len, Int_t &l
 
 
 //_____________________________________________________________________________
-Int_t TFileCacheRead::ReadBufferExtPrefetch(char *buf, Long64_t pos, Int_t len, Int_t &loc)
+Bool_t TFileCacheRead::SubmitPrefetch()
 {
-   //prefetch the first block                                                                                                                            
+   // Hand to the prefetching thread the blocks registered since the last
+   // call, first block first. Returns kTRUE if a block was submitted.
+
+   Bool_t submitted = kFALSE;
+
+   //prefetch the first block
    if (fNseek > 0 && !fIsSorted) {
       Sort();
-      loc = -1;
       fPrefetch->ReadBlock(fPos, fLen, fNb);
       fPrefetchedBlocks++;
       fIsTransferred = kTRUE;
+      submitted = kTRUE;
    }
 
-   //try to prefetch the second block                                                                                                                        
+   //try to prefetch the second block
    if (fBNseek > 0 && !fBIsSorted) {
       SecondSort();
-      loc = -1;
       fPrefetch->ReadBlock(fBPos, fBLen, fBNb);
       fPrefetchedBlocks++;
+      submitted = kTRUE;
    }
+   return submitted;
+}
+
+//_____________________________________________________________________________
+Int_t TFileCacheRead::ReadBufferExtPrefetch(char *buf, Long64_t pos, Int_t len, Int_t &loc)
+{
+   if (SubmitPrefetch()) loc = -1;
 
    // in case we are writing and reading to/from this file, we must check                                                                                    
    // if this buffer is in the write cache (not yet written to the file)
@@ -715,6 +730,9 @@ void TFileCacheRead::SetEnablePrefetchingImpl(Bool_t setPrefetching)
       if (strcmp(cacheDir, ""))
         if (!fPrefetch->SetCache((char*) cacheDir))
            fprintf(stderr, "Error while trying to set the cache directory: %s.\n", cacheDir);
+      // Blocks read ahead of the one in use (see TTreeCache) and memory they may use
+      fPrefetch->SetLookAhead(gEnv->GetValue("TFile.AsyncPrefetchLookAhead", 2));
+      fPrefetch->SetMemoryBudget(Long64_t(gEnv->GetValue("TFile.AsyncPrefetchMemory", 256)) * 1024 * 1024);
       if (fPrefetch->ThreadStart()){
          fprintf(stderr,"Error stating prefetching thread. Disabling prefetching.\n");
          fEnablePrefetching = 0;
@@ -21,6 +21,8 @@
 // rfio, dcap, etc.                                                     //
 // The merging interface allows files containing histograms and trees   //
 // to be merged, like the standalone hadd program.                      //
+// With SetNThreads, groups of input files are merged concurrently      //
+// into temporary files which are then merged into the output.          //
 //                                                                      //
 //////////////////////////////////////////////////////////////////////////
 
@@ -40,6 +42,10 @@
 #include "TClassRef.h"
 #include "TROOT.h"
 #include "TMemFile.h"
+#include "TThread.h"
+#include "TThreadPool.h"
+
+#include <vector>
 
 #ifdef WIN32
 // For _getmaxstdio
@@ -57,6 +63,33 @@ TClassRef R__TTree_Class("TTree");
 
 static const Int_t kCpProgress = BIT(14);
 static const Int_t kCintFileNumber = 100;
+
+namespace {
+
+   class TFileMergerTask : public TThreadPoolTaskImp<TFileMergerTask, Int_t> {
+      // Merge of one group of input files into a temporary file, run by
+      // one thread of TFileMerger::MergeGroups. The input files are opened
+      // by the thread itself.
+
+   public:
+      TFileMerger          *fMerger;  // Merger of the group, writing the partial result
+      std::vector<TString>  fUrls;    // Input files of the group
+      Bool_t                fStatus;  // Result of the merge of the group
+
+      TFileMergerTask() : fMerger(0), fStatus(kFALSE) {}
+
+      bool runTask(Int_t type) {
+         fStatus = kTRUE;
+         for (UInt_t i = 0; i < fUrls.size() && fStatus; ++i) {
+            fStatus = fMerger->AddFile(fUrls[i], kFALSE);
+         }
+         if (fStatus) fStatus = fMerger->PartialMerge(type);
+         return true;
+      }
+   };
+
+}
+
 //______________________________________________________________________________
 static Int_t R__GetSystemMaxOpenedFiles()
 {
@@ -87,7 +120,7 @@ static Int_t R__GetSystemMaxOpenedFiles()
 TFileMerger::TFileMerger(Bool_t isLocal, Bool_t histoOneGo)
             : fOutputFile(0), fFastMethod(kTRUE), fNoTrees(kFALSE), fExplicitCompLevel(kFALSE), fCompressionChange(kFALSE),
               fPrintLevel(0), fMsgPrefix("TFileMerger"), fMaxOpenedFiles( R__GetSystemMaxOpenedFiles() ),
-              fLocal(isLocal), fHistoOneGo(histoOneGo), fObjectNames()
+              fLocal(isLocal), fHistoOneGo(histoOneGo), fObjectNames(), fNThreads(0)
 {
    // Create file merger object.
 
@@ -137,7 +170,8 @@ Bool_t TFileMerger::AddFile(const char *url, Bool_t cpProgress)
    TFile *newfile = 0;
    TString localcopy;
    
-   if (fFileList->GetEntries() >= (fMaxOpenedFiles-1)) {
+   // With several threads the files are opened by the threads merging them.
+   if (fNThreads > 1 || fFileList->GetEntries() >= (fMaxOpenedFiles-1)) {
 
       TObjString *urlObj = new TObjString(url);
       fMergeList->Add(urlObj);
@@ -778,6 +812,26 @@ Bool_t TFileMerger::PartialMerge(Int_t in_type)
       }
    }
 
+   // With several threads, merge groups of input files concurrently and
+   // then merge the partial results, which are removed like local copies.
+   Bool_t local = fLocal;
+   if (fNThreads > 1 && fFileList->GetEntries() == 0 && !(in_type & kIncremental)) {
+      Int_t ngroups = fExcessFiles->GetEntries() / 2;
+      if (ngroups > fNThreads) ngroups = fNThreads;
+      if (ngroups > 1) {
+         if (!MergeGroups(in_type, ngroups)) {
+            Error("Merge", "error during merge of your ROOT files");
+            fOutputFile->Close();
+            SafeDelete(fOutputFile);
+            return kFALSE;
+         }
+         fLocal = kTRUE;
+      }
+   }
+   if (fFileList->GetEntries() == 0 && fExcessFiles->GetEntries() > 0) {
+      OpenExcessFiles();
+   }
+
    // Special treament for the single file case ...
    if ((fFileList->GetEntries() == 1) && !fExcessFiles->GetEntries() &&
       !(in_type & kIncremental) && !fCompressionChange && !fExplicitCompLevel) {
@@ -804,6 +858,7 @@ Bool_t TFileMerger::PartialMerge(Int_t in_type)
             Warning("PartialMerge", "problems removing temporary local file '%s'", u.GetFile());
       }
       fFileList->Clear();
+      fLocal = local;
       return result;
    }
 
@@ -858,9 +913,107 @@ Bool_t TFileMerger::PartialMerge(Int_t in_type)
       fOutputFile->ResetBit(kMustCleanup);
       SafeDelete(fOutputFile);
    }
+   fLocal = local;
    return result;
 }
 
+//______________________________________________________________________________
+Bool_t TFileMerger::MergeGroups(Int_t type, Int_t ngroups)
+{
+   // Merge the input files, which have not been opened yet, in ngroups
+   // groups of consecutive files (so that the order of the tree entries is
+   // kept), each on its own thread and into its own temporary file. Those
+   // partial results then replace the input files in fFileList.
+   // Returns kFALSE (and removes the partial results) in case of error.
+
+   TThread::Initialize();
+
+   Int_t nfiles = fExcessFiles->GetEntries();
+   Int_t maxopened = (fMaxOpenedFiles - 1) / ngroups;
+   std::vector<TFileMergerTask> tasks(ngroups);
+   TIter next(fExcessFiles);
+   Int_t ifile = 0;
+   Bool_t status = kTRUE;
+   {
+      // We want gDirectory untouched by anything going on here
+      TDirectory::TContext ctx(0);
+      for (Int_t i = 0; i < ngroups && status; ++i) {
+         TFileMergerTask &task = tasks[i];
+         TFileMerger *merger = new TFileMerger(fLocal, fHistoOneGo);
+         task.fMerger = merger;
+         merger->fFastMethod  = fFastMethod;
+         merger->fNoTrees     = fNoTrees;
+         merger->fObjectNames = fObjectNames;
+         merger->SetPrintLevel(fPrintLevel);
+         merger->SetMsgPrefix(TString::Format("%s[%d]", fMsgPrefix.Data(), i));
+         merger->SetMaxOpenedFiles(maxopened);
+
+         TUUID uuid;
+         TString part = TString::Format("%s/ROOTMERGE-%s.root", gSystem->TempDirectory(), uuid.AsString());
+         status = merger->OutputFile(part, "RECREATE", fOutputFile->GetCompressionSettings());
+
+         Int_t last = (i + 1) * nfiles / ngroups;
+         TObjString *url;
+         while (ifile < last && (url = (TObjString*)next())) {
+            task.fUrls.push_back(url->GetString());
+            ++ifile;
+         }
+      }
+   }
+
+   if (status) {
+      if (fPrintLevel > 0) {
+         Printf("%s Merging %d files in %d groups", fMsgPrefix.Data(), nfiles, ngroups);
+      }
+      TThreadPool<TFileMergerTask, Int_t> pool(ngroups);
+      for (Int_t i = 0; i < ngroups; ++i) {
+         pool.PushTask(tasks[i], type & ~kIncremental);
+      }
+      pool.Stop(kTRUE);
+   }
+
+   std::vector<TString> parts;
+   for (Int_t i = 0; i < ngroups; ++i) {
+      if (tasks[i].fMerger) {
+         parts.push_back(tasks[i].fMerger->GetOutputFileName());
+         if (!tasks[i].fStatus) {
+            Error("MergeGroups", "error during the merge of group %d", i);
+            status = kFALSE;
+         }
+         delete tasks[i].fMerger;
+      }
+   }
+
+   // Open the partial results, they are merged like the input files.
+   TDirectory::TContext ctx(0);
+   for (UInt_t i = 0; i < parts.size() && status; ++i) {
+      TFile *part = TFile::Open(parts[i], "READ");
+      if (!part || part->IsZombie()) {
+         Error("MergeGroups", "cannot open the partial result %s", parts[i].Data());
+         delete part;
+         status = kFALSE;
+      } else {
+         part->SetBit(kCanDelete);
+         fFileList->Add(part);
+      }
+   }
+   if (!status) {
+      TIter nextfile(fFileList);
+      TFile *file;
+      while ((file = (TFile*) nextfile())) {
+         file->Close();
+         delete file;
+      }
+      fFileList->Clear();
+      for (UInt_t i = 0; i < parts.size(); ++i) {
+         gSystem->Unlink(parts[i]);
+      }
+      return kFALSE;
+   }
+   fExcessFiles->Clear();
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 Bool_t TFileMerger::OpenExcessFiles()
 {
@@ -937,6 +1090,39 @@ void TFileMerger::SetMaxOpenedFiles(Int_t newmax)
    }
 }
 
+//______________________________________________________________________________
+void TFileMerger::SetNThreads(Int_t nthreads)
+{
+   // Set the number of threads used to merge the input files.
+   //
+   // nthreads = 0 or 1 : the files are merged sequentially (default)
+   // nthreads > 1      : the files are merged by up to nthreads threads
+   // nthreads < 0      : one thread per available cpu core is used
+   //
+   // With several threads the input files passed by name to AddFile are
+   // not opened (nor copied) right away. Merge splits them in groups of
+   // consecutive files, at least two per group, and each group is merged
+   // by its own thread, which opens its files, into a temporary file in
+   // gSystem->TempDirectory(). The histograms and trees of different
+   // groups are thus read and merged concurrently. The partial results are
+   // then merged into the output file; as they have the compression
+   // settings of the output file, their trees are copied with TTreeCloner
+   // without being uncompressed. An input file that cannot be opened makes
+   // the merge fail. Incremental merges (PartialMerge with kIncremental)
+   // and files added as TFile objects are merged sequentially.
+   // SetNThreads must be called before the files are added.
+
+   if (nthreads < 0) {
+      SysInfo_t info;
+      if (gSystem->GetSysInfo(&info) == 0 && info.fCpus > 0) {
+         nthreads = info.fCpus;
+      } else {
+         nthreads = 1;
+      }
+   }
+   fNThreads = nthreads;
+}
+
 //______________________________________________________________________________
 void TFileMerger::SetMsgPrefix(const char *prefix)
 {
@@ -21,7 +21,7 @@
 #include <cstdlib>
 #include <cctype>
 
-static const int kMAX_READ_SIZE    = 2;   //maximum size of the read list of blocks
+static const int kMAX_READ_SIZE    = 2;   //size of the read list of blocks without look-ahead
 
 inline int xtod(char c) { return (c>='0' && c<='9') ? c-'0' : ((c>='A' && c<='F') ? c-'A'+10 : ((c>='a' && c<='f') ? c-'a'+10 : 0)); }
 
@@ -33,7 +33,18 @@ ClassImp(TFilePrefetch)
 TFilePrefetch::TFilePrefetch(TFile* file) :
   fFile(file),
   fConsumer(0),
-  fThreadJoined(kTRUE)
+  fReadingBlock(0),
+  fThreadJoined(kTRUE),
+  fLookAhead(0),
+  fNConsumed(0),
+  fMemoryBudget(0),
+  fReadBytes(0),
+  fConsumerWaiting(kFALSE),
+  fInterrupt(kFALSE),
+  fNReadRequests(0),
+  fNStalls(0),
+  fNCoveredBlocks(0),
+  fNMemoryWaits(0)
 {
    // Constructor.
 
@@ -47,6 +58,7 @@ TFilePrefetch::TFilePrefetch(TFile* file) :
    fMutexPendingList = new TMutex();
    fNewBlockAdded    = new TCondition(0);
    fReadBlockAdded   = new TCondition(0);
+   fBlockConsumed    = new TCondition(fMutexReadList);
    fSemMasterWorker  = new TSemaphore(0);
    fSemWorkerMaster  = new TSemaphore(0);
    fSemChangeFile    = new TSemaphore(0);
@@ -64,6 +76,7 @@ TFilePrefetch::~TFilePrefetch()
    SafeDelete(fConsumer);
    SafeDelete(fPendingBlocks);
    SafeDelete(fReadBlocks);
+   SafeDelete(fBlockConsumed);
    SafeDelete(fMutexReadList);
    SafeDelete(fMutexPendingList);
    SafeDelete(fNewBlockAdded);
@@ -79,6 +92,12 @@ void TFilePrefetch::WaitFinishPrefetch()
 {
    // Killing the async prefetching thread
 
+   // Make sure the worker is not waiting for memory to be released
+   fMutexReadList->Lock();
+   fInterrupt = kTRUE;
+   fBlockConsumed->Broadcast();
+   fMutexReadList->UnLock();
+
    fSemMasterWorker->Post();
 
    TMutex *mutexCond = fNewBlockAdded->GetMutex();
@@ -124,8 +143,13 @@ void TFilePrefetch::ReadListOfBlocks()
    TFPBlock*  block = 0;
 
    while((block = GetPendingBlock())){
+      WaitForMemory(block);
       ReadAsync(block, inCache);
       AddReadBlock(block);
+
+      fMutexPendingList->Lock();
+      fReadingBlock = 0;
+      fMutexPendingList->UnLock();
       if (!inCache)
          SaveBlockInCache(block);
    }
@@ -171,6 +195,7 @@ Bool_t TFilePrefetch::ReadBuffer(char* buf, Long64_t offset, Int_t len)
    // Return a prefetched element.
 
    Bool_t found = false;
+   Bool_t stalled = false;
    TFPBlock* blockObj = 0;
    TMutex *mutexBlocks = fMutexReadList;
    Int_t index = -1;
@@ -178,17 +203,30 @@ Bool_t TFilePrefetch::ReadBuffer(char* buf, Long64_t offset, Int_t len)
    while (1){
       mutexBlocks->Lock();
       TIter iter(fReadBlocks);
+      Int_t position = 0;
       while ((blockObj = (TFPBlock*) iter.Next())){
          index = -1;
          if (BinarySearchReadList(blockObj, offset, len, &index)){
             found = true;
             break;
          }
+         position++;
       }
-      if (found)
+      if (found) {
+         // The blocks read before this one can be released if memory is needed
+         if (position > fNConsumed) {
+            fNConsumed = position;
+            fBlockConsumed->Broadcast();
+         }
+         fConsumerWaiting = kFALSE;
          break;
+      }
       else{
+         // The worker must not wait for memory while we wait for a block
+         fConsumerWaiting = kTRUE;
+         fBlockConsumed->Broadcast();
          mutexBlocks->UnLock();
+         stalled = true;
 
          fWaitTime.Start(kFALSE);
          fReadBlockAdded->Wait(); //wait for a new block to be added
@@ -196,6 +234,9 @@ Bool_t TFilePrefetch::ReadBuffer(char* buf, Long64_t offset, Int_t len)
       }
    }
 
+   fNReadRequests++;
+   if (stalled) fNStalls++;
+
    if (found){
       char *pBuff = blockObj->GetPtrToPiece(index);
       pBuff += (offset - blockObj->GetPos(index));
@@ -209,6 +250,13 @@ Bool_t TFilePrefetch::ReadBuffer(char* buf, Long64_t offset, Int_t len)
 void TFilePrefetch::ReadBlock(Long64_t* offset, Int_t* len, Int_t nblock)
 {
    // Create a TFPBlock object or recycle one and add it to the prefetchBlocks list.
+   // Nothing is done if all the segments are part of blocks already requested,
+   // typically by the look-ahead of TTreeCache.
+
+   if (fLookAhead > 0 && IsRequested(offset, len, nblock)) {
+      fNCoveredBlocks++;
+      return;
+   }
 
    TFPBlock* block = CreateBlockObj(offset, len, nblock);
    AddPendingBlock(block);
@@ -244,6 +292,7 @@ TFPBlock* TFilePrefetch::GetPendingBlock()
       block = (TFPBlock*)fPendingBlocks->First();
       block = (TFPBlock*)fPendingBlocks->Remove(block);
    }
+   fReadingBlock = block;
    mutex->UnLock();
    return block;
 }
@@ -257,14 +306,16 @@ void TFilePrefetch::AddReadBlock(TFPBlock* block)
    TMutex *mutex = fMutexReadList;
    mutex->Lock();
 
-   if (fReadBlocks->GetSize() >= kMAX_READ_SIZE){
-      TFPBlock* movedBlock = (TFPBlock*) fReadBlocks->First();
-      movedBlock = (TFPBlock*)fReadBlocks->Remove(movedBlock);
-      delete movedBlock;
-      movedBlock = 0;
-   }
+   while (fReadBlocks->GetSize() >= kMAX_READ_SIZE + fLookAhead && CanRemoveFirstReadBlock())
+      delete RemoveFirstReadBlock();
+
+   // Over budget, release first the blocks which are not used any more
+   while (fMemoryBudget > 0 && fNConsumed > 0 &&
+          fReadBytes + block->GetCapacity() > fMemoryBudget)
+      delete RemoveFirstReadBlock();
 
    fReadBlocks->Add(block);
+   fReadBytes += block->GetCapacity();
    mutex->UnLock();
 
    //signal the addition of a new block
@@ -284,9 +335,8 @@ TFPBlock* TFilePrefetch::CreateBlockObj(Long64_t* offset, Int_t* len, Int_t nobl
 
    mutex->Lock();
 
-   if (fReadBlocks->GetSize() >= kMAX_READ_SIZE){
-      blockObj = static_cast<TFPBlock*>(fReadBlocks->First());
-      fReadBlocks->Remove(blockObj);
+   if (fReadBlocks->GetSize() >= kMAX_READ_SIZE + fLookAhead && CanRemoveFirstReadBlock()){
+      blockObj = RemoveFirstReadBlock();
       mutex->UnLock();
       blockObj->ReallocBlock(offset, len, noblock);
    }
@@ -297,6 +347,140 @@ TFPBlock* TFilePrefetch::CreateBlockObj(Long64_t* offset, Int_t* len, Int_t nobl
    return blockObj;
 }
 
+//____________________________________________________________________________________________
+Bool_t TFilePrefetch::CanRemoveFirstReadBlock() const
+{
+   // Check if the oldest block of the readList can be released when the
+   // list is full. With look-ahead, requests covered by blocks already read
+   // are not read again (see IsRequested), so a block is kept until the
+   // consumer has moved past it; the list is then allowed to grow beyond
+   // its usual size. Must be called with the readList mutex held.
+
+   return fLookAhead == 0 || fNConsumed > 0;
+}
+
+//____________________________________________________________________________________________
+TFPBlock* TFilePrefetch::RemoveFirstReadBlock()
+{
+   // Remove the oldest block from the readList and return it.
+   // Must be called with the readList mutex held.
+
+   TFPBlock* block = static_cast<TFPBlock*>(fReadBlocks->First());
+   if (!block) return 0;
+   fReadBlocks->Remove(block);
+   fReadBytes -= block->GetCapacity();
+   if (fNConsumed > 0) fNConsumed--;
+   return block;
+}
+
+//____________________________________________________________________________________________
+void TFilePrefetch::WaitForMemory(TFPBlock* block)
+{
+   // Called by the worker thread before reading a block: wait while the
+   // blocks kept in memory would exceed the memory budget and none of them
+   // can be released yet. The worker never waits when the consumer is
+   // itself waiting for a block, nor with less than the blocks needed by
+   // the double buffering, so the budget cannot cause a deadlock.
+
+   if (fMemoryBudget <= 0) return;
+
+   Long64_t size = block->GetCapacity();
+   Bool_t waited = kFALSE;
+   TMutex *mutex = fMutexReadList;
+   mutex->Lock();
+   while (!fInterrupt && !fConsumerWaiting && fNConsumed == 0 &&
+          fReadBlocks->GetSize() >= kMAX_READ_SIZE &&
+          fReadBytes + size > fMemoryBudget) {
+      waited = kTRUE;
+      fBlockConsumed->TimedWaitRelative(100);
+   }
+   if (waited) fNMemoryWaits++;
+   mutex->UnLock();
+}
+
+//____________________________________________________________________________________________
+Bool_t TFilePrefetch::IsCovered(TFPBlock* block, Long64_t offset, Int_t len) const
+{
+   // Check if the segment [offset, offset+len[ is contained in the block,
+   // possibly spanning several contiguous pieces.
+
+   Int_t first = 0, last = block->GetNoElem()-1, index = -1;
+   while (first <= last){
+      Int_t mid = first + (last - first) / 2;
+      if (offset < block->GetPos(mid))
+         last = mid - 1;
+      else if (offset >= block->GetPos(mid) + block->GetLen(mid))
+         first = mid + 1;
+      else {
+         index = mid;
+         break;
+      }
+   }
+   if (index < 0) return kFALSE;
+
+   Long64_t end = offset + len;
+   Long64_t covered = block->GetPos(index) + block->GetLen(index);
+   while (covered < end) {
+      if (++index >= block->GetNoElem() || block->GetPos(index) != covered)
+         return kFALSE;
+      covered += block->GetLen(index);
+   }
+   return kTRUE;
+}
+
+//____________________________________________________________________________________________
+Bool_t TFilePrefetch::IsRequested(Long64_t* offset, Int_t* len, Int_t nblock)
+{
+   // Check if all the segments are part of blocks already pending, being
+   // read or read. Blocks of the readList the consumer has moved past may
+   // be recycled at any time and are not taken into account.
+
+   if (nblock <= 0) return kFALSE;
+
+   Bool_t requested = kTRUE;
+   fMutexPendingList->Lock();
+   fMutexReadList->Lock();
+   for (Int_t i = 0; requested && i < nblock; i++) {
+      Bool_t found = fReadingBlock && IsCovered(fReadingBlock, offset[i], len[i]);
+      TFPBlock* block = 0;
+      TIter nextPending(fPendingBlocks);
+      while (!found && (block = (TFPBlock*) nextPending()))
+         found = IsCovered(block, offset[i], len[i]);
+      TIter nextRead(fReadBlocks);
+      Int_t position = 0;
+      while (!found && (block = (TFPBlock*) nextRead()))
+         found = position++ >= fNConsumed && IsCovered(block, offset[i], len[i]);
+      requested = found;
+   }
+   fMutexReadList->UnLock();
+   fMutexPendingList->UnLock();
+   return requested;
+}
+
+//____________________________________________________________________________________________
+void TFilePrefetch::SetLookAhead(Int_t nblocks)
+{
+   // Set the number of blocks which can be requested ahead of the one being
+   // used. The read list then keeps up to 2+nblocks blocks in memory.
+
+   fMutexReadList->Lock();
+   fLookAhead = nblocks > 0 ? nblocks : 0;
+   fMutexReadList->UnLock();
+}
+
+//____________________________________________________________________________________________
+void TFilePrefetch::SetMemoryBudget(Long64_t bytes)
+{
+   // Set the maximum size of the blocks kept in memory. When it is reached
+   // the worker thread waits for the consumer to move to a newer block
+   // before reading further. 0 means no limit.
+
+   fMutexReadList->Lock();
+   fMemoryBudget = bytes > 0 ? bytes : 0;
+   fBlockConsumed->Broadcast();
+   fMutexReadList->UnLock();
+}
+
 //____________________________________________________________________________________________
 TThread* TFilePrefetch::GetThread() const
 {
@@ -315,6 +499,11 @@ void TFilePrefetch::SetFile(TFile *file)
    // - clear all blocks from prefetching and read list
    // - reset the file pointer
   
+   fMutexReadList->Lock();
+   fInterrupt = kTRUE;
+   fBlockConsumed->Broadcast();
+   fMutexReadList->UnLock();
+
    fSemChangeFile->Wait();
 
    if (fFile) {
@@ -325,9 +514,16 @@ void TFilePrefetch::SetFile(TFile *file)
 
      fMutexReadList->Lock();
      fReadBlocks->Clear();
+     fReadBytes = 0;
+     fNConsumed = 0;
+     fConsumerWaiting = kFALSE;
      fMutexReadList->UnLock();
    }
       
+   fMutexReadList->Lock();
+   fInterrupt = kFALSE;
+   fMutexReadList->UnLock();
+
    fFile = file;
    fSemChangeFile->Post();
 }
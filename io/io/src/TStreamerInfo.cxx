@@ -54,6 +54,7 @@
 #include "TRef.h"
 #include "TProcessID.h"
 #include "TSystem.h"
+#include "TEnv.h"
 
 #include "TStreamer.h"
 #include "TContainerConverters.h"
@@ -74,6 +75,7 @@
 
 TStreamerElement *TStreamerInfo::fgElement = 0;
 Int_t   TStreamerInfo::fgCount = 0;
+Int_t   TStreamerInfo::fgJit = -1;
 
 const Int_t kMaxLen = 1024;
 
@@ -3291,6 +3293,35 @@ TStreamerElement *TStreamerInfo::GetCurrentElement()
    return fgElement;
 }
 
+//______________________________________________________________________________
+Int_t TStreamerInfo::GetJit()
+{
+   // Return the number of times an object wise action sequence is applied
+   // by a TBufferFile before being compiled (see SetJit), 0 if the
+   // sequences are never compiled.
+   // The default is taken from the resource TStreamerInfo.Jit.
+
+   if (fgJit < 0) {
+      fgJit = gEnv->GetValue("TStreamerInfo.Jit", 0);
+      if (fgJit < 0) fgJit = 0;
+   }
+   return fgJit;
+}
+
+//______________________________________________________________________________
+void TStreamerInfo::SetJit(Int_t nuses)
+{
+   // Compile the object wise read and write action sequences with the
+   // interpreter JIT once a TBufferFile has applied them nuses times
+   // (nuses=1: at the first use). The compiled function streams the runs of
+   // consecutive data members of the same basic type with a single call
+   // to ReadFastArray/WriteFastArray and calls the other actions directly,
+   // see TStreamerInfoActions::TActionSequence::Fuse.
+   // nuses=0 disables the compilation of the sequences not yet compiled.
+
+   fgJit = nuses > 0 ? nuses : 0;
+}
+
 //______________________________________________________________________________
 Int_t TStreamerInfo::GetDataMemberOffset(TDataMember *dm, TMemberStreamer *&streamer) const
 {
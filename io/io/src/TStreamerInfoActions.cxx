@@ -24,6 +24,7 @@
 #include "TVirtualCollectionIterators.h"
 #include "TProcessID.h"
 
+
 static const Int_t kRegrouped = TStreamerInfo::kOffsetL;
 
 // More possible optimizations:
@@ -3128,6 +3129,11 @@ void TStreamerInfoActions::TActionSequence::AddToOffset(Int_t delta)
 {
    // Add the (potentially negative) delta to all the configuration's offset.  This is used by
    // TBranchElement in the case of split sub-object.
+   // The compiled function, if any, has the old offsets: it is discarded.
+
+   fFusedAction = 0;
+   fFuseTried = kFALSE;
+   fNApplied.Set(0);
 
    TStreamerInfoActions::ActionContainer_t::iterator end = fActions.end();
    for(TStreamerInfoActions::ActionContainer_t::iterator iter = fActions.begin();
@@ -3195,6 +3201,154 @@ TStreamerInfoActions::TActionSequence *TStreamerInfoActions::TActionSequence::Cr
    }
    return sequence;
 }
+
+namespace {
+   struct TFusedType {
+      // Basic type which the compiled sequences stream inline (see TActionSequence::Fuse).
+      Int_t                 fType;   // TStreamerInfo type code
+      const char           *fName;   // C++ type name
+      const char           *fMethod; // Suffix of the TBufferFile::ReadXXX/WriteXXX methods
+      Int_t                 fSize;   // sizeof of the type
+      TStreamerInfoAction_t fRead;   // Object wise read action of the type
+      TStreamerInfoAction_t fWrite;  // Object wise write action of the type
+   };
+
+   // Long_t and ULong_t are not in the list: their size on file differs from
+   // their size in memory on 32 bits platforms.
+   const TFusedType gFusedTypes[] = {
+      { TStreamerInfo::kBool,    "Bool_t",    "Bool",    sizeof(Bool_t),    ReadBasicType<Bool_t>,    WriteBasicType<Bool_t>    },
+      { TStreamerInfo::kChar,    "Char_t",    "Char",    sizeof(Char_t),    ReadBasicType<Char_t>,    WriteBasicType<Char_t>    },
+      { TStreamerInfo::kShort,   "Short_t",   "Short",   sizeof(Short_t),   ReadBasicType<Short_t>,   WriteBasicType<Short_t>   },
+      { TStreamerInfo::kInt,     "Int_t",     "Int",     sizeof(Int_t),     ReadBasicType<Int_t>,     WriteBasicType<Int_t>     },
+      { TStreamerInfo::kLong64,  "Long64_t",  "Long64",  sizeof(Long64_t),  ReadBasicType<Long64_t>,  WriteBasicType<Long64_t>  },
+      { TStreamerInfo::kFloat,   "Float_t",   "Float",   sizeof(Float_t),   ReadBasicType<Float_t>,   WriteBasicType<Float_t>   },
+      { TStreamerInfo::kDouble,  "Double_t",  "Double",  sizeof(Double_t),  ReadBasicType<Double_t>,  WriteBasicType<Double_t>  },
+      { TStreamerInfo::kUChar,   "UChar_t",   "UChar",   sizeof(UChar_t),   ReadBasicType<UChar_t>,   WriteBasicType<UChar_t>   },
+      { TStreamerInfo::kUShort,  "UShort_t",  "UShort",  sizeof(UShort_t),  ReadBasicType<UShort_t>,  WriteBasicType<UShort_t>  },
+      { TStreamerInfo::kUInt,    "UInt_t",    "UInt",    sizeof(UInt_t),    ReadBasicType<UInt_t>,    WriteBasicType<UInt_t>    },
+      { TStreamerInfo::kULong64, "ULong64_t", "ULong64", sizeof(ULong64_t), ReadBasicType<ULong64_t>, WriteBasicType<ULong64_t> }
+   };
+   const Int_t kNFusedTypes = sizeof(gFusedTypes)/sizeof(gFusedTypes[0]);
+
+   Int_t FindFusedType(const TConfiguredAction &action, Bool_t &read, Int_t &offset, Int_t &length)
+   {
+      // Return the index in gFusedTypes of the type streamed by the action if
+      // it reads or writes one data member or a fixed size array of this
+      // type, -1 otherwise. Set the direction, the offset of the data in the
+      // object and its number of elements.
+
+      const TConfiguration *conf = action.fConfiguration;
+      Int_t type = -1;
+      if (action.fAction == GenericReadAction || action.fAction == GenericWriteAction) {
+         // Fixed size arrays and the members regrouped by the optimization.
+         TStreamerInfo *info = (TStreamerInfo*)conf->fInfo;
+         Int_t kase = info->GetTypes()[conf->fElemId];
+         if (kase <= TStreamerInfo::kOffsetL || kase >= TStreamerInfo::kOffsetP) return -1;
+         type = kase - TStreamerInfo::kOffsetL;
+         read = action.fAction == GenericReadAction;
+         offset = conf->fOffset + info->GetOffsets()[conf->fElemId];
+         length = info->GetLengths()[conf->fElemId];
+      }
+      for (Int_t t = 0; t < kNFusedTypes; ++t) {
+         if (type >= 0) {
+            if (gFusedTypes[t].fType == type) return length > 0 ? t : -1;
+         } else if (action.fAction == gFusedTypes[t].fRead || action.fAction == gFusedTypes[t].fWrite) {
+            read = action.fAction == gFusedTypes[t].fRead;
+            offset = conf->fOffset;
+            length = 1;
+            return t;
+         }
+      }
+      return -1;
+   }
+}
+
+Bool_t TStreamerInfoActions::TActionSequence::Fuse()
+{
+   // Compile with the interpreter JIT a function equivalent to the loop on
+   // the object wise actions, used instead of the loop by
+   // TBufferFile::ApplySequence (see TStreamerInfo::SetJit).
+   // The consecutive data members and fixed size arrays of the same basic
+   // type which are contiguous in memory are streamed by a single call to
+   // TBufferFile::ReadFastArray or WriteFastArray, which produces the same
+   // bytes as streaming them one by one; the isolated basic data members
+   // are streamed by the inline TBufferFile::ReadXXX/WriteXXX. The other
+   // actions are called directly, in the same order as in the loop.
+   // The compilation is attempted only once; it is not done if fewer than
+   // two actions can be inlined. Each distinct function is compiled once
+   // and shared by all the sequences streaming the same layout.
+   // Return true if the compiled function is available.
+   // Several threads may call Fuse and ApplySequence on the same sequence:
+   // fFusedAction is set under gInterpreterMutex, and fNApplied is set to
+   // -1 only after the mutex is released, so a thread seeing fNApplied < 0
+   // sees the final fFusedAction.
+
+   if (fNApplied < 0) return fFusedAction != 0;
+   {
+      R__LOCKGUARD2(gInterpreterMutex);
+      if (!fFuseTried) {
+         fFuseTried = kTRUE;
+         fFusedAction = CompileFused();
+      }
+   }
+   fNApplied.Set(-1);
+   return fFusedAction != 0;
+}
+
+TStreamerInfoActions::TStreamerInfoFusedAction_t TStreamerInfoActions::TActionSequence::CompileFused() const
+{
+   // Generate and compile the function used by Fuse, return 0 if there is
+   // nothing to gain or if it could not be compiled.
+
+   if (fLoopConfig || fActions.empty()) return 0;
+
+   TString body;
+   UInt_t ninlined = 0;
+   UInt_t nactions = fActions.size();
+   for (UInt_t i = 0; i < nactions; ) {
+      Bool_t read = kTRUE;
+      Int_t offset = 0, length = 0;
+      Int_t t = FindFusedType(fActions[i], read, offset, length);
+      if (t < 0) {
+         body += TString::Format("   actions[%u](buf,obj);\n", i);
+         ++i;
+         continue;
+      }
+      // Extend the run with the following actions streaming the same type
+      // right after it in memory.
+      UInt_t j = i+1;
+      for (; j < nactions; ++j) {
+         Bool_t nextread = kTRUE;
+         Int_t nextoffset = 0, nextlength = 0;
+         if (FindFusedType(fActions[j], nextread, nextoffset, nextlength) != t || nextread != read
+             || nextoffset != offset + length*gFusedTypes[t].fSize) break;
+         length += nextlength;
+      }
+      const TFusedType &type = gFusedTypes[t];
+      if (length == 1) {
+         body += TString::Format("   b.TBufferFile::%s%s(*(%s*)(addr+%d));\n", read ? "Read" : "Write",
+                                 type.fMethod, type.fName, offset);
+      } else {
+         body += TString::Format("   b.TBufferFile::%sFastArray((%s%s*)(addr+%d),%d);\n", read ? "Read" : "Write",
+                                 read ? "" : "const ", type.fName, offset, length);
+      }
+      ninlined += j-i;
+      i = j;
+   }
+   if (ninlined < 2) return 0;
+
+   body.Prepend("   TBufferFile &b = (TBufferFile&)buf;\n"
+                "   char *addr = (char*)obj;\n");
+   body += "   return 0;\n";
+   TStreamerInfoFusedAction_t action = (TStreamerInfoFusedAction_t)
+      gInterpreter->CompileFunction("R__TStreamerInfoActions_jit",
+                                    "Int_t $name(TBuffer &buf, void *obj, const TStreamerInfoActions::TConfiguredAction *actions)",
+                                    body, "TBufferFile.h TStreamerInfoActions.h");
+   if (gDebug > 0 && !action) {
+      Info("Fuse", "could not compile the actions of %s", fStreamerInfo ? fStreamerInfo->GetName() : "");
+   }
+   return action;
+}
  
 #if !defined(R__WIN32) && !defined(_AIX)
 
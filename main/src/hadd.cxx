@@ -48,6 +48,12 @@
   (i.e. direct copy of the raw byte on disk). The "fast" mode is typically
   5 times faster than the mode unzipping and unstreaming the baskets.
 
+  With the option -j, groups of input files are merged concurrently
+  by several threads into temporary files, which are then merged into
+  the target file:
+       hadd -j 8 targetfile source1 source2 ...
+  uses 8 threads ("-j 0" uses one thread per core).
+
   NOTE1: By default histograms are added. However hadd does not support the case where
          histograms have their bit TH1::kIsAverage set.
 
@@ -77,7 +83,7 @@ int main( int argc, char **argv )
 {
 
    if ( argc < 3 || "-h" == std::string(argv[1]) || "--help" == std::string(argv[1]) ) {
-      std::cout << "Usage: " << argv[0] << " [-f[0-9]] [-k] [-T] [-O] [-n maxopenedfiles] [-v verbosity] targetfile source1 [source2 source3 ...]" << std::endl;
+      std::cout << "Usage: " << argv[0] << " [-f[0-9]] [-k] [-T] [-O] [-n maxopenedfiles] [-j nthreads] [-v verbosity] targetfile source1 [source2 source3 ...]" << std::endl;
       std::cout << "This program will add histograms from a list of root files and write them" << std::endl;
       std::cout << "to a target root file. The target file is newly created and must not " << std::endl;
       std::cout << "exist, or if -f (\"force\") is given, must not be one of the source files." << std::endl;
@@ -87,6 +93,7 @@ int main( int argc, char **argv )
       std::cout << "If the option -O is used, when merging TTree, the basket size is re-optimized" <<std::endl;
       std::cout << "If the option -v is used, explicitly set the verbosity level; 0 request no output, 99 is the default" <<std::endl;
       std::cout << "If the option -n is used, hadd will open at most 'maxopenedfiles' at once, use 0 to request to use the system maximum." << std::endl;
+      std::cout << "If the option -j is used, groups of input files are merged concurrently by 'nthreads' threads, use 0 to request one thread per core (not supported together with -k)." << std::endl;
       std::cout << "When -the -f option is specified, one can also specify the compression" <<std::endl;
       std::cout << "level of the target file. By default the compression level is 1, but" <<std::endl;
       std::cout << "if \"-f0\" is specified, the target file will not be compressed." <<std::endl;
@@ -101,6 +108,7 @@ int main( int argc, char **argv )
    Bool_t reoptimize = kFALSE;
    Bool_t noTrees = kFALSE;
    Int_t maxopenedfiles = 0;
+   Int_t nthreads = 1;
    Int_t verbosity = 99;
 
    int outputPlace = 0;
@@ -133,6 +141,20 @@ int main( int argc, char **argv )
             }
          }
          ++ffirst;
+      } else if ( strcmp(argv[a],"-j") == 0 ) {
+         if (a+1 >= argc) {
+            std::cerr << "Error: no number of threads was provided after -j.\n";
+         } else {
+            Long_t request = strtol(argv[a+1], 0, 10);
+            if (request < kMaxLong && request >= 0) {
+               nthreads = request ? (Int_t)request : -1;
+               ++a;
+               ++ffirst;
+            } else {
+               std::cerr << "Error: could not parse the number of threads passed after -j: " << argv[a+1] << ". The files will be merged sequentially.\n";
+            }
+         }
+         ++ffirst;
       } else if ( strcmp(argv[a],"-v") == 0 ) {
          if (a+1 >= argc) {
             std::cerr << "Error: no verbosity level was provided after -v.\n";
@@ -187,6 +209,14 @@ int main( int argc, char **argv )
    if (maxopenedfiles > 0) {
       merger.SetMaxOpenedFiles(maxopenedfiles);
    }
+   if (nthreads != 1) {
+      if (skip_errors) {
+         // The files are only opened by the merging threads, too late to skip them.
+         std::cerr << "hadd the option -j is ignored together with -k, the files are merged sequentially." << std::endl;
+      } else {
+         merger.SetNThreads(nthreads);
+      }
+   }
    if (!merger.OutputFile(targetname,force,newcomp) ) {
       std::cerr << "hadd error opening target file (does " << argv[ffirst-1] << " exist?)." << std::endl;
       std::cerr << "Pass \"-f\" argument to force re-creation of output file." << std::endl;
@@ -165,6 +165,11 @@ endif
 ##### extra rules ######
 $(MATHCOREO): CXXFLAGS += -DUSE_ROOT_ERROR
 $(MATHCOREDO): CXXFLAGS += -DUSE_ROOT_ERROR 
+# for openMP (parallel build and batched searches of TKDTree)
+ifneq ($(USE_OPENMP),)
+$(call stripsrc,$(MATHCOREDIRS)/TKDTree.o): CXXFLAGS += -fopenmp
+$(MATHCORELIB): LDFLAGS += -fopenmp
+endif
 # add optimization to G__Math compilation
 # Optimize dictionary with stl containers.
 $(MATHCOREDO1) : NOOPT = $(OPT)
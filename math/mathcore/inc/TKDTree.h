@@ -50,9 +50,11 @@ public:
    Index   GetBucketSize() {return fBucketSize;}
 
    void    FindNearestNeighbors(const Value *point, Int_t k, Index *ind, Value *dist);
+   void    FindNearestNeighborsN(Int_t npoints, const Value *points, Int_t k, Index *ind, Value *dist);
    Index   FindNode(const Value * point) const;
    void    FindPoint(Value * point, Index &index, Int_t &iter);
    void    FindInRange(Value *point, Value range, std::vector<Index> &res);
+   void    FindInRangeN(Int_t npoints, const Value *points, Value range, std::vector<Index> &res, std::vector<Index> &offsets);
    void    FindBNodeA(Value * point, Value * delta, Int_t &inode);
 
    Bool_t  IsTerminal(Index inode) const {return (inode>=fNNodes);}
@@ -71,9 +73,10 @@ public:
    TKDTree(const TKDTree &); // not implemented
    TKDTree<Index, Value>& operator=(const TKDTree<Index, Value>&); // not implemented
    void CookBoundaries(const Int_t node, Bool_t left);
+   void BuildNodes(Int_t node, Int_t row, Int_t pos, Int_t nnode, Int_t splitRow, std::vector<Int_t> *split);
 
    void UpdateNearestNeighbors(Index inode, const Value *point, Int_t kNN, Index *ind, Value *dist);
-   void UpdateRange(Index inode, Value *point, Value range, std::vector<Index> &res); 
+   void UpdateRange(Index inode, const Value *point, Value range, std::vector<Index> &res);
 
  protected:
    Int_t   fDataOwner;  //! 0 - not owner, 2 - owner of the pointer array, 1 - owner of the whole 2-d array
@@ -15,6 +15,9 @@
 #include "TString.h"
 #include <string.h>
 #include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 templateClassImp(TKDTree)
 
@@ -29,6 +32,7 @@ templateClassImp(TKDTree)
 // 3. Using TKDTree
 //    a. Creating the kd-tree and setting the data
 //    b. Navigating the kd-tree
+//    c. Searching many points at once
 // 4. TKDTree implementation - technical details
 //    a. The order of nodes in internal arrays
 //    b. Division algorithm
@@ -154,6 +158,23 @@ templateClassImp(TKDTree)
 //     part of the index array. To find the number of point in the node
 //     (not only terminal), call TKDTree::GetNpointsNode(Index inode).
 //
+// 3c. Searching many points at once
+//
+//     TKDTree::FindNearestNeighborsN() and TKDTree::FindInRangeN() search the neighbours of
+//     an array of points, stored point after point (npoints*ndim values). They give the same
+//     results as calling FindNearestNeighbors() and FindInRange() for each point, but the
+//     tree is prepared for the search only once and, when ROOT is built with OpenMP
+//     (USE_OPENMP), the points are searched by several threads. The tree itself is only
+//     read during the search; each thread collects its results in its own buffers.
+//     {
+//     Double_t *points = new Double_t[nquery*ndim];  // x0 y0 z0 x1 y1 z1 ...
+//     Int_t    *ind    = new Int_t[nquery*kNN];
+//     Double_t *dist   = new Double_t[nquery*kNN];
+//     kdtree->FindNearestNeighborsN(nquery, points, kNN, ind, dist);
+//     // neighbours of point i: ind[i*kNN] ... ind[i*kNN+kNN-1]
+//     }
+//     With OpenMP, Build() also divides the nodes of the lower rows of the tree in parallel.
+//
 // 4.  TKDtree implementation details - internal information, not needed to use the kd-tree.
 //     4a. Order of nodes in the node information arrays:
 //
@@ -431,6 +452,35 @@ void TKDTree<Index, Value>::Build()
    //
    //
    //4.
+   //    The nodes down to the row splitRow are divided here. With OpenMP the subtrees
+   //    below that row, which cover disjoint ranges of fIndPoints, are then divided in
+   //    parallel; the resulting tree does not depend on the number of threads.
+   Int_t splitRow = 0;
+   std::vector<Int_t> split;
+#ifdef _OPENMP
+   if (fNPoints >= 16384) {
+      Int_t nsub = 8*omp_get_max_threads();
+      while (splitRow < fRowT0 && (1<<splitRow) < nsub) splitRow++;
+   }
+#endif
+   BuildNodes(0, 0, 0, fNPoints, splitRow, splitRow ? &split : 0);
+   Int_t nsplit = split.size()/4;
+#ifdef _OPENMP
+   #pragma omp parallel for schedule(dynamic)
+#endif
+   for (Int_t i=0; i<nsplit; i++)
+      BuildNodes(split[4*i], split[4*i+1], split[4*i+2], split[4*i+3], 0, 0);
+}
+
+//_________________________________________________________________
+template <typename  Index, typename Value>
+void TKDTree<Index, Value>::BuildNodes(Int_t node, Int_t row, Int_t pos, Int_t nnode, Int_t splitRow, std::vector<Int_t> *split)
+{
+   // Non recursive division of the subtree of the node, holding nnode points
+   // from position pos of fIndPoints.
+   // If split is given, the nodes of row splitRow are not divided but appended
+   // to split (node, row, position and number of points), to be divided later.
+
    //    stack for non recursive build - size 128 bytes enough
    Int_t rowStack[128];
    Int_t nodeStack[128];
@@ -438,11 +488,12 @@ void TKDTree<Index, Value>::Build()
    Int_t posStack[128];
    Int_t currentIndex = 0;
    Int_t iter =0;
-   rowStack[0]    = 0;
-   nodeStack[0]   = 0;
-   npointStack[0] = fNPoints;
-   posStack[0]   = 0;
+   rowStack[0]    = row;
+   nodeStack[0]   = node;
+   npointStack[0] = nnode;
+   posStack[0]    = pos;
    //
+   std::vector<Value> smin(fNDim), smax(fNDim);
    Int_t nbucketsall =0;
    while (currentIndex>=0){
       iter++;
@@ -457,6 +508,14 @@ void TKDTree<Index, Value>::Build()
       Int_t crow     = rowStack[currentIndex];
       Int_t cpos     = posStack[currentIndex];
       Int_t cnode    = nodeStack[currentIndex];
+      if (split && crow>=splitRow) {
+         split->push_back(cnode);
+         split->push_back(crow);
+         split->push_back(cpos);
+         split->push_back(npoints);
+         currentIndex--;
+         continue;
+      }
       //printf("currentIndex %d npoints %d node %d\n", currentIndex, npoints, cnode);
       //
       // divide points
@@ -479,13 +538,19 @@ void TKDTree<Index, Value>::Build()
 
       //
       //find the axis with biggest spread
+      //the spreads of the large nodes at the top of the tree are computed in parallel
       Value maxspread=0;
       Value tempspread, min, max;
       Index axspread=0;
       Value *array;
+#ifdef _OPENMP
+      #pragma omp parallel for if (split && fNDim > 1)
+#endif
+      for (Int_t idim=0; idim<fNDim; idim++)
+         Spread(npoints, fData[idim], fIndPoints+cpos, smin[idim], smax[idim]);
       for (Int_t idim=0; idim<fNDim; idim++){
-         array = fData[idim];
-         Spread(npoints, array, fIndPoints+cpos, min, max);
+         min = smin[idim];
+         max = smax[idim];
          tempspread = max - min;
          if (maxspread < tempspread) {
             maxspread=tempspread;
@@ -543,6 +608,38 @@ void TKDTree<Index, Value>::FindNearestNeighbors(const Value *point, const Int_t
 
 }
 
+//_________________________________________________________________
+template <typename Index, typename Value>
+void TKDTree<Index, Value>::FindNearestNeighborsN(Int_t npoints, const Value *points, const Int_t kNN, Index *ind, Value *dist)
+{
+   //Find the kNN nearest neighbors of each of the npoints points of the array points,
+   //which holds the coordinates of the points one after the other (npoints*fNDim values).
+   //The neighbors of point i are returned in ind[i*kNN]...ind[i*kNN+kNN-1] and
+   //dist[i*kNN]...dist[i*kNN+kNN-1], as FindNearestNeighbors() would return them.
+   //Arrays ind and dist are provided by the user and are assumed to be at least npoints*kNN elements long
+   //When compiled with OpenMP, the points are searched in parallel.
+
+   if (!ind || !dist) {
+      Error("FindNearestNeighborsN", "Working arrays must be allocated by the user!");
+      return;
+   }
+   if (npoints<=0 || kNN<=0) return;
+   //from here on the tree is only read, and can be searched by several threads
+   MakeBoundariesExact();
+#ifdef _OPENMP
+   #pragma omp parallel for schedule(dynamic, 64) if (npoints > 256)
+#endif
+   for (Int_t ipoint=0; ipoint<npoints; ipoint++){
+      Index *pind  = ind  + Long64_t(ipoint)*kNN;
+      Value *pdist = dist + Long64_t(ipoint)*kNN;
+      for (Int_t i=0; i<kNN; i++){
+         pdist[i]=std::numeric_limits<Value>::max();
+         pind[i]=-1;
+      }
+      UpdateNearestNeighbors(0, points + Long64_t(ipoint)*fNDim, kNN, pind, pdist);
+   }
+}
+
 //_________________________________________________________________
 template <typename Index, typename Value>
 void TKDTree<Index, Value>::UpdateNearestNeighbors(Index inode, const Value *point, Int_t kNN, Index *ind, Value *dist)
@@ -741,7 +838,48 @@ void TKDTree<Index, Value>::FindInRange(Value * point, Value range, std::vector<
 
 //_________________________________________________________________
 template <typename  Index, typename Value>
-void TKDTree<Index, Value>::UpdateRange(Index inode, Value* point, Value range, std::vector<Index> &res)
+void TKDTree<Index, Value>::FindInRangeN(Int_t npoints, const Value *points, Value range, std::vector<Index> &res, std::vector<Index> &offsets)
+{
+//Find all points in the sphere of a given radius "range" around each of the npoints
+//points of the array points, which holds the coordinates of the points one after the
+//other (npoints*fNDim values).
+//The points found around point i are res[offsets[i]]...res[offsets[i+1]-1], in the
+//order FindInRange() returns them; offsets has npoints+1 elements.
+//When compiled with OpenMP, the points are searched in parallel, each chunk of points
+//collecting its results in its own vector before they are appended to res.
+
+   res.clear();
+   offsets.assign(npoints>0 ? npoints+1 : 1, 0);
+   if (npoints<=0) return;
+   //from here on the tree is only read, and can be searched by several threads
+   MakeBoundariesExact();
+   const Int_t kChunk = 256;
+   Int_t nchunks = (npoints+kChunk-1)/kChunk;
+   std::vector<std::vector<Index> > chunkres(nchunks);
+#ifdef _OPENMP
+   #pragma omp parallel for schedule(dynamic)
+#endif
+   for (Int_t ichunk=0; ichunk<nchunks; ichunk++){
+      std::vector<Index> &local = chunkres[ichunk];
+      Int_t last = TMath::Min(npoints, (ichunk+1)*kChunk);
+      for (Int_t ipoint=ichunk*kChunk; ipoint<last; ipoint++){
+         UpdateRange(0, points + Long64_t(ipoint)*fNDim, range, local);
+         offsets[ipoint+1] = local.size();
+      }
+   }
+   for (Int_t ichunk=0; ichunk<nchunks; ichunk++){
+      Index base = res.size();
+      Int_t last = TMath::Min(npoints, (ichunk+1)*kChunk);
+      for (Int_t ipoint=ichunk*kChunk; ipoint<last; ipoint++)
+         offsets[ipoint+1] += base;
+      res.insert(res.end(), chunkres[ichunk].begin(), chunkres[ichunk].end());
+      std::vector<Index>().swap(chunkres[ichunk]);
+   }
+}
+
+//_________________________________________________________________
+template <typename  Index, typename Value>
+void TKDTree<Index, Value>::UpdateRange(Index inode, const Value* point, Value range, std::vector<Index> &res)
 {
 //Internal recursive function with the implementation of range searches
 
@@ -3,6 +3,7 @@
 
   TestBuild();       // test build function of kdTree for memory leaks
   TestSpeed();       // test the CPU consumption to build kdTree
+  TestBatchSpeed();  // compare the batched searches with the point by point searches
   TestkdtreeIF();    // test functionality of the kdTree
   TestSizeIF();      // test the size of kdtree - search application - Alice TPC tracker situation
   //
@@ -22,6 +23,7 @@
 void TestBuild(const Int_t npoints = 1000000, const Int_t bsize = 100);
 void TestConstr(const Int_t npoints = 1000000, const Int_t bsize = 100);
 void TestSpeed(Int_t npower2 = 20, Int_t bsize = 10);
+void TestBatchSpeed(Int_t npoints = 1000000, Int_t nquery = 200000, Int_t kNN = 10, Int_t bsize = 10);
 
 //void TestkdtreeIF(Int_t npoints=1000, Int_t bsize=9, Int_t nloop=1000, Int_t mode = 2);
 //void TestSizeIF(Int_t nsec=36, Int_t nrows=159, Int_t npoints=1000,  Int_t bsize=10, Int_t mode=1);
@@ -46,6 +48,8 @@ void kDTreeTest()
   TestBuild();  
   printf("\n\tTesting kDTree speed ...\n");
   TestSpeed();
+  printf("\n\tTesting kDTree batched searches ...\n");
+  TestBatchSpeed();
 }
 
 //______________________________________________________________________
@@ -254,6 +258,83 @@ void TestSpeed(Int_t npower2, Int_t bsize)
   return;
 }
 
+//______________________________________________________________________
+void TestBatchSpeed(Int_t npoints, Int_t nquery, Int_t kNN, Int_t bsize)
+{
+  //
+  // Compare the time of FindNearestNeighborsN() and FindInRangeN() with
+  // calling FindNearestNeighbors() and FindInRange() for each point,
+  // and check that they find the same neighbours
+  //
+  const Int_t ndim = 3;
+  Double_t *data0 = new Double_t[npoints*ndim];
+  Double_t *data[ndim];
+  for (Int_t idim=0; idim<ndim; idim++) data[idim] = &data0[idim*npoints];
+  for (Int_t i=0; i<npoints*ndim; i++) data0[i] = gRandom->Rndm();
+  Double_t *query = new Double_t[nquery*ndim];
+  for (Int_t i=0; i<nquery*ndim; i++) query[i] = gRandom->Rndm();
+
+  TStopwatch timer;
+  timer.Start(kTRUE);
+  TKDTreeID *kdtree = new TKDTreeID(npoints, ndim, bsize, data);
+  kdtree->Build();
+  timer.Stop();
+  printf("build %d points: real time %f [s]\n", npoints, timer.RealTime());
+
+  Int_t *ind1 = new Int_t[nquery*kNN];
+  Int_t *ind2 = new Int_t[nquery*kNN];
+  Double_t *dist1 = new Double_t[nquery*kNN];
+  Double_t *dist2 = new Double_t[nquery*kNN];
+  timer.Start(kTRUE);
+  for (Int_t i=0; i<nquery; i++)
+    kdtree->FindNearestNeighbors(&query[i*ndim], kNN, &ind1[i*kNN], &dist1[i*kNN]);
+  timer.Stop();
+  Double_t tpoint = timer.RealTime();
+  timer.Start(kTRUE);
+  kdtree->FindNearestNeighborsN(nquery, query, kNN, ind2, dist2);
+  timer.Stop();
+  Double_t tbatch = timer.RealTime();
+  Int_t ndiff = 0;
+  for (Int_t i=0; i<nquery*kNN; i++)
+    if (ind1[i] != ind2[i] || dist1[i] != dist2[i]) ndiff++;
+  printf("%d nearest neighbors of %d points: per point %f [s] batch %f [s] speedup %5.2f, %d differences\n",
+         kNN, nquery, tpoint, tbatch, tbatch > 0 ? tpoint/tbatch : 0., ndiff);
+
+  Int_t nrange = nquery/10;
+  Double_t range = 0.02;
+  std::vector<Int_t> res1, res2, offsets;
+  Int_t nfound = 0;
+  timer.Start(kTRUE);
+  for (Int_t i=0; i<nrange; i++) {
+    res1.clear();
+    kdtree->FindInRange(&query[i*ndim], range, res1);
+    nfound += res1.size();
+  }
+  timer.Stop();
+  tpoint = timer.RealTime();
+  timer.Start(kTRUE);
+  kdtree->FindInRangeN(nrange, query, range, res2, offsets);
+  timer.Stop();
+  tbatch = timer.RealTime();
+  ndiff = TMath::Abs(nfound - Int_t(res2.size()));
+  for (Int_t i=0; i<nrange && !ndiff; i++) {
+    res1.clear();
+    kdtree->FindInRange(&query[i*ndim], range, res1);
+    for (Int_t j=0; j<Int_t(res1.size()); j++)
+      if (offsets[i]+j >= offsets[i+1] || res1[j] != res2[offsets[i]+j]) ndiff++;
+  }
+  printf("range search of %d points: per point %f [s] batch %f [s] speedup %5.2f, %d differences\n",
+         nrange, tpoint, tbatch, tbatch > 0 ? tpoint/tbatch : 0., ndiff);
+
+  delete kdtree;
+  delete [] data0;
+  delete [] query;
+  delete [] ind1;
+  delete [] ind2;
+  delete [] dist1;
+  delete [] dist2;
+}
+
 /*
 //______________________________________________________________________
 void TestSizeIF(Int_t nsec, Int_t nrows, Int_t npoints,  Int_t bsize, Int_t mode)
@@ -7,6 +7,7 @@
 #include "TH2.h"
 #include "TStopwatch.h"
 #include <cmath>
+#include <algorithm>
 
 using namespace std;
 
@@ -210,6 +211,62 @@ int TestIntegral(TF1* f1)
    return status;
 }
 
+int TestEvalParVec()
+{
+   // Evaluate formulas at NB points with EvalParVec, interpreted and
+   // compiled (TFormula::SetJit), and compare with EvalPar at each point.
+
+   const int NF = 6;
+   const char* formulas[NF] = { "[0]*sin(x)+[1]", "gaus", "expo", "pol3",
+                                "sqrt(abs(x))*TMath::Landau(x,[0],[1])",
+                                "x>[0] ? [1]*x*x : log(1+x)" };
+   const double par[4] = { 1.5, 0.7, -0.3, 0.05 };
+   int status = 0;
+   TStopwatch w;
+   double totalTime = 0;
+
+   cout << "EvalParVec TEST\n"
+        << "---------------------------------------------------------"
+        << endl;
+
+   // x values, and the same values with a stride of 2
+   double x[NB], x2[2*NB], result[NB], result2[NB];
+   for ( int i = 0; i < NB; ++i ) {
+      x[i] = XMIN + i*(XMAX-XMIN)/(NB-1);
+      x2[2*i] = x[i];
+      x2[2*i+1] = -1;
+   }
+
+   for ( int jit = 0; jit < 2; ++jit ) {
+      TFormula::SetJit(jit);
+      for ( int k = 0; k < NF; ++k ) {
+         TF1* f = new TF1("fvec", formulas[k], XMIN, XMAX);
+         w.Start(kTRUE);
+         for ( int j = 0; j < REP/NB; ++j )
+            f->EvalParVec(NB, x, result, par);
+         w.Stop();
+         f->EvalParVec(NB, x2, result2, par, 2);
+         double maxdiff = 0;
+         for ( int i = 0; i < NB; ++i ) {
+            double expected = f->EvalPar(&x[i], par);
+            double scale = std::max(1., std::abs(expected));
+            maxdiff = std::max(maxdiff, std::abs(result[i] - expected)/scale);
+            maxdiff = std::max(maxdiff, std::abs(result2[i] - expected)/scale);
+         }
+         status += PrintStatus(jit ? "EvalParVec (jit)" : "EvalParVec", maxdiff, 0, w.RealTime()/ TNORM );
+         totalTime += w.RealTime();
+         delete f;
+      }
+   }
+   TFormula::SetJit(kFALSE);
+
+   cout << "Total Time: " << totalTime  << endl;
+
+   sumTime += totalTime;
+
+   return status;
+}
+
 double func(double * x, double * p) { 
    double xx = *x; 
    ncall++;
@@ -233,6 +290,7 @@ int stressTF1()
    status += TestMaxMin(f1);
    status += TestDerivative(f1);
    status += TestIntegral(f1);
+   status += TestEvalParVec();
 
    cout << "End of Tests..." << endl;
    cout << "Total time for all tests: " << sumTime << endl;
@@ -111,6 +111,20 @@ public:
    */ 
    virtual void SetErrorDef(double ) {}; 
 
+   /** 
+       return true if operator() can be called at the same time by several threads 
+       on this object. The numerical derivatives are then computed in parallel 
+       (see MnStrategy::SetNumberOfThreads). Re-implement this function if needed. 
+   */ 
+   virtual bool IsThreadSafe() const { return false; }
+
+   /** 
+       return a copy of the function, owned by the caller, for functions which are not 
+       thread safe: each thread computing the numerical derivatives evaluates its own copy. 
+       The default returns 0 (no copy); then, unless IsThreadSafe(), a single thread is used. 
+   */ 
+   virtual FCNBase * Clone() const { return 0; }
+
 };
 
   }  // namespace Minuit2
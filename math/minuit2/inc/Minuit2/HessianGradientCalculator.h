@@ -24,6 +24,7 @@ class MnFcn;
 class MnUserTransformation;
 class MnMachinePrecision;
 class MnStrategy;
+class MnParallelFcn;
 
 /**
    HessianGradientCalculator: class to calculate Gradient for Hessian
@@ -57,6 +58,10 @@ public:
 
 private:
 
+  void Derivative(unsigned int i, MnAlgebraicVector& x, const MnParallelFcn& fcn, unsigned int ithread,
+                  double dfmin, MnAlgebraicVector& grd, const MnAlgebraicVector& g2,
+                  MnAlgebraicVector& gstep, MnAlgebraicVector& dgrd) const;
+
   const MnFcn& fFcn;
   const MnUserTransformation& fTransformation; 
   const MnStrategy& fStrategy;
@@ -42,6 +42,9 @@ public:
   virtual double operator()(const MnAlgebraicVector&) const;
   unsigned int NumOfCalls() const {return fNumCall;}
 
+  /// evaluate fcn (the FCN or a copy of it) without counting the call
+  virtual double Eval(const FCNBase& fcn, const MnAlgebraicVector&) const;
+
   //
   //forward interface
   //
@@ -56,6 +59,8 @@ private:
 
 protected:
 
+  friend class MnParallelFcn;
+
   mutable int fNumCall;
 };
 
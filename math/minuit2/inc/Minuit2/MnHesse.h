@@ -12,6 +12,7 @@
 
 #include "Minuit2/MnConfig.h"
 #include "Minuit2/MnStrategy.h"
+#include "Minuit2/MnMatrix.h"
 
 #include <vector>
 
@@ -29,6 +30,7 @@ class MinimumState;
 class MnMachinePrecision;
 class MnFcn;
 class FunctionMinimum; 
+class MnParallelFcn;
 
 //_______________________________________________________________________
 /** 
@@ -89,6 +91,12 @@ public:
 
 private:
 
+   /// compute the 2nd derivative of the parameter i (return false if it is zero)
+   bool Diagonal(unsigned int i, MnAlgebraicVector& x, const MnParallelFcn& mfcn, unsigned int ithread,
+                 double amin, double aimsag, const MnUserTransformation& trafo,
+                 MnAlgebraicVector& g2, MnAlgebraicVector& grd, MnAlgebraicVector& gst,
+                 MnAlgebraicVector& dirin, MnAlgebraicVector& yy, unsigned int& ncall) const;
+
    MnStrategy fStrategy;
 };
 
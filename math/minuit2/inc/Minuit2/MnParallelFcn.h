@@ -0,0 +1,70 @@
+// @(#)root/minuit2:$Id$
+// Authors: M. Winkler, F. James, L. Moneta, A. Zsenei   2003-2005
+
+/**********************************************************************
+ *                                                                    *
+ * Copyright (c) 2005 LCG ROOT Math team,  CERN/PH-SFT                *
+ *                                                                    *
+ **********************************************************************/
+
+#ifndef ROOT_Minuit2_MnParallelFcn
+#define ROOT_Minuit2_MnParallelFcn
+
+#include "Minuit2/MnConfig.h"
+#include "Minuit2/MnMatrix.h"
+
+#include <vector>
+
+namespace ROOT {
+
+   namespace Minuit2 {
+
+
+class FCNBase;
+class MnFcn;
+class MnStrategy;
+
+/**
+   Evaluation of a MnFcn by several threads, used for computing the numerical
+   derivatives (Numerical2PGradientCalculator, HessianGradientCalculator, MnHesse)
+   in parallel when Minuit2 is built with OpenMP.
+   The number of threads is given by MnStrategy::NumberOfThreads(). Thread 0 uses
+   the FCN itself; the other threads share it if FCNBase::IsThreadSafe(), otherwise
+   each of them evaluates its own copy made with FCNBase::Clone(). When the FCN
+   can neither be shared nor copied a single thread is used.
+   The calls are counted in the MnFcn, as for a serial evaluation.
+ */
+class MnParallelFcn {
+
+public:
+
+   MnParallelFcn(const MnFcn& fcn, const MnStrategy& stra);
+
+   ~MnParallelFcn();
+
+   /// number of threads which can evaluate the function (1 for serial evaluation)
+   unsigned int NThreads() const { return fFcns.size(); }
+
+   /// number of the calling thread, between 0 and NThreads()-1
+   unsigned int ThreadNumber() const;
+
+   /// evaluate the function for the thread ithread and count the call
+   double operator()(const MnAlgebraicVector& v, unsigned int ithread) const;
+
+   const MnFcn& Fcn() const { return fMnFcn; }
+
+private:
+
+   MnParallelFcn(const MnParallelFcn&); // not implemented
+   MnParallelFcn& operator=(const MnParallelFcn&); // not implemented
+
+   const MnFcn& fMnFcn;
+   std::vector<const FCNBase*> fFcns;   // function evaluated by each thread
+   std::vector<FCNBase*> fCopies;       // copies owned by this object
+};
+
+  }  // namespace Minuit2
+
+}  // namespace ROOT
+
+#endif  // ROOT_Minuit2_MnParallelFcn
@@ -48,6 +48,8 @@ public:
    unsigned int HessianGradientNCycles() const {return fHessGradNCyc;}
 
    int StorageLevel() const { return fStoreLevel; }
+
+   unsigned int NumberOfThreads() const { return fNThreads; }
  
    bool IsLow() const {return fStrategy == 0;}
    bool IsMedium() const {return fStrategy == 1;}
@@ -69,6 +71,11 @@ public:
    // set storage level of iteration quantities 
    // 0 = store only last iterations 1 = full storage (default)
    void SetStorageLevel(unsigned int level) { fStoreLevel = level; }
+
+   // set the number of threads computing the numerical gradient and Hessian 
+   // (Minuit2 built with OpenMP): 1 = serial, 0 = OpenMP default (the default) 
+   // The FCN must be thread safe or provide copies (see FCNBase::IsThreadSafe and Clone)
+   void SetNumberOfThreads(unsigned int n) { fNThreads = n; }
 private:
 
    unsigned int fStrategy;
@@ -81,6 +88,7 @@ private:
    double fHessTlrG2;
    unsigned int fHessGradNCyc;
    int fStoreLevel; 
+   unsigned int fNThreads;
 };
 
   }  // namespace Minuit2
@@ -32,7 +32,7 @@ public:
 
   ~MnUserFcn() {}
 
-  virtual double operator()(const MnAlgebraicVector&) const;
+  virtual double Eval(const FCNBase& fcn, const MnAlgebraicVector&) const;
 
 private:
 
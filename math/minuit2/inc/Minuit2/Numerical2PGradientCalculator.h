@@ -18,6 +18,10 @@
 #include "Minuit2/GradientCalculator.h"
 #endif
 
+#ifndef ROOT_Minuit2_MnMatrix
+#include "Minuit2/MnMatrix.h"
+#endif
+
 #include <vector>
 
 namespace ROOT {
@@ -29,6 +33,7 @@ class MnFcn;
 class MnUserTransformation;
 class MnMachinePrecision;
 class MnStrategy;
+class MnParallelFcn;
 
 /**
    class performing the numerical gradient calculation
@@ -69,6 +74,10 @@ public:
 
 private:
 
+  void Derivative(unsigned int i, MnAlgebraicVector& x, const MnParallelFcn& fcn, unsigned int ithread,
+                  double fcnmin, double dfmin, double vrysml,
+                  MnAlgebraicVector& grd, MnAlgebraicVector& g2, MnAlgebraicVector& gstep) const;
+
   const MnFcn& fFcn;
   const MnUserTransformation& fTransformation; 
   const MnStrategy& fStrategy;
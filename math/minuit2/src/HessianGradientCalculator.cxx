@@ -25,6 +25,7 @@
 #endif
 
 #include "Minuit2/MPIProcess.h"
+#include "Minuit2/MnParallelFcn.h"
 
 namespace ROOT {
 
@@ -85,63 +86,86 @@ std::pair<FunctionGradient, MnAlgebraicVector> HessianGradientCalculator::DeltaG
    unsigned int n = x.size();
    MnAlgebraicVector dgrd(n);
    
+   // the parameters are independent: with several threads (see
+   // MnStrategy::SetNumberOfThreads) each thread computes some of them
+   MnParallelFcn pfcn(Fcn(), Strategy());
+   unsigned int nthreads = pfcn.NThreads();
+
+   if (nthreads > 1) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+      for(int i = 0; i < int(n); i++) {
+         // each thread uses its own copy of the parameters
+         MnAlgebraicVector xi = par.Vec();
+         Derivative(i, xi, pfcn, pfcn.ThreadNumber(), dfmin, grd, g2, gstep, dgrd);
+      }
+      return std::pair<FunctionGradient, MnAlgebraicVector>(FunctionGradient(grd, g2, gstep), dgrd);
+   }
+
    MPIProcess mpiproc(n,0);
    // initial starting values
    unsigned int startElementIndex = mpiproc.StartElementIndex();
    unsigned int endElementIndex = mpiproc.EndElementIndex();
 
-   for(unsigned int i = startElementIndex; i < endElementIndex; i++) {
-      double xtf = x(i);
-      double dmin = 4.*Precision().Eps2()*(xtf + Precision().Eps2());
-      double epspri = Precision().Eps2() + fabs(grd(i)*Precision().Eps2());
-      double optstp = sqrt(dfmin/(fabs(g2(i))+epspri));
-      double d = 0.2*fabs(gstep(i));
-      if(d > optstp) d = optstp;
-      if(d < dmin) d = dmin;
-      double chgold = 10000.;
-      double dgmin = 0.;
-      double grdold = 0.;
-      double grdnew = 0.;
-      for(unsigned int j = 0; j < Ncycle(); j++)  {
-         x(i) = xtf + d;
-         double fs1 = Fcn()(x);
-         x(i) = xtf - d;
-         double fs2 = Fcn()(x);
-         x(i) = xtf;
-         //       double sag = 0.5*(fs1+fs2-2.*fcnmin);
-         //LM: should I calculate also here second derivatives ???
-
-         grdold = grd(i);
-         grdnew = (fs1-fs2)/(2.*d);
-         dgmin = Precision().Eps()*(fabs(fs1) + fabs(fs2))/d;
-         //if(fabs(grdnew) < Precision().Eps()) break;
-         if (grdnew == 0) break; 
-         double change = fabs((grdold-grdnew)/grdnew);
-         if(change > chgold && j > 1) break;
-         chgold = change;
-         grd(i) = grdnew;
-         //LM : update also the step sizes
-         gstep(i) = d; 
-
-         if(change < 0.05) break;
-         if(fabs(grdold-grdnew) < dgmin) break;
-         if(d < dmin) break;
-         d *= 0.2;
-      }  
-
-      dgrd(i) = std::max(dgmin, fabs(grdold-grdnew));
-
-#ifdef DEBUG
-      std::cout << "HGC Param : " << i << "\t new g1 = " << grd(i) << " gstep = " << d << " dgrd = " << dgrd(i) << std::endl;
-#endif
-
-   }
+   for(unsigned int i = startElementIndex; i < endElementIndex; i++)
+      Derivative(i, x, pfcn, 0, dfmin, grd, g2, gstep, dgrd);
    
    mpiproc.SyncVector(grd);
    mpiproc.SyncVector(gstep);
    mpiproc.SyncVector(dgrd);
    
    return std::pair<FunctionGradient, MnAlgebraicVector>(FunctionGradient(grd, g2, gstep), dgrd);
+}
+
+void HessianGradientCalculator::Derivative(unsigned int i, MnAlgebraicVector& x, const MnParallelFcn& fcn, unsigned int ithread, double dfmin, MnAlgebraicVector& grd, const MnAlgebraicVector& g2, MnAlgebraicVector& gstep, MnAlgebraicVector& dgrd) const {
+   // compute the derivative of the parameter i, updating only the element i of
+   // grd, gstep and dgrd; x is modified during the computation and then restored
+
+   double xtf = x(i);
+   double dmin = 4.*Precision().Eps2()*(xtf + Precision().Eps2());
+   double epspri = Precision().Eps2() + fabs(grd(i)*Precision().Eps2());
+   double optstp = sqrt(dfmin/(fabs(g2(i))+epspri));
+   double d = 0.2*fabs(gstep(i));
+   if(d > optstp) d = optstp;
+   if(d < dmin) d = dmin;
+   double chgold = 10000.;
+   double dgmin = 0.;
+   double grdold = 0.;
+   double grdnew = 0.;
+   for(unsigned int j = 0; j < Ncycle(); j++)  {
+      x(i) = xtf + d;
+      double fs1 = fcn(x, ithread);
+      x(i) = xtf - d;
+      double fs2 = fcn(x, ithread);
+      x(i) = xtf;
+      //       double sag = 0.5*(fs1+fs2-2.*fcnmin);
+      //LM: should I calculate also here second derivatives ???
+
+      grdold = grd(i);
+      grdnew = (fs1-fs2)/(2.*d);
+      dgmin = Precision().Eps()*(fabs(fs1) + fabs(fs2))/d;
+      //if(fabs(grdnew) < Precision().Eps()) break;
+      if (grdnew == 0) break; 
+      double change = fabs((grdold-grdnew)/grdnew);
+      if(change > chgold && j > 1) break;
+      chgold = change;
+      grd(i) = grdnew;
+      //LM : update also the step sizes
+      gstep(i) = d; 
+
+      if(change < 0.05) break;
+      if(fabs(grdold-grdnew) < dgmin) break;
+      if(d < dmin) break;
+      d *= 0.2;
+   }  
+
+   dgrd(i) = std::max(dgmin, fabs(grdold-grdnew));
+
+#ifdef DEBUG
+   std::cout << "HGC Param : " << i << "\t new g1 = " << grd(i) << " gstep = " << d << " dgrd = " << dgrd(i) << std::endl;
+#endif
+
 }
 
    }  // namespace Minuit2
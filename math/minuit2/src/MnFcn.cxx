@@ -23,7 +23,12 @@ MnFcn::~MnFcn() {
 double MnFcn::operator()(const MnAlgebraicVector& v) const {
    // evaluate FCN converting from from MnAlgebraicVector to std::vector
    fNumCall++;
-   return fFCN(MnVectorTransform()(v));
+   return Eval(fFCN, v);
+}
+
+double MnFcn::Eval(const FCNBase& fcn, const MnAlgebraicVector& v) const {
+   // evaluate the function fcn (the FCN or a copy of it) without counting the call
+   return fcn(MnVectorTransform()(v));
 }
 
 // double MnFcn::operator()(const std::vector<double>& par) const {
@@ -26,6 +26,7 @@
 #endif
 
 #include "Minuit2/MPIProcess.h"
+#include "Minuit2/MnParallelFcn.h"
 
 namespace ROOT {
 
@@ -127,45 +128,33 @@ MinimumState MnHesse::operator()(const MnFcn& mfcn, const MinimumState& st, cons
 #endif
 
    
-   for(unsigned int i = 0; i < n; i++) {
-      
-      double xtf = x(i);
-      double dmin = 8.*prec.Eps2()*(fabs(xtf) + prec.Eps2());
-      double d = fabs(gst(i));
-      if(d < dmin) d = dmin;
-
-#ifdef DEBUG
-      std::cout << "\nDerivative parameter  " << i << " d = " << d << " dmin = " << dmin << std::endl;
+   // the 2nd derivatives of the parameters are independent: with several threads
+   // (see MnStrategy::SetNumberOfThreads) each thread computes some of them, then
+   // the checks done after each parameter are replayed in the serial order
+   MnParallelFcn pfcn(mfcn, fStrategy);
+   unsigned int nthreads = pfcn.NThreads();
+   std::vector<int> ok(n, 1);
+   std::vector<unsigned int> ncalls(n, 0);
+   // values of g2 when failing for a parameter are those of the serial computation
+   MnAlgebraicVector g2in = g2;
+   unsigned int ncall = mfcn.NumOfCalls();
+
+   if (nthreads > 1) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
 #endif
+      for(int i = 0; i < int(n); i++) {
+         // each thread uses its own copy of the parameters
+         MnAlgebraicVector xi = x;
+         ok[i] = Diagonal(i, xi, pfcn, pfcn.ThreadNumber(), amin, aimsag, trafo, g2, grd, gst, dirin, yy, ncalls[i]);
+      }
+   }
 
+   for(unsigned int i = 0; i < n; i++) {
       
-      for(unsigned int icyc = 0; icyc < Ncycles(); icyc++) {
-         double sag = 0.;
-         double fs1 = 0.;
-         double fs2 = 0.;
-         for(unsigned int multpy = 0; multpy < 5; multpy++) {
-            x(i) = xtf + d;
-            fs1 = mfcn(x);
-            x(i) = xtf - d;
-            fs2 = mfcn(x);
-            x(i) = xtf;
-            sag = 0.5*(fs1+fs2-2.*amin);
+      if (nthreads == 1) ok[i] = Diagonal(i, x, pfcn, 0, amin, aimsag, trafo, g2, grd, gst, dirin, yy, ncalls[i]);
 
-#ifdef DEBUG
-            std::cout << "cycle " << icyc << " mul " << multpy << "\t sag = " << sag << " d = " << d << std::endl; 
-#endif
-            //  Now as F77 Minuit - check taht sag is not zero
-            if (sag != 0) goto L30; // break
-            if(trafo.Parameter(i).HasLimits()) {
-               if(d > 0.5) goto L26;
-               d *= 10.;
-               if(d > 0.5) d = 0.51;
-               continue;
-            }
-            d *= 10.;
-         }
-         
-L26:  
+      if (!ok[i]) {
 #ifdef WARNINGMSG
 
          // get parameter name for i
@@ -177,39 +166,18 @@ L26:
          }
 #endif
          
+         for(unsigned int j = i+1; j < n; j++) g2(j) = g2in(j);
          for(unsigned int j = 0; j < n; j++) {
             double tmp = g2(j) < prec.Eps2() ? 1. : 1./g2(j);
             vhmat(j,j) = tmp < prec.Eps2() ? 1. : tmp;
          }
          
          return MinimumState(st.Parameters(), MinimumError(vhmat, MinimumError::MnHesseFailed()), st.Gradient(), st.Edm(), mfcn.NumOfCalls());
-         
-L30:      
-            double g2bfor = g2(i);
-         g2(i) = 2.*sag/(d*d);
-         grd(i) = (fs1-fs2)/(2.*d);
-         gst(i) = d;
-         dirin(i) = d;
-         yy(i) = fs1;
-         double dlast = d;
-         d = sqrt(2.*aimsag/fabs(g2(i)));
-         if(trafo.Parameter(i).HasLimits()) d = std::min(0.5, d);
-         if(d < dmin) d = dmin;
-
-#ifdef DEBUG
-         std::cout << "\t g1 = " << grd(i) << " g2 = " << g2(i) << " step = " << gst(i) << " d = " << d 
-                   << " diffd = " <<  fabs(d-dlast)/d << " diffg2 = " << fabs(g2(i)-g2bfor)/g2(i) << std::endl;
-#endif
-
-         
-         // see if converged
-         if(fabs((d-dlast)/d) < Tolerstp()) break;
-         if(fabs((g2(i)-g2bfor)/g2(i)) < TolerG2()) break; 
-         d = std::min(d, 10.*dlast);
-         d = std::max(d, 0.1*dlast);   
       }
+
       vhmat(i,i) = g2(i);
-      if(mfcn.NumOfCalls()  > maxcalls) {
+      ncall += ncalls[i];
+      if(ncall  > maxcalls) {
          
 #ifdef WARNINGMSG
          //std::cout<<"maxcalls " << maxcalls << " " << mfcn.NumOfCalls() << "  " <<   st.NFcn() << std::endl;
@@ -217,6 +185,7 @@ L30:
          MN_INFO_MSG("MnHesse fails and will return diagonal matrix ");
 #endif
          
+         for(unsigned int j = i+1; j < n; j++) g2(j) = g2in(j);
          for(unsigned int j = 0; j < n; j++) {
             double tmp = g2(j) < prec.Eps2() ? 1. : 1./g2(j);
             vhmat(j,j) = tmp < prec.Eps2() ? 1. : tmp;
@@ -241,39 +210,58 @@ L30:
    }
    
    //off-diagonal Elements  
-   // initial starting values
-   MPIProcess mpiprocOffDiagonal(n*(n-1)/2,0);
-   unsigned int startParIndexOffDiagonal = mpiprocOffDiagonal.StartElementIndex();
-   unsigned int endParIndexOffDiagonal = mpiprocOffDiagonal.EndElementIndex();
+   if (nthreads > 1) {
+      // each thread computes some rows, with its own copy of the parameters
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+      for(int i = 0; i < int(n)-1; i++) {
+         MnAlgebraicVector xi = x;
+         unsigned int ith = pfcn.ThreadNumber();
+         xi(i) += dirin(i);
+         for(unsigned int j = i+1; j < n; j++) {
+            xi(j) += dirin(j);
+            double fs1 = pfcn(xi, ith);
+            vhmat(i,j) = (fs1 + amin - yy(i) - yy(j))/(dirin(i)*dirin(j));
+            xi(j) -= dirin(j);
+         }
+      }
+   }
+   else {
+      // initial starting values
+      MPIProcess mpiprocOffDiagonal(n*(n-1)/2,0);
+      unsigned int startParIndexOffDiagonal = mpiprocOffDiagonal.StartElementIndex();
+      unsigned int endParIndexOffDiagonal = mpiprocOffDiagonal.EndElementIndex();
 
-   unsigned int offsetVect = 0;
-   for (unsigned int in = 0; in<startParIndexOffDiagonal; in++)
-      if ((in+offsetVect)%(n-1)==0) offsetVect += (in+offsetVect)/(n-1);
+      unsigned int offsetVect = 0;
+      for (unsigned int in = 0; in<startParIndexOffDiagonal; in++)
+         if ((in+offsetVect)%(n-1)==0) offsetVect += (in+offsetVect)/(n-1);
 
-   for (unsigned int in = startParIndexOffDiagonal;
-        in<endParIndexOffDiagonal; in++) {
+      for (unsigned int in = startParIndexOffDiagonal;
+           in<endParIndexOffDiagonal; in++) {
 
-      int i = (in+offsetVect)/(n-1);
-      if ((in+offsetVect)%(n-1)==0) offsetVect += i;
-      int j = (in+offsetVect)%(n-1)+1;
+         int i = (in+offsetVect)/(n-1);
+         if ((in+offsetVect)%(n-1)==0) offsetVect += i;
+         int j = (in+offsetVect)%(n-1)+1;
 
-      if ((i+1)==j || in==startParIndexOffDiagonal)
-         x(i) += dirin(i);
+         if ((i+1)==j || in==startParIndexOffDiagonal)
+            x(i) += dirin(i);
       
-      x(j) += dirin(j);
+         x(j) += dirin(j);
       
-      double fs1 = mfcn(x);
-      double elem = (fs1 + amin - yy(i) - yy(j))/(dirin(i)*dirin(j));
-      vhmat(i,j) = elem;
+         double fs1 = mfcn(x);
+         double elem = (fs1 + amin - yy(i) - yy(j))/(dirin(i)*dirin(j));
+         vhmat(i,j) = elem;
       
-      x(j) -= dirin(j);
+         x(j) -= dirin(j);
       
-      if (j%(n-1)==0 || in==endParIndexOffDiagonal-1)
-         x(i) -= dirin(i);
+         if (j%(n-1)==0 || in==endParIndexOffDiagonal-1)
+            x(i) -= dirin(i);
       
-   }
+      }
    
-   mpiprocOffDiagonal.SyncSymMatrixOffDiagonal(vhmat);
+      mpiprocOffDiagonal.SyncSymMatrixOffDiagonal(vhmat);
+   }
 
    //verify if matrix pos-def (still 2nd derivative)
 
@@ -341,6 +329,75 @@ L30:
    return MinimumState(st.Parameters(), err, gr, edm, mfcn.NumOfCalls());
 }
 
+bool MnHesse::Diagonal(unsigned int i, MnAlgebraicVector& x, const MnParallelFcn& mfcn, unsigned int ithread, double amin, double aimsag, const MnUserTransformation& trafo, MnAlgebraicVector& g2, MnAlgebraicVector& grd, MnAlgebraicVector& gst, MnAlgebraicVector& dirin, MnAlgebraicVector& yy, unsigned int& ncall) const {
+   // compute the 2nd derivative of the parameter i, updating only the element i of
+   // g2, grd, gst, dirin and yy, and counting the function calls in ncall.
+   // Return false if the 2nd derivative is zero.
+   // x is modified during the computation and then restored
+
+   const MnMachinePrecision& prec = trafo.Precision();
+   double xtf = x(i);
+   double dmin = 8.*prec.Eps2()*(fabs(xtf) + prec.Eps2());
+   double d = fabs(gst(i));
+   if(d < dmin) d = dmin;
+
+#ifdef DEBUG
+   std::cout << "\nDerivative parameter  " << i << " d = " << d << " dmin = " << dmin << std::endl;
+#endif
+
+   for(unsigned int icyc = 0; icyc < Ncycles(); icyc++) {
+      double sag = 0.;
+      double fs1 = 0.;
+      double fs2 = 0.;
+      for(unsigned int multpy = 0; multpy < 5; multpy++) {
+         x(i) = xtf + d;
+         fs1 = mfcn(x, ithread);
+         x(i) = xtf - d;
+         fs2 = mfcn(x, ithread);
+         x(i) = xtf;
+         ncall += 2;
+         sag = 0.5*(fs1+fs2-2.*amin);
+
+#ifdef DEBUG
+         std::cout << "cycle " << icyc << " mul " << multpy << "\t sag = " << sag << " d = " << d << std::endl; 
+#endif
+         //  Now as F77 Minuit - check taht sag is not zero
+         if (sag != 0) break;
+         if(trafo.Parameter(i).HasLimits()) {
+            if(d > 0.5) return false;
+            d *= 10.;
+            if(d > 0.5) d = 0.51;
+            continue;
+         }
+         d *= 10.;
+      }
+      if (sag == 0) return false;
+
+      double g2bfor = g2(i);
+      g2(i) = 2.*sag/(d*d);
+      grd(i) = (fs1-fs2)/(2.*d);
+      gst(i) = d;
+      dirin(i) = d;
+      yy(i) = fs1;
+      double dlast = d;
+      d = sqrt(2.*aimsag/fabs(g2(i)));
+      if(trafo.Parameter(i).HasLimits()) d = std::min(0.5, d);
+      if(d < dmin) d = dmin;
+
+#ifdef DEBUG
+      std::cout << "\t g1 = " << grd(i) << " g2 = " << g2(i) << " step = " << gst(i) << " d = " << d 
+                << " diffd = " <<  fabs(d-dlast)/d << " diffg2 = " << fabs(g2(i)-g2bfor)/g2(i) << std::endl;
+#endif
+
+      // see if converged
+      if(fabs((d-dlast)/d) < Tolerstp()) break;
+      if(fabs((g2(i)-g2bfor)/g2(i)) < TolerG2()) break; 
+      d = std::min(d, 10.*dlast);
+      d = std::max(d, 0.1*dlast);   
+   }
+   return true;
+}
+
 /*
  MinimumError MnHesse::Hessian(const MnFcn& mfcn, const MinimumState& st, const MnUserTransformation& trafo) const {
     
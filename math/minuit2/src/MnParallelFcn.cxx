@@ -0,0 +1,74 @@
+// @(#)root/minuit2:$Id$
+// Authors: M. Winkler, F. James, L. Moneta, A. Zsenei   2003-2005
+
+/**********************************************************************
+ *                                                                    *
+ * Copyright (c) 2005 LCG ROOT Math team,  CERN/PH-SFT                *
+ *                                                                    *
+ **********************************************************************/
+
+#include "Minuit2/MnParallelFcn.h"
+#include "Minuit2/MnFcn.h"
+#include "Minuit2/FCNBase.h"
+#include "Minuit2/MnStrategy.h"
+#include "Minuit2/StackAllocator.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace ROOT {
+
+   namespace Minuit2 {
+
+
+MnParallelFcn::MnParallelFcn(const MnFcn& fcn, const MnStrategy& stra) : fMnFcn(fcn) {
+   // find the number of threads and make the copies of the FCN needed by them
+   unsigned int nthreads = 1;
+#if defined(_OPENMP) && !defined(_MN_NO_THREAD_SAVE_)
+   nthreads = stra.NumberOfThreads();
+   if (nthreads == 0) nthreads = omp_get_max_threads();
+#else
+   (void) stra;
+#endif
+   const FCNBase& fcnbase = fcn.Fcn();
+   fFcns.push_back(&fcnbase);
+   for (unsigned int i = 1; i < nthreads; i++) {
+      if (fcnbase.IsThreadSafe()) {
+         fFcns.push_back(&fcnbase);
+         continue;
+      }
+      FCNBase* copy = fcnbase.Clone();
+      // function cannot be copied: use a single thread
+      if (copy == 0) break;
+      fCopies.push_back(copy);
+      fFcns.push_back(copy);
+   }
+}
+
+MnParallelFcn::~MnParallelFcn() {
+   // delete the copies of the FCN
+   for (unsigned int i = 0; i < fCopies.size(); i++) delete fCopies[i];
+}
+
+unsigned int MnParallelFcn::ThreadNumber() const {
+   // number of the calling thread
+#ifdef _OPENMP
+   return omp_get_thread_num();
+#else
+   return 0;
+#endif
+}
+
+double MnParallelFcn::operator()(const MnAlgebraicVector& v, unsigned int ithread) const {
+   // evaluate the function of the thread ithread and count the call in the MnFcn
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+   fMnFcn.fNumCall++;
+   return fMnFcn.Eval(*fFcns[ithread], v);
+}
+
+   }  // namespace Minuit2
+
+}  // namespace ROOT
@@ -16,9 +16,9 @@ namespace ROOT {
    namespace Minuit2 {
 
 
-double MnUserFcn::operator()(const MnAlgebraicVector& v) const {
+double MnUserFcn::Eval(const FCNBase& fcn, const MnAlgebraicVector& v) const {
    // call Fcn function transforming from a MnAlgebraicVector of internal values to a std::vector of external ones 
-   fNumCall++;
+   // (the call is counted by MnFcn::operator())
 
    // calling fTransform() like here was not thread safe because it was using a cached vector
    //return Fcn()( fTransform(v) );
@@ -39,7 +39,7 @@ double MnUserFcn::operator()(const MnAlgebraicVector& v) const {
          vpar[ext] = v(i);
       }
    }
-   return Fcn()(vpar); 
+   return fcn(vpar); 
 }
 
    }  // namespace Minuit2
@@ -15,6 +15,7 @@
 #include "Minuit2/MinimumParameters.h"
 #include "Minuit2/FunctionGradient.h"
 #include "Minuit2/MnStrategy.h"
+#include "Minuit2/MnParallelFcn.h"
 
 
 //#define DEBUG
@@ -94,16 +95,11 @@ FunctionGradient Numerical2PGradientCalculator::operator()(const MinimumParamete
    //    std::cout << " ncycle " << Ncycle() << std::endl;
    
    unsigned int n = (par.Vec()).size();
-   unsigned int ncycle = Ncycle();
    //   MnAlgebraicVector vgrd(n), vgrd2(n), vgstp(n);
    MnAlgebraicVector grd = Gradient.Grad();
    MnAlgebraicVector g2 = Gradient.G2();
    MnAlgebraicVector gstep = Gradient.Gstep();
 
-#ifndef _OPENMP
-   MPIProcess mpiproc(n,0);
-#endif
-
 #ifdef DEBUG
    std::cout << "Calculating Gradient at x =   " << par.Vec() << std::endl;
    int pr = std::cout.precision(13);
@@ -111,121 +107,124 @@ FunctionGradient Numerical2PGradientCalculator::operator()(const MinimumParamete
    std::cout.precision(pr);
 #endif
 
-#ifndef _OPENMP
+   // the derivatives of the parameters are independent: with several threads
+   // (see MnStrategy::SetNumberOfThreads) each thread computes some of them
+   MnParallelFcn pfcn(Fcn(), Strategy());
+   unsigned int nthreads = pfcn.NThreads();
+
+   if (nthreads > 1) {
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+      for(int i = 0; i < int(n); i++) {
+         // each thread uses its own copy of the parameters
+         MnAlgebraicVector x = par.Vec();
+         unsigned int ith = pfcn.ThreadNumber();
+         Derivative(i, x, pfcn, ith, fcnmin, dfmin, vrysml, grd, g2, gstep);
+
+#ifdef DEBUG_MP
+#pragma omp critical
+         {
+            std::cout << "Gradient for thread " << ith << "  " << i << "  " << std::setprecision(15)  << grd(i) << "  " << g2(i) << std::endl;
+         }
+#endif
+      }
+      
+      return FunctionGradient(grd, g2, gstep);
+   }
+
+   MPIProcess mpiproc(n,0);
+
    // for serial execution this can be outside the loop
    MnAlgebraicVector x = par.Vec();
 
    unsigned int startElementIndex = mpiproc.StartElementIndex();
    unsigned int endElementIndex = mpiproc.EndElementIndex();
 
-   for(unsigned int i = startElementIndex; i < endElementIndex; i++) {
+   for(unsigned int i = startElementIndex; i < endElementIndex; i++)
+      Derivative(i, x, pfcn, 0, fcnmin, dfmin, vrysml, grd, g2, gstep);
 
-#else
-
- // parallelize this loop using OpenMP
-//#define N_PARALLEL_PAR 5
-#pragma omp parallel
-#pragma omp for 
-//#pragma omp for schedule (static, N_PARALLEL_PAR)
-
-   for(int i = 0; i < int(n); i++) {
+   mpiproc.SyncVector(grd);
+   mpiproc.SyncVector(g2);
+   mpiproc.SyncVector(gstep);
 
-#endif
+   return FunctionGradient(grd, g2, gstep);
+}
 
-#ifdef DEBUG_MP
-      int ith = omp_get_thread_num();
-      //std::cout << "Thread number " << ith << "  " << i << std::endl;
-#endif
+void Numerical2PGradientCalculator::Derivative(unsigned int i, MnAlgebraicVector& x, const MnParallelFcn& fcn, unsigned int ithread, double fcnmin, double dfmin, double vrysml, MnAlgebraicVector& grd, MnAlgebraicVector& g2, MnAlgebraicVector& gstep) const {
+   // compute the derivative of the parameter i, updating only the element i of
+   // grd, g2 and gstep; x is modified during the computation and then restored
 
-#ifdef _OPENMP
-       // create in loop since each thread will use its own copy
-      MnAlgebraicVector x = par.Vec();
-#endif
-
-      double xtf = x(i);
-      double epspri = eps2 + fabs(grd(i)*eps2);
-      double stepb4 = 0.;
-      for(unsigned int j = 0; j < ncycle; j++)  {
-         double optstp = sqrt(dfmin/(fabs(g2(i))+epspri));
-         double step = std::max(optstp, fabs(0.1*gstep(i)));
-         //       std::cout<<"step: "<<step;
-         if(Trafo().Parameter(Trafo().ExtOfInt(i)).HasLimits()) {
-            if(step > 0.5) step = 0.5;
-         }
-         double stpmax = 10.*fabs(gstep(i));
-         if(step > stpmax) step = stpmax;
-         //       std::cout<<" "<<step;
-         double stpmin = std::max(vrysml, 8.*fabs(eps2*x(i)));
-         if(step < stpmin) step = stpmin;
-         //       std::cout<<" "<<step<<std::endl;
-         //       std::cout<<"step: "<<step<<std::endl;
-         if(fabs((step-stepb4)/step) < StepTolerance()) {
-            //  	std::cout<<"(step-stepb4)/step"<<std::endl;
-            //  	std::cout<<"j= "<<j<<std::endl;
-            //  	std::cout<<"step= "<<step<<std::endl;
-            break;
-         }
-         gstep(i) = step;
-         stepb4 = step;
-         //       MnAlgebraicVector pstep(n);
-         //       pstep(i) = step;
-         //       double fs1 = Fcn()(pstate + pstep);
-         //       double fs2 = Fcn()(pstate - pstep);
-         
-         x(i) = xtf + step;
-         double fs1 = Fcn()(x);
-         x(i) = xtf - step;
-         double fs2 = Fcn()(x);
-         x(i) = xtf;
-         
-         double grdb4 = grd(i);
-         grd(i) = 0.5*(fs1 - fs2)/step;
-         g2(i) = (fs1 + fs2 - 2.*fcnmin)/step/step;
+   double eps2 = Precision().Eps2(); 
+   unsigned int ncycle = Ncycle();
 
-#ifdef DEBUG
-         pr = std::cout.precision(13);
-         std::cout << "cycle " << j << " x " << x(i) << " step " << step << " f1 " << fs1 << " f2 " << fs2 
-                   << " grd " << grd(i) << " g2 " << g2(i) << std::endl; 
-         std::cout.precision(pr);
-#endif
-         
-         if(fabs(grdb4-grd(i))/(fabs(grd(i))+dfmin/step) < GradTolerance())  {
-            //  	std::cout<<"j= "<<j<<std::endl;
-            //  	std::cout<<"step= "<<step<<std::endl;
-            //  	std::cout<<"fs1, fs2: "<<fs1<<" "<<fs2<<std::endl;
-            //  	std::cout<<"fs1-fs2: "<<fs1-fs2<<std::endl;
-            break;
-         }
+   double xtf = x(i);
+   double epspri = eps2 + fabs(grd(i)*eps2);
+   double stepb4 = 0.;
+   for(unsigned int j = 0; j < ncycle; j++)  {
+      double optstp = sqrt(dfmin/(fabs(g2(i))+epspri));
+      double step = std::max(optstp, fabs(0.1*gstep(i)));
+      //       std::cout<<"step: "<<step;
+      if(Trafo().Parameter(Trafo().ExtOfInt(i)).HasLimits()) {
+         if(step > 0.5) step = 0.5;
       }
-      
-
-#ifdef DEBUG_MP
-#pragma omp critical
-      {
-         std::cout << "Gradient for thread " << ith << "  " << i << "  " << std::setprecision(15)  << grd(i) << "  " << g2(i) << std::endl;
+      double stpmax = 10.*fabs(gstep(i));
+      if(step > stpmax) step = stpmax;
+      //       std::cout<<" "<<step;
+      double stpmin = std::max(vrysml, 8.*fabs(eps2*x(i)));
+      if(step < stpmin) step = stpmin;
+      //       std::cout<<" "<<step<<std::endl;
+      //       std::cout<<"step: "<<step<<std::endl;
+      if(fabs((step-stepb4)/step) < StepTolerance()) {
+         //  	std::cout<<"(step-stepb4)/step"<<std::endl;
+         //  	std::cout<<"j= "<<j<<std::endl;
+         //  	std::cout<<"step= "<<step<<std::endl;
+         break;
       }
-#endif
-
-      //     vgrd(i) = grd;
-      //     vgrd2(i) = g2;
-      //     vgstp(i) = gstep;
-
+      gstep(i) = step;
+      stepb4 = step;
+      //       MnAlgebraicVector pstep(n);
+      //       pstep(i) = step;
+      //       double fs1 = Fcn()(pstate + pstep);
+      //       double fs2 = Fcn()(pstate - pstep);
+      
+      x(i) = xtf + step;
+      double fs1 = fcn(x, ithread);
+      x(i) = xtf - step;
+      double fs2 = fcn(x, ithread);
+      x(i) = xtf;
+      
+      double grdb4 = grd(i);
+      grd(i) = 0.5*(fs1 - fs2)/step;
+      g2(i) = (fs1 + fs2 - 2.*fcnmin)/step/step;
 
 #ifdef DEBUG
-      pr = std::cout.precision(13);
-      int iext = Trafo().ExtOfInt(i);
-      std::cout << "Parameter " << Trafo().Name(iext) << " Gradient =   " << grd(i) << " g2 = " << g2(i) << " step " << gstep(i) << std::endl;
+      int pr = std::cout.precision(13);
+      std::cout << "cycle " << j << " x " << x(i) << " step " << step << " f1 " << fs1 << " f2 " << fs2 
+                << " grd " << grd(i) << " g2 " << g2(i) << std::endl; 
       std::cout.precision(pr);
 #endif
+      
+      if(fabs(grdb4-grd(i))/(fabs(grd(i))+dfmin/step) < GradTolerance())  {
+         //  	std::cout<<"j= "<<j<<std::endl;
+         //  	std::cout<<"step= "<<step<<std::endl;
+         //  	std::cout<<"fs1, fs2: "<<fs1<<" "<<fs2<<std::endl;
+         //  	std::cout<<"fs1-fs2: "<<fs1-fs2<<std::endl;
+         break;
+      }
    }
 
-#ifndef _OPENMP
-   mpiproc.SyncVector(grd);
-   mpiproc.SyncVector(g2);
-   mpiproc.SyncVector(gstep);
-#endif
+   //     vgrd(i) = grd;
+   //     vgrd2(i) = g2;
+   //     vgstp(i) = gstep;
 
-   return FunctionGradient(grd, g2, gstep);
+#ifdef DEBUG
+   int pr = std::cout.precision(13);
+   int iext = Trafo().ExtOfInt(i);
+   std::cout << "Parameter " << Trafo().Name(iext) << " Gradient =   " << grd(i) << " g2 = " << g2(i) << " step " << gstep(i) << std::endl;
+   std::cout.precision(pr);
+#endif
 }
 
 const MnMachinePrecision& Numerical2PGradientCalculator::Precision() const {
@@ -17,13 +17,19 @@
 #include "Minuit2/MnPlot.h"
 #include "Minuit2/MinosError.h"
 #include "Minuit2/FCNBase.h"
+#include "Minuit2/MnStrategy.h"
 #include <cmath>
 #include <iostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // example of a multi dimensional fit where parallelization can be used
 // to speed up the result
 // define the environment variable OMP_NUM_THREADS to the number of desired threads
 // By default it will have thenumber of core of the machine
+// The fit is done first with a single thread and then with the parallel computation
+// of the derivatives (MnStrategy::SetNumberOfThreads), and the two results are compared
 // The default number of dimension is 20 (fit in 40 parameters) on 1000 data events. 
 // One can change the dimension and the number of events by doing: 
 // ./test_Minuit2_Parallel    ndim  nevents   
@@ -67,9 +73,19 @@ struct LogLikeFCN  : public FCNBase {
       return logl; 
    }
    double Up() const { return 0.5; }
+   // the function only reads the data: it can be evaluated by several threads at once
+   bool IsThreadSafe() const { return true; }
    const Data & fData; 
 };
 
+double WallTime() { 
+#ifdef _OPENMP
+   return omp_get_wtime();
+#else
+   return 0;
+#endif
+}
+
 int doFit(int ndim, int ndata) {
 
   // generate the data (1000 data points) in 100 dimension
@@ -107,15 +123,36 @@ int doFit(int ndim, int ndata) {
   for (int k = 0; k < 2*ndim; ++k) {
      init_err[k] = 0.1; 
   }    
-  // create minimizer (default constructor)
-  VariableMetricMinimizer fMinimizer;
-  
-  // Minimize
-  FunctionMinimum min = fMinimizer.Minimize(fcn, init_par, init_err);
+  // Minimize with a single thread and with the default number of threads
+  MnStrategy serial(1);
+  serial.SetNumberOfThreads(1);
+  MnStrategy parallel(1);
+
+  double t0 = WallTime();
+  MnMigrad migrad1(fcn, MnUserParameterState(init_par, init_err), serial);
+  FunctionMinimum min1 = migrad1();
+  double t1 = WallTime();
+  MnMigrad migrad2(fcn, MnUserParameterState(init_par, init_err), parallel);
+  FunctionMinimum min = migrad2();
+  double t2 = WallTime();
 
   // output
   std::cout<<"minimum: "<<min<<std::endl;
 
+  // the parallel computation must give the serial result
+  int ndiff = 0; 
+  if (std::fabs(min.Fval() - min1.Fval()) > 1.E-10*std::fabs(min1.Fval())) ndiff++;
+  for (unsigned int k = 0; k < init_par.size(); ++k) { 
+     double v1 = min1.UserState().Value(k); 
+     double e1 = min1.UserState().Error(k); 
+     if (std::fabs(min.UserState().Value(k) - v1) > 1.E-6*e1) ndiff++;
+     if (std::fabs(min.UserState().Error(k) - e1) > 1.E-6*e1) ndiff++;
+  }
+  std::cout << "serial fit: " << t1-t0 << " s  " << min1.NFcn() << " calls" << std::endl;
+  std::cout << "parallel fit: " << t2-t1 << " s  " << min.NFcn() << " calls" << std::endl;
+  std::cout << ndiff << " differences between the serial and the parallel fit" << std::endl;
+  if (ndiff) return 1;
+
 
 //     // create MINOS Error factory
 //     MnMinos Minos(fFCN, min);
@@ -154,5 +191,5 @@ int main(int argc, char **argv) {
       ndata = atoi(argv[2] ); 
    }
    std::cout << "do fit of " << ndim << " dimensional data on " << ndata << " events " << std::endl;
-   doFit(ndim,ndata);
+   return doFit(ndim,ndata);
 }
@@ -38,6 +38,9 @@ public:
 
   Double_t getLogVal(const RooArgSet* set) const ;
 
+  virtual void evaluateBatch(Double_t* output, BatchData& batch) const ;
+  virtual Bool_t canEvaluateBatch(const RooArgSet& columns) const ;
+
 protected:
 
   RooRealProxy x ;
@@ -38,6 +38,9 @@ public:
   Int_t getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* rangeName=0) const ;
   Double_t analyticalIntegral(Int_t code, const char* rangeName=0) const ;
 
+  virtual void evaluateBatch(Double_t* output, BatchData& batch) const ;
+  virtual Bool_t canEvaluateBatch(const RooArgSet& columns) const ;
+
 protected:
 
   RooRealProxy _x;
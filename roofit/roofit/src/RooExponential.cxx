@@ -59,6 +59,32 @@ Double_t RooExponential::evaluate() const{
 }
 
 
+//_____________________________________________________________________________
+void RooExponential::evaluateBatch(Double_t* output, BatchData& batch) const
+{
+  // Calculate the values for the events of the given batch, as in evaluate()
+
+  const Double_t* xv = x.arg().getValBatch(batch,x.nset()) ;
+  const Double_t* cv = c.arg().getValBatch(batch,c.nset()) ;
+  Int_t n = batch.size() ;
+  for (Int_t i=0 ; i<n ; i++) {
+    output[i] = exp(cv[i]*xv[i]) ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooExponential::canEvaluateBatch(const RooArgSet& columns) const
+{
+  // Batch evaluation is possible if it is for x and c
+
+  return RooAbsPdf::canEvaluateBatch(columns) || 
+    (x.arg().canEvaluateBatch(columns) && c.arg().canEvaluateBatch(columns)) ;
+}
+
+
+
 //_____________________________________________________________________________
 Int_t RooExponential::getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* /*rangeName*/) const 
 {
@@ -74,6 +74,35 @@ Double_t RooGaussian::evaluate() const
 
 
 
+//_____________________________________________________________________________
+void RooGaussian::evaluateBatch(Double_t* output, BatchData& batch) const
+{
+  // Calculate the values for the events of the given batch, as in evaluate()
+
+  const Double_t* xv = x.arg().getValBatch(batch,x.nset()) ;
+  const Double_t* mv = mean.arg().getValBatch(batch,mean.nset()) ;
+  const Double_t* sv = sigma.arg().getValBatch(batch,sigma.nset()) ;
+  Int_t n = batch.size() ;
+  for (Int_t i=0 ; i<n ; i++) {
+    Double_t arg = xv[i] - mv[i] ;
+    Double_t sig = sv[i] ;
+    output[i] = exp(-0.5*arg*arg/(sig*sig)) ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooGaussian::canEvaluateBatch(const RooArgSet& columns) const
+{
+  // Batch evaluation is possible if it is for x, mean and sigma
+
+  return RooAbsPdf::canEvaluateBatch(columns) || 
+    (x.arg().canEvaluateBatch(columns) && mean.arg().canEvaluateBatch(columns) && sigma.arg().canEvaluateBatch(columns)) ;
+}
+
+
+
 //_____________________________________________________________________________
 Double_t RooGaussian::getLogVal(const RooArgSet* set) const 
 {
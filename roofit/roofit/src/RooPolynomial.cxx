@@ -144,6 +144,49 @@ Double_t RooPolynomial::evaluate() const
 
 
 
+//_____________________________________________________________________________
+void RooPolynomial::evaluateBatch(Double_t* output, BatchData& batch) const 
+{
+  // Calculate the values for the events of the given batch, as in evaluate()
+
+  Int_t order(_lowestOrder) ;
+  Int_t n = batch.size() ;
+  for (Int_t i=0 ; i<n ; i++) {
+    output[i] = (order<1 ? 0 : 1) ;
+  }
+
+  const Double_t* xv = _x.arg().getValBatch(batch,_x.nset()) ;
+  const RooArgSet* nset = _coefList.nset() ;
+  RooFIter it = _coefList.fwdIterator() ;
+  RooAbsReal* coef ;
+  while((coef=(RooAbsReal*)it.next())) {
+    const Double_t* cv = coef->getValBatch(batch,nset) ;
+    for (Int_t i=0 ; i<n ; i++) {
+      output[i] += cv[i]*TMath::Power(xv[i],order) ;
+    }
+    order++ ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooPolynomial::canEvaluateBatch(const RooArgSet& columns) const 
+{
+  // Batch evaluation is possible if it is for x and all coefficients
+
+  if (RooAbsPdf::canEvaluateBatch(columns)) return kTRUE ;
+  if (!_x.arg().canEvaluateBatch(columns)) return kFALSE ;
+  RooFIter it = _coefList.fwdIterator() ;
+  RooAbsReal* coef ;
+  while((coef=(RooAbsReal*)it.next())) {
+    if (!coef->canEvaluateBatch(columns)) return kFALSE ;
+  }
+  return kTRUE ;
+}
+
+
+
 //_____________________________________________________________________________
 Int_t RooPolynomial::getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* /*rangeName*/) const 
 {
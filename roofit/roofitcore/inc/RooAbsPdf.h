@@ -185,6 +185,7 @@ public:
   // Function evaluation support
   virtual Bool_t traceEvalHook(Double_t value) const ;  
   virtual Double_t getValV(const RooArgSet* set=0) const ;
+  virtual const Double_t* getValBatch(BatchData& batch, const RooArgSet* set=0) const ;
   virtual Double_t getLogVal(const RooArgSet* set=0) const ;
 
   Double_t getNorm(const RooArgSet& nset) const { 
@@ -48,6 +48,7 @@ class TH3F;
 
 #include <list>
 #include <string>
+#include <vector>
 #include <iostream>
 
 class RooAbsReal : public RooAbsArg {
@@ -73,6 +74,37 @@ public:
 
   virtual Double_t getValV(const RooArgSet* set=0) const ;
 
+  // Batch evaluation over the stored values of the observables of a set of events
+  class BatchData {
+  public:
+    BatchData() : _size(0), _events(0), _contiguous(kFALSE), _nUsed(0), _failed(kFALSE) { }
+    ~BatchData() ;
+    void addColumn(const RooAbsArg& arg, const Double_t* values) ;
+    void setEvents(const Int_t* events, Int_t n) ;
+    Int_t size() const { return _size ; }
+    const RooArgSet& columns() const { return _columnArgs ; }
+    const Double_t* column(const RooAbsArg& arg) ;
+    Double_t* buffer() ;
+    void setFailed() { _failed = kTRUE ; }
+    Bool_t failed() const { return _failed ; }
+  private:
+    BatchData(const BatchData&) ; // not implemented
+    BatchData& operator=(const BatchData&) ; // not implemented
+    Int_t _size ;                                 // Number of events in the current batch
+    const Int_t* _events ;                        // Indices of the events of the current batch
+    Bool_t _contiguous ;                          // True if the indices of the batch are consecutive
+    RooArgSet _columnArgs ;                       // Args (observables, cached nodes) with stored values
+    std::vector<const RooAbsArg*> _columnPtrs ;   // Same args, for lookup by instance
+    std::vector<const Double_t*> _columnValues ;  // Stored values of each arg for all events
+    std::vector<const Double_t*> _batchValues ;   // Values of each arg for the current batch (0 if not gathered yet)
+    std::vector<std::vector<Double_t>*> _buffers ; // Result buffers
+    Int_t _nUsed ;                                // Number of buffers used by the current batch
+    Bool_t _failed ;                              // An evaluation of the current batch needs the per-event path
+  } ;
+
+  virtual const Double_t* getValBatch(BatchData& batch, const RooArgSet* set=0) const ;
+  virtual Bool_t canEvaluateBatch(const RooArgSet& columns) const ;
+
   Double_t getPropagatedError(const RooFitResult& fr) ;
 
   Bool_t operator==(Double_t value) const ;
@@ -370,6 +402,8 @@ protected:
     return kFALSE ;
   }
   virtual Double_t evaluate() const = 0 ;
+  virtual void evaluateBatch(Double_t* output, BatchData& batch) const ;
+  Bool_t isBatchConstant(const BatchData& batch) const ;
 
   // Hooks for RooDataSet interface
   friend class RooRealIntegral ;
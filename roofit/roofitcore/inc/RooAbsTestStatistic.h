@@ -64,6 +64,12 @@ public:
   virtual Double_t offset() const { return _offset ; }
   virtual Double_t offsetCarry() const { return _offsetCarry; }
 
+  void setThreadedMP(Bool_t flag=kTRUE) ;
+  Bool_t isThreadedMP() const { 
+    // Return true if the parallel calculation uses threads instead of processes
+    return _threadedMP ; 
+  }
+
 protected:
 
   virtual void printCompactTreeHook(std::ostream& os, const char* indent="") ;
@@ -139,6 +145,8 @@ protected:
   // Parallel mode data
   Int_t          _nCPU ;      //  Number of processors to use in parallel calculation mode
   pRooRealMPFE*  _mpfeArray ; //! Array of parallel execution frond ends
+  Bool_t         _threadedMP ; // Calculate in threads of the current process rather than in forked processes
+  RooAbsData*    _mpData ;    //! Copy of the data whose values are shared by the calculation threads
 
   RooFit::MPSplit        _mpinterl ; // Use interleaving strategy rather than N-wise split for partioning of dataset for multiprocessor-split
   Bool_t         _doOffset ; // Apply interval value offset to control numeric precision?
@@ -146,7 +154,7 @@ protected:
   mutable Double_t _offsetCarry; //! avoids loss of precision
   mutable Double_t _evalCarry; //! carry of Kahan sum in evaluatePartition
 
-  ClassDef(RooAbsTestStatistic,2) // Abstract base class for real-valued test statistics
+  ClassDef(RooAbsTestStatistic,3) // Abstract base class for real-valued test statistics
 
 };
 
@@ -41,6 +41,8 @@ public:
   virtual ~RooAddPdf() ;
 
   Double_t evaluate() const ;
+  virtual void evaluateBatch(Double_t* output, BatchData& batch) const ;
+  virtual Bool_t canEvaluateBatch(const RooArgSet& columns) const ;
   virtual Bool_t checkObservables(const RooArgSet* nset) const ;	
 
   virtual Bool_t forceAnalyticalInt(const RooAbsArg& /*dep*/) const { 
@@ -66,6 +66,8 @@ protected:
 
   Bool_t _extended ;
   virtual Double_t evaluatePartition(Int_t firstEvent, Int_t lastEvent, Int_t stepSize) const ;
+  Bool_t evaluateBatchPartition(Int_t firstEvent, Int_t lastEvent, Int_t stepSize, Double_t& result, Double_t& carry,
+				Double_t& sumWeight, Double_t& sumWeightCarry) const ;
   Bool_t _weightSq ; // Apply weights squared?
   mutable Bool_t _first ; //!
   Double_t _offsetSaveW2; //!
@@ -55,7 +55,10 @@ public:
   virtual ~RooProdPdf() ;
 
   virtual Double_t getValV(const RooArgSet* set=0) const ;
+  virtual const Double_t* getValBatch(BatchData& batch, const RooArgSet* set=0) const ;
   Double_t evaluate() const ;
+  virtual void evaluateBatch(Double_t* output, BatchData& batch) const ;
+  virtual Bool_t canEvaluateBatch(const RooArgSet& columns) const ;
   virtual Bool_t checkObservables(const RooArgSet* nset) const ;	
 
   virtual Bool_t forceAnalyticalInt(const RooAbsArg& dep) const ; 
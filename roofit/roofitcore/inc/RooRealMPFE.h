@@ -25,12 +25,12 @@
 #include <vector> 
 
 class RooArgSet ;
-namespace RooFit { class BidirMMapPipe; }
+namespace RooFit { class BidirMMapPipe; class MPFEThread; }
 
 class RooRealMPFE : public RooAbsReal {
 public:
   // Constructors, assignment etc
-  RooRealMPFE(const char *name, const char *title, RooAbsReal& arg, Bool_t calcInline=kFALSE) ;
+  RooRealMPFE(const char *name, const char *title, RooAbsReal& arg, Bool_t calcInline=kFALSE, Bool_t useThread=kFALSE) ;
   RooRealMPFE(const RooRealMPFE& other, const char* name=0);
   virtual TObject* clone(const char* newname) const { return new RooRealMPFE(*this,newname); }
   virtual ~RooRealMPFE();
@@ -52,10 +52,11 @@ public:
   // Function evaluation
   virtual Double_t evaluate() const ;
   friend class RooAbsTestStatistic ;
+  friend class RooFit::MPFEThread ;
   virtual void constOptimizeTestStatistic(ConstOpCode opcode, Bool_t doAlsoTracking=kTRUE) ;
   virtual Double_t getCarry() const;
 
-  enum State { Initialize,Client,Server,Inline } ;
+  enum State { Initialize,Client,Server,Inline,Thread } ;
   State _state ;
 
   enum Message { SendReal=0, SendCat, Calculate, Retrieve, ReturnValue, Terminate, 
@@ -66,6 +67,8 @@ public:
   void serverLoop() ;
 
   void doApplyNLLW2(Bool_t flag) ;
+  Double_t calculateInThread() const ;
+  void waitForThread() const ;
 
   RooRealProxy _arg ; // Function to calculate in parallel process
   RooListProxy _vars ;   // Variables
@@ -74,10 +77,13 @@ public:
   Bool_t _verboseClient ;
   Bool_t _verboseServer ;
   Bool_t _inlineMode ;
+  Bool_t _threadMode ;   // Calculate in a thread of the current process rather than in a forked process
   mutable Bool_t _forceCalc ;
   mutable RooAbsReal::ErrorLoggingMode _remoteEvalErrorLoggingState ;
 
   RooFit::BidirMMapPipe *_pipe; //! connection to child
+  RooFit::MPFEThread *_thread; //! calculation thread in thread mode
+  mutable Bool_t _threadWarm ; //! Calculation in thread allowed (first calculation after an optimization is done inline)
 
   mutable std::vector<Bool_t> _valueChanged ; //! Flags if variable needs update on server-side
   mutable std::vector<Bool_t> _constChanged ; //! Flags if variable needs update on server-side
@@ -87,7 +93,7 @@ public:
 
   static RooMPSentinel _sentinel ;
 
-  ClassDef(RooRealMPFE,2) // Multi-process front-end for parallel calculation of a real valued function 
+  ClassDef(RooRealMPFE,3) // Multi-process front-end for parallel calculation of a real valued function 
 };
 
 #endif
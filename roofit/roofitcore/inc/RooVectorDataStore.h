@@ -107,6 +107,18 @@ public:
 
   const RooVectorDataStore* cache() const { return _cache ; }
 
+  void setShareOnCopy(Bool_t flag=kTRUE) { 
+    // Let copies of this store refer to its stored values instead of copying them. A copy
+    // copies the values only when they are modified. This store must not be modified or
+    // deleted before its copies
+    _shareOnCopy = flag ; 
+  }
+
+  // Access to the stored values for batch evaluation
+  void addBatchColumns(RooAbsReal::BatchData& batch) const ;
+  const Double_t* weightArray() const ;
+  Bool_t hasCategories() const ;
+
   void loadValues(const RooAbsDataStore *tds, const RooFormulaVar* select=0, const char* rangeName=0, Int_t nStart=0, Int_t nStop=2000000000) ;
   
   void dump() ;
@@ -132,12 +144,12 @@ public:
   class RealVector {
   public:
     RealVector(UInt_t initialCapacity=(4096 / sizeof(Double_t))) : 
-      _nativeReal(0), _real(0), _buf(0), _nativeBuf(0), _vec0(0), _tracker(0), _nset(0) { 
+      _nativeReal(0), _real(0), _buf(0), _nativeBuf(0), _vec0(0), _tracker(0), _nset(0), _nShared(0) { 
       _vec.reserve(initialCapacity);
     }
 
     RealVector(RooAbsReal* arg, UInt_t initialCapacity=(4096 / sizeof(Double_t))) : 
-      _nativeReal(arg), _real(0), _buf(0), _nativeBuf(0), _vec0(0), _tracker(0), _nset(0) { 
+      _nativeReal(arg), _real(0), _buf(0), _nativeBuf(0), _vec0(0), _tracker(0), _nset(0), _nShared(0) { 
       _vec.reserve(initialCapacity);
     }
 
@@ -146,9 +158,16 @@ public:
       if (_nset) delete _nset ;
     }
 
-    RealVector(const RealVector& other, RooAbsReal* real=0) : 
-      _vec(other._vec), _nativeReal(real?real:other._nativeReal), _real(real?real:other._real), _buf(other._buf), _nativeBuf(other._nativeBuf), _nset(0)   {
-      _vec0 = _vec.size()>0 ? &_vec.front() : 0 ;
+    RealVector(const RealVector& other, RooAbsReal* real=0, Bool_t share=kFALSE) : 
+      _nativeReal(real?real:other._nativeReal), _real(real?real:other._real), _buf(other._buf), _nativeBuf(other._nativeBuf), _nset(0), _nShared(0)   {
+      if ((share || other._nShared>0) && other.size()>0) {
+	// Refer to the values of the other vector instead of copying them
+	_vec0 = other._vec0 ;
+	_nShared = other.size() ;
+      } else {
+	_vec = other._vec ;
+	_vec0 = _vec.size()>0 ? &_vec.front() : 0 ;
+      }
       if (other._tracker) {
 	_tracker = new RooChangeTracker(Form("track_%s",_nativeReal->GetName()),"tracker",other._tracker->parameters()) ;
       } else {
@@ -165,7 +184,10 @@ public:
       _real = other._real;
       _buf = other._buf;
       _nativeBuf = other._nativeBuf;
-      if (other._vec.size() <= _vec.capacity() / 2 && _vec.capacity() > (4096 / sizeof(Double_t))) {
+      _nShared = 0;
+      if (other._nShared > 0) {
+	_vec.assign(other._vec0, other._vec0 + other._nShared);
+      } else if (other._vec.size() <= _vec.capacity() / 2 && _vec.capacity() > (4096 / sizeof(Double_t))) {
 	std::vector<Double_t> tmp;
 	tmp.reserve(std::max(other._vec.size(), 4096 / sizeof(Double_t)));
 	tmp.assign(other._vec.begin(), other._vec.end());
@@ -209,11 +231,13 @@ public:
     }
 
     void fill() { 
+      if (_nShared>0) unshare() ;
       _vec.push_back(*_buf) ; 
       _vec0 = &_vec.front() ;
     } ;
 
     void write(Int_t i) {
+      if (_nShared>0) unshare() ;
 /*         std::cout << "write(" << this << ") [" << i << "] nativeReal = " << _nativeReal << " = " << _nativeReal->GetName() << " real = " << _real << " buf = " << _buf << " value = " << *_buf << " native getVal() = " << _nativeReal->getVal() << " getVal() = " << _real->getVal() << std::endl ;  */
       _vec[i] = *_buf ;
     }
@@ -223,6 +247,15 @@ public:
       std::vector<Double_t> tmp;
       _vec.swap(tmp);
       _vec0 = 0;
+      _nShared = 0;
+    }
+
+    void unshare() {
+      // Copy the values referred to in another vector, so that they can be modified
+      if (_nShared==0) return ;
+      _vec.assign(_vec0,_vec0+_nShared) ;
+      _vec0 = &_vec.front() ;
+      _nShared = 0 ;
     }
 
     inline void get(Int_t idx) const { 
@@ -233,9 +266,10 @@ public:
       *_nativeBuf = *(_vec0+idx) ; 
     }
 
-    Int_t size() const { return _vec.size() ; }
+    Int_t size() const { return _nShared>0 ? _nShared : _vec.size() ; }
 
     void resize(Int_t siz) {
+      if (_nShared>0) unshare() ;
       if (siz < Int_t(_vec.capacity()) / 2 && _vec.capacity() > (4096 / sizeof(Double_t))) {
 	// do an expensive copy, if we save at least a factor 2 in size
 	std::vector<Double_t> tmp;
@@ -252,6 +286,7 @@ public:
     }
 
     void reserve(Int_t siz) {
+      if (_nShared>0) unshare() ;
       _vec.reserve(siz);
       _vec0 = &_vec.front();
     }
@@ -268,6 +303,7 @@ public:
     Double_t* _vec0 ; //!
     RooChangeTracker* _tracker ; //
     RooArgSet* _nset ; //! 
+    Int_t _nShared ; //! Number of values referred to in another vector, if not copied
     ClassDef(RealVector,1) // STL-vector-based Data Storage class
   } ;
   
@@ -293,7 +329,7 @@ public:
       if (_vecEH) delete _vecEH ;
     }
     
-    RealFullVector(const RealFullVector& other, RooAbsReal* real=0) : RealVector(other,real),
+    RealFullVector(const RealFullVector& other, RooAbsReal* real=0, Bool_t share=kFALSE) : RealVector(other,real,share),
       _bufE(other._bufE), _bufEL(other._bufEL), _bufEH(other._bufEH),
       _nativeBufE(other._nativeBufE), _nativeBufEL(other._nativeBufEL), _nativeBufEH(other._nativeBufEH) {
       _vecE = (other._vecE) ? new std::vector<Double_t>(*other._vecE) : 0 ;
@@ -458,13 +494,13 @@ public:
   class CatVector {
   public:
     CatVector(UInt_t initialCapacity=(4096 / sizeof(RooCatType))) : 
-      _cat(0), _buf(0), _nativeBuf(0), _vec0(0)
+      _cat(0), _buf(0), _nativeBuf(0), _vec0(0), _nShared(0)
     {
       _vec.reserve(initialCapacity);
     }
 
     CatVector(RooAbsCategory* cat, UInt_t initialCapacity=(4096 / sizeof(RooCatType))) : 
-      _cat(cat), _buf(0), _nativeBuf(0), _vec0(0)
+      _cat(cat), _buf(0), _nativeBuf(0), _vec0(0), _nShared(0)
     {
       _vec.reserve(initialCapacity);
     }
@@ -472,10 +508,17 @@ public:
     virtual ~CatVector() {
     }
 
-    CatVector(const CatVector& other, RooAbsCategory* cat=0) : 
-      _cat(cat?cat:other._cat), _buf(other._buf), _nativeBuf(other._nativeBuf), _vec(other._vec) 
+    CatVector(const CatVector& other, RooAbsCategory* cat=0, Bool_t share=kFALSE) : 
+      _cat(cat?cat:other._cat), _buf(other._buf), _nativeBuf(other._nativeBuf), _nShared(0) 
       {
-	_vec0 = _vec.size()>0 ? &_vec.front() : 0 ;
+	if ((share || other._nShared>0) && other.size()>0) {
+	  // Refer to the values of the other vector instead of copying them
+	  _vec0 = other._vec0 ;
+	  _nShared = other.size() ;
+	} else {
+	  _vec = other._vec ;
+	  _vec0 = _vec.size()>0 ? &_vec.front() : 0 ;
+	}
       }
 
     CatVector& operator=(const CatVector& other) {
@@ -483,7 +526,10 @@ public:
       _cat = other._cat;
       _buf = other._buf;
       _nativeBuf = other._nativeBuf;
-      if (other._vec.size() <= _vec.capacity() / 2 && _vec.capacity() > (4096 / sizeof(RooCatType))) {
+      _nShared = 0;
+      if (other._nShared > 0) {
+	_vec.assign(other._vec0, other._vec0 + other._nShared);
+      } else if (other._vec.size() <= _vec.capacity() / 2 && _vec.capacity() > (4096 / sizeof(RooCatType))) {
 	std::vector<RooCatType> tmp;
 	tmp.reserve(std::max(other._vec.size(), 4096 / sizeof(RooCatType)));
 	tmp.assign(other._vec.begin(), other._vec.end());
@@ -505,10 +551,12 @@ public:
     }
     
     void fill() { 
+      if (_nShared>0) unshare() ;
       _vec.push_back(*_buf) ; 
       _vec0 = &_vec.front() ;
     } ;
     void write(Int_t i) { 
+      if (_nShared>0) unshare() ;
       _vec[i]=*_buf ; 
     } ;
     void reset() { 
@@ -516,6 +564,14 @@ public:
       std::vector<RooCatType> tmp;
       _vec.swap(tmp);
       _vec0 = 0;
+      _nShared = 0;
+    }
+    void unshare() {
+      // Copy the values referred to in another vector, so that they can be modified
+      if (_nShared==0) return ;
+      _vec.assign(_vec0,_vec0+_nShared) ;
+      _vec0 = &_vec.front() ;
+      _nShared = 0 ;
     }
     inline void get(Int_t idx) const { 
       _buf->assignFast(*(_vec0+idx)) ;
@@ -523,9 +579,10 @@ public:
     inline void getNative(Int_t idx) const { 
       _nativeBuf->assignFast(*(_vec0+idx)) ;
     }
-    Int_t size() const { return _vec.size() ; }
+    Int_t size() const { return _nShared>0 ? _nShared : _vec.size() ; }
 
     void resize(Int_t siz) {
+      if (_nShared>0) unshare() ;
       if (siz < Int_t(_vec.capacity()) / 2 && _vec.capacity() > (4096 / sizeof(RooCatType))) {
 	// do an expensive copy, if we save at least a factor 2 in size
 	std::vector<RooCatType> tmp;
@@ -542,6 +599,7 @@ public:
     }
 
     void reserve(Int_t siz) {
+      if (_nShared>0) unshare() ;
       _vec.reserve(siz);
       _vec0 = &_vec.front();
     }
@@ -556,6 +614,7 @@ public:
     RooCatType* _nativeBuf ;  //!
     std::vector<RooCatType> _vec ;
     RooCatType* _vec0 ; //!
+    Int_t _nShared ; //! Number of values referred to in another vector, if not copied
     ClassDef(CatVector,1) // STL-vector-based Data Storage class
   } ;
   
@@ -745,6 +804,8 @@ public:
   RooVectorDataStore* _cache ; //! Optimization cache
   RooAbsArg* _cacheOwner ; //! Cache owner
 
+  Bool_t _shareOnCopy ; //! Copies refer to the values of this store instead of copying them
+
   ClassDef(RooVectorDataStore,2) // STL-vector-based Data Storage class
 };
 
@@ -155,6 +155,10 @@
 #include "Math/CholeskyDecomp.h"
 #include <string>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 using namespace std;
 
 ClassImp(RooAbsPdf) 
@@ -166,6 +170,20 @@ Int_t RooAbsPdf::_verboseEval = 0;
 Bool_t RooAbsPdf::_evalError = kFALSE ;
 TString RooAbsPdf::_normRangeOverride ;
 
+#ifndef _WIN32
+namespace {
+  // The evaluation error flag can be raised by the calculation threads of
+  // RooRealMPFE in thread mode while the main thread reads or clears it
+  pthread_mutex_t gEvalErrorFlagMutex = PTHREAD_MUTEX_INITIALIZER ;
+
+  class EvalErrorFlagLock {
+  public:
+    EvalErrorFlagLock() { pthread_mutex_lock(&gEvalErrorFlagMutex) ; }
+    ~EvalErrorFlagLock() { pthread_mutex_unlock(&gEvalErrorFlagMutex) ; }
+  } ;
+}
+#endif
+
 //_____________________________________________________________________________
 RooAbsPdf::RooAbsPdf() : _norm(0), _normSet(0), _specGeneratorConfig(0)
 {
@@ -303,6 +321,69 @@ Double_t RooAbsPdf::getValV(const RooArgSet* nset) const
 
 
 
+//_____________________________________________________________________________
+const Double_t* RooAbsPdf::getValBatch(BatchData& batch, const RooArgSet* nset) const
+{
+  // Return the values normalized over the observables in 'nset' for the
+  // events of the given batch, see RooAbsReal::getValBatch(). The
+  // unnormalized values are calculated with evaluateBatch() and divided by
+  // the normalization integral, as in getValV(). A negative or NaN value,
+  // a normalization integral that is not positive or an observable of the
+  // batch that is not in 'nset' (conditional observable, for which the
+  // normalization differs between events) marks the batch as failed.
+
+  const Double_t* values = batch.column(*this) ;
+  if (values || isBatchConstant(batch)) {
+    return RooAbsReal::getValBatch(batch,nset) ;
+  }
+
+  Double_t* output = batch.buffer() ;
+  Int_t n = batch.size() ;
+
+  Double_t normVal(1) ;
+  if (!nset) {
+    RooArgSet* tmp = _normSet ;
+    _normSet = 0 ;
+    evaluateBatch(output,batch) ;
+    _normSet = tmp ;
+  } else {
+    if (nset!=_normSet || _norm==0) {
+      syncNormalization(nset) ;
+    }
+    // The normalization is the same for all events unless there are conditional observables
+    RooFIter iter = batch.columns().fwdIterator() ;
+    RooAbsArg* obs ;
+    while((obs=iter.next())) {
+      if (obs->isLValue() && !nset->find(*obs) && dependsOnValue(*obs)) {
+	batch.setFailed() ;
+	return output ;
+      }
+    }
+    evaluateBatch(output,batch) ;
+    normVal = _norm->getVal() ;
+  }
+
+  // Same checks as in traceEvalPdf() and getValV()
+  Bool_t error(!(normVal>0.)) ;
+  for (Int_t i=0 ; i<n ; i++) {
+    error |= (TMath::IsNaN(output[i]) || output[i]<0) ;
+  }
+  if (error) {
+    batch.setFailed() ;
+    return output ;
+  }
+
+  if (nset) {
+    for (Int_t i=0 ; i<n ; i++) {
+      output[i] = output[i] / normVal ;
+    }
+  }
+
+  return output ;
+}
+
+
+
 //_____________________________________________________________________________
 Double_t RooAbsPdf::analyticalIntegralWN(Int_t code, const RooArgSet* normSet, const char* rangeName) const
 {
@@ -715,6 +796,8 @@ RooAbsReal* RooAbsPdf::createNLL(RooAbsData& data, const RooCmdArg& arg1, const
   //                                    Multiple comma separated range names can be specified.
   // SumCoefRange(const char* name)  -- Set the range in which to interpret the coefficients of RooAddPdf components  
   // NumCPU(int num, int strat)      -- Parallelize NLL calculation on num CPUs
+  // NumThreads(int num, int strat)  -- Parallelize NLL calculation on num threads of the current process, with the
+  //                                    same strategies as NumCPU. The threads share the memory of the current process
   //
   //                                    Strategy 0 = RooFit::BulkPartition (Default) --> Divide events in N equal chunks 
   //                                    Strategy 1 = RooFit::Interleave --> Process event i%N in process N. Recommended for binned data with 
@@ -781,6 +864,7 @@ RooAbsReal* RooAbsPdf::createNLL(RooAbsData& data, const RooLinkedList& cmdList)
   pc.defineInt("ext","Extended",0,2) ;
   pc.defineInt("numcpu","NumCPU",0,1) ;
   pc.defineInt("interleave","NumCPU",1,0) ;
+  pc.defineString("mpMode","NumCPU",0,"") ;
   pc.defineInt("verbose","Verbose",0,0) ;
   pc.defineInt("optConst","Optimize",0,0) ;
   pc.defineInt("cloneData","CloneData",2,0) ;
@@ -807,6 +891,7 @@ RooAbsReal* RooAbsPdf::createNLL(RooAbsData& data, const RooLinkedList& cmdList)
   Int_t ext      = pc.getInt("ext") ;
   Int_t numcpu   = pc.getInt("numcpu") ;
   RooFit::MPSplit interl = (RooFit::MPSplit) pc.getInt("interleave") ;
+  Bool_t mpThreads = !strcmp(pc.getString("mpMode"),"Threads") ;
 
   Int_t splitr   = pc.getInt("splitRange") ;
   Bool_t verbose = pc.getInt("verbose") ;
@@ -891,7 +976,9 @@ RooAbsReal* RooAbsPdf::createNLL(RooAbsData& data, const RooLinkedList& cmdList)
     // Simple case: default range, or single restricted range
     //cout<<"FK: Data test 1: "<<data.sumEntries()<<endl;
 
-    nll = new RooNLLVar(baseName.c_str(),"-log(likelihood)",*this,data,projDeps,ext,rangeName,addCoefRangeName,numcpu,interl,verbose,splitr,cloneData) ;
+    RooNLLVar* nllVar = new RooNLLVar(baseName.c_str(),"-log(likelihood)",*this,data,projDeps,ext,rangeName,addCoefRangeName,numcpu,interl,verbose,splitr,cloneData) ;
+    if (mpThreads) nllVar->setThreadedMP() ;
+    nll = nllVar ;
 
   } else {
     // Composite case: multiple ranges
@@ -901,7 +988,8 @@ RooAbsReal* RooAbsPdf::createNLL(RooAbsData& data, const RooLinkedList& cmdList)
     strlcpy(buf,rangeName,bufSize) ;
     char* token = strtok(buf,",") ;
     while(token) {
-      RooAbsReal* nllComp = new RooNLLVar(Form("%s_%s",baseName.c_str(),token),"-log(likelihood)",*this,data,projDeps,ext,token,addCoefRangeName,numcpu,interl,verbose,splitr,cloneData) ;
+      RooNLLVar* nllComp = new RooNLLVar(Form("%s_%s",baseName.c_str(),token),"-log(likelihood)",*this,data,projDeps,ext,token,addCoefRangeName,numcpu,interl,verbose,splitr,cloneData) ;
+      if (mpThreads) nllComp->setThreadedMP() ;
       nllList.add(*nllComp) ;
       token = strtok(0,",") ;
     }
@@ -978,6 +1066,8 @@ RooFitResult* RooAbsPdf::fitTo(RooAbsData& data, const RooCmdArg& arg1, const Ro
   //                                    Multiple comma separated range names can be specified.
   // SumCoefRange(const char* name)  -- Set the range in which to interpret the coefficients of RooAddPdf components 
   // NumCPU(int num, int strat)      -- Parallelize NLL calculation on num CPUs
+  // NumThreads(int num, int strat)  -- Parallelize NLL calculation on num threads of the current process, with the
+  //                                    same strategies as NumCPU. The threads share the memory of the current process
   //
   //                                    Strategy 0 = RooFit::BulkPartition (Default) --> Divide events in N equal chunks 
   //                                    Strategy 1 = RooFit::Interleave --> Process event i%N in process N. Recommended for binned data with 
@@ -1475,6 +1565,7 @@ RooAbsReal* RooAbsPdf::createChi2(RooDataHist& data, const RooCmdArg& arg1,  con
   //  DataError()  -- Choose between Expected error [RooAbsData::Expected] , or Observed error (e.g. Sum-of-weights [RooAbsData:SumW2] or Poisson interval [RooAbsData::Poisson] ) 
   //                  Default is AUTO : Expected error for unweighted data, Sum-of-weights for weighted data
   //  NumCPU()     -- Activate parallel processing feature
+  //  NumThreads() -- Activate parallel processing feature with threads
   //  Range()      -- Fit only selected region
   //  SumCoefRange() -- Set the range in which to interpret the coefficients of RooAddPdf components 
   //  SplitRange() -- Fit range is split by index catory of simultaneous PDF
@@ -3206,6 +3297,9 @@ RooArgSet* RooAbsPdf::getAllConstraints(const RooArgSet& observables, RooArgSet&
 void RooAbsPdf::clearEvalError() 
 { 
   // Clear the evaluation error flag
+#ifndef _WIN32
+  EvalErrorFlagLock lock ;
+#endif
   _evalError = kFALSE ; 
 }
 
@@ -3215,6 +3309,9 @@ void RooAbsPdf::clearEvalError()
 Bool_t RooAbsPdf::evalError() 
 { 
   // Return the evaluation error flag
+#ifndef _WIN32
+  EvalErrorFlagLock lock ;
+#endif
   return _evalError ; 
 }
 
@@ -3224,6 +3321,9 @@ Bool_t RooAbsPdf::evalError()
 void RooAbsPdf::raiseEvalError() 
 { 
   // Raise the evaluation error flag
+#ifndef _WIN32
+  EvalErrorFlagLock lock ;
+#endif
   _evalError = kTRUE ; 
 }
 
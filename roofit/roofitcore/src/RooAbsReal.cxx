@@ -99,6 +99,10 @@
 
 #include <sstream>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 using namespace std ;
  
 ClassImp(RooAbsReal)
@@ -115,6 +119,33 @@ RooAbsReal::ErrorLoggingMode RooAbsReal::_evalErrorMode = RooAbsReal::PrintError
 Int_t RooAbsReal::_evalErrorCount = 0 ;
 map<const RooAbsArg*,pair<string,list<RooAbsReal::EvalError> > > RooAbsReal::_evalErrorList ;
 
+#ifndef _WIN32
+namespace {
+  // Evaluation errors can be logged by the calculation threads of RooRealMPFE
+  // in thread mode. The error log is protected by a recursive mutex, so that
+  // errors logged while logging an error are ignored as in a single thread.
+  pthread_once_t gEvalErrorMutexOnce = PTHREAD_ONCE_INIT ;
+  pthread_mutex_t gEvalErrorMutex ;
+
+  void InitEvalErrorMutex() {
+    pthread_mutexattr_t attr ;
+    pthread_mutexattr_init(&attr) ;
+    pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE) ;
+    pthread_mutex_init(&gEvalErrorMutex,&attr) ;
+    pthread_mutexattr_destroy(&attr) ;
+  }
+
+  class EvalErrorLock {
+  public:
+    EvalErrorLock() { 
+      pthread_once(&gEvalErrorMutexOnce,InitEvalErrorMutex) ;
+      pthread_mutex_lock(&gEvalErrorMutex) ;
+    }
+    ~EvalErrorLock() { pthread_mutex_unlock(&gEvalErrorMutex) ; }
+  } ;
+}
+#endif
+
 
 //_____________________________________________________________________________
 RooAbsReal::RooAbsReal() : _specIntegratorConfig(0), _treeVar(kFALSE), _selectComp(kTRUE), _lastNSet(0)
@@ -254,6 +285,180 @@ Double_t RooAbsReal::getValV(const RooArgSet* nset) const
 }
 
 
+//_____________________________________________________________________________
+const Double_t* RooAbsReal::getValBatch(BatchData& batch, const RooArgSet* nset) const
+{
+  // Return the values of this object for the events of the given batch,
+  // the batch equivalent of getVal(). Objects with stored values (observables
+  // and nodes cached by the constant term optimizer) return these, objects
+  // that do not depend on them return getVal() for every event and all others
+  // are calculated with evaluateBatch(). The returned array has batch.size()
+  // elements and is valid until the next batch is selected.
+  //
+  // The values are those getVal() would return for each event. If an
+  // evaluation error occurs for any event of the batch, batch.failed() is set
+  // and the caller should calculate the batch event by event, which logs the
+  // error as usual.
+
+  const Double_t* values = batch.column(*this) ;
+  if (values) return values ;
+
+  Double_t* output = batch.buffer() ;
+  Int_t n = batch.size() ;
+  if (isBatchConstant(batch)) {
+    Double_t value = getVal(nset) ;
+    for (Int_t i=0 ; i<n ; i++) {
+      output[i] = value ;
+    }
+    return output ;
+  }
+
+  if (nset && nset!=_lastNSet) {
+    ((RooAbsReal*) this)->setProxyNormSet(nset) ;    
+    _lastNSet = (RooArgSet*) nset ;
+  }
+
+  evaluateBatch(output,batch) ;
+
+  // Same check as in traceEval()
+  Bool_t error(kFALSE) ;
+  for (Int_t i=0 ; i<n ; i++) {
+    error |= TMath::IsNaN(output[i]) ;
+  }
+  if (error) batch.setFailed() ;
+
+  return output ;
+}
+
+
+
+//_____________________________________________________________________________
+void RooAbsReal::evaluateBatch(Double_t* /*output*/, BatchData& batch) const
+{
+  // Calculate the values of this object for the events of the given batch.
+  // Classes that can do so override this function and canEvaluateBatch().
+  // The default implementation does not calculate anything and marks the
+  // batch as failed, so that it is evaluated event by event.
+
+  batch.setFailed() ;
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooAbsReal::canEvaluateBatch(const RooArgSet& columns) const
+{
+  // Return true if getValBatch() can calculate the values of this object
+  // for events whose observables and cached nodes are the given columns.
+  // This is the case if this object is one of the columns or does not depend
+  // on them. Classes implementing evaluateBatch() override this function to
+  // check that their servers can be evaluated as well.
+
+  return columns.containsInstance(*this) || !dependsOnValue(columns) ;
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooAbsReal::isBatchConstant(const BatchData& batch) const
+{
+  // Return true if the value of this object is the same for all events
+  // of the batch, i.e. if it does not depend on any of its columns
+
+  return !dependsOnValue(batch.columns()) ;
+}
+
+
+
+//_____________________________________________________________________________
+RooAbsReal::BatchData::~BatchData() 
+{
+  // Destructor
+
+  for (UInt_t i=0 ; i<_buffers.size() ; i++) {
+    delete _buffers[i] ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+void RooAbsReal::BatchData::addColumn(const RooAbsArg& arg, const Double_t* values) 
+{
+  // Declare that the values of 'arg' for all events are stored in 'values'
+
+  _columnArgs.add(arg,kTRUE) ;
+  _columnPtrs.push_back(&arg) ;
+  _columnValues.push_back(values) ;
+  _batchValues.push_back(0) ;
+}
+
+
+
+//_____________________________________________________________________________
+void RooAbsReal::BatchData::setEvents(const Int_t* events, Int_t n) 
+{
+  // Select the events of the next batch, given by their indices in the
+  // stored columns. The array 'events' must stay valid until the next call.
+
+  _size = n ;
+  _events = events ;
+  _contiguous = (n>0 && events[n-1]-events[0]==n-1) ;
+  _nUsed = 0 ;
+  _failed = kFALSE ;
+  for (UInt_t i=0 ; i<_batchValues.size() ; i++) {
+    _batchValues[i] = 0 ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+const Double_t* RooAbsReal::BatchData::column(const RooAbsArg& arg) 
+{
+  // Return the values of 'arg' for the events of the current batch, or
+  // zero if 'arg' is not one of the columns. The values of a column are
+  // gathered only when they are first requested.
+
+  for (UInt_t i=0 ; i<_columnPtrs.size() ; i++) {
+    if (_columnPtrs[i]!=&arg) continue ;
+    if (!_batchValues[i]) {
+      if (_contiguous) {
+	_batchValues[i] = _columnValues[i] + _events[0] ;
+      } else {
+	Double_t* values = buffer() ;
+	const Double_t* all = _columnValues[i] ;
+	for (Int_t j=0 ; j<_size ; j++) {
+	  values[j] = all[_events[j]] ;
+	}
+	_batchValues[i] = values ;
+      }
+    }
+    return _batchValues[i] ;
+  }
+  return 0 ;
+}
+
+
+
+//_____________________________________________________________________________
+Double_t* RooAbsReal::BatchData::buffer() 
+{
+  // Return an array of size() elements for the values of a node. It
+  // remains valid until the next batch is selected.
+
+  if (_nUsed==Int_t(_buffers.size())) {
+    _buffers.push_back(new std::vector<Double_t>) ;
+  }
+  std::vector<Double_t>* buf = _buffers[_nUsed++] ;
+  if (Int_t(buf->size())<_size) {
+    buf->resize(_size) ;
+  }
+  return buf->empty() ? 0 : &buf->front() ;
+}
+
+
+
 //_____________________________________________________________________________
 Int_t RooAbsReal::numEvalErrorItems() 
 { 
@@ -3367,6 +3572,10 @@ void RooAbsReal::logEvalError(const RooAbsReal* originator, const char* origName
     return ;
   }
 
+#ifndef _WIN32
+  EvalErrorLock lock ;
+#endif
+
   if (_evalErrorMode==CountErrors) {
     _evalErrorCount++ ;
     return ;
@@ -3422,6 +3631,10 @@ void RooAbsReal::logEvalError(const char* message, const char* serverValueString
     return ;
   }
 
+#ifndef _WIN32
+  EvalErrorLock lock ;
+#endif
+
   if (_evalErrorMode==CountErrors) {
     _evalErrorCount++ ;
     return ;
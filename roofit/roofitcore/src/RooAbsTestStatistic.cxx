@@ -29,7 +29,12 @@
 // organizes multi-processor parallel calculation of test statistic
 // values. For the latter, the test statistic value is calculated in
 // partitions in parallel executing processes and a posteriori
-// combined in the main thread.
+// combined in the main thread. With setThreadedMP() the partitions
+// are calculated by threads of the current process instead, each
+// with its own clone of the function. The threads share the stored
+// values of a single copy of the dataset. The partitions and
+// the order in which they are combined are the same in both cases, so
+// that the result does not depend on the timing of the threads.
 // END_HTML
 //
 
@@ -41,6 +46,8 @@
 #include "RooAbsPdf.h"
 #include "RooSimultaneous.h"
 #include "RooAbsData.h"
+#include "RooDataSet.h"
+#include "RooVectorDataStore.h"
 #include "RooArgSet.h"
 #include "RooRealVar.h"
 #include "RooNLLVar.h"
@@ -64,7 +71,7 @@ RooAbsTestStatistic::RooAbsTestStatistic() :
   _func(0), _data(0), _projDeps(0), _splitRange(0), _simCount(0),
   _verbose(kFALSE), _init(kFALSE), _gofOpMode(Slave), _nEvents(0), _setNum(0),
   _numSets(0), _extSet(0), _nGof(0), _gofArray(0), _nCPU(1), _mpfeArray(0),
-  _mpinterl(RooFit::BulkPartition), _doOffset(kFALSE), _offset(0),
+  _threadedMP(kFALSE), _mpData(0), _mpinterl(RooFit::BulkPartition), _doOffset(kFALSE), _offset(0),
   _offsetCarry(0), _evalCarry(0)
 {
       // Default constructor
@@ -90,6 +97,8 @@ RooAbsTestStatistic::RooAbsTestStatistic(const char *name, const char *title, Ro
   _gofArray(0),
   _nCPU(nCPU),
   _mpfeArray(0),
+  _threadedMP(kFALSE),
+  _mpData(0),
   _mpinterl(interleave),
   _doOffset(kFALSE),
   _offset(0),
@@ -160,6 +169,8 @@ RooAbsTestStatistic::RooAbsTestStatistic(const RooAbsTestStatistic& other, const
   _gofSplitMode(other._gofSplitMode),
   _nCPU(other._nCPU),
   _mpfeArray(0),
+  _threadedMP(other._threadedMP),
+  _mpData(0),
   _mpinterl(other._mpinterl),
   _doOffset(other._doOffset),
   _offset(other._offset),
@@ -210,6 +221,7 @@ RooAbsTestStatistic::~RooAbsTestStatistic()
   if (MPMaster == _gofOpMode && _init) {
     for (Int_t i = 0; i < _nCPU; ++i) delete _mpfeArray[i];
     delete[] _mpfeArray ;
+    delete _mpData ;
   }
 
   if (SimMaster == _gofOpMode && _init) {
@@ -447,9 +459,34 @@ void RooAbsTestStatistic::initMPMode(RooAbsReal* real, RooAbsData* data, const R
 {
   // Initialize multi-processor calculation mode. Create component test statistics in separate
   // processed that are connected to this process through a RooAbsRealMPFE front-end class.
+  // In threaded mode each component test statistic is created in the current process and
+  // calculated by a thread of its RooRealMPFE front-end.
 
   _mpfeArray = new pRooRealMPFE[_nCPU];
 
+  if (_threadedMP) {
+    // The datasets of the threads refer to the values stored in a single copy of the
+    // data, rather than to copy them for each thread
+    RooAbsData* tdata = data ;
+    if (dynamic_cast<RooDataSet*>(data) && dynamic_cast<RooVectorDataStore*>(data->store()) && !(rangeName && strlen(rangeName))) {
+      _mpData = (RooAbsData*) data->Clone() ;
+      ((RooVectorDataStore*)_mpData->store())->setShareOnCopy(kTRUE) ;
+      tdata = _mpData ;
+    }
+    for (Int_t i = 0; i < _nCPU; ++i) {
+      RooAbsTestStatistic* gof = create(Form("%s_GOF%d",GetName(),i),Form("%s_GOF%d",GetTitle(),i),*real,*tdata,*projDeps,rangeName,addCoefRangeName,1,_mpinterl,_verbose,_splitRange);
+      gof->recursiveRedirectServers(_paramSet);
+      gof->setMPSet(i,_nCPU);
+
+      ccoutD(Eval) << "RooAbsTestStatistic::initMPMode: starting calculation thread #" << i << endl;
+      _mpfeArray[i] = new RooRealMPFE(Form("%s_%lx_MPFE%d",GetName(),(ULong_t)this,i),Form("%s_%lx_MPFE%d",GetTitle(),(ULong_t)this,i),*gof,kFALSE,kTRUE);
+      _mpfeArray[i]->initialize();
+      _mpfeArray[i]->addOwnedComponents(*gof);
+    }
+    coutI(Eval) << "RooAbsTestStatistic::initMPMode: started " << _nCPU << " calculation threads." << endl;
+    return ;
+  }
+
   // Create proto-goodness-of-fit
   RooAbsTestStatistic* gof = create(GetName(),GetTitle(),*real,*data,*projDeps,rangeName,addCoefRangeName,1,_mpinterl,_verbose,_splitRange);
   gof->recursiveRedirectServers(_paramSet);
@@ -552,6 +589,7 @@ void RooAbsTestStatistic::initSimMode(RooSimultaneous* simpdf, RooAbsData* data,
 			      rangeName,addCoefRangeName,_nCPU,_mpinterl,_verbose,_splitRange,(binnedPdf?kTRUE:kFALSE));
       }
       _gofArray[n]->setSimCount(_nGof);
+      _gofArray[n]->_threadedMP = _threadedMP;
 
       // Fill per-component split mode with Bulk Partition for now so that Auto will map to bulk-splitting of all components
       if (_mpinterl==RooFit::Hybrid) {
@@ -694,3 +732,29 @@ void RooAbsTestStatistic::enableOffsetting(Bool_t flag)
 
 Double_t RooAbsTestStatistic::getCarry() const
 { return _evalCarry; }
+
+
+
+//_____________________________________________________________________________
+void RooAbsTestStatistic::setThreadedMP(Bool_t flag)
+{
+  // Calculate the partitions of the parallel calculation mode (nCPU>1) in threads
+  // of the current process instead of forked processes. Each thread has its own clone
+  // of the function, the parameters and the stored values of an unbinned dataset with
+  // vector storage are shared. Other datasets, and datasets reduced to a fit range, are
+  // copied for each thread. The function must
+  // not modify objects shared with other clones when it is evaluated. This must be
+  // called before the test statistic is first evaluated or optimized.
+
+  if (_init && MPMaster == _gofOpMode) {
+    coutW(Eval) << "RooAbsTestStatistic::setThreadedMP(" << GetName() << ") WARNING: parallel calculation already started, "
+		<< "calculation mode is not changed" << endl ;
+    return ;
+  }
+  _threadedMP = flag ;
+  if (SimMaster == _gofOpMode && _init) {
+    for (Int_t i = 0; i < _nGof; ++i) {
+      _gofArray[i]->setThreadedMP(flag);
+    }
+  }
+}
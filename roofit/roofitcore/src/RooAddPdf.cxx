@@ -843,6 +843,75 @@ Double_t RooAddPdf::evaluate() const
 }
 
 
+//_____________________________________________________________________________
+void RooAddPdf::evaluateBatch(Double_t* output, BatchData& batch) const 
+{
+  // Calculate the values for the events of the given batch. The
+  // coefficients are calculated once for the batch, the component values
+  // are summed in the same order as in evaluate().
+
+  const RooArgSet* nset = _normSet ; 
+
+  if (nset==0 || nset->getSize()==0) {
+    if (_refCoefNorm.getSize()!=0) {
+      nset = &_refCoefNorm ;
+    }
+  }
+
+  CacheElem* cache = getProjCache(nset) ;
+  updateCoefficients(*cache,nset) ;
+
+  Int_t n = batch.size() ;
+  for (Int_t j=0 ; j<n ; j++) {
+    output[j] = 0 ;
+  }
+
+  RooAbsPdf* pdf ;
+  Int_t i(0) ;
+  RooFIter pi = _pdfList.fwdIterator() ;
+  while((pdf = (RooAbsPdf*)pi.next())) {
+    const Double_t* pdfVal = pdf->getValBatch(batch,nset) ;
+    if (pdf->isSelectedComp()) {
+      Double_t coef = _coefCache[i] ;
+      if (cache->_needSupNorm) {
+	Double_t snormVal = ((RooAbsReal*)cache->_suppNormList.at(i))->getVal() ;
+	for (Int_t j=0 ; j<n ; j++) {
+	  output[j] += pdfVal[j]*coef/snormVal ;
+	}
+      } else {
+	for (Int_t j=0 ; j<n ; j++) {
+	  output[j] += pdfVal[j]*coef ;
+	}
+      }
+    }
+    i++ ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooAddPdf::canEvaluateBatch(const RooArgSet& columns) const 
+{
+  // The sum can be calculated for a batch of events if all components
+  // can and the coefficients do not depend on the observables
+
+  if (RooAbsPdf::canEvaluateBatch(columns)) return kTRUE ;
+
+  RooFIter pi = _pdfList.fwdIterator() ;
+  RooAbsReal* arg ;
+  while((arg = (RooAbsReal*)pi.next())) {
+    if (!arg->canEvaluateBatch(columns)) return kFALSE ;
+  }
+  RooFIter ci = _coefList.fwdIterator() ;
+  while((arg = (RooAbsReal*)ci.next())) {
+    if (arg->dependsOnValue(columns)) return kFALSE ;
+  }
+  return kTRUE ;
+}
+
+
+
 //_____________________________________________________________________________
 void RooAddPdf::resetErrorCounters(Int_t resetValue)
 {
@@ -66,12 +66,14 @@ RooChi2Var::RooChi2Var(const char *name, const char* title, RooAbsReal& func, Ro
   //
   //  DataError()  -- Choose between Poisson errors and Sum-of-weights errors
   //  NumCPU()     -- Activate parallel processing feature
+  //  NumThreads() -- Activate parallel processing feature with threads
   //  Range()      -- Fit only selected region
   //  Verbose()    -- Verbose output of GOF framework
 {
   RooCmdConfig pc("RooChi2Var::RooChi2Var") ;
   pc.defineInt("etype","DataError",0,(Int_t)RooDataHist::Auto) ;  
   pc.defineInt("extended","Extended",0,kFALSE) ;
+  pc.defineString("mpMode","NumCPU",0,"") ;
   pc.allowUndefined() ;
 
   pc.process(arg1) ;  pc.process(arg2) ;  pc.process(arg3) ;
@@ -84,6 +86,7 @@ RooChi2Var::RooChi2Var(const char *name, const char* title, RooAbsReal& func, Ro
     _funcMode = Function ;
   }
   _etype = (RooDataHist::ErrorType) pc.getInt("etype") ;
+  setThreadedMP(!strcmp(pc.getString("mpMode"),"Threads")) ;
 
   if (_etype==RooAbsData::Auto) {
     _etype = hdata.isNonPoissonWeighted()? RooAbsData::SumW2 : RooAbsData::Expected ;
@@ -112,6 +115,7 @@ RooChi2Var::RooChi2Var(const char *name, const char* title, RooAbsPdf& pdf, RooD
   //  Extended()   -- Include extended term in calculation
   //  DataError()  -- Choose between Poisson errors and Sum-of-weights errors
   //  NumCPU()     -- Activate parallel processing feature
+  //  NumThreads() -- Activate parallel processing feature with threads
   //  Range()      -- Fit only selected region
   //  SumCoefRange() -- Set the range in which to interpret the coefficients of RooAddPdf components 
   //  SplitRange() -- Fit range is split by index catory of simultaneous PDF
@@ -121,6 +125,7 @@ RooChi2Var::RooChi2Var(const char *name, const char* title, RooAbsPdf& pdf, RooD
   RooCmdConfig pc("RooChi2Var::RooChi2Var") ;
   pc.defineInt("extended","Extended",0,kFALSE) ;
   pc.defineInt("etype","DataError",0,(Int_t)RooDataHist::Auto) ;  
+  pc.defineString("mpMode","NumCPU",0,"") ;
   pc.allowUndefined() ;
 
   pc.process(arg1) ;  pc.process(arg2) ;  pc.process(arg3) ;
@@ -129,6 +134,7 @@ RooChi2Var::RooChi2Var(const char *name, const char* title, RooAbsPdf& pdf, RooD
 
   _funcMode = pc.getInt("extended") ? ExtendedPdf : Pdf ;
   _etype = (RooDataHist::ErrorType) pc.getInt("etype") ;
+  setThreadedMP(!strcmp(pc.getString("mpMode"),"Threads")) ;
   if (_etype==RooAbsData::Auto) {
     _etype = hdata.isNonPoissonWeighted()? RooAbsData::SumW2 : RooAbsData::Expected ;
   }
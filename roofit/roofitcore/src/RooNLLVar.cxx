@@ -38,6 +38,8 @@
 #include "RooCmdConfig.h"
 #include "RooMsgService.h"
 #include "RooAbsDataStore.h"
+#include "RooVectorDataStore.h"
+#include "RooDataSet.h"
 #include "RooRealMPFE.h"
 #include "RooRealSumPdf.h"
 #include "RooRealVar.h"
@@ -69,6 +71,7 @@ RooNLLVar::RooNLLVar(const char *name, const char* title, RooAbsPdf& pdf, RooAbs
   //
   //  Extended()     -- Include extended term in calculation
   //  NumCPU()       -- Activate parallel processing feature
+  //  NumThreads()   -- Activate parallel processing feature with threads
   //  Range()        -- Fit only selected region
   //  SumCoefRange() -- Set the range in which to interpret the coefficients of RooAddPdf components 
   //  SplitRange()   -- Fit range is split by index catory of simultaneous PDF
@@ -79,12 +82,14 @@ RooNLLVar::RooNLLVar(const char *name, const char* title, RooAbsPdf& pdf, RooAbs
   RooCmdConfig pc("RooNLLVar::RooNLLVar") ;
   pc.allowUndefined() ;
   pc.defineInt("extended","Extended",0,kFALSE) ;
+  pc.defineString("mpMode","NumCPU",0,"") ;
 
   pc.process(arg1) ;  pc.process(arg2) ;  pc.process(arg3) ;
   pc.process(arg4) ;  pc.process(arg5) ;  pc.process(arg6) ;
   pc.process(arg7) ;  pc.process(arg8) ;  pc.process(arg9) ;
 
   _extended = pc.getInt("extended") ;
+  setThreadedMP(!strcmp(pc.getString("mpMode"),"Threads")) ;
   _weightSq = kFALSE ;
   _first = kTRUE ;
   _offset = 0.;
@@ -282,28 +287,32 @@ Double_t RooNLLVar::evaluatePartition(Int_t firstEvent, Int_t lastEvent, Int_t s
 
   } else {
 
-    for (i=firstEvent ; i<lastEvent ; i+=stepSize) {
+    // Evaluate the p.d.f for blocks of events if all its nodes support it
+    if (!evaluateBatchPartition(firstEvent,lastEvent,stepSize,result,carry,sumWeight,sumWeightCarry)) {
+
+      for (i=firstEvent ; i<lastEvent ; i+=stepSize) {
             
-      _dataClone->get(i) ;
+        _dataClone->get(i) ;
       
-      if (!_dataClone->valid()) continue;
+        if (!_dataClone->valid()) continue;
       
-      Double_t eventWeight = _dataClone->weight();
-      if (0. == eventWeight * eventWeight) continue ;
-      if (_weightSq) eventWeight = _dataClone->weightSquared() ;
+        Double_t eventWeight = _dataClone->weight();
+        if (0. == eventWeight * eventWeight) continue ;
+        if (_weightSq) eventWeight = _dataClone->weightSquared() ;
       
-      Double_t term = -eventWeight * pdfClone->getLogVal(_normSet);
+        Double_t term = -eventWeight * pdfClone->getLogVal(_normSet);
       
       
-      Double_t y = eventWeight - sumWeightCarry;
-      Double_t t = sumWeight + y;
-      sumWeightCarry = (t - sumWeight) - y;
-      sumWeight = t;
+        Double_t y = eventWeight - sumWeightCarry;
+        Double_t t = sumWeight + y;
+        sumWeightCarry = (t - sumWeight) - y;
+        sumWeight = t;
       
-      y = term - carry;
-      t = result + y;
-      carry = (t - result) - y;
-      result = t;
+        y = term - carry;
+        t = result + y;
+        carry = (t - result) - y;
+        result = t;
+      }
     }
     
     // include the extended maximum likelihood term, if requested
@@ -377,3 +386,115 @@ Double_t RooNLLVar::evaluatePartition(Int_t firstEvent, Int_t lastEvent, Int_t s
 
 
 
+
+
+
+//_____________________________________________________________________________
+Bool_t RooNLLVar::evaluateBatchPartition(Int_t firstEvent, Int_t lastEvent, Int_t stepSize, Double_t& result, Double_t& carry,
+					 Double_t& sumWeight, Double_t& sumWeightCarry) const 
+{
+  // Add the terms of the events from firstEvent to lastEvent (step size
+  // 'stepSize') to the Kahan sums 'result' and 'sumWeight', evaluating the
+  // p.d.f for blocks of events with RooAbsReal::getValBatch() instead of
+  // event by event. This requires a dataset stored in a RooVectorDataStore
+  // without category observables, and a p.d.f whose observables are all
+  // stored as columns and whose nodes can all be evaluated for a batch (see
+  // RooAbsReal::canEvaluateBatch()); if this is not the case, nothing is
+  // done and kFALSE is returned.
+  //
+  // The terms are summed in the same order as in evaluatePartition(), so
+  // the result is the same. A block in which an evaluation error or a
+  // p.d.f value that getLogVal() would report occurs is recalculated
+  // event by event, which logs the errors as usual.
+
+  RooAbsPdf* pdfClone = (RooAbsPdf*) _funcClone ;
+
+  const RooVectorDataStore* vstore = dynamic_cast<const RooVectorDataStore*>(_dataClone->store()) ;
+  if (!vstore || !dynamic_cast<RooDataSet*>(_dataClone)) return kFALSE ;
+
+  const Double_t* wgtArray = vstore->weightArray() ;
+  if (!wgtArray && vstore->isWeighted()) return kFALSE ;
+  Double_t unitWeight = wgtArray ? 0 : _dataClone->weight() ;
+
+  // Category observables are not stored as columns, so nodes depending on
+  // them would wrongly be taken as constant over the batch
+  if (vstore->hasCategories()) return kFALSE ;
+
+  RooAbsReal::BatchData batch ;
+  vstore->addBatchColumns(batch) ;
+  const RooArgSet& columns = batch.columns() ;
+  if (columns.containsInstance(*pdfClone) || !pdfClone->dependsOnValue(columns) || !pdfClone->canEvaluateBatch(columns)) {
+    return kFALSE ;
+  }
+
+  // All observables of the p.d.f must be columns
+  RooArgSet* pdfObs = pdfClone->getObservables(_dataClone->get()) ;
+  Bool_t allColumns(kTRUE) ;
+  TIterator* iter = pdfObs->createIterator() ;
+  RooAbsArg* arg ;
+  while ((arg=(RooAbsArg*)iter->Next())) {
+    if (!columns.containsInstance(*arg)) allColumns = kFALSE ;
+  }
+  delete iter ;
+  delete pdfObs ;
+  if (!allColumns) return kFALSE ;
+
+  const Int_t batchSize(1024) ;
+  std::vector<Int_t> events(batchSize) ;
+  std::vector<Double_t> weights(batchSize) ;
+  std::vector<Double_t> logVal(batchSize) ;
+
+  Int_t i(firstEvent) ;
+  while (i<lastEvent) {
+
+    // Select the next block of events with a non-zero weight
+    Int_t n(0) ;
+    for ( ; i<lastEvent && n<batchSize ; i+=stepSize) {
+      Double_t eventWeight = wgtArray ? wgtArray[i] : unitWeight ;
+      if (0. == eventWeight * eventWeight) continue ;
+      if (_weightSq) eventWeight = eventWeight * eventWeight ;
+      events[n] = i ;
+      weights[n] = eventWeight ;
+      n++ ;
+    }
+    if (n==0) break ;
+
+    batch.setEvents(&events[0],n) ;
+    const Double_t* prob = pdfClone->getValBatch(batch,_normSet) ;
+
+    // Values for which RooAbsPdf::getLogVal() prints a message
+    Bool_t error = batch.failed() ;
+    if (!error) {
+      for (Int_t k=0 ; k<n ; k++) {
+	error |= !(prob[k]>0 && prob[k]<=1e6) ;
+      }
+    }
+
+    if (error) {
+      for (Int_t k=0 ; k<n ; k++) {
+	_dataClone->get(events[k]) ;
+	logVal[k] = pdfClone->getLogVal(_normSet) ;
+      }
+    } else {
+      for (Int_t k=0 ; k<n ; k++) {
+	logVal[k] = log(prob[k]) ;
+      }
+    }
+
+    for (Int_t k=0 ; k<n ; k++) {
+      Double_t term = -weights[k] * logVal[k] ;
+
+      Double_t y = weights[k] - sumWeightCarry;
+      Double_t t = sumWeight + y;
+      sumWeightCarry = (t - sumWeight) - y;
+      sumWeight = t;
+      
+      y = term - carry;
+      t = result + y;
+      carry = (t - result) - y;
+      result = t;
+    }
+  }
+
+  return kTRUE ;
+}
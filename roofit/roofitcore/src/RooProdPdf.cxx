@@ -511,6 +511,16 @@ Double_t RooProdPdf::getValV(const RooArgSet* set) const
 
 
 
+//_____________________________________________________________________________
+const Double_t* RooProdPdf::getValBatch(BatchData& batch, const RooArgSet* set) const 
+{
+  // Overload getValBatch() to intercept normalization set for use in evaluateBatch()
+  _curNormSet = (RooArgSet*)set ;
+  return RooAbsPdf::getValBatch(batch,set) ;
+}
+
+
+
 //_____________________________________________________________________________
 Double_t RooProdPdf::evaluate() const 
 {
@@ -620,6 +630,86 @@ Double_t RooProdPdf::calculate(const RooProdPdf::CacheElem& cache, Bool_t /*verb
 
 
 
+//_____________________________________________________________________________
+void RooProdPdf::evaluateBatch(Double_t* output, BatchData& batch) const 
+{
+  // Calculate the running product of the terms for the events of the given
+  // batch, see calculate(). Rearranged products are not supported and mark
+  // the batch as failed.
+
+  Int_t code ;
+  CacheElem* cache = (CacheElem*) _cacheMgr.getObj(_curNormSet,0,&code) ;
+  if (!cache) {
+    RooArgList *plist(0) ;
+    RooLinkedList *nlist(0) ;
+    getPartIntList(_curNormSet,0,plist,nlist,code) ;
+    cache = (CacheElem*) _cacheMgr.getObj(_curNormSet,0,&code) ;
+  }
+
+  if (cache->_isRearranged) {
+    batch.setFailed() ;
+    return ;
+  }
+
+  Int_t n = batch.size() ;
+  for (Int_t j=0 ; j<n ; j++) {
+    output[j] = 1.0 ;
+  }
+
+  RooAbsReal* partInt ;
+  RooArgSet* normSet ;
+  RooFIter plIter = cache->_partList.fwdIterator() ;
+  RooFIter nlIter = cache->_normList.fwdIterator() ;
+  Bool_t first(kTRUE) ;
+  while((partInt = (RooAbsReal*) plIter.next())) {
+    normSet = (RooArgSet*) nlIter.next() ;
+    const Double_t* piVal = partInt->getValBatch(batch,normSet->getSize()>0 ? normSet : 0) ;
+    // Events whose product already fell below the cutoff keep their value
+    if (first) {
+      for (Int_t j=0 ; j<n ; j++) {
+	output[j] *= piVal[j] ;
+      }
+    } else {
+      Double_t cutOff = _cutOff ;
+      for (Int_t j=0 ; j<n ; j++) {
+	output[j] = (output[j]<=cutOff) ? output[j] : output[j]*piVal[j] ;
+      }
+    }
+    first = kFALSE ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooProdPdf::canEvaluateBatch(const RooArgSet& columns) const 
+{
+  // The product can be calculated for a batch of events if all its terms
+  // can. Once the product has been evaluated, the terms of the current
+  // normalization set are checked, otherwise the input p.d.f.s
+
+  if (RooAbsPdf::canEvaluateBatch(columns)) return kTRUE ;
+
+  RooAbsReal* arg ;
+  CacheElem* cache = (CacheElem*) _cacheMgr.getObj(_curNormSet,(RooArgSet*)0) ;
+  if (cache) {
+    if (cache->_isRearranged) return kFALSE ;
+    RooFIter plIter = cache->_partList.fwdIterator() ;
+    while((arg = (RooAbsReal*) plIter.next())) {
+      if (!arg->canEvaluateBatch(columns)) return kFALSE ;
+    }
+    return kTRUE ;
+  }
+
+  RooFIter pi = _pdfList.fwdIterator() ;
+  while((arg = (RooAbsReal*) pi.next())) {
+    if (!arg->canEvaluateBatch(columns)) return kFALSE ;
+  }
+  return kTRUE ;
+}
+
+
+
 //_____________________________________________________________________________
 void RooProdPdf::factorizeProduct(const RooArgSet& normSet, const RooArgSet& intSet,
 				  RooLinkedList& termList, RooLinkedList& normList, 
@@ -38,6 +38,16 @@
 // Double_t val = mpfe.getVal() // Wait for remote calculation to finish and retrieve value
 // </pre>
 //
+// In thread mode (useThread=kTRUE in the constructor) the calculation runs in a
+// thread of the current process instead of a forked process. The thread evaluates
+// the proxied object directly, so no variable values need to be exchanged, but the
+// proxied object must not share any state other than its parameters with the objects
+// evaluated by other threads. Each test statistic created by RooAbsTestStatistic
+// in threaded multi-processor mode has its own clone of the function and dataset.
+// The first calculation after initialization, constant term optimization or a change
+// of the offsetting is done in the calling thread, so that all caches are created
+// before the evaluation moves to the thread.
+//
 // END_HTML
 //
 
@@ -46,6 +56,7 @@
 
 #ifndef _WIN32
 #include "BidirMMapPipe.h"
+#include <pthread.h>
 #endif
 
 #include <cstdlib>
@@ -71,8 +82,85 @@ ClassImp(RooRealMPFE)
   ;
 
 
+#ifndef _WIN32
+namespace RooFit {
+
+  // Calculation thread of a RooRealMPFE in thread mode. The thread waits for
+  // calculation requests and stores the value calculated by the front-end.
+  class MPFEThread {
+  public:
+    MPFEThread(const RooRealMPFE& mpfe) : 
+      _mpfe(mpfe), _request(kFALSE), _done(kTRUE), _terminate(kFALSE), _value(0) {
+      pthread_mutex_init(&_mutex,0) ;
+      pthread_cond_init(&_cond,0) ;
+      pthread_create(&_thread,0,&MPFEThread::start,this) ;
+    }
+    ~MPFEThread() {
+      pthread_mutex_lock(&_mutex) ;
+      _terminate = kTRUE ;
+      pthread_cond_broadcast(&_cond) ;
+      pthread_mutex_unlock(&_mutex) ;
+      pthread_join(_thread,0) ;
+      pthread_cond_destroy(&_cond) ;
+      pthread_mutex_destroy(&_mutex) ;
+    }
+
+    void calculate() {
+      // Start a calculation
+      pthread_mutex_lock(&_mutex) ;
+      _request = kTRUE ;
+      _done = kFALSE ;
+      pthread_cond_broadcast(&_cond) ;
+      pthread_mutex_unlock(&_mutex) ;
+    }
+
+    Double_t result() {
+      // Wait for the end of the calculation and return its value
+      pthread_mutex_lock(&_mutex) ;
+      while (!_done) pthread_cond_wait(&_cond,&_mutex) ;
+      Double_t value = _value ;
+      pthread_mutex_unlock(&_mutex) ;
+      return value ;
+    }
+
+  private:
+    static void* start(void* arg) {
+      ((MPFEThread*)arg)->loop() ;
+      return 0 ;
+    }
+
+    void loop() {
+      pthread_mutex_lock(&_mutex) ;
+      while (kTRUE) {
+	while (!_request && !_terminate) pthread_cond_wait(&_cond,&_mutex) ;
+	if (_terminate) break ;
+	_request = kFALSE ;
+	pthread_mutex_unlock(&_mutex) ;
+	Double_t value = _mpfe.calculateInThread() ;
+	pthread_mutex_lock(&_mutex) ;
+	_value = value ;
+	_done = kTRUE ;
+	pthread_cond_broadcast(&_cond) ;
+      }
+      pthread_mutex_unlock(&_mutex) ;
+    }
+
+    const RooRealMPFE& _mpfe ;
+    pthread_t _thread ;
+    pthread_mutex_t _mutex ;
+    pthread_cond_t _cond ;
+    Bool_t _request ;   // calculation requested
+    Bool_t _done ;      // calculation finished
+    Bool_t _terminate ; // thread must exit
+    Double_t _value ;   // calculated value
+  };
+
+}
+#endif // _WIN32
+
+
 //_____________________________________________________________________________
-RooRealMPFE::RooRealMPFE(const char *name, const char *title, RooAbsReal& arg, Bool_t calcInline) : 
+RooRealMPFE::RooRealMPFE(const char *name, const char *title, RooAbsReal& arg, Bool_t calcInline, Bool_t useThread) : 
   RooAbsReal(name,title),
   _state(Initialize),
   _arg("arg","arg",this,arg),
@@ -81,14 +169,18 @@ RooRealMPFE::RooRealMPFE(const char *name, const char *title, RooAbsReal& arg, B
   _verboseClient(kFALSE),
   _verboseServer(kFALSE),
   _inlineMode(calcInline),
+  _threadMode(useThread),
   _remoteEvalErrorLoggingState(RooAbsReal::PrintErrors),
   _pipe(0),
+  _thread(0),
+  _threadWarm(kFALSE),
   _updateMaster(0),
   _retrieveDispatched(kFALSE), _evalCarry(0.)
 {  
   // Construct front-end object for object 'arg' whose evaluation will be calculated
   // asynchronously in a separate process. If calcInline is true the value of 'arg'
-  // is calculate synchronously in the current process.
+  // is calculate synchronously in the current process. If useThread is true the
+  // value is calculated asynchronously in a thread of the current process.
 #ifdef _WIN32
   _inlineMode = kTRUE;
 #endif
@@ -109,9 +201,12 @@ RooRealMPFE::RooRealMPFE(const RooRealMPFE& other, const char* name) :
   _verboseClient(other._verboseClient),
   _verboseServer(other._verboseServer),
   _inlineMode(other._inlineMode),
+  _threadMode(other._threadMode),
   _forceCalc(other._forceCalc),
   _remoteEvalErrorLoggingState(other._remoteEvalErrorLoggingState),
   _pipe(0),
+  _thread(0),
+  _threadWarm(kFALSE),
   _updateMaster(0),
   _retrieveDispatched(kFALSE), _evalCarry(other._evalCarry)
 {
@@ -129,7 +224,7 @@ RooRealMPFE::~RooRealMPFE()
 {
   // Destructor
 
-  if (_state==Client) standby();
+  if (_state==Client || _state==Thread) standby();
   _sentinel.remove(*this);
 }
 
@@ -164,7 +259,7 @@ void RooRealMPFE::initVars()
 
 Double_t RooRealMPFE::getCarry() const
 {
-  if (_inlineMode) {
+  if (_inlineMode || _state==Thread) {
     RooAbsTestStatistic* tmp = dynamic_cast<RooAbsTestStatistic*>(_arg.absArg());
     if (tmp) return tmp->getCarry();
     else return 0.;
@@ -186,6 +281,15 @@ void RooRealMPFE::initialize()
   }
 
 #ifndef _WIN32
+  // Thread mode: start calculation thread
+  if (_threadMode) {
+    _thread = new MPFEThread(*this) ;
+    _state = Thread ;
+    _threadWarm = kFALSE ;
+    _calcInProgress = kFALSE ;
+    return ;
+  }
+
   // Clear eval error log prior to forking
   // to avoid confusions...
   clearEvalErrorLog() ;
@@ -393,6 +497,30 @@ void RooRealMPFE::serverLoop()
 
 
 
+//_____________________________________________________________________________
+Double_t RooRealMPFE::calculateInThread() const 
+{
+  // Calculate the value of arg, called by the calculation thread in thread mode
+  return _arg ;
+}
+
+
+
+//_____________________________________________________________________________
+void RooRealMPFE::waitForThread() const 
+{
+  // Wait for the end of a calculation in progress in thread mode
+
+#ifndef _WIN32
+  if (_state==Thread && _calcInProgress) {
+    _value = _thread->result() ;
+    _calcInProgress = kFALSE ;
+  }
+#endif // _WIN32
+}
+
+
+
 //_____________________________________________________________________________
 void RooRealMPFE::calculate() const 
 {
@@ -416,6 +544,21 @@ void RooRealMPFE::calculate() const
   }
 
 #ifndef _WIN32
+  // Thread mode -- Start calculation in thread. The first calculation after
+  // initialization or optimization may create caches and is done now
+  if (_state==Thread) {
+    waitForThread() ;
+    if (_threadWarm) {
+      _thread->calculate() ;
+      _calcInProgress = kTRUE ;
+    } else {
+      _value = _arg ;
+      _threadWarm = kTRUE ;
+    }
+    clearValueDirty() ;
+    _forceCalc = kFALSE ;
+  }
+
   // Compare current value of variables with saved values and send changes to server
   if (_state==Client) {
     //     cout << "RooRealMPFE::calculate(" << GetName() << ") state is Client trigger remote calculation" << endl ;
@@ -485,9 +628,9 @@ void RooRealMPFE::calculate() const
 			     << ") IPC toServer> Retrieve " << endl ;    
     _retrieveDispatched = kTRUE ;        
 
-  } else if (_state!=Inline) {
+  } else if (_state!=Inline && _state!=Thread) {
     cout << "RooRealMPFE::calculate(" << GetName() 
-	 << ") ERROR not in Client or Inline mode" << endl ;
+	 << ") ERROR not in Client, Inline or Thread mode" << endl ;
   }
 
   
@@ -537,6 +680,9 @@ Double_t RooRealMPFE::evaluate() const
   Double_t return_value = 0;
   if (_state==Inline) {
     return_value = _arg ; 
+  } else if (_state==Thread) {
+    waitForThread() ;
+    return_value = _value ;
   } else if (_state==Client) {
 #ifndef _WIN32
     bool needflush = false;
@@ -615,6 +761,14 @@ void RooRealMPFE::standby()
   // this call will automatically recreated the server process.
 
 #ifndef _WIN32
+  if (_state==Thread) {
+    // Stop calculation thread
+    waitForThread() ;
+    delete _thread ;
+    _thread = 0 ;
+    _state = Initialize ;
+  }
+
   if (_state==Client) {
     if (_pipe->good()) {
       // Terminate server process ;
@@ -667,8 +821,10 @@ void RooRealMPFE::constOptimizeTestStatistic(ConstOpCode opcode, Bool_t doAlsoTr
   }
 #endif // _WIN32
 
-  if (_state==Inline) {
+  if (_state==Inline || _state==Thread) {
+    waitForThread() ;
     ((RooAbsReal&)_arg.arg()).constOptimizeTestStatistic(opcode,doAlsoTracking) ;
+    _threadWarm = kFALSE ;
   }
 }
 
@@ -706,6 +862,7 @@ void RooRealMPFE::applyNLLWeightSquared(Bool_t flag)
 			     << ") IPC toServer> ApplyNLLW2 " << (flag?1:0) << endl ;      
   } 
 #endif // _WIN32
+  waitForThread() ;
   doApplyNLLW2(flag) ;
 }
 
@@ -734,7 +891,9 @@ void RooRealMPFE::enableOffsetting(Bool_t flag)
 			     << ") IPC toServer> EnableOffset " << (flag?1:0) << endl ;      
   } 
 #endif // _WIN32
+  waitForThread() ;
   ((RooAbsReal&)_arg.arg()).enableOffsetting(flag) ;
+  _threadWarm = kFALSE ;
 }
 
 
@@ -72,7 +72,8 @@ RooVectorDataStore::RooVectorDataStore() :
   _curWgtErrHi(0),
   _curWgtErr(0),
   _cache(0),
-  _cacheOwner(0)
+  _cacheOwner(0),
+  _shareOnCopy(kFALSE)
 {
 }
 
@@ -101,7 +102,8 @@ RooVectorDataStore::RooVectorDataStore(const char* name, const char* title, cons
   _curWgtErrHi(0),
   _curWgtErr(0),
   _cache(0),
-  _cacheOwner(0)
+  _cacheOwner(0),
+  _shareOnCopy(kFALSE)
 {
   TIterator* iter = _varsww.createIterator() ;
   RooAbsArg* arg ;
@@ -191,25 +193,26 @@ RooVectorDataStore::RooVectorDataStore(const RooVectorDataStore& other, const ch
   _curWgtErrHi(other._curWgtErrHi),
   _curWgtErr(other._curWgtErr),
   _cache(0),
-  _cacheOwner(0)
+  _cacheOwner(0),
+  _shareOnCopy(kFALSE)
 {
   // Regular copy ctor
 
   vector<RealVector*>::const_iterator oiter = other._realStoreList.begin() ;
   for (; oiter!=other._realStoreList.end() ; ++oiter) {
-    _realStoreList.push_back(new RealVector(**oiter,(RooAbsReal*)_varsww.find((*oiter)->_nativeReal->GetName()))) ;
+    _realStoreList.push_back(new RealVector(**oiter,(RooAbsReal*)_varsww.find((*oiter)->_nativeReal->GetName()),other._shareOnCopy)) ;
     _nReal++ ;
   }
 
   vector<RealFullVector*>::const_iterator fiter = other._realfStoreList.begin() ;
   for (; fiter!=other._realfStoreList.end() ; ++fiter) {
-    _realfStoreList.push_back(new RealFullVector(**fiter,(RooAbsReal*)_varsww.find((*fiter)->_nativeReal->GetName()))) ;
+    _realfStoreList.push_back(new RealFullVector(**fiter,(RooAbsReal*)_varsww.find((*fiter)->_nativeReal->GetName()),other._shareOnCopy)) ;
     _nRealF++ ;
   }
 
   vector<CatVector*>::const_iterator citer = other._catStoreList.begin() ;
   for (; citer!=other._catStoreList.end() ; ++citer) {
-    _catStoreList.push_back(new CatVector(**citer,(RooAbsCategory*)_varsww.find((*citer)->_cat->GetName()))) ;
+    _catStoreList.push_back(new CatVector(**citer,(RooAbsCategory*)_varsww.find((*citer)->_cat->GetName()),other._shareOnCopy)) ;
     _nCat++ ;
  }
 
@@ -244,7 +247,8 @@ RooVectorDataStore::RooVectorDataStore(const RooTreeDataStore& other, const RooA
   _curWgtErrHi(0),
   _curWgtErr(0),
   _cache(0),
-  _cacheOwner(0)
+  _cacheOwner(0),
+  _shareOnCopy(kFALSE)
 {
   TIterator* iter = _varsww.createIterator() ;
   RooAbsArg* arg ;
@@ -285,7 +289,8 @@ RooVectorDataStore::RooVectorDataStore(const RooVectorDataStore& other, const Ro
   _curWgtErrLo(other._curWgtErrLo),
   _curWgtErrHi(other._curWgtErrHi),
   _curWgtErr(other._curWgtErr),
-  _cache(0)
+  _cache(0),
+  _shareOnCopy(kFALSE)
 {
   // Clone ctor, must connect internal storage to given new external set of vars
   vector<RealVector*>::const_iterator oiter = other._realStoreList.begin() ;
@@ -293,7 +298,7 @@ RooVectorDataStore::RooVectorDataStore(const RooVectorDataStore& other, const Ro
     RooAbsReal* real = (RooAbsReal*) vars.find((*oiter)->bufArg()->GetName()) ;
     if (real) {
       // Clone vector
-      _realStoreList.push_back(new RealVector(**oiter,real)) ;
+      _realStoreList.push_back(new RealVector(**oiter,real,other._shareOnCopy)) ;
       // Adjust buffer pointer
       real->attachToVStore(*this) ;
       _nReal++ ;
@@ -305,7 +310,7 @@ RooVectorDataStore::RooVectorDataStore(const RooVectorDataStore& other, const Ro
     RooAbsReal* real = (RooAbsReal*) vars.find((*fiter)->bufArg()->GetName()) ;
     if (real) {
       // Clone vector
-      _realfStoreList.push_back(new RealFullVector(**fiter,real)) ;
+      _realfStoreList.push_back(new RealFullVector(**fiter,real,other._shareOnCopy)) ;
       // Adjust buffer pointer
       real->attachToVStore(*this) ;
       _nRealF++ ;
@@ -317,7 +322,7 @@ RooVectorDataStore::RooVectorDataStore(const RooVectorDataStore& other, const Ro
     RooAbsCategory* cat = (RooAbsCategory*) vars.find((*citer)->bufArg()->GetName()) ;
     if (cat) {
       // Clone vector
-      _catStoreList.push_back(new CatVector(**citer,cat)) ;
+      _catStoreList.push_back(new CatVector(**citer,cat,other._shareOnCopy)) ;
       // Adjust buffer pointer
       cat->attachToVStore(*this) ;
       _nCat++ ;
@@ -361,7 +366,8 @@ RooVectorDataStore::RooVectorDataStore(const char *name, const char *title, RooA
   _curWgtErrLo(0),
   _curWgtErrHi(0),
   _curWgtErr(0),
-  _cache(0)
+  _cache(0),
+  _shareOnCopy(kFALSE)
 {
   TIterator* iter = _varsww.createIterator() ;
   RooAbsArg* arg ;
@@ -1403,6 +1409,62 @@ void RooVectorDataStore::setArgStatus(const RooArgSet& /*set*/, Bool_t /*active*
 
 
 
+//_____________________________________________________________________________
+void RooVectorDataStore::addBatchColumns(RooAbsReal::BatchData& batch) const
+{
+  // Declare the stored values of all real valued observables, and of
+  // the nodes cached by the constant term optimizer, as columns of the
+  // given batch. Each column is associated with the object into which
+  // get() loads its values.
+
+  for (Int_t i=0 ; i<_nReal ; i++) {
+    const RealVector* rv = *(_firstReal+i) ;
+    if (rv->_real && rv->_vec0) batch.addColumn(*rv->_real,rv->_vec0) ;
+  }
+  for (Int_t i=0 ; i<_nRealF ; i++) {
+    const RealFullVector* rfv = *(_firstRealF+i) ;
+    if (rfv->_real && rfv->_vec0) batch.addColumn(*rfv->_real,rfv->_vec0) ;
+  }
+  if (_cache) {
+    _cache->addBatchColumns(batch) ;
+  }
+}
+
+
+
+//_____________________________________________________________________________
+Bool_t RooVectorDataStore::hasCategories() const
+{
+  // Return true if this store, or its cache, holds category valued
+  // observables or nodes. These are not available as batch columns.
+
+  return _nCat>0 || (_cache && _cache->hasCategories()) ;
+}
+
+
+
+//_____________________________________________________________________________
+const Double_t* RooVectorDataStore::weightArray() const
+{
+  // Return the weights of all events, or zero if the weights are not
+  // stored in an array (unweighted data, or weight variable not found)
+
+  if (_extWgtArray) return _extWgtArray ;
+  if (!_wgtVar) return 0 ;
+
+  for (Int_t i=0 ; i<_nReal ; i++) {
+    const RealVector* rv = *(_firstReal+i) ;
+    if (rv->bufArg()->namePtr()==_wgtVar->namePtr()) return rv->_vec0 ;
+  }
+  for (Int_t i=0 ; i<_nRealF ; i++) {
+    const RealFullVector* rfv = *(_firstRealF+i) ;
+    if (rfv->bufArg()->namePtr()==_wgtVar->namePtr()) return rfv->_vec0 ;
+  }
+  return 0 ;
+}
+
+
+
 //_____________________________________________________________________________
 void RooVectorDataStore::attachBuffers(const RooArgSet& extObs) 
 {
@@ -1441,9 +1503,9 @@ void RooVectorDataStore::dump()
   for (; iter!=_realStoreList.end() ; ++iter) {
     cout << "RealVector " << *iter << " _nativeReal = " << (*iter)->_nativeReal << " = " << (*iter)->_nativeReal->GetName() << " bufptr = " << (*iter)->_buf  << endl ;
     cout << " values : " ;
-    Int_t imax = (*iter)->_vec.size()>10 ? 10 : (*iter)->_vec.size() ;
+    Int_t imax = (*iter)->size()>10 ? 10 : (*iter)->size() ;
     for (Int_t i=0 ; i<imax ; i++) {
-      cout << (*iter)->_vec[i] << " " ;
+      cout << (*iter)->_vec0[i] << " " ;
     }
     cout << endl ;
   }    
@@ -1453,9 +1515,9 @@ void RooVectorDataStore::dump()
 	 << " bufptr = " << (*iter2)->_buf  << " errbufptr = " << (*iter2)->_bufE << endl ;
 
     cout << " values : " ;
-    Int_t imax = (*iter2)->_vec.size()>10 ? 10 : (*iter2)->_vec.size() ;
+    Int_t imax = (*iter2)->size()>10 ? 10 : (*iter2)->size() ;
     for (Int_t i=0 ; i<imax ; i++) {
-      cout << (*iter2)->_vec[i] << " " ;
+      cout << (*iter2)->_vec0[i] << " " ;
     }
     cout << endl ;
     if ((*iter2)->_vecE) {
@@ -1514,6 +1576,7 @@ void RooVectorDataStore::RealVector::Streamer(TBuffer &R__b)
       R__b.ReadClassBuffer(RooVectorDataStore::RealVector::Class(),this);
       _vec0 = _vec.size()>0 ? &_vec.front() : 0 ;
    } else {
+      unshare() ;
       R__b.WriteClassBuffer(RooVectorDataStore::RealVector::Class(),this);
    }
 }
@@ -1533,6 +1596,7 @@ void RooVectorDataStore::RealFullVector::Streamer(TBuffer &R__b)
      if (_vecEL && _vecEL->empty()) { delete _vecEL ; _vecEL = 0 ; }
      if (_vecEH && _vecEH->empty()) { delete _vecEH ; _vecEH = 0 ; }
    } else {
+     unshare() ;
      R__b.WriteClassBuffer(RooVectorDataStore::RealFullVector::Class(),this);
    }
 }
@@ -1546,6 +1610,7 @@ void RooVectorDataStore::CatVector::Streamer(TBuffer &R__b)
       R__b.ReadClassBuffer(RooVectorDataStore::CatVector::Class(),this);
       _vec0 = _vec.size()>0 ? &_vec.front() : 0 ;
    } else {
+      unshare() ;
       R__b.WriteClassBuffer(RooVectorDataStore::CatVector::Class(),this);
    }
 }
@@ -12,6 +12,8 @@
 //               and using ">>+elist" in TTree::Draw
 //   - Test3() - transforming TEventList objects into TEntryList objects for a TChain
 //   - Test4() - same as Test3() but for a TTree 
+//   - Test5() - entry lists with very many or very few events
+//   - Test6() - intersecting entry lists, bulk iteration and range queries
 //
 //   To run in batch mode, do
 //     stressEntryList
@@ -31,6 +33,8 @@
 // Test2: Adding and subtracting entry lists-------------------------- OK
 // Test3: TEntryList and TEventList for TChain------------------------ OK
 // Test4: TEntryList and TEventList for TTree------------------------- OK
+// Test5: Full and Empty TEntryList----------------------------------- OK
+// Test6: Intersection, bulk iteration and ranges of TEntryList------- OK
 // **********************************************************************
 // *******************Deleting the data files****************************
 // **********************************************************************
@@ -511,6 +515,83 @@ Bool_t Test5()
       return kTRUE;
 }
 
+Bool_t Test6()
+{
+   //Test intersecting entry lists, TEntryList::NextEntries() and
+   //TEntryList::ContainsRange()
+
+   Int_t wrongentries1=0;
+   Int_t wrongentries2=0;
+   Int_t wrongentries3=0;
+   TChain *chain = new TChain("chain", "chain");
+   chain->Add("stressEntryListTrees*.root/tree1");
+   TCut cut1("cut1", "x>0");
+   TCut cut2("cut2", "y<0.1 && y>-0.1");
+   TEntryList *elist1 = new TEntryList("elist1", "elist1");
+   chain->Draw(">>elist1", cut1, "entrylist");
+   TEntryList *elist2 = new TEntryList("elist2", "elist2");
+   chain->Draw(">>elist2", cut2, "entrylist");
+   TEntryList *elistcheck = new TEntryList("elistcheck", "elistcheck");
+   chain->Draw(">>elistcheck", cut1 && cut2, "entrylist");
+
+   //intersect the 2 lists
+   TEntryList *elistand = new TEntryList("elistand", "elistand");
+   elistand->Add(elist1);
+   elistand->Intersect(elist2);
+   Long64_t n = elistcheck->GetN();
+   if (elistand->GetN() != n) wrongentries1++;
+   for (Int_t i=0; i<n; i++){
+      if (elistand->GetEntry(i) != elistcheck->GetEntry(i))
+         wrongentries1++;
+   }
+   if (wrongentries1>0)
+      printf("\nwrong entries after intersect = %d\n", wrongentries1);
+
+   //read the entries by batches
+   Long64_t batch[100];
+   Long64_t nread = 0;
+   batch[0] = elistand->GetEntry(0);
+   Int_t nbatch = 1 + elistand->NextEntries(99, batch+1);
+   while (nbatch > 0){
+      for (Int_t i=0; i<nbatch; i++){
+         if (batch[i] != elistcheck->GetEntry(nread+i))
+            wrongentries2++;
+      }
+      nread += nbatch;
+      nbatch = elistand->NextEntries(100, batch);
+   }
+   if (nread != n) wrongentries2++;
+   if (wrongentries2>0)
+      printf("\nwrong entries read by batches = %d\n", wrongentries2);
+
+   //ranges of entries of the first tree
+   TEntryList *sublist = elist1->GetEntryList("tree1", "stressEntryListTrees_0.root");
+   if (sublist){
+      Long64_t nentries = chain->GetEntries()/chain->GetNtrees();
+      for (Long64_t first=0; first<nentries; first+=7){
+         Long64_t last = first+2;
+         Bool_t contains = kFALSE;
+         for (Long64_t e=first; e<=last; e++)
+            if (sublist->Contains(e)) contains = kTRUE;
+         if (contains != sublist->ContainsRange(first, last))
+            wrongentries3++;
+      }
+   } else {
+      wrongentries3++;
+   }
+   if (wrongentries3>0)
+      printf("\nwrong ranges = %d\n", wrongentries3);
+
+   delete elist1;
+   delete elist2;
+   delete elistand;
+   delete elistcheck;
+   delete chain;
+   if (wrongentries1>0 || wrongentries2>0 || wrongentries3>0)
+      return kFALSE;
+   return kTRUE;
+}
+
 
 void MakeTrees(Int_t nentries, Int_t nfiles)
 {
@@ -578,6 +659,7 @@ Int_t stressEntryList(Int_t nentries, Int_t nfiles)
    Bool_t ok3=kTRUE;
    Bool_t ok4=kTRUE;
    Bool_t ok5=kTRUE;
+   Bool_t ok6=kTRUE;
 
    ok1 = Test1();
    if (ok1)
@@ -613,6 +695,12 @@ Int_t stressEntryList(Int_t nentries, Int_t nfiles)
    else
       printf("Test5: Full and Empty TEntryList----------------------------------- FAILED\n");
 
+   ok6 = Test6();
+   if (ok6)
+      printf("Test6: Intersection, bulk iteration and ranges of TEntryList------- OK\n");
+   else
+      printf("Test6: Intersection, bulk iteration and ranges of TEntryList------- FAILED\n");
+
    printf("**********************************************************************\n");
    printf("*******************Deleting the data files****************************\n");
    printf("**********************************************************************\n");
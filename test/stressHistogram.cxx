@@ -58,10 +58,14 @@
 
 #include <sstream>
 #include <cmath>
+#include <vector>
 
 #include "TH2.h"
 #include "TH3.h"
 #include "TH2.h"
+#include "TH2Poly.h"
+#include "TCutG.h"
+#include "TGraphErrors.h"
 #include "THn.h"
 #include "THnSparse.h"
 
@@ -87,6 +91,7 @@
 #include "TClass.h"
 
 #include "TROOT.h"
+#include "TThread.h"
 #include <algorithm>
 #include <cassert>
 
@@ -3593,6 +3598,118 @@ bool testMergeHn()
    return ret;
 }
 
+template <typename HIST>
+bool testMergeHnBase()
+{
+   // Tests the merge method for n-dim Histograms called through a THnBase
+   // pointer and through the merge function of the class, as hadd does
+
+   Int_t bsize[] = { TMath::Nint( r.Uniform(1, 5) ),
+                     TMath::Nint( r.Uniform(1, 5) ),
+                     TMath::Nint( r.Uniform(1, 5) )
+   };
+   Double_t xmin[] = {minRange, minRange, minRange};
+   Double_t xmax[] = {maxRange, maxRange, maxRange};
+
+   HIST* s1 = new HIST("mergeB-s1", "s1-Title", 3, bsize, xmin, xmax);
+   HIST* s2 = new HIST("mergeB-s2", "s2-Title", 3, bsize, xmin, xmax);
+   HIST* s3 = new HIST("mergeB-s3", "s3-Title", 3, bsize, xmin, xmax);
+   HIST* s4 = new HIST("mergeB-s4", "s4-Title", 3, bsize, xmin, xmax);
+
+   s1->Sumw2();s2->Sumw2();s3->Sumw2();
+
+   HIST* hists[3] = { s1, s2, s3 };
+   for ( Int_t k = 0; k < 3; ++k ) {
+      for ( Int_t e = 0; e < nEvents * nEvents; ++e ) {
+         Double_t points[3];
+         points[0] = r.Uniform( minRange * .9, maxRange * 1.1);
+         points[1] = r.Uniform( minRange * .9, maxRange * 1.1);
+         points[2] = r.Uniform( minRange * .9, maxRange * 1.1);
+         hists[k]->Fill(points, 1.0);
+         s4->Fill(points, 1.0);
+      }
+   }
+
+   TList *list = new TList;
+   list->Add(s2);
+   THnBase* base = s1;
+   base->Merge(list);
+
+   list->Clear();
+   list->Add(s3);
+   ROOT::MergeFunc_t merge = s1->IsA()->GetMerge();
+   if (merge) merge(s1, list, 0);
+   delete list;
+
+   bool ret = equals(TString::Format("MergeHnBase<%s>", HIST::Class()->GetName()), s1, s4, cmpOptNone, 1E-10);
+   ret |= (merge == 0);
+   delete s1;
+   delete s2;
+   delete s3;
+   return ret;
+}
+
+bool testMergeSparseWide()
+{
+   // Tests the merge method of THnSparse, through a THnBase pointer, for
+   // bins whose compact coordinates are longer than 8 bytes
+
+   const Int_t ndim = 10;
+   Int_t bsize[ndim];
+   Double_t xmin[ndim];
+   Double_t xmax[ndim];
+   for ( Int_t d = 0; d < ndim; ++d ) {
+      bsize[d] = 100;
+      xmin[d] = minRange;
+      xmax[d] = maxRange;
+   }
+
+   THnSparseD* s1 = new THnSparseD("mergeW-s1", "s1-Title", ndim, bsize, xmin, xmax);
+   THnSparseD* s2 = new THnSparseD("mergeW-s2", "s2-Title", ndim, bsize, xmin, xmax);
+   THnSparseD* s3 = new THnSparseD("mergeW-s3", "s3-Title", ndim, bsize, xmin, xmax);
+
+   // s2 gets some of the bins of s1 again, and others
+   std::vector<Double_t> points(ndim);
+   for ( Int_t e = 0; e < nEvents * 10; ++e ) {
+      for ( Int_t d = 0; d < ndim; ++d )
+         points[d] = r.Uniform( minRange, maxRange );
+      Double_t w = r.Uniform( 0.5, 2. );
+      s1->Fill(&points[0], w);
+      s3->Fill(&points[0], w);
+      if ( e % 3 == 0 ) {
+         s2->Fill(&points[0], w);
+         s3->Fill(&points[0], w);
+      }
+      for ( Int_t d = 0; d < ndim; ++d )
+         points[d] = r.Uniform( minRange, maxRange );
+      s2->Fill(&points[0], w);
+      s3->Fill(&points[0], w);
+   }
+
+   TList list;
+   list.Add(s2);
+   THnBase* base = s1;
+   base->Merge(&list);
+
+   int differents = 0;
+   if ( s1->GetNbins() != s3->GetNbins() ) ++differents;
+   std::vector<Int_t> coord(ndim);
+   for ( Long64_t i = 0; i < s3->GetNbins(); ++i ) {
+      Double_t v = s3->GetBinContent(i, &coord[0]);
+      Long64_t bin = s1->GetBin(&coord[0], kFALSE);
+      if ( bin < 0 ) ++differents;
+      else differents += equals(s1->GetBinContent(bin), v, 1E-10);
+   }
+   differents += equals(s1->GetEntries(), s3->GetEntries(), 1E-10);
+   if ( defaultEqualOptions & cmpOptPrint )
+      std::cout << "MergeSparseWide: \t" << (differents?"FAILED":"OK") << std::endl;
+
+   delete s1;
+   delete s2;
+   delete s3;
+   return differents;
+}
+
 bool testMerge1DLabelSame()
 {
    // Tests the merge with some equal labels method for 1D Histograms
@@ -7123,6 +7240,321 @@ bool testBinDataData3DInt()
    return status;
 }
 
+bool testTH2PolyCutG()
+{
+   // Tests filling a TH2Poly whose bins are a TGraph rectangle, a TCutG
+   // triangle and a TGraphErrors square
+
+   TH2Poly* h2p = new TH2Poly("th2p-cutg", "h2p-Title", minRange, maxRange, minRange, maxRange);
+   h2p->AddBin(minRange, minRange, 2, 2);
+   Double_t xc[4] = { 3, 5, 3, 3 };
+   Double_t yc[4] = { 1, 1, 3, 1 };
+   TCutG* cut = new TCutG("th2p-cut", 4, xc, yc);
+   h2p->AddBin(cut);
+   Double_t xe[5] = { 1, 2, 2, 1, 1 };
+   Double_t ye[5] = { 4, 4, 5, 5, 4 };
+   TGraphErrors* ge = new TGraphErrors(5, xe, ye);
+   h2p->AddBin(ge);
+
+   Double_t expected[3] = { 0, 0, 0 };
+   for ( Int_t e = 0; e < nEvents; ++e ) {
+      Double_t x = r.Uniform(minRange, maxRange);
+      Double_t y = r.Uniform(minRange, maxRange);
+      h2p->Fill(x, y);
+      if ( x >= minRange && x <= 2 && y >= minRange && y <= 2 ) expected[0] += 1;
+      else if ( TMath::IsInside(x, y, 4, xc, yc) ) expected[1] += 1;
+      else if ( TMath::IsInside(x, y, 5, xe, ye) ) expected[2] += 1;
+   }
+
+   int status = 0;
+   for ( Int_t bin = 1; bin <= 3; ++bin ) {
+      status += equals(h2p->GetBinContent(bin), expected[bin-1]);
+   }
+   status += h2p->FindBin(4, 1.5) != 2;
+   status += h2p->FindBin(1.5, 4.5) != 3;
+
+   delete h2p;
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testTH2PolyCutG: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
+const int nFillThreads = 4;
+
+struct TConcurrentFillArgs {
+   TH1* h1;              // histogram filled with x (or x,y if h2 is 0)
+   TH1* h2;              // histogram filled with y, alternately with h1
+   const Double_t* x;
+   const Double_t* y;
+   Int_t n;
+};
+
+void* ConcurrentFiller(void* arg)
+{
+   // Fills the histograms of arg from a thread
+
+   TConcurrentFillArgs* a = (TConcurrentFillArgs*) arg;
+   for ( Int_t e = 0; e < a->n; ++e ) {
+      if ( a->h2 ) {
+         a->h1->Fill(a->x[e]);
+         a->h2->Fill(a->y[e]);
+      } else {
+         a->h1->Fill(a->x[e], a->y[e]);
+      }
+   }
+   return 0;
+}
+
+int concurrentFill(TH1* c1, TH1* c2, TH1* s1, TH1* s2)
+{
+   // Fills c1 (and c2) from nFillThreads threads with SetConcurrentFill and
+   // s1 (and s2) serially with the same points. If c2 is 0, c1 is filled
+   // with (x,y), otherwise c1 with x and c2 with y, alternately.
+
+   TThread::Initialize();
+   const Int_t n = nFillThreads * nEvents;
+   std::vector<Double_t> x(n), y(n);
+   for ( Int_t e = 0; e < n; ++e ) {
+      x[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+      y[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+   }
+
+   c1->SetConcurrentFill(kTRUE, 100);
+   if ( c2 ) c2->SetConcurrentFill(kTRUE, 100);
+   TConcurrentFillArgs args[nFillThreads];
+   TThread* threads[nFillThreads];
+   for ( Int_t t = 0; t < nFillThreads; ++t ) {
+      args[t].h1 = c1;
+      args[t].h2 = c2;
+      args[t].x = &x[t * nEvents];
+      args[t].y = &y[t * nEvents];
+      args[t].n = nEvents;
+      threads[t] = new TThread(ConcurrentFiller, &args[t]);
+      threads[t]->Run();
+   }
+   for ( Int_t t = 0; t < nFillThreads; ++t ) {
+      threads[t]->Join();
+      delete threads[t];
+   }
+
+   TConcurrentFillArgs serial = { s1, s2, &x[0], &y[0], n };
+   ConcurrentFiller(&serial);
+
+   // The histograms must have been filled through the thread buffers
+   return ( c1->IsConcurrentFill() && (!c2 || c2->IsConcurrentFill()) ) ? 0 : 1;
+}
+
+bool testConcurrentFill1D()
+{
+   // Tests filling two 1D histograms from several threads at the same time
+
+   TH1D* c1 = new TH1D("cf1D-c1", "c1-Title", numberOfBins, minRange, maxRange);
+   TH1D* c2 = new TH1D("cf1D-c2", "c2-Title", numberOfBins, minRange, maxRange);
+   TH1D* s1 = new TH1D("cf1D-s1", "s1-Title", numberOfBins, minRange, maxRange);
+   TH1D* s2 = new TH1D("cf1D-s2", "s2-Title", numberOfBins, minRange, maxRange);
+
+   int status = concurrentFill(c1, c2, s1, s2);
+   status += equals("Concurrent Fill Hist 1D", c1, s1, cmpOptStats);
+   status += equals("Concurrent Fill Hist 1D", c2, s2, cmpOptStats);
+
+   delete c1;
+   delete c2;
+   delete s1;
+   delete s2;
+   return status;
+}
+
+bool testConcurrentFill2D()
+{
+   // Tests filling a 2D histogram from several threads at the same time
+
+   TH2D* c1 = new TH2D("cf2D-c1", "c1-Title", numberOfBins, minRange, maxRange,
+                                              numberOfBins, minRange, maxRange);
+   TH2D* s1 = new TH2D("cf2D-s1", "s1-Title", numberOfBins, minRange, maxRange,
+                                              numberOfBins, minRange, maxRange);
+
+   int status = concurrentFill(c1, 0, s1, 0);
+   status += equals("Concurrent Fill Hist 2D", c1, s1, cmpOptStats);
+
+   delete c1;
+   delete s1;
+   return status;
+}
+
+bool testConcurrentFillProfile()
+{
+   // Tests filling a profile from several threads at the same time
+
+   TProfile* c1 = new TProfile("cfProf-c1", "c1-Title", numberOfBins, minRange, maxRange);
+   TProfile* s1 = new TProfile("cfProf-s1", "s1-Title", numberOfBins, minRange, maxRange);
+
+   int status = concurrentFill(c1, 0, s1, 0);
+   status += equals("Concurrent Fill Profile", c1, s1, cmpOptStats);
+
+   delete c1;
+   delete s1;
+   return status;
+}
+
+int findFixBins(const TAxis* axis)
+{
+   // Compares the bins found by TAxis::FindFixBins with the ones of
+   // FindFixBin, for random abscissas, the bin edges, the underflows and the
+   // overflows, with a stride of 1 and of 2
+
+   const Int_t nbins = axis->GetNbins();
+   std::vector<Double_t> x;
+   for ( Int_t e = 0; e < nEvents; ++e )
+      x.push_back( r.Uniform(axis->GetXmin() - 1, axis->GetXmax() + 1) );
+   for ( Int_t i = 1; i <= nbins + 1; ++i )
+      x.push_back( axis->GetBinLowEdge(i) );
+   x.push_back( -1E300 );
+   x.push_back( 1E300 );
+
+   int status = 0;
+   const Int_t n = x.size();
+   std::vector<Int_t> bins(n);
+   for ( Int_t stride = 1; stride <= 2; ++stride ) {
+      const Int_t nx = (n + stride - 1) / stride;
+      axis->FindFixBins(nx, &x[0], &bins[0], stride);
+      for ( Int_t i = 0; i < nx; ++i ) {
+         if ( bins[i] != axis->FindFixBin(x[i*stride]) ) {
+            if ( defaultEqualOptions & cmpOptPrint )
+               std::cout << "FindFixBins: x = " << x[i*stride] << " bin " << bins[i]
+                         << " instead of " << axis->FindFixBin(x[i*stride]) << std::endl;
+            status += 1;
+         }
+      }
+   }
+   return status;
+}
+
+bool testFindFixBins()
+{
+   // Tests TAxis::FindFixBins for fix and variable bin sizes, with few and
+   // many bins
+
+   Double_t v[numberOfBins+1];
+   FillVariableRange(v);
+   std::vector<Double_t> v1000(1001);
+   v1000[0] = minRange;
+   for ( Int_t i = 1; i <= 1000; ++i )
+      v1000[i] = v1000[i-1] + r.Uniform(0.001, 0.01);
+
+   TAxis fix(numberOfBins, minRange, maxRange);
+   TAxis fix1000(1000, minRange, maxRange);
+   TAxis var(numberOfBins, v);
+   TAxis var1000(1000, &v1000[0]);
+
+   int status = findFixBins(&fix);
+   status += findFixBins(&fix1000);
+   status += findFixBins(&var);
+   status += findFixBins(&var1000);
+   return status;
+}
+
+bool testFillN1D()
+{
+   // Tests that TH1::FillN fills fix and variable bin histograms as Fill does,
+   // with and without weights
+
+   Double_t v[numberOfBins+1];
+   FillVariableRange(v);
+
+   TH1D* h1 = new TH1D("fn1D-h1", "h1-Title", numberOfBins, minRange, maxRange);
+   TH1D* h2 = new TH1D("fn1D-h2", "h2-Title", numberOfBins, minRange, maxRange);
+   TH1D* h3 = new TH1D("fn1D-h3", "h3-Title", numberOfBins, v);
+   TH1D* h4 = new TH1D("fn1D-h4", "h4-Title", numberOfBins, v);
+   TH1D* h5 = new TH1D("fn1D-h5", "h5-Title", numberOfBins, v);
+   TH1D* h6 = new TH1D("fn1D-h6", "h6-Title", numberOfBins, v);
+
+   std::vector<Double_t> x(2*nEvents), w(2*nEvents);
+   for ( Int_t e = 0; e < 2*nEvents; ++e ) {
+      x[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+      w[e] = r.Uniform(0.1, 2);
+   }
+   for ( Int_t e = 0; e < nEvents; ++e ) {
+      h1->Fill(x[2*e], w[2*e]);
+      h3->Fill(x[2*e], w[2*e]);
+      h5->Fill(x[e]);
+   }
+   h2->FillN(nEvents, &x[0], &w[0], 2);
+   h4->FillN(nEvents, &x[0], &w[0], 2);
+   h6->FillN(nEvents, &x[0], 0);
+
+   int status = equals("FillN Hist 1D", h1, h2, cmpOptStats);
+   status += equals("FillN Variable Hist 1D", h3, h4, cmpOptStats);
+   status += equals("FillN Variable Hist 1D no weights", h5, h6, cmpOptStats);
+
+   delete h1;
+   delete h2;
+   delete h3;
+   delete h4;
+   delete h5;
+   delete h6;
+   return status;
+}
+
+bool testFillN2D()
+{
+   // Tests that TH2::FillN fills a histogram with variable bins in x as Fill
+   // does
+
+   Double_t v[numberOfBins+1];
+   FillVariableRange(v);
+
+   TH2D* h1 = new TH2D("fn2D-h1", "h1-Title", numberOfBins, v,
+                                              numberOfBins + 2, minRange, maxRange);
+   TH2D* h2 = new TH2D("fn2D-h2", "h2-Title", numberOfBins, v,
+                                              numberOfBins + 2, minRange, maxRange);
+
+   std::vector<Double_t> x(nEvents), y(nEvents), w(nEvents);
+   for ( Int_t e = 0; e < nEvents; ++e ) {
+      x[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+      y[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+      w[e] = r.Uniform(0.1, 2);
+      h1->Fill(x[e], y[e], w[e]);
+   }
+   h2->FillN(nEvents, &x[0], &y[0], &w[0]);
+
+   int status = equals("FillN Hist 2D", h1, h2, cmpOptStats);
+
+   delete h1;
+   delete h2;
+   return status;
+}
+
+bool testFillN3D()
+{
+   // Tests that TH3::FillN fills a histogram as Fill does
+
+   Double_t v[numberOfBins+1];
+   FillVariableRange(v);
+
+   TH3D* h1 = new TH3D("fn3D-h1", "h1-Title", numberOfBins, minRange, maxRange,
+                                              numberOfBins + 1, minRange, maxRange,
+                                              numberOfBins + 2, minRange, maxRange);
+   TH3D* h2 = new TH3D("fn3D-h2", "h2-Title", numberOfBins, minRange, maxRange,
+                                              numberOfBins + 1, minRange, maxRange,
+                                              numberOfBins + 2, minRange, maxRange);
+
+   std::vector<Double_t> x(nEvents), y(nEvents), z(nEvents), w(nEvents);
+   for ( Int_t e = 0; e < nEvents; ++e ) {
+      x[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+      y[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+      z[e] = r.Uniform(0.9 * minRange, 1.1 * maxRange);
+      w[e] = r.Uniform(0.1, 2);
+      h1->Fill(x[e], y[e], z[e], w[e]);
+   }
+   h2->FillN(nEvents, &x[0], &y[0], &z[0], &w[0]);
+
+   int status = equals("FillN Hist 3D", h1, h2, cmpOptStats);
+
+   delete h1;
+   delete h2;
+   return status;
+}
+
 bool testRefRead1D()
 {
    // Tests consistency with a reference file for 1D Histogram
@@ -9328,12 +9760,14 @@ int stressHistogram()
 
    // Test 10
    // Merge Tests
-   const unsigned int numberOfMerge = 43;
+   const unsigned int numberOfMerge = 46;
    pointer2Test mergeTestPointer[numberOfMerge] = { testMerge1D,                 testMergeProf1D,
                                                     testMergeVar1D,              testMergeProfVar1D,
                                                     testMerge2D,                 testMergeProf2D,
                                                     testMerge3D,                 testMergeProf3D,
                                                     testMergeHn<THnD>,           testMergeHn<THnSparseD>,
+                                                    testMergeHnBase<THnD>,       testMergeHnBase<THnSparseD>,
+                                                    testMergeSparseWide,
                                                     testMerge1DLabelSame,        testMergeProf1DLabelSame,
                                                     testMerge2DLabelSame,        testMergeProf2DLabelSame,
                                                     testMerge3DLabelSame,        testMergeProf3DLabelSame,
@@ -9429,8 +9863,40 @@ int stressHistogram()
                                            fillDataTestPointer };
 
 
+   // Test 17
+   // TH2Poly Tests
+   const unsigned int numberOfPoly = 1;
+   pointer2Test polyTestPointer[numberOfPoly] = { testTH2PolyCutG
+   };
+   struct TTestSuite polyTestSuite = { numberOfPoly,
+                                       "TH2Poly Fill tests...............................................",
+                                       polyTestPointer };
+
+   // Test 18
+   // Concurrent Fill Tests
+   const unsigned int numberOfConcurrent = 3;
+   pointer2Test concurrentTestPointer[numberOfConcurrent] = { testConcurrentFill1D,
+                                                              testConcurrentFill2D,
+                                                              testConcurrentFillProfile
+   };
+   struct TTestSuite concurrentTestSuite = { numberOfConcurrent,
+                                             "Concurrent Fill tests from several threads.......................",
+                                             concurrentTestPointer };
+
+   // Test 19
+   // FillN Tests
+   const unsigned int numberOfFillN = 4;
+   pointer2Test fillNTestPointer[numberOfFillN] = { testFindFixBins,
+                                                    testFillN1D,
+                                                    testFillN2D,
+                                                    testFillN3D
+   };
+   struct TTestSuite fillNTestSuite = { numberOfFillN,
+                                        "FillN and FindFixBins tests......................................",
+                                        fillNTestPointer };
+
    // Combination of tests
-   const unsigned int numberOfSuits = 14;
+   const unsigned int numberOfSuits = 17;
    struct TTestSuite* testSuite[numberOfSuits];
    testSuite[ 0] = &rangeTestSuite;
    testSuite[ 1] = &rebinTestSuite;
@@ -9446,6 +9912,9 @@ int stressHistogram()
    testSuite[11] = &integralTestSuite;
    testSuite[12] = &conversionsTestSuite;
    testSuite[13] = &fillDataTestSuite;
+   testSuite[14] = &polyTestSuite;
+   testSuite[15] = &concurrentTestSuite;
+   testSuite[16] = &fillNTestSuite;
 
    status = 0;
    for ( unsigned int i = 0; i < numberOfSuits; ++i ) {
@@ -9460,7 +9929,7 @@ int stressHistogram()
    }
    GlobalStatus += status;
 
-   // Test 17
+   // Test 20
    // Reference Tests
    const unsigned int numberOfRefRead = 7;
    pointer2Test refReadTestPointer[numberOfRefRead] = { testRefRead1D,  testRefReadProf1D,
@@ -6453,3 +6453,236 @@ public:
   }
 } ;
 
+
+
+
+
+/////////////////////////////////////////////////////////////////////////
+//
+// Batch evaluation of the likelihood
+// 
+// Compares the likelihood of p.d.f.s that are evaluated for blocks of
+// events (dataset in a RooVectorDataStore) with the event by event
+// calculation (same events in a RooTreeDataStore), including a p.d.f.
+// depending on a category
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef __CINT__
+#include "RooGlobalFunc.h"
+#endif
+#include "RooRealVar.h"
+#include "RooDataSet.h"
+#include "RooGaussian.h"
+#include "RooExponential.h"
+#include "RooPolynomial.h"
+#include "RooAddPdf.h"
+#include "RooProdPdf.h"
+#include "RooCategory.h"
+#include "RooSimultaneous.h"
+
+using namespace RooFit ;
+
+
+class TestBasic901 : public RooUnitTest
+{
+public: 
+  TestBasic901(TFile* refFile, Bool_t writeRef, Int_t verbose) : RooUnitTest("Batch evaluation of the likelihood",refFile,writeRef,verbose) {} ;
+
+  Bool_t compareNLL(const char* what, RooAbsPdf& pdf, const RooArgSet& obs) {
+
+    // Generate the events in the default vector store, which is evaluated in batches,
+    // and copy them to a tree store, which is evaluated event by event
+    RooDataSet* data = pdf.generate(obs,5000) ;
+    RooAbsData::setDefaultStorageType(RooAbsData::Tree) ;
+    RooDataSet tdata("tdata","tdata",obs) ;
+    RooAbsData::setDefaultStorageType(RooAbsData::Vector) ;
+    tdata.append(*data) ;
+
+    RooAbsReal* nllBatch = pdf.createNLL(*data) ;
+    RooAbsReal* nllEvent = pdf.createNLL(tdata) ;
+
+    // Compare at the generated values and at the fitted values of the parameters
+    Bool_t ok(kTRUE) ;
+    for (Int_t i=0 ; i<2 ; i++) {
+      if (i==1) pdf.fitTo(*data,PrintLevel(-1)) ;
+      Double_t vBatch = nllBatch->getVal() ;
+      Double_t vEvent = nllEvent->getVal() ;
+      if (fabs(vBatch-vEvent) > 1e-10*fabs(vEvent)) {
+	cout << "TestBasic901: " << what << ": batch NLL " << vBatch << " differs from event by event NLL " << vEvent << endl ;
+	ok = kFALSE ;
+      }
+    }
+
+    delete nllBatch ;
+    delete nllEvent ;
+    delete data ;
+    return ok ;
+  }
+
+  Bool_t testCode() {
+
+  RooRealVar x("x","x",-10,10) ;
+  RooRealVar y("y","y",0,10) ;
+
+  RooRealVar m("m","m",1,-10,10) ;
+  RooRealVar s("s","s",2,0.1,10) ;
+  RooGaussian g("g","g",x,m,s) ;
+
+  RooRealVar c("c","c",-0.2,-5.,0.) ;
+  RooExponential e("e","e",x,c) ;
+
+  RooRealVar a1("a1","a1",0.01,-0.05,0.05) ;
+  RooRealVar a2("a2","a2",0.002,0,0.01) ;
+  RooPolynomial p("p","p",x,RooArgList(a1,a2)) ;
+
+  RooRealVar f("f","f",0.4,0.,1.) ;
+  RooAddPdf sum("sum","sum",RooArgList(g,p),f) ;
+
+  RooRealVar cy("cy","cy",-0.3,-5.,0.) ;
+  RooExponential ey("ey","ey",y,cy) ;
+  RooProdPdf prod("prod","prod",RooArgSet(g,ey)) ;
+
+  // Categories are not evaluated in batches, but must give the same likelihood
+  RooCategory cat("cat","cat") ;
+  cat.defineType("A") ;
+  cat.defineType("B") ;
+  RooRealVar mB("mB","mB",-2,-10,10) ;
+  RooGaussian gB("gB","gB",x,mB,s) ;
+  RooSimultaneous sim("sim","sim",cat) ;
+  sim.addPdf(g,"A") ;
+  sim.addPdf(gB,"B") ;
+
+  Bool_t ok(kTRUE) ;
+  ok &= compareNLL("RooGaussian",g,x) ;
+  ok &= compareNLL("RooExponential",e,x) ;
+  ok &= compareNLL("RooPolynomial",p,x) ;
+  ok &= compareNLL("RooAddPdf",sum,x) ;
+  ok &= compareNLL("RooProdPdf",prod,RooArgSet(x,y)) ;
+  ok &= compareNLL("RooSimultaneous",sim,RooArgSet(x,cat)) ;
+
+  return ok ;
+  }
+} ;
+
+
+
+
+/////////////////////////////////////////////////////////////////////////
+//
+// Likelihood calculation in threads
+// 
+// Compares the likelihood and the fit result obtained with NumThreads()
+// with those obtained with NumCPU() and with the serial calculation
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef __CINT__
+#include "RooGlobalFunc.h"
+#endif
+#include "RooRealVar.h"
+#include "RooDataSet.h"
+#include "RooGaussian.h"
+#include "RooExponential.h"
+#include "RooAddPdf.h"
+#include "RooFitResult.h"
+
+using namespace RooFit ;
+
+
+class TestBasic902 : public RooUnitTest
+{
+public: 
+  TestBasic902(TFile* refFile, Bool_t writeRef, Int_t verbose) : RooUnitTest("Likelihood calculation in threads",refFile,writeRef,verbose) {} ;
+
+  // Forked processes and threads are not available on Windows
+  Bool_t isTestAvailable() { 
+#ifdef _WIN32
+    return kFALSE ;
+#else
+    return kTRUE ;
+#endif
+  }
+
+  Bool_t compareValues(const char* what, Double_t val, Double_t ref, Double_t tol) {
+    if (fabs(val-ref) <= tol*fabs(ref)) return kTRUE ;
+    cout << "TestBasic902: " << what << ": " << val << " differs from " << ref << endl ;
+    return kFALSE ;
+  }
+
+  Bool_t testCode() {
+
+  RooRealVar x("x","x",-10,10) ;
+
+  RooRealVar m("m","m",1,-10,10) ;
+  RooRealVar s("s","s",2,0.1,10) ;
+  RooGaussian g("g","g",x,m,s) ;
+
+  RooRealVar c("c","c",-0.2,-5.,0.) ;
+  RooExponential e("e","e",x,c) ;
+
+  RooRealVar f("f","f",0.4,0.,1.) ;
+  RooAddPdf sum("sum","sum",RooArgList(g,e),f) ;
+
+  RooDataSet* data = sum.generate(x,10000) ;
+
+  Bool_t ok(kTRUE) ;
+
+  // C o m p a r e   t h e   l i k e l i h o o d s
+  // ---------------------------------------------
+
+  for (Int_t strat=0 ; strat<2 ; strat++) {
+
+    RooAbsReal* nllSerial  = sum.createNLL(*data) ;
+    RooAbsReal* nllCPU     = sum.createNLL(*data,NumCPU(3,strat)) ;
+    RooAbsReal* nllThreads = sum.createNLL(*data,NumThreads(3,strat)) ;
+
+    // At the generated values and after changing the parameters
+    for (Int_t i=0 ; i<2 ; i++) {
+      if (i==1) {
+	m.setVal(0.5) ;
+	s.setVal(2.5) ;
+	c.setVal(-0.1) ;
+	f.setVal(0.3) ;
+      }
+      Double_t vSerial  = nllSerial->getVal() ;
+      Double_t vCPU     = nllCPU->getVal() ;
+      Double_t vThreads = nllThreads->getVal() ;
+      ok &= compareValues("NLL with NumThreads vs NumCPU",vThreads,vCPU,1e-12) ;
+      ok &= compareValues("NLL with NumThreads vs serial",vThreads,vSerial,1e-10) ;
+    }
+    m.setVal(1) ;
+    s.setVal(2) ;
+    c.setVal(-0.2) ;
+    f.setVal(0.4) ;
+
+    delete nllSerial ;
+    delete nllCPU ;
+    delete nllThreads ;
+  }
+
+  // C o m p a r e   t h e   f i t   r e s u l t s
+  // ---------------------------------------------
+
+  RooArgSet* params = sum.getParameters(x) ;
+  RooArgSet* init = (RooArgSet*) params->snapshot() ;
+
+  RooFitResult* rSerial = sum.fitTo(*data,Save(),PrintLevel(-1)) ;
+  *params = *init ;
+  RooFitResult* rCPU = sum.fitTo(*data,Save(),PrintLevel(-1),NumCPU(3)) ;
+  *params = *init ;
+  RooFitResult* rThreads = sum.fitTo(*data,Save(),PrintLevel(-1),NumThreads(3)) ;
+
+  ok &= rThreads->isIdentical(*rCPU,1e-10) ;
+  ok &= rThreads->isIdentical(*rSerial,1e-4,1e-3) ;
+
+  delete rSerial ;
+  delete rCPU ;
+  delete rThreads ;
+  delete init ;
+  delete params ;
+  delete data ;
+
+  return ok ;
+  }
+} ;
@@ -0,0 +1,836 @@
+/////////////////////////////////////////////////////////////////
+//
+//___A stress test for the reading and querying of TTree___
+//
+//   The functions below check that the faster ways of reading
+//   and querying a TTree give the same results as the usual ones
+//   - Test1() - asynchronous prefetching of the clusters with look-ahead
+//   - Test2() - TTreeIndex built with one and several threads
+//   - Test3() - TTreeIndex written and read back, compact or not
+//   - Test4() - TTree::Draw with and without a zone map
+//   - Test5() - TTreeFormula compiled and interpreted, with arrays
+//   - Test6() - TFileMerger with groups of files merged by threads
+//   - Test7() - TTree written with baskets compressed by threads
+//   - Test8() - TTreeCache branches learned, saved and loaded back
+//   - Test9() - TChainIndex built with one and several threads
+//   - Test10() - TTreeCacheUnzip with baskets unzipped by the thread pool
+//   - Test11() - TBranch::GetBulkEntries compared with TBranch::GetEntry
+//
+//   To run in batch mode, do
+//     stressTree
+//     stressTree 1000
+//   Here the parameter is the number of entries in the TTree.
+//   The default value is 50000.
+//
+//   An example of output when all tests pass:
+// **********************************************************************
+// ******************Starting TTree stress test**************************
+// **********************************************************************
+// Test1: Prefetching clusters ahead with a small read list------------ OK
+// Test2: TTreeIndex built with one and several threads---------------- OK
+// Test3: Writing and reading compact and plain TTreeIndex------------- OK
+// Test4: Selecting the entries with and without a zone map------------ OK
+// Test5: Evaluating formulas compiled and interpreted----------------- OK
+// Test6: Merging groups of files with several threads----------------- OK
+// Test7: Writing baskets compressed with one and several threads------ OK
+// Test8: Saving and loading the branches learned by the cache--------- OK
+// Test9: TChainIndex built with one and several threads--------------- OK
+// Test10: Reading two trees with the shared unzip thread pool--------- OK
+// Test11: Reading the entries of basic branches in bulk--------------- OK
+// **********************************************************************
+// ******************Deleting the data file******************************
+// **********************************************************************
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include "TApplication.h"
+#include "TChain.h"
+#include "TChainIndex.h"
+#include "TEnv.h"
+#include "TFile.h"
+#include "TFileCacheRead.h"
+#include "TFileMerger.h"
+#include "TH1.h"
+#include "TRandom.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "TTreeCache.h"
+#include "TTreeCacheUnzip.h"
+#include "TTreeFormula.h"
+#include "TTreeIndex.h"
+
+Int_t stressTree(Int_t nentries = 50000);
+
+const char *kStressTreeFile = "stressTree.root";
+
+Bool_t Test1()
+{
+   // Read the tree with asynchronous prefetching and one cluster requested
+   // ahead: the read list is then 3 blocks only, and the blocks read ahead
+   // must not be recycled before the entries they hold are read.
+
+   Int_t lookAhead = gEnv->GetValue("TFile.AsyncPrefetchLookAhead", 2);
+   gEnv->SetValue("TFile.AsyncPrefetchLookAhead", 1);
+
+   TFile *f = TFile::Open(kStressTreeFile);
+   TTree *tree = 0;
+   f->GetObject("tree", tree);
+   tree->SetCacheSize(100000);
+   tree->AddBranchToCache("*", kTRUE);
+   tree->StopCacheLearningPhase();
+   TFileCacheRead *cache = f->GetCacheRead(tree);
+   if (cache) cache->SetEnablePrefetching(kTRUE);
+
+   Int_t i, k;
+   Double_t x;
+   tree->SetBranchAddress("i", &i);
+   tree->SetBranchAddress("k", &k);
+   tree->SetBranchAddress("x", &x);
+   Bool_t ok = cache != 0;
+   Long64_t nentries = tree->GetEntries();
+   for (Long64_t entry = 0; ok && entry < nentries; entry++) {
+      if (tree->GetEntry(entry) <= 0 || i != entry || k != (Int_t)(entry / 3))
+         ok = kFALSE;
+   }
+   delete f;
+
+   gEnv->SetValue("TFile.AsyncPrefetchLookAhead", lookAhead);
+   return ok;
+}
+
+Bool_t Test2()
+{
+   // Build an index with many equal values serially and with 2 and 4
+   // threads (the sort is done in parallel with 2 threads for more than
+   // 20000 entries): the entries must be in the same order.
+
+   TFile *f = TFile::Open(kStressTreeFile);
+   TTree *tree = 0;
+   f->GetObject("tree", tree);
+   Int_t nthreads = TTree::GetImplicitMT();
+
+   TTree::SetImplicitMT(0);
+   TTreeIndex *serial = new TTreeIndex(tree, "k%100", "k%7");
+   Bool_t ok = !serial->IsZombie() && serial->GetN() == tree->GetEntries();
+   for (Int_t n = 2; ok && n <= 4; n += 2) {
+      TTree::SetImplicitMT(n);
+      TTreeIndex *parallel = new TTreeIndex(tree, "k%100", "k%7");
+      ok = !parallel->IsZombie() && parallel->GetN() == serial->GetN();
+      for (Long64_t i = 0; ok && i < serial->GetN(); i++) {
+         if (parallel->GetIndex()[i] != serial->GetIndex()[i] ||
+             parallel->GetIndexValues()[i] != serial->GetIndexValues()[i])
+            ok = kFALSE;
+      }
+      delete parallel;
+   }
+   // Equal values are in the order of the entries
+   for (Long64_t i = 1; ok && i < serial->GetN(); i++) {
+      if (serial->GetIndexValues()[i] == serial->GetIndexValues()[i-1] &&
+          serial->GetIndex()[i] < serial->GetIndex()[i-1])
+         ok = kFALSE;
+   }
+   TTree::SetImplicitMT(nthreads);
+   delete serial;
+   delete f;
+   return ok;
+}
+
+Bool_t Test3()
+{
+   // Write an index with negative and extreme values, whose differences do
+   // not fit in a Long64_t, in the plain and compact formats and read it
+   // back.
+
+   TFile *f = new TFile("stressTreeIndex.root", "RECREATE");
+   TTree *tree = new TTree("tree", "tree");
+   Int_t major, minor;
+   tree->Branch("major", &major, "major/I");
+   tree->Branch("minor", &minor, "minor/I");
+   const Int_t nvalues = 7;
+   Int_t values[nvalues] = { -2147483647-1, -2147483647, -65536, -1, 0, 1, 2147483647 };
+   for (Int_t i = 0; i < 1000; i++) {
+      major = values[gRandom->Integer(nvalues)];
+      minor = values[gRandom->Integer(nvalues)];
+      tree->Fill();
+   }
+   TTreeIndex *index = new TTreeIndex(tree, "major", "minor");
+   index->Write("plain");
+   index->SetCompact();
+   index->Write("compact");
+   std::vector<Long64_t> entries(index->GetIndex(), index->GetIndex() + index->GetN());
+   std::vector<Long64_t> indexValues(index->GetIndexValues(), index->GetIndexValues() + index->GetN());
+   delete index;
+   delete f;
+
+   f = TFile::Open("stressTreeIndex.root");
+   Bool_t ok = kTRUE;
+   const char *names[2] = { "plain", "compact" };
+   for (Int_t k = 0; ok && k < 2; k++) {
+      TTreeIndex *read = 0;
+      f->GetObject(names[k], read);
+      ok = read && read->GetN() == (Long64_t)entries.size() && read->IsCompact() == (k == 1);
+      for (Long64_t i = 0; ok && i < read->GetN(); i++) {
+         if (read->GetIndex()[i] != entries[i] || read->GetIndexValues()[i] != indexValues[i])
+            ok = kFALSE;
+      }
+      delete read;
+   }
+   delete f;
+   gSystem->Unlink("stressTreeIndex.root");
+   return ok;
+}
+
+Bool_t Test4()
+{
+   // Select entries with TTree::Draw, then build a zone map and select them
+   // again: the clusters skipped thanks to the zone map must not hold any
+   // selected entry. The branch named inf must not be taken for a number,
+   // and i&4!=0 is i&(4!=0), not a bit test.
+
+   TFile *f = TFile::Open(kStressTreeFile);
+   TTree *tree = 0;
+   f->GetObject("tree", tree);
+   const Int_t nsel = 9;
+   const char *selections[nsel] = { "k==1234", "k>10000 && i<40000", "x>25", "(i&0x4)",
+                                    "k>inf", "inf<k && k<=200", "x<1e1 && k>=2e3", "i!=0 && inf==7",
+                                    "i&4!=0" };
+   Long64_t counts[nsel];
+   for (Int_t s = 0; s < nsel; s++)
+      counts[s] = tree->Draw("i", selections[s], "goff");
+   Bool_t ok = tree->BuildZoneMap("i:k:x:inf") == 1;
+   for (Int_t s = 0; ok && s < nsel; s++) {
+      if (tree->Draw("i", selections[s], "goff") != counts[s])
+         ok = kFALSE;
+   }
+   delete f;
+   return ok;
+}
+
+Bool_t Test5()
+{
+   // Evaluate formulas on a tree with a variable size and a fixed size
+   // array, interpreted and compiled by the interpreter JIT: all the
+   // instances must have the same values.
+
+   TTree *tree = new TTree("arrays", "arrays");
+   tree->SetDirectory(0);
+   Int_t i, n;
+   Float_t a[10];
+   Double_t b[3], x;
+   tree->Branch("i", &i, "i/I");
+   tree->Branch("x", &x, "x/D");
+   tree->Branch("n", &n, "n/I");
+   tree->Branch("a", a, "a[n]/F");
+   tree->Branch("b", b, "b[3]/D");
+   for (Int_t entry = 0; entry < 2000; entry++) {
+      i = entry;
+      x = gRandom->Gaus(0, 10);
+      n = gRandom->Integer(10);
+      for (Int_t j = 0; j < n; j++) a[j] = gRandom->Uniform(-5, 5);
+      for (Int_t j = 0; j < 3; j++) b[j] = gRandom->Gaus(j, 1);
+      tree->Fill();
+   }
+
+   const Int_t nformulas = 12;
+   const char *expressions[nformulas] = {
+      "i*2+x", "sqrt(abs(x))+sin(i)", "a", "a*b[1]", "a[2]+i", "b[i%3]",
+      "Sum$(a)", "Max$(a)-Min$(a)", "n>2 && a[0]>0", "x>0 ? b[0] : -b[2]",
+      "(i&3)==1 || x<0", "a+b" };
+   Bool_t jit = TTreeFormula::IsJitEnabled();
+   Bool_t ok = kTRUE;
+   for (Int_t f = 0; ok && f < nformulas; f++) {
+      TTreeFormula::SetJit(kFALSE);
+      TTreeFormula *interpreted = new TTreeFormula("interpreted", expressions[f], tree);
+      TTreeFormula::SetJit(kTRUE);
+      TTreeFormula *compiled = new TTreeFormula("compiled", expressions[f], tree);
+      ok = interpreted->GetNdim() > 0 && compiled->GetNdim() > 0;
+      for (Long64_t entry = 0; ok && entry < tree->GetEntries(); entry++) {
+         tree->LoadTree(entry);
+         Int_t ndata = interpreted->GetNdata();
+         if (compiled->GetNdata() != ndata) ok = kFALSE;
+         for (Int_t j = 0; ok && j < ndata; j++) {
+            Double_t vi = interpreted->EvalInstance(j);
+            Double_t vc = compiled->EvalInstance(j);
+            if (fabs(vi - vc) > 1e-12 * (fabs(vi) > 1 ? fabs(vi) : 1)) ok = kFALSE;
+         }
+      }
+      if (!ok) printf("Test5: %s differs once compiled\n", expressions[f]);
+      delete interpreted;
+      delete compiled;
+   }
+   TTreeFormula::SetJit(jit);
+   delete tree;
+   return ok;
+}
+
+Bool_t MergeFiles(const char *output, Int_t nfiles, Int_t nthreads)
+{
+   // Merge the files written by Test6 with the given number of threads.
+
+   TFileMerger merger(kFALSE);
+   merger.SetNThreads(nthreads);
+   merger.SetPrintLevel(0);
+   for (Int_t n = 0; n < nfiles; n++)
+      merger.AddFile(Form("stressTreeMerge%d.root", n), kFALSE);
+   return merger.OutputFile(output, "RECREATE") && merger.Merge();
+}
+
+Bool_t Test6()
+{
+   // Merge files holding a tree and a histogram sequentially and with
+   // 3 threads: the merged trees must have the same entries in the same
+   // order, and the merged histograms the same contents.
+
+   const Int_t nfiles = 7;
+   for (Int_t n = 0; n < nfiles; n++) {
+      TFile *f = new TFile(Form("stressTreeMerge%d.root", n), "RECREATE");
+      TTree *tree = new TTree("tree", "tree");
+      TH1F *h = new TH1F("h", "h", 100, -50, 50);
+      Int_t i;
+      Double_t x;
+      tree->Branch("i", &i, "i/I");
+      tree->Branch("x", &x, "x/D");
+      for (Int_t entry = 0; entry < 1000 + 100 * n; entry++) {
+         i = 10000 * n + entry;
+         x = gRandom->Gaus(0, 10);
+         h->Fill(x);
+         tree->Fill();
+      }
+      f->Write();
+      delete f;
+   }
+
+   Bool_t ok = MergeFiles("stressTreeMergeSeq.root", nfiles, 0) &&
+               MergeFiles("stressTreeMergePar.root", nfiles, 3);
+   TFile *fseq = TFile::Open("stressTreeMergeSeq.root");
+   TFile *fpar = TFile::Open("stressTreeMergePar.root");
+   TTree *tseq = 0, *tpar = 0;
+   TH1F *hseq = 0, *hpar = 0;
+   if (ok && fseq && fpar) {
+      fseq->GetObject("tree", tseq);
+      fpar->GetObject("tree", tpar);
+      fseq->GetObject("h", hseq);
+      fpar->GetObject("h", hpar);
+   }
+   ok = tseq && tpar && hseq && hpar && tseq->GetEntries() == tpar->GetEntries() &&
+        hseq->GetEntries() == hpar->GetEntries();
+   if (ok) {
+      Int_t iseq, ipar;
+      Double_t xseq, xpar;
+      tseq->SetBranchAddress("i", &iseq);
+      tseq->SetBranchAddress("x", &xseq);
+      tpar->SetBranchAddress("i", &ipar);
+      tpar->SetBranchAddress("x", &xpar);
+      for (Long64_t entry = 0; ok && entry < tseq->GetEntries(); entry++) {
+         tseq->GetEntry(entry);
+         tpar->GetEntry(entry);
+         if (iseq != ipar || xseq != xpar) ok = kFALSE;
+      }
+      for (Int_t bin = 0; ok && bin <= hseq->GetNbinsX() + 1; bin++) {
+         if (hseq->GetBinContent(bin) != hpar->GetBinContent(bin)) ok = kFALSE;
+      }
+   }
+   delete fseq;
+   delete fpar;
+   for (Int_t n = 0; n < nfiles; n++)
+      gSystem->Unlink(Form("stressTreeMerge%d.root", n));
+   gSystem->Unlink("stressTreeMergeSeq.root");
+   gSystem->Unlink("stressTreeMergePar.root");
+   return ok;
+}
+
+Long64_t WriteCompressedTree(const char *filename, Int_t nthreads)
+{
+   // Write the tree of Test7 with the given number of compression threads
+   // and return the size of the compressed baskets.
+
+   Int_t implicitMT = TTree::GetImplicitMT();
+   TTree::SetImplicitMT(nthreads);
+   gRandom->SetSeed(7);
+   TFile *f = new TFile(filename, "RECREATE");
+   TTree *tree = new TTree("tree", "tree");
+   Int_t i, n;
+   Float_t a[20];
+   Double_t x;
+   tree->Branch("i", &i, "i/I");
+   tree->Branch("x", &x, "x/D");
+   tree->Branch("n", &n, "n/I");
+   tree->Branch("a", a, "a[n]/F");
+   tree->SetAutoFlush(1000);
+   for (Int_t entry = 0; entry < 20000; entry++) {
+      i = entry;
+      x = gRandom->Gaus(0, 10);
+      n = gRandom->Integer(20);
+      for (Int_t j = 0; j < n; j++) a[j] = gRandom->Uniform(-5, 5);
+      tree->Fill();
+   }
+   tree->Write();
+   Long64_t zipBytes = tree->GetZipBytes();
+   delete f;
+   TTree::SetImplicitMT(implicitMT);
+   return zipBytes;
+}
+
+Bool_t Test7()
+{
+   // Write the same tree with its baskets compressed serially and by 4
+   // threads, twice so that the threads are reused: the compressed sizes
+   // must be equal, and the entries read back the same.
+
+   Long64_t serialBytes = WriteCompressedTree("stressTreeSerial.root", 0);
+   Bool_t ok = serialBytes > 0;
+   for (Int_t pass = 0; ok && pass < 2; pass++) {
+      ok = WriteCompressedTree("stressTreeParallel.root", 4) == serialBytes;
+      TFile *fser = TFile::Open("stressTreeSerial.root");
+      TFile *fpar = TFile::Open("stressTreeParallel.root");
+      TTree *tser = 0, *tpar = 0;
+      if (fser) fser->GetObject("tree", tser);
+      if (fpar) fpar->GetObject("tree", tpar);
+      ok = ok && tser && tpar && tser->GetEntries() == tpar->GetEntries();
+      if (ok) {
+         Int_t iser, ipar, nser, npar;
+         Float_t aser[20], apar[20];
+         Double_t xser, xpar;
+         tser->SetBranchAddress("i", &iser);
+         tser->SetBranchAddress("x", &xser);
+         tser->SetBranchAddress("n", &nser);
+         tser->SetBranchAddress("a", aser);
+         tpar->SetBranchAddress("i", &ipar);
+         tpar->SetBranchAddress("x", &xpar);
+         tpar->SetBranchAddress("n", &npar);
+         tpar->SetBranchAddress("a", apar);
+         for (Long64_t entry = 0; ok && entry < tser->GetEntries(); entry++) {
+            if (tser->GetEntry(entry) <= 0 || tpar->GetEntry(entry) <= 0 ||
+                iser != ipar || xser != xpar || nser != npar)
+               ok = kFALSE;
+            for (Int_t j = 0; ok && j < nser; j++) {
+               if (aser[j] != apar[j]) ok = kFALSE;
+            }
+         }
+      }
+      delete fser;
+      delete fpar;
+   }
+   gSystem->Unlink("stressTreeSerial.root");
+   gSystem->Unlink("stressTreeParallel.root");
+   return ok;
+}
+
+Bool_t SameBranches(const TTreeCache *cache, const std::vector<TString> &names)
+{
+   // Return true if the cache holds the given branches, in the same order,
+   // and is no longer learning.
+
+   const TObjArray *branches = cache->GetCachedBranches();
+   if (cache->IsLearning() || branches->GetEntriesFast() != (Int_t)names.size()) return kFALSE;
+   for (UInt_t b = 0; b < names.size(); b++) {
+      if (names[b] != branches->UncheckedAt(b)->GetName()) return kFALSE;
+   }
+   return kTRUE;
+}
+
+Bool_t Test8()
+{
+   // Learn the branches read from a tree with a TTreeCache, save them in a
+   // text file and in the user info of the tree, and load them back in a
+   // new cache: the new cache must hold the same branches without learning.
+   // A list with duplicated names must be saved with each name once.
+
+   TFile *f = TFile::Open(kStressTreeFile);
+   TTree *tree = 0;
+   f->GetObject("tree", tree);
+   tree->SetCacheSize(100000);
+   TTreeCache *cache = (TTreeCache*)f->GetCacheRead(tree);
+   tree->SetBranchStatus("*", 0);
+   tree->SetBranchStatus("i", 1);
+   tree->SetBranchStatus("x", 1);
+   for (Long64_t entry = 0; entry < 2 * TTreeCache::GetLearnEntries(); entry++)
+      tree->GetEntry(entry);
+   std::vector<TString> learned;
+   const TObjArray *branches = cache ? cache->GetCachedBranches() : 0;
+   for (Int_t b = 0; branches && b < branches->GetEntriesFast(); b++)
+      learned.push_back(branches->UncheckedAt(b)->GetName());
+   Bool_t ok = learned.size() == 2 && cache->SaveLearnedBranches("stressTreeBranches.txt") == 2;
+   delete f;
+
+   // Load the saved branches in a new cache of the read-only file
+   f = TFile::Open(kStressTreeFile);
+   f->GetObject("tree", tree);
+   tree->SetCacheSize(100000);
+   cache = (TTreeCache*)f->GetCacheRead(tree);
+   ok = ok && cache && cache->LoadLearnedBranches("stressTreeBranches.txt") == 2 &&
+        SameBranches(cache, learned);
+   Int_t i;
+   Double_t x;
+   tree->SetBranchAddress("i", &i);
+   tree->SetBranchAddress("x", &x);
+   for (Long64_t entry = 0; ok && entry < tree->GetEntries(); entry += 7) {
+      if (tree->GetEntry(entry) <= 0 || i != entry) ok = kFALSE;
+   }
+   delete f;
+
+   // Duplicated names are loaded and saved once
+   FILE *fp = fopen("stressTreeBranches.txt", "w");
+   fprintf(fp, "# duplicated names\ni\nx\ni\n\nx\n");
+   fclose(fp);
+   f = TFile::Open(kStressTreeFile);
+   f->GetObject("tree", tree);
+   tree->SetCacheSize(100000);
+   cache = (TTreeCache*)f->GetCacheRead(tree);
+   ok = ok && cache && cache->LoadLearnedBranches("stressTreeBranches.txt") == 2 &&
+        SameBranches(cache, learned) && cache->SaveLearnedBranches("stressTreeBranches.txt") == 2;
+   delete f;
+
+   // Save the branches in the user info of a copy of the tree, written again
+   f = new TFile("stressTreeLearn.root", "RECREATE");
+   TTree *copy = 0;
+   {
+      TFile *in = TFile::Open(kStressTreeFile);
+      in->GetObject("tree", tree);
+      f->cd();
+      copy = tree->CloneTree(-1, "fast");
+      copy->Write();
+      delete in;
+   }
+   delete f;
+   f = new TFile("stressTreeLearn.root", "UPDATE");
+   f->GetObject("tree", tree);
+   tree->SetCacheSize(100000);
+   cache = (TTreeCache*)f->GetCacheRead(tree);
+   ok = ok && cache && cache->LoadLearnedBranches("stressTreeBranches.txt") == 2 &&
+        cache->SaveLearnedBranches() == 2;
+   tree->Write("", TObject::kOverwrite);
+   delete f;
+   f = TFile::Open("stressTreeLearn.root");
+   f->GetObject("tree", tree);
+   tree->SetCacheSize(100000);
+   cache = (TTreeCache*)f->GetCacheRead(tree);
+   ok = ok && cache && cache->LoadLearnedBranches() == 2 && SameBranches(cache, learned);
+   delete f;
+
+   gSystem->Unlink("stressTreeBranches.txt");
+   gSystem->Unlink("stressTreeLearn.root");
+   return ok;
+}
+
+Bool_t Test9()
+{
+   // Build the index of a chain of 4 files, whose trees have no index,
+   // serially and with 2 threads: both must find the same entries, and
+   // TChain::GetEntryWithIndex must read the entry with the requested
+   // values. The entries of each tree are not in the order of the index.
+
+   const Int_t nfiles = 4;
+   const Int_t nentries = 3000;
+   TChain *chain = new TChain("tree");
+   for (Int_t n = 0; n < nfiles; n++) {
+      TFile *f = new TFile(Form("stressTreeChain%d.root", n), "RECREATE");
+      TTree *tree = new TTree("tree", "tree");
+      Int_t run, event;
+      tree->Branch("run", &run, "run/I");
+      tree->Branch("event", &event, "event/I");
+      for (Int_t entry = 0; entry < nentries; entry++) {
+         run = 100 * n + entry % 3;
+         event = entry / 3;
+         tree->Fill();
+      }
+      tree->Write();
+      delete f;
+      chain->Add(Form("stressTreeChain%d.root", n));
+   }
+
+   Int_t nthreads = TTree::GetImplicitMT();
+   TTree::SetImplicitMT(0);
+   TChainIndex *serial = new TChainIndex(chain, "run", "event");
+   TTree::SetImplicitMT(2);
+   Bool_t ok = !serial->IsZombie() && chain->BuildIndex("run", "event") > 0;
+   TTree::SetImplicitMT(nthreads);
+
+   Int_t run, event;
+   chain->SetBranchAddress("run", &run);
+   chain->SetBranchAddress("event", &event);
+   for (Int_t n = 0; ok && n < nfiles; n++) {
+      for (Int_t entry = 0; ok && entry < nentries; entry += 7) {
+         Int_t r = 100 * n + entry % 3;
+         Int_t e = entry / 3;
+         Long64_t expected = (Long64_t)n * nentries + entry;
+         if (serial->GetEntryNumberWithIndex(r, e) != expected ||
+             chain->GetEntryNumberWithIndex(r, e) != expected ||
+             chain->GetEntryWithIndex(r, e) <= 0 || run != r || event != e)
+            ok = kFALSE;
+      }
+      // Values which are not in the chain
+      if (serial->GetEntryNumberWithIndex(100 * n + 5, 0) != -1 ||
+          chain->GetEntryNumberWithIndex(100 * n + 5, 0) != -1)
+         ok = kFALSE;
+   }
+   delete serial;
+   delete chain;
+   for (Int_t n = 0; n < nfiles; n++)
+      gSystem->Unlink(Form("stressTreeChain%d.root", n));
+   return ok;
+}
+
+Bool_t Test10()
+{
+   // Read the tree of two files at the same time with TTreeCacheUnzip, the
+   // baskets of both being unzipped in advance by the shared pool of 3
+   // threads: the entries must be those read without unzipping in advance.
+
+   TTreeCacheUnzip::EParUnzipMode mode = TTreeCacheUnzip::GetParallelUnzip();
+   TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kDisable);
+   TFile *f = TFile::Open(kStressTreeFile);
+   TTree *tree = 0;
+   f->GetObject("tree", tree);
+   Double_t x;
+   tree->SetBranchAddress("x", &x);
+   Long64_t nentries = tree->GetEntries();
+   std::vector<Double_t> xref;
+   for (Long64_t entry = 0; entry < nentries; entry++) {
+      tree->GetEntry(entry);
+      xref.push_back(x);
+   }
+   delete f;
+
+   TTreeCacheUnzip::SetUnzipPoolSize(3);
+   TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kForce);
+   TFile *files[2];
+   TTree *trees[2];
+   TTreeCacheUnzip *caches[2];
+   Int_t i[2], k[2];
+   Double_t xs[2];
+   Bool_t ok = kTRUE;
+   for (Int_t c = 0; c < 2; c++) {
+      files[c] = TFile::Open(kStressTreeFile);
+      trees[c] = 0;
+      files[c]->GetObject("tree", trees[c]);
+      trees[c]->SetCacheSize(200000);
+      caches[c] = dynamic_cast<TTreeCacheUnzip*>(files[c]->GetCacheRead(trees[c]));
+      if (!caches[c]) ok = kFALSE;
+      trees[c]->SetBranchAddress("i", &i[c]);
+      trees[c]->SetBranchAddress("k", &k[c]);
+      trees[c]->SetBranchAddress("x", &xs[c]);
+   }
+   for (Long64_t entry = 0; ok && entry < nentries; entry++) {
+      for (Int_t c = 0; ok && c < 2; c++) {
+         if (trees[c]->GetEntry(entry) <= 0 || i[c] != entry || k[c] != (Int_t)(entry / 3) ||
+             xs[c] != xref[entry])
+            ok = kFALSE;
+      }
+   }
+   for (Int_t c = 0; c < 2; c++) delete files[c];
+   TTreeCacheUnzip::SetParallelUnzip(mode);
+   return ok;
+}
+
+Bool_t Test11()
+{
+   // Read branches of basic types, and of fixed size arrays, in bulk with
+   // TBranch::GetBulkEntries, starting in the middle of a basket: the values
+   // must be those read entry by entry. A variable size array is not
+   // supported, and an entry after the last one has no value.
+
+   TFile *f = new TFile("stressTreeBulk.root", "RECREATE");
+   TTree *tree = new TTree("tree", "tree");
+   Int_t n;
+   Short_t s;
+   Float_t pos[3], a[10];
+   Double_t x;
+   tree->Branch("x", &x, "x/D");
+   tree->Branch("s", &s, "s/S");
+   tree->Branch("pos", pos, "pos[3]/F");
+   tree->Branch("n", &n, "n/I");
+   tree->Branch("a", a, "a[n]/F");
+   tree->SetAutoFlush(700);
+   const Int_t nentries = 10000;
+   for (Int_t entry = 0; entry < nentries; entry++) {
+      x = gRandom->Gaus(0, 10);
+      s = (Short_t)(entry - 5000);
+      for (Int_t j = 0; j < 3; j++) pos[j] = gRandom->Uniform(-5, 5);
+      n = gRandom->Integer(10);
+      for (Int_t j = 0; j < n; j++) a[j] = gRandom->Uniform(-5, 5);
+      tree->Fill();
+   }
+   tree->Write();
+   delete f;
+
+   f = TFile::Open("stressTreeBulk.root");
+   f->GetObject("tree", tree);
+   tree->SetBranchAddress("x", &x);
+   tree->SetBranchAddress("s", &s);
+   tree->SetBranchAddress("pos", pos);
+   std::vector<Double_t> xs, xbulk(1000);
+   std::vector<Short_t> ss, sbulk(1000);
+   std::vector<Float_t> ps, pbulk(3000);
+   for (Long64_t entry = 0; entry < nentries; entry++) {
+      tree->GetEntry(entry);
+      xs.push_back(x);
+      ss.push_back(s);
+      for (Int_t j = 0; j < 3; j++) ps.push_back(pos[j]);
+   }
+
+   TBranch *bx = tree->GetBranch("x");
+   TBranch *bs = tree->GetBranch("s");
+   TBranch *bp = tree->GetBranch("pos");
+   Bool_t ok = kTRUE;
+   for (Long64_t first = 123; ok && first < nentries; ) {
+      Int_t nx = bx->GetBulkEntries(first, &xbulk[0], 1000);
+      Int_t ns = bs->GetBulkEntries(first, &sbulk[0], 1000);
+      Int_t np = bp->GetBulkEntries(first, &pbulk[0], 1000);
+      if (nx <= 0 || ns <= 0 || np <= 0 || nx > 1000 || ns > 1000 || np > 1000) {
+         ok = kFALSE;
+         break;
+      }
+      for (Int_t j = 0; ok && j < nx; j++) {
+         if (xbulk[j] != xs[first + j]) ok = kFALSE;
+      }
+      for (Int_t j = 0; ok && j < ns; j++) {
+         if (sbulk[j] != ss[first + j]) ok = kFALSE;
+      }
+      for (Int_t j = 0; ok && j < 3 * np; j++) {
+         if (pbulk[j] != ps[3 * first + j]) ok = kFALSE;
+      }
+      Int_t nmin = nx < ns ? nx : ns;
+      first += nmin < np ? nmin : np;
+   }
+   ok = ok && tree->GetBranch("a")->GetBulkEntries(0, &pbulk[0], 100) == -1 &&
+        bx->GetBulkEntries(nentries, &xbulk[0], 100) == 0;
+   delete f;
+   gSystem->Unlink("stressTreeBulk.root");
+   return ok;
+}
+
+void MakeTree(Int_t nentries)
+{
+   // Make a tree of many small clusters.
+
+   TFile *f = new TFile(kStressTreeFile, "RECREATE");
+   TTree *tree = new TTree("tree", "tree");
+   Int_t i, k, inf;
+   Double_t x;
+   tree->Branch("i", &i, "i/I");
+   tree->Branch("k", &k, "k/I");
+   tree->Branch("x", &x, "x/D");
+   tree->Branch("inf", &inf, "inf/I");
+   tree->SetAutoFlush(500);
+   for (Int_t entry = 0; entry < nentries; entry++) {
+      i = entry;
+      k = entry / 3;
+      x = gRandom->Gaus(0, 10);
+      inf = entry % 10;
+      tree->Fill();
+   }
+   tree->Write();
+   delete f;
+}
+
+void CleanUp()
+{
+   gSystem->Unlink(kStressTreeFile);
+}
+
+Int_t stressTree(Int_t nentries)
+{
+   MakeTree(nentries);
+   printf("**********************************************************************\n");
+   printf("******************Starting TTree stress test**************************\n");
+   printf("**********************************************************************\n");
+
+   Int_t nfailed = 0;
+
+   Bool_t ok1 = Test1();
+   if (ok1)
+      printf("Test1: Prefetching clusters ahead with a small read list------------ OK\n");
+   else
+      printf("Test1: Prefetching clusters ahead with a small read list------------ FAILED\n");
+   if (!ok1) nfailed++;
+
+   Bool_t ok2 = Test2();
+   if (ok2)
+      printf("Test2: TTreeIndex built with one and several threads---------------- OK\n");
+   else
+      printf("Test2: TTreeIndex built with one and several threads---------------- FAILED\n");
+   if (!ok2) nfailed++;
+
+   Bool_t ok3 = Test3();
+   if (ok3)
+      printf("Test3: Writing and reading compact and plain TTreeIndex------------- OK\n");
+   else
+      printf("Test3: Writing and reading compact and plain TTreeIndex------------- FAILED\n");
+   if (!ok3) nfailed++;
+
+   Bool_t ok4 = Test4();
+   if (ok4)
+      printf("Test4: Selecting the entries with and without a zone map------------ OK\n");
+   else
+      printf("Test4: Selecting the entries with and without a zone map------------ FAILED\n");
+   if (!ok4) nfailed++;
+
+   Bool_t ok5 = Test5();
+   if (ok5)
+      printf("Test5: Evaluating formulas compiled and interpreted----------------- OK\n");
+   else
+      printf("Test5: Evaluating formulas compiled and interpreted----------------- FAILED\n");
+   if (!ok5) nfailed++;
+
+   Bool_t ok6 = Test6();
+   if (ok6)
+      printf("Test6: Merging groups of files with several threads----------------- OK\n");
+   else
+      printf("Test6: Merging groups of files with several threads----------------- FAILED\n");
+   if (!ok6) nfailed++;
+
+   Bool_t ok7 = Test7();
+   if (ok7)
+      printf("Test7: Writing baskets compressed with one and several threads------ OK\n");
+   else
+      printf("Test7: Writing baskets compressed with one and several threads------ FAILED\n");
+   if (!ok7) nfailed++;
+
+   Bool_t ok8 = Test8();
+   if (ok8)
+      printf("Test8: Saving and loading the branches learned by the cache--------- OK\n");
+   else
+      printf("Test8: Saving and loading the branches learned by the cache--------- FAILED\n");
+   if (!ok8) nfailed++;
+
+   Bool_t ok9 = Test9();
+   if (ok9)
+      printf("Test9: TChainIndex built with one and several threads--------------- OK\n");
+   else
+      printf("Test9: TChainIndex built with one and several threads--------------- FAILED\n");
+   if (!ok9) nfailed++;
+
+   Bool_t ok10 = Test10();
+   if (ok10)
+      printf("Test10: Reading two trees with the shared unzip thread pool--------- OK\n");
+   else
+      printf("Test10: Reading two trees with the shared unzip thread pool--------- FAILED\n");
+   if (!ok10) nfailed++;
+
+   Bool_t ok11 = Test11();
+   if (ok11)
+      printf("Test11: Reading the entries of basic branches in bulk--------------- OK\n");
+   else
+      printf("Test11: Reading the entries of basic branches in bulk--------------- FAILED\n");
+   if (!ok11) nfailed++;
+
+   printf("**********************************************************************\n");
+   printf("******************Deleting the data file******************************\n");
+   printf("**********************************************************************\n");
+   CleanUp();
+   return nfailed;
+}
+//_____________________________batch only_____________________
+#ifndef __CINT__
+
+int main(int argc, char *argv[])
+{
+   TApplication theApp("App", &argc, argv);
+   Int_t nentries = 50000;
+   if (argc > 1) nentries = atoi(argv[1]);
+   return stressTree(nentries);
+}
+
+#endif
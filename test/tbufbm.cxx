@@ -0,0 +1,309 @@
+// @(#)root/test:$Id$
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Riostream.h"
+#include "TBufferFile.h"
+#include "TStreamerInfo.h"
+#include "TAttText.h"
+#include "TStopwatch.h"
+#include "TString.h"
+#include "TRandom.h"
+#include "Bytes.h"
+#include "Bswapcpy.h"
+//
+// This program benchmarks the streaming of arrays of basic types by
+// TBufferFile::ReadFastArray/WriteFastArray (bulk byte swapping) against
+// the element by element conversion with frombuf/tobuf, which is what
+// these functions did before the bulk kernels were introduced.
+// On x86_64 the SSE2 and AVX2 byte swapping kernels from Bswapcpy.h are
+// also timed individually.
+// It also streams objects with their object wise streamer actions, as
+// looped over by TBufferFile and as compiled together (TStreamerInfo::SetJit).
+// Every test also checks that both paths produce the same values (or the
+// same bytes for the objects); a mismatch is reported as FAILED.
+//
+// Usage: tbufbm [nelements] [ntimes]
+//
+// parameters:
+//       nelements     - number of elements of the arrays (default 100000)
+//       ntimes        - number of times each array is streamed (default 1000)
+
+Int_t nelements = 100000; // Number of elements per array.
+Int_t ntimes    = 1000;   // Number of repetitions per test.
+Int_t nfailed   = 0;      // Number of failed consistency checks.
+
+//_____________________________________________________________
+
+static void Report(const char *what, Double_t bytes, Double_t tbulk, Double_t tscalar)
+{
+   // Print throughput of the bulk and element by element paths.
+
+   Double_t mb = bytes*ntimes/1024./1024.;
+   printf("%-24s bulk: %9.1f MB/s   per element: %9.1f MB/s   speedup: %5.2f\n",
+          what, tbulk > 0 ? mb/tbulk : 0., tscalar > 0 ? mb/tscalar : 0.,
+          tbulk > 0 ? tscalar/tbulk : 0.);
+}
+
+//_____________________________________________________________
+
+template <typename T>
+static void TestArray(const char *name)
+{
+   // Write and read back an array of n T with the bulk and the element by
+   // element paths.
+
+   T *in  = new T[nelements];
+   T *out = new T[nelements];
+   T *ref = new T[nelements];
+   for (Int_t i = 0; i < nelements; i++) in[i] = (T)(gRandom->Rndm()*30000);
+
+   TBufferFile b(TBuffer::kWrite, nelements*sizeof(T)+1024);
+   TStopwatch timer;
+
+   // Write
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      b.SetBufferOffset(0);
+      b.WriteFastArray(in, nelements);
+   }
+   Double_t tbulk = timer.RealTime();
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      char *buf = b.Buffer();
+      for (Int_t i = 0; i < nelements; i++) tobuf(buf, in[i]);
+   }
+   Double_t tscalar = timer.RealTime();
+   Report(Form("WriteFastArray(%s)", name), nelements*sizeof(T), tbulk, tscalar);
+
+   // Read
+   b.SetReadMode();
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      b.SetBufferOffset(0);
+      b.ReadFastArray(out, nelements);
+   }
+   tbulk = timer.RealTime();
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      char *buf = b.Buffer();
+      for (Int_t i = 0; i < nelements; i++) frombuf(buf, &ref[i]);
+   }
+   tscalar = timer.RealTime();
+   Report(Form("ReadFastArray(%s)", name), nelements*sizeof(T), tbulk, tscalar);
+
+   if (memcmp(out, in, nelements*sizeof(T)) || memcmp(ref, in, nelements*sizeof(T))) {
+      printf("ReadFastArray(%s): FAILED\n", name);
+      nfailed++;
+   }
+   delete [] in;
+   delete [] out;
+   delete [] ref;
+}
+
+//_____________________________________________________________
+
+static void TestTruncated(Bool_t isdouble)
+{
+   // Stream Float16_t or Double32_t arrays (no range, default number of
+   // bits) with ReadFastArrayFloat16/Double32 and with the per element
+   // ReadFloat16/ReadDouble32.
+
+   const char *name = isdouble ? "Double32_t" : "Float16_t";
+   Float_t  *fin  = new Float_t[nelements];
+   Double_t *din  = new Double_t[nelements];
+   Float_t  *fout = new Float_t[nelements];
+   Double_t *dout = new Double_t[nelements];
+   Float_t  *fref = new Float_t[nelements];
+   Double_t *dref = new Double_t[nelements];
+   for (Int_t i = 0; i < nelements; i++) {
+      fin[i] = (Float_t)gRandom->Gaus(0, 100);
+      din[i] = fin[i];
+   }
+
+   TBufferFile b(TBuffer::kWrite, nelements*sizeof(Double_t)+1024);
+   TStopwatch timer;
+
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      b.SetBufferOffset(0);
+      if (isdouble) b.WriteFastArrayDouble32(din, nelements);
+      else          b.WriteFastArrayFloat16(fin, nelements);
+   }
+   Double_t tbulk = timer.RealTime();
+   Int_t len = b.Length();
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      b.SetBufferOffset(0);
+      for (Int_t i = 0; i < nelements; i++) {
+         if (isdouble) b.WriteDouble32(&din[i]);
+         else          b.WriteFloat16(&fin[i]);
+      }
+   }
+   Double_t tscalar = timer.RealTime();
+   Report(Form("WriteFastArray(%s)", name), len, tbulk, tscalar);
+
+   b.SetReadMode();
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      b.SetBufferOffset(0);
+      if (isdouble) b.ReadFastArrayDouble32(dout, nelements);
+      else          b.ReadFastArrayFloat16(fout, nelements);
+   }
+   tbulk = timer.RealTime();
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      b.SetBufferOffset(0);
+      for (Int_t i = 0; i < nelements; i++) {
+         if (isdouble) b.ReadDouble32(&dref[i]);
+         else          b.ReadFloat16(&fref[i]);
+      }
+   }
+   tscalar = timer.RealTime();
+   Report(Form("ReadFastArray(%s)", name), len, tbulk, tscalar);
+
+   Bool_t ok = isdouble ? !memcmp(dout, dref, nelements*sizeof(Double_t))
+                        : !memcmp(fout, fref, nelements*sizeof(Float_t));
+   if (!ok) {
+      printf("ReadFastArray(%s): FAILED\n", name);
+      nfailed++;
+   }
+   delete [] fin;  delete [] din;
+   delete [] fout; delete [] dout;
+   delete [] fref; delete [] dref;
+}
+
+//_____________________________________________________________
+
+template <typename T>
+static void TestFused(const char *name, T *objects, Int_t nobjects)
+{
+   // Write the objects with the loop on the object wise streamer actions
+   // and with the compiled actions, which must write the same bytes, and
+   // read them back with the compiled actions.
+   // If the actions can not be compiled (no interpreter), the loop is used
+   // in both cases.
+
+   TClass *cl = T::Class();
+   Int_t jit = TStreamerInfo::GetJit();
+   TBufferFile loop(TBuffer::kWrite, 1024);
+   TBufferFile fused(TBuffer::kWrite, 1024);
+   TStopwatch timer;
+
+   TStreamerInfo::SetJit(0);
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      loop.SetBufferOffset(0);
+      for (Int_t i = 0; i < nobjects; i++) loop.WriteClassBuffer(cl, &objects[i]);
+   }
+   Double_t tscalar = timer.RealTime();
+
+   TStreamerInfo::SetJit(1);
+   timer.Start();
+   for (Int_t k = 0; k < ntimes; k++) {
+      fused.SetBufferOffset(0);
+      for (Int_t i = 0; i < nobjects; i++) fused.WriteClassBuffer(cl, &objects[i]);
+   }
+   Double_t tbulk = timer.RealTime();
+   Report(Form("WriteClassBuffer(%s)", name), loop.Length(), tbulk, tscalar);
+
+   Bool_t ok = loop.Length() == fused.Length() && !memcmp(loop.Buffer(), fused.Buffer(), loop.Length());
+
+   // Read back with the compiled actions and write again with the loop
+   T *back = new T[nobjects];
+   fused.SetReadMode();
+   fused.SetBufferOffset(0);
+   for (Int_t i = 0; i < nobjects; i++) fused.ReadClassBuffer(cl, &back[i], 0);
+   TStreamerInfo::SetJit(0);
+   TBufferFile again(TBuffer::kWrite, 1024);
+   for (Int_t i = 0; i < nobjects; i++) again.WriteClassBuffer(cl, &back[i]);
+   ok = ok && again.Length() == loop.Length() && !memcmp(loop.Buffer(), again.Buffer(), loop.Length());
+   if (!ok) {
+      printf("WriteClassBuffer(%s): FAILED\n", name);
+      nfailed++;
+   }
+   delete [] back;
+   TStreamerInfo::SetJit(jit);
+}
+
+#ifdef R__BSWAPCPY_SIMD
+//_____________________________________________________________
+
+static void TestKernels()
+{
+   // Time the byte swapping kernels for 4 and 8 byte elements separately.
+
+   Int_t nbytes = nelements*8;
+   char *from = new char[nbytes];
+   char *to   = new char[nbytes];
+   for (Int_t i = 0; i < nbytes; i++) from[i] = (char)i;
+
+   const char *names[3] = { "scalar", "SSE2", "AVX2" };
+   Int_t nlevels = bswapcpy_simdlevel() + 1;
+   for (Int_t bits = 32; bits <= 64; bits *= 2) {
+      Int_t n = nbytes/(bits/8);
+      for (Int_t level = 0; level < nlevels; level++) {
+         TStopwatch timer;
+         timer.Start();
+         for (Int_t k = 0; k < ntimes; k++) {
+            if (bits == 32) {
+               if (level == 0)      bswapcpy32_scalar(to, from, n);
+               else if (level == 1) bswapcpy32_sse2(to, from, n);
+               else                 bswapcpy32_avx2(to, from, n);
+            } else {
+               if (level == 0)      bswapcpy64_scalar(to, from, n);
+               else if (level == 1) bswapcpy64_sse2(to, from, n);
+               else                 bswapcpy64_avx2(to, from, n);
+            }
+         }
+         Double_t t = timer.RealTime();
+         printf("bswapcpy%d_%-14s %9.1f MB/s\n", bits, names[level],
+                t > 0 ? Double_t(nbytes)*ntimes/1024./1024./t : 0.);
+      }
+   }
+   delete [] from;
+   delete [] to;
+}
+#endif
+
+//_____________________________________________________________
+
+int main(int argc, char **argv)
+{
+   if (argc > 1) nelements = atoi(argv[1]);
+   if (argc > 2) ntimes    = atoi(argv[2]);
+   if (nelements <= 0 || ntimes <= 0) {
+      printf("Usage: tbufbm [nelements] [ntimes]\n");
+      return 1;
+   }
+
+   printf("Streaming %d elements %d times\n", nelements, ntimes);
+   TestArray<Short_t>("Short_t");
+   TestArray<Int_t>("Int_t");
+   TestArray<Long64_t>("Long64_t");
+   TestArray<Float_t>("Float_t");
+   TestArray<Double_t>("Double_t");
+   TestTruncated(kFALSE);
+   TestTruncated(kTRUE);
+
+   Int_t nobjects = nelements/10 > 0 ? nelements/10 : 1;
+   TAttText *texts = new TAttText[nobjects];
+   TStopwatch *watches = new TStopwatch[nobjects];
+   for (Int_t i = 0; i < nobjects; i++) {
+      texts[i].SetTextAngle(gRandom->Rndm()*360);
+      texts[i].SetTextSize(gRandom->Rndm());
+      texts[i].SetTextAlign(gRandom->Integer(40));
+      texts[i].SetTextColor(gRandom->Integer(1000));
+      texts[i].SetTextFont(gRandom->Integer(150));
+      if (i % 2) watches[i].Stop();
+   }
+   TestFused("TAttText", texts, nobjects);
+   TestFused("TStopwatch", watches, nobjects);
+   delete [] texts;
+   delete [] watches;
+#ifdef R__BSWAPCPY_SIMD
+   TestKernels();
+#endif
+   return nfailed ? 1 : 0;
+}
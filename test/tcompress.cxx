@@ -0,0 +1,116 @@
+// @(#)root/test:$Id$
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Riostream.h"
+#include "TRandom.h"
+#include "Compression.h"
+//
+// This program compresses buffers of various contents with the LZ4 and
+// Zstandard compression algorithms at several levels, as done for the
+// baskets and keys, decompresses them and checks that the original
+// contents are found again. It also checks that the compressors never
+// write beyond the given target size, which is deliberately made too
+// small for some of the buffers.
+// When ROOT is built without LZ4 or Zstandard support the buffers are left
+// uncompressed (the compressor returns 0), which is accepted.
+// A failed check is reported as FAILED.
+//
+// Usage: tcompress [nbytes]
+//
+// parameters:
+//       nbytes        - size of the buffers (default 100000)
+
+extern "C" void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep, int compressionAlgorithm);
+extern "C" void R__unzip(Int_t *nin, UChar_t *bufin, Int_t *lout, char *bufout, Int_t *nout);
+extern "C" int R__unzip_header(Int_t *nin, UChar_t *bufin, Int_t *lout);
+
+Int_t nbytes  = 100000; // Size of the buffers.
+Int_t nfailed = 0;      // Number of failed checks.
+
+const Int_t kGuard = 64; // Bytes checked after the end of the target buffer.
+
+//_____________________________________________________________
+
+static void Check(const char *what, Int_t algorithm, Int_t level, Bool_t ok)
+{
+   // Report a failed check.
+
+   if (ok) return;
+   printf("%-28s algorithm %d level %d: FAILED\n", what, algorithm, level);
+   nfailed++;
+}
+
+//_____________________________________________________________
+
+static void RoundTrip(const char *what, const char *src, Int_t srcsize,
+                      Int_t algorithm, Int_t level, Int_t tgtsize)
+{
+   // Compress src into a target buffer of tgtsize bytes followed by guard
+   // bytes, check that the guard bytes are untouched, and decompress.
+
+   char *tgt = new char[tgtsize + kGuard];
+   memset(tgt, 0x5a, tgtsize + kGuard);
+   Int_t nin = srcsize, nout = tgtsize, irep = 0;
+   R__zipMultipleAlgorithm(level, &nin, (char*)src, &nout, tgt, &irep, algorithm);
+
+   Bool_t guard = kTRUE;
+   for (Int_t i = tgtsize; i < tgtsize + kGuard; i++) {
+      if (tgt[i] != 0x5a) guard = kFALSE;
+   }
+   Check(what, algorithm, level, guard && irep >= 0 && irep <= tgtsize);
+
+   if (irep > 0) {
+      Int_t zsize = 0, unzsize = 0;
+      Int_t hc = R__unzip_header(&zsize, (UChar_t*)tgt, &unzsize);
+      Check(what, algorithm, level, hc == 0 && zsize == irep && unzsize == srcsize);
+      if (hc == 0 && unzsize == srcsize) {
+         char *back = new char[srcsize];
+         Int_t nunzip = 0;
+         R__unzip(&zsize, (UChar_t*)tgt, &unzsize, back, &nunzip);
+         Check(what, algorithm, level, nunzip == srcsize && memcmp(back, src, srcsize) == 0);
+         delete [] back;
+      }
+   }
+   delete [] tgt;
+}
+
+//_____________________________________________________________
+
+int main(int argc, char **argv)
+{
+   if (argc > 1) nbytes = atoi(argv[1]);
+   if (nbytes < 16) nbytes = 16;
+
+   // A buffer with repeated patterns, and one of random bytes which
+   // cannot be compressed.
+   char *text = new char[nbytes];
+   char *noise = new char[nbytes];
+   const char *words[4] = { "event ", "track ", "cluster ", "vertex " };
+   for (Int_t i = 0; i < nbytes; ) {
+      const char *w = words[gRandom->Integer(4)];
+      for (const char *c = w; *c && i < nbytes; c++) text[i++] = *c;
+   }
+   for (Int_t i = 0; i < nbytes; i++) noise[i] = (char)gRandom->Integer(256);
+
+   Int_t algorithms[2] = { ROOT::kLZ4, ROOT::kZSTD };
+   Int_t levels[3] = { 1, 5, 9 };
+   for (Int_t a = 0; a < 2; a++) {
+      for (Int_t l = 0; l < 3; l++) {
+         Int_t alg = algorithms[a], lev = levels[l];
+         RoundTrip("text",                 text,  nbytes, alg, lev, nbytes);
+         RoundTrip("noise",                noise, nbytes, alg, lev, nbytes);
+         RoundTrip("text, small target",   text,  nbytes, alg, lev, nbytes/20);
+         RoundTrip("noise, small target",  noise, nbytes, alg, lev, nbytes/2);
+         RoundTrip("target below header",  text,  nbytes, alg, lev, 8);
+      }
+   }
+
+   delete [] text;
+   delete [] noise;
+
+   if (nfailed) printf("tcompress: %d checks FAILED\n", nfailed);
+   else         printf("tcompress: all checks OK\n");
+   return nfailed ? 1 : 0;
+}
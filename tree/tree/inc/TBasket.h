@@ -47,6 +47,11 @@ private:
 
    // Helper for managing the compressed buffer.
    void InitializeCompressedBuffer(Int_t len, TFile* file);
+
+   // Helpers for WriteBuffer and CompressBuffer.
+   void  PrepareWriteBuffer();
+   Int_t CompressPayload(Int_t cxlevel, Int_t cxAlgorithm);
+   void  ReleasePrivateCompressedBuffer();
  
 protected:
    Int_t       fBufferSize;      //fBuffer length in bytes
@@ -60,6 +65,8 @@ protected:
    TBuffer    *fCompressedBufferRef; //! Compressed buffer.
    Bool_t      fOwnsCompressedBuffer; //! Whether or not we own the compressed buffer.
    Int_t       fLastWriteBufferSize; //! Size of the buffer last time we wrote it to disk
+   Int_t       fCompressedSize;      //! Size of the payload prepared by CompressBuffer (0: not compressible, -1: not prepared)
+   TBuffer    *fSharedCompressedBufferRef; //! Tree transient buffer put aside while CompressBuffer uses a private one
 
 public:
    
@@ -69,6 +76,7 @@ public:
    virtual ~TBasket();
    
    virtual void    AdjustSize(Int_t newsize);
+           Int_t   CompressBuffer();
    virtual void    DeleteEntryOffset();
    virtual Int_t   DropBuffers();
    TBranch        *GetBranch() const {return fBranch;}
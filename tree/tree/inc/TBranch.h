@@ -150,6 +150,7 @@ public:
    virtual Long64_t  GetBasketSeek(Int_t basket) const;
    virtual Int_t     GetBasketSize() const {return fBasketSize;}
    virtual TList    *GetBrowsables();
+           Int_t     GetBulkEntries(Long64_t entry, void *array, Int_t nentries);
    virtual const char* GetClassName() const;
            Int_t     GetCompressionAlgorithm() const;
            Int_t     GetCompressionLevel() const;
@@ -65,6 +65,7 @@ class TEntryList: public TNamed
 
    virtual void        Add(const TEntryList *elist);
    virtual Int_t       Contains(Long64_t entry, TTree *tree = 0);
+   virtual Bool_t      ContainsRange(Long64_t first, Long64_t last);
    virtual void        DirectoryAutoAdd(TDirectory *);
    virtual Bool_t      Enter(Long64_t entry, TTree *tree = 0);
    virtual TEntryList *GetCurrentList() const { return fCurrent; };
@@ -79,9 +80,11 @@ class TEntryList: public TNamed
    virtual const char *GetFileName() const { return fFileName.Data(); }
    virtual Int_t       GetTreeNumber() const { return fTreeNumber; }
    virtual Bool_t      GetReapplyCut() const { return fReapply; };
+   virtual void        Intersect(const TEntryList *elist);
    virtual Int_t       Merge(TCollection *list);
    
    virtual Long64_t    Next();
+   virtual Int_t       NextEntries(Int_t n, Long64_t *entries);
    virtual void        OptimizeStorage();
    virtual Int_t       RelocatePaths(const char *newloc, const char *oldloc = 0);
    virtual Bool_t      Remove(Long64_t entry, TTree *tree = 0);
@@ -29,9 +29,12 @@
 // - Merge() - adds all entries from one block to the other. If the first block 
 //             uses array representation, it's changed to bits representation only
 //             if the total number of passing entries is still less than kBlockSize
+// - Intersect(), Subtract() - keep the entries which are (are not) in the other block
+// - ContainsRange(first, last) - true if one of the entries first to last is in the block
 // - GetEntry(n) - returns n-th non-zero entry.
 // - Next()      - return next non-zero entry. In case of representation 1), Next()
 //                 is faster than GetEntry()
+// - NextEntries(n, entries) - return the next n non-zero entries at once
 //
 //////////////////////////////////////////////////////////////////////////
 
@@ -57,6 +60,8 @@ class TEntryListBlock:public TObject
    Int_t    fLastIndexReturned; //! to optimize GetEntry() in a loop
 
    void Transform(Bool_t dir, UShort_t *indexnew);
+   void FillBits(UShort_t *bits) const;
+   void CombineBits(const TEntryListBlock *block, Int_t oper);
 
  public:
 
@@ -69,9 +74,13 @@ class TEntryListBlock:public TObject
    Bool_t  Enter(Int_t entry);
    Bool_t  Remove(Int_t entry);
    Int_t   Contains(Int_t entry);
+   Bool_t  ContainsRange(Int_t first, Int_t last);
    void    OptimizeStorage();
    Int_t   Merge(TEntryListBlock *block);
+   Int_t   Intersect(TEntryListBlock *block);
+   Int_t   Subtract(TEntryListBlock *block);
    Int_t   Next();
+   Int_t   NextEntries(Int_t n, Int_t *entries);
    Int_t   GetEntry(Int_t entry);
    void    ResetIndices() {fLastIndexQueried = -1, fLastIndexReturned = -1;}
    Int_t   GetType() { return fType; }
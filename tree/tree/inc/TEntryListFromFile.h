@@ -79,9 +79,11 @@ public:
    
    virtual Int_t       LoadList(Int_t listnumber);
    
+   virtual void        Intersect(const TEntryList * /*elist*/) {};
    virtual Int_t       Merge(TCollection * /*list*/){ return 0; };
    
    virtual Long64_t    Next();
+   virtual Int_t       NextEntries(Int_t n, Long64_t *entries);
    virtual void        OptimizeStorage() {};
    virtual Bool_t      Remove(Long64_t /*entry*/, TTree * /*tree = 0*/){ return 0; };
    
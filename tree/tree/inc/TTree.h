@@ -143,6 +143,7 @@ protected:
 
    static Int_t     fgBranchStyle;      //  Old/New branch style
    static Long64_t  fgMaxTreeSize;      //  Maximum size of a file containg a Tree
+   static Int_t     fgImplicitMT;       //  Number of threads used by Process, Draw and FlushBaskets (0: sequential)
 
 private:
    TTree(const TTree& tt);              // not implemented
@@ -331,6 +332,7 @@ public:
    virtual TBranch        *BranchRef();
    virtual void            Browse(TBrowser*);
    virtual Int_t           BuildIndex(const char* majorname, const char* minorname = "0");
+   virtual Int_t           BuildZoneMap(const char* columns);
    TStreamerInfo          *BuildStreamerInfo(TClass* cl, void* pointer = 0, Bool_t canOptimize = kTRUE);
    virtual TFile          *ChangeFile(TFile* file);
    virtual TTree          *CloneTree(Long64_t nentries = -1, Option_t* option = "");
@@ -372,6 +374,7 @@ public:
    virtual Long64_t        GetEntriesFast() const   { return fEntries; }
    virtual Long64_t        GetEntriesFriend() const;
    virtual Long64_t        GetEstimate() const { return fEstimate; }
+   static  Int_t           GetImplicitMT();
    virtual Int_t           GetEntry(Long64_t entry = 0, Int_t getall = 0);
            Int_t           GetEvent(Long64_t entry = 0, Int_t getall = 0) { return GetEntry(entry, getall); }
    virtual Int_t           GetEntryWithIndex(Int_t major, Int_t minor = 0);
@@ -520,6 +523,7 @@ public:
    virtual Long64_t        SetEntries(Long64_t n = -1);
    virtual void            SetEstimate(Long64_t nentries = 1000000);
    virtual void            SetFileNumber(Int_t number = 0);
+   static  void            SetImplicitMT(Int_t nthreads = -1);
    virtual void            SetEventList(TEventList* list);
    virtual void            SetEntryList(TEntryList* list, Option_t *opt="");
    virtual void            SetMakeClass(Int_t make);
@@ -59,12 +59,15 @@ protected:
    Bool_t          fReadDirectionSet; //! read direction established
    Bool_t          fEnabled;     //! cache enabled for cached reading
    EPrefillType    fPrefillType; // Whether a prefilling is enabled (and if applicable which type)
+   Long64_t        fEntryLookAhead; //! first entry not yet requested by the prefetching look-ahead
    static  Int_t   fgLearnEntries; // number of entries used for learning mode
 
 private:
    TTreeCache(const TTreeCache &);            //this class cannot be copied
    TTreeCache& operator=(const TTreeCache &);
 
+   void         LookAhead();
+
 public:
 
    TTreeCache();
@@ -89,12 +92,14 @@ public:
 
    virtual Bool_t       FillBuffer();
    virtual void         LearnPrefill();
+   virtual Int_t        LoadLearnedBranches(const char *filename = 0);
 
    virtual void         Print(Option_t *option="") const;
    virtual Int_t        ReadBuffer(char *buf, Long64_t pos, Int_t len);
    virtual Int_t        ReadBufferNormal(char *buf, Long64_t pos, Int_t len); 
    virtual Int_t        ReadBufferPrefetch(char *buf, Long64_t pos, Int_t len);
    virtual void         ResetCache();
+   virtual Int_t        SaveLearnedBranches(const char *filename = 0) const;
    virtual void         SetEntryRange(Long64_t emin,   Long64_t emax);
    virtual void         SetFile(TFile *file, TFile::ECacheAction action=TFile::kDisconnect);
    virtual void         SetLearnPrefill(EPrefillType type = kNoPrefill);
@@ -29,11 +29,10 @@
 #include "TTreeCache.h"
 #endif
 
-#include <queue>
+#include <vector>
 
 class TTree;
 class TBranch;
-class TThread;
 class TCondition;
 class TBasket;
 class TMutex;
@@ -44,29 +43,30 @@ public:
    // enable, disable and force
    enum EParUnzipMode { kEnable, kDisable, kForce };
 
+   // Status of the individual blocks
+   enum EUnzipStatus { kUntouched, kProgress, kFinished, kQueued };
+
 protected:
 
    // Members for paral. managing
-   TThread    *fUnzipThread[10];
-   Bool_t      fActiveThread;          // Used to terminate gracefully the unzippers
-   TCondition *fUnzipStartCondition;   // Used to signal the threads to start.
-   TCondition *fUnzipDoneCondition;    // Used to wait for an unzip tour to finish. Gives the Async feel.
+   TCondition *fUnzipDoneCondition;    // Used to wait for a pending block or for the pending tasks to finish.
    Bool_t      fParallel;              // Indicate if we want to activate the parallelism (for this instance)
    Bool_t      fAsyncReading;
    TMutex     *fMutexList;             // Mutex to protect the various lists. Used by the condvars.
    TMutex     *fIOMutex;
 
-   Int_t       fCycle;
+   Int_t       fCycle;                 // Incremented each time the content of the cache changes
+   Int_t       fNPendingTasks;         // Number of tasks of this cache queued or running in the unzip pool
+   Int_t       fNextToSchedule;        // Next position in fUnzipOrder to hand to the unzip pool
    static TTreeCacheUnzip::EParUnzipMode fgParallel;  // Indicate if we want to activate the parallelism
-
-   Int_t       fLastReadPos;
-   Int_t       fBlocksToGo;
+   static Int_t fgPoolSize;            // Number of threads of the unzip pool shared by all the caches
 
    // Unzipping related members
    Int_t      *fUnzipLen;         //! [fNseek] Length of the unzipped buffers
    char      **fUnzipChunks;      //! [fNseek] Individual unzipped chunks. Their summed size is kept under control.
-   Byte_t     *fUnzipStatus;      //! [fNSeek] For each blk, tells us if it's unzipped or pending
+   Byte_t     *fUnzipStatus;      //! [fNSeek] For each blk, tells us if it's unzipped or pending (see EUnzipStatus)
    Long64_t    fTotalUnzipBytes;  //! The total sum of the currently unzipped blks
+   std::vector<Int_t> fUnzipOrder; //! Blocks in the order they will be used (sorted by first entry)
 
    Int_t       fNseekMax;         //!  fNseek can change so we need to know its max size
    Long64_t    fUnzipBufferSize;  //!  Max Size for the ready unzipped blocks (default is 2*fBufferSize)
@@ -79,8 +79,6 @@ protected:
    Int_t       fNStalls;          //! number of hits which caused a stall
    Int_t       fNMissed;          //! number of blocks that were not found in the cache and were unzipped
 
-   std::queue<Int_t>       fActiveBlks; // The blocks which are active now
-
 private:
    TTreeCacheUnzip(const TTreeCacheUnzip &);            //this class cannot be copied
    TTreeCacheUnzip& operator=(const TTreeCacheUnzip &);
@@ -90,8 +88,9 @@ private:
 
    // Private methods
    void  Init();
-   Int_t StartThreadUnzip(Int_t nthreads);
-   Int_t StopThreadUnzip();
+   void  ExpandUnzipArrays();
+   void  ScheduleUnzip();
+   void  WaitForPendingTasks();
 
 public:
    TTreeCacheUnzip();
@@ -105,16 +104,12 @@ public:
    virtual void        StopLearningPhase();
    void                UpdateBranches(TTree *tree);
 
-   // Methods related to the thread
+   // Methods related to the thread pool
    static EParUnzipMode GetParallelUnzip();
    static Bool_t        IsParallelUnzip();
    static Int_t         SetParallelUnzip(TTreeCacheUnzip::EParUnzipMode option = TTreeCacheUnzip::kEnable);
-
-   Bool_t               IsActiveThread();
-   Bool_t               IsQueueEmpty();
-
-   void                 WaitUnzipStartSignal();
-   void                 SendUnzipStartSignal(Bool_t broadcast);
+   static Int_t         GetUnzipPoolSize();
+   static void          SetUnzipPoolSize(Int_t nthreads);
 
    // Unzipping related methods
    Int_t          GetRecordHeader(char *buf, Int_t maxbytes, Int_t &nbytes, Int_t &objlen, Int_t &keylen);
@@ -123,7 +118,7 @@ public:
    void           SetUnzipBufferSize(Long64_t bufferSize);
    static void    SetUnzipRelBufferSize(Float_t relbufferSize);
    Int_t          UnzipBuffer(char **dest, char *src);
-   Int_t          UnzipCache(Int_t &startindex, Int_t &locbuffsz, char *&locbuff);
+   Int_t          UnzipCache(Int_t index, Int_t cycle);
 
    // Methods to get stats
    Int_t  GetNUnzip() { return fNUnzip; }
@@ -132,8 +127,6 @@ public:
 
    void Print(Option_t* option = "") const;
 
-   // static members
-   static void* UnzipLoop(void *arg);
    ClassDef(TTreeCacheUnzip,0)  //Specialization of TTreeCache for parallel unzipping
 };
 
@@ -45,6 +45,7 @@ public:
    TVirtualTreePlayer() { }
    virtual ~TVirtualTreePlayer();
    virtual TVirtualIndex *BuildIndex(const TTree *T, const char *majorname, const char *minorname) = 0;
+   virtual TObject       *BuildZoneMap(TTree *T, const char *columns) = 0;
    virtual TTree         *CopyTree(const char *selection, Option_t *option=""
                                    ,Long64_t nentries=1000000000, Long64_t firstentry=0) = 0;
    virtual Long64_t       DrawScript(const char *wrapperPrefix,
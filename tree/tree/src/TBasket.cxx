@@ -40,6 +40,22 @@ const Int_t  kMAXBUF = 0xFFFFFF;
 const UInt_t kDisplacementMask = 0xFF000000;  // In the streamer the two highest bytes of
                                               // the fEntryOffset are used to stored displacement.
 
+//_______________________________________________________________________
+static inline TBuffer* R__DetachBasketBuffer(TBuffer* bufferRef)
+{
+   // If the buffer points to bytes it does not own (the memory map of the
+   // file or a block held by the cache), replace it by a buffer of the same
+   // size owning its memory so that it can be filled and expanded again.
+
+   if (R__unlikely(bufferRef && !bufferRef->TestBit(TBuffer::kIsOwner))) {
+      TBuffer* result = new TBufferFile(TBuffer::kRead, bufferRef->BufferSize());
+      result->SetParent(bufferRef->GetParent());
+      delete bufferRef;
+      return result;
+   }
+   return bufferRef;
+}
+
 ClassImp(TBasket)
 
 //_______________________________________________________________________
@@ -49,7 +65,7 @@ ClassImp(TBasket)
 //
 
 //_______________________________________________________________________
-TBasket::TBasket() : fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0)
+TBasket::TBasket() : fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0), fCompressedSize(-1), fSharedCompressedBufferRef(0)
 {
    // Default contructor.
 
@@ -66,7 +82,7 @@ TBasket::TBasket() : fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLa
 }
 
 //_______________________________________________________________________
-TBasket::TBasket(TDirectory *motherDir) : TKey(motherDir),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0)
+TBasket::TBasket(TDirectory *motherDir) : TKey(motherDir),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0), fCompressedSize(-1), fSharedCompressedBufferRef(0)
 {
    // Constructor used during reading.
    fDisplacement  = 0;
@@ -83,7 +99,7 @@ TBasket::TBasket(TDirectory *motherDir) : TKey(motherDir),fCompressedBufferRef(0
 
 //_______________________________________________________________________
 TBasket::TBasket(const char *name, const char *title, TBranch *branch) : 
-   TKey(branch->GetDirectory()),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0)
+   TKey(branch->GetDirectory()),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0), fCompressedSize(-1), fSharedCompressedBufferRef(0)
 {
    // Basket normal constructor, used during writing.
 
@@ -227,6 +243,7 @@ Int_t TBasket::LoadBasketBuffers(Long64_t pos, Int_t len, TFile *file, TTree *tr
    // This function is called by TTreeCloner.
    // The function returns 0 in case of success, 1 in case of error.
 
+   fBufferRef = R__DetachBasketBuffer(fBufferRef);
    if (fBufferRef) {
       // Reuse the buffer if it exist.
       fBufferRef->Reset();
@@ -383,6 +400,7 @@ static inline TBuffer* R__InitializeReadBasketBuffer(TBuffer* bufferRef, Int_t l
    // Initialize a buffer for reading if it is not already initialized
 
    TBuffer* result;
+   bufferRef = R__DetachBasketBuffer(bufferRef);
    if (R__likely(bufferRef)) {
       bufferRef->SetReadMode();
       Int_t curBufferSize = bufferRef->BufferSize();
@@ -441,7 +459,7 @@ Int_t TBasket::ReadBasketBuffers(Long64_t pos, Int_t len, TFile *file)
    if (pf) {
       Int_t res = -1;
       Bool_t free = kTRUE;
-      char *buffer;
+      char *buffer = 0;
       res = pf->GetUnzipBuffer(&buffer, pos, len, &free);
       if (R__unlikely(res >= 0)) {
          len = ReadBasketBuffersUnzip(buffer, res, free, file);
@@ -452,6 +470,40 @@ Int_t TBasket::ReadBasketBuffers(Long64_t pos, Int_t len, TFile *file)
       }
    }
 
+   // If the file is mapped in memory (TFile option "MMAP"), the bytes of an
+   // uncompressed basket are used in place and the others are uncompressed
+   // straight from the map, without reading them into a buffer first.
+   rawCompressedBuffer = const_cast<char*>(file->GetMappedBuffer(pos, len));
+   if (R__unlikely(rawCompressedBuffer)) {
+      fBranch->GetTree()->IncrementTotalBuffers(-fBufferSize);
+
+      TBufferFile mappedRef(TBuffer::kRead, len, rawCompressedBuffer, kFALSE);
+      mappedRef.SetParent(file);
+      Streamer(mappedRef);
+      if (IsZombie()) {
+         return 1;
+      }
+
+      oldCase = OLD_CASE_EXPRESSION;
+      Bool_t compressed = fObjlen > fNbytes-fKeylen || oldCase;
+      if (!compressed || (TestBit(TBufferFile::kNotDecompressed) && (fNevBuf==1))) {
+         if (fBufferRef) {
+            fBufferRef->SetReadMode();
+            fBufferRef->SetBuffer(rawCompressedBuffer, len, kFALSE);
+         } else {
+            fBufferRef = new TBufferFile(TBuffer::kRead, len, rawCompressedBuffer, kFALSE);
+         }
+         fBufferRef->SetParent(file);
+         fBufferRef->SetBufferOffset(mappedRef.Length());
+         fBuffer = rawCompressedBuffer;
+         if (compressed) {
+            return ReadBasketBuffersUncompressedCase();
+         }
+         goto AfterBuffer;
+      }
+      goto Uncompress;
+   }
+
    // Determine which buffer to use, so that we can avoid a memcpy in case of 
    // the basket was not compressed.
    TBuffer* readBufferRef;
@@ -523,6 +575,8 @@ Int_t TBasket::ReadBasketBuffers(Long64_t pos, Int_t len, TFile *file)
       }
    }
 
+Uncompress:
+
    // Initialize buffer to hold the uncompressed data
    // Note that in previous versions we didn't allocate buffers until we verified
    // the zip headers; this is no longer beforehand as the buffer lifetime is scoped
@@ -646,6 +700,10 @@ void TBasket::Reset()
    // Name, Title, fClassName, fBranch 
    // stay the same.
 
+   // The basket is going to be written, it cannot keep using the memory
+   // map of the file.
+   fBufferRef = R__DetachBasketBuffer(fBufferRef);
+
    // Downsize the buffer if needed.
    Int_t curSize = fBufferRef->BufferSize();
    // fBufferLen at this point is already reset, so use indirect measurements
@@ -934,27 +992,11 @@ Int_t TBasket::WriteBuffer()
       return nBytes>0 ? fKeylen+nout : -1;
    }
 
-   // Transfer fEntryOffset table at the end of fBuffer.
-   fLast = fBufferRef->Length();
-   if (fEntryOffset) {
-      // Note: We might want to investigate the compression gain if we 
-      // transform the Offsets to fBuffer in entry length to optimize 
-      // compression algorithm.  The aggregate gain on a (random) CMS files
-      // is around 5.5%. So the code could something like:
-      //      for(Int_t z = fNevBuf; z > 0; --z) {
-      //         if (fEntryOffset[z]) fEntryOffset[z] = fEntryOffset[z] - fEntryOffset[z-1];
-      //      }
-      fBufferRef->WriteArray(fEntryOffset,fNevBuf+1);
-      if (fDisplacement) {
-         fBufferRef->WriteArray(fDisplacement,fNevBuf+1);
-         delete [] fDisplacement; fDisplacement = 0;
-      }
+   if (fCompressedSize < 0) {
+      PrepareWriteBuffer();
    }
 
-   Int_t lbuf, nout, noutot, bufmax, nzip;
-   lbuf       = fBufferRef->Length();
-   fObjlen    = lbuf - fKeylen;
-
+   Int_t nout;
    fHeaderOnly = kTRUE;
    fCycle = fBranch->GetWriteBasket();
    Int_t cxlevel = fBranch->GetCompressionLevel();
@@ -962,53 +1004,45 @@ Int_t TBasket::WriteBuffer()
    if (cxlevel > 0) {
       Int_t nbuffers = 1 + (fObjlen - 1) / kMAXBUF;
       Int_t buflen = fKeylen + fObjlen + 9 * nbuffers + 28; //add 28 bytes in case object is placed in a deleted gap
-      InitializeCompressedBuffer(buflen, file);
-      if (!fCompressedBufferRef) {
-         Warning("WriteBuffer", "Unable to allocate the compressed buffer");
-         return -1;
-      }
-      fCompressedBufferRef->SetWriteMode();
-      fBuffer = fCompressedBufferRef->Buffer();
-      char *objbuf = fBufferRef->Buffer() + fKeylen;
-      char *bufcur = &fBuffer[fKeylen];
-      noutot = 0;
-      nzip   = 0;
-      for (Int_t i = 0; i < nbuffers; ++i) {
-         if (i == nbuffers - 1) bufmax = fObjlen - nzip;
-         else bufmax = kMAXBUF;
-         //compress the buffer
-         R__zipMultipleAlgorithm(cxlevel, &bufmax, objbuf, &bufmax, bufcur, &nout, cxAlgorithm);
-
-         // test if buffer has really been compressed. In case of small buffers 
-         // when the buffer contains random data, it may happen that the compressed
-         // buffer is larger than the input. In this case, we write the original uncompressed buffer
-         if (nout == 0 || nout >= fObjlen) {
-            nout = fObjlen;
-            // We used to delete fBuffer here, we no longer want to since
-            // the buffer (held by fCompressedBufferRef) might be re-used later.
-            fBuffer = fBufferRef->Buffer();
-            Create(fObjlen,file);
-            fBufferRef->SetBufferOffset(0);
-
-            Streamer(*fBufferRef);         //write key itself again
-            if ((nout+fKeylen)>buflen) {
-               Warning("WriteBuffer","Possible memory corruption due to compression algorithm, wrote %d bytes past the end of a block of %d bytes. fNbytes=%d, fObjLen=%d, fKeylen=%d",
-                  (nout+fKeylen-buflen),buflen,fNbytes,fObjlen,fKeylen);
-            }
-            goto WriteFile;
+      if (fCompressedSize < 0) {
+         InitializeCompressedBuffer(buflen, file);
+         if (!fCompressedBufferRef) {
+            Warning("WriteBuffer", "Unable to allocate the compressed buffer");
+            return -1;
          }
-         bufcur += nout;
-         noutot += nout;
-         objbuf += kMAXBUF;
-         nzip   += kMAXBUF;
+         nout = CompressPayload(cxlevel, cxAlgorithm);
+      } else {
+         // The payload was already compressed by CompressBuffer.
+         nout = fCompressedSize;
       }
-      nout = noutot;
-      Create(noutot,file);
-      fBufferRef->SetBufferOffset(0);
+      fCompressedSize = -1;
+
+      // test if buffer has really been compressed. In case of small buffers 
+      // when the buffer contains random data, it may happen that the compressed
+      // buffer is larger than the input. In this case, we write the original uncompressed buffer
+      if (nout == 0) {
+         nout = fObjlen;
+         // We used to delete fBuffer here, we no longer want to since
+         // the buffer (held by fCompressedBufferRef) might be re-used later.
+         fBuffer = fBufferRef->Buffer();
+         Create(fObjlen,file);
+         fBufferRef->SetBufferOffset(0);
+
+         Streamer(*fBufferRef);         //write key itself again
+         if ((nout+fKeylen)>buflen) {
+            Warning("WriteBuffer","Possible memory corruption due to compression algorithm, wrote %d bytes past the end of a block of %d bytes. fNbytes=%d, fObjLen=%d, fKeylen=%d",
+               (nout+fKeylen-buflen),buflen,fNbytes,fObjlen,fKeylen);
+         }
+      } else {
+         fBuffer = fCompressedBufferRef->Buffer();
+         Create(nout,file);
+         fBufferRef->SetBufferOffset(0);
 
-      Streamer(*fBufferRef);         //write key itself again
-      memcpy(fBuffer,fBufferRef->Buffer(),fKeylen);
+         Streamer(*fBufferRef);         //write key itself again
+         memcpy(fBuffer,fBufferRef->Buffer(),fKeylen);
+      }
    } else {
+      fCompressedSize = -1;
       fBuffer = fBufferRef->Buffer();
       Create(fObjlen,file);
       fBufferRef->SetBufferOffset(0);
@@ -1017,9 +1051,120 @@ Int_t TBasket::WriteBuffer()
       nout = fObjlen;
    }
 
-WriteFile:
    Int_t nBytes = WriteFileKeepBuffer();
    fHeaderOnly = kFALSE;
+   ReleasePrivateCompressedBuffer();
    return nBytes>0 ? fKeylen+nout : -1;
 }
 
+//_______________________________________________________________________
+Int_t TBasket::CompressBuffer()
+{
+   // Compress the content of this basket ahead of the call to WriteBuffer.
+   //
+   // The entry offset table is transferred at the end of the buffer and the
+   // payload is compressed into a buffer private to this basket (rather than
+   // into the transient buffer shared by all the baskets of the tree).
+   // No file operation is performed, so that the baskets of different branches
+   // may be compressed concurrently (see TTree::FlushBaskets).  The next call
+   // to WriteBuffer then only reserves the space in the file and writes the
+   // prepared bytes; the private buffer is released once written.
+   //
+   // The function returns the number of compressed bytes, 0 if the basket will
+   // be written uncompressed and -1 if the basket can not be prepared in advance.
+
+   if (fCompressedSize >= 0) return fCompressedSize;
+   if (!fBranch || !fBufferRef || fBufferRef->TestBit(TBufferFile::kNotDecompressed)) {
+      return -1;
+   }
+
+   PrepareWriteBuffer();
+
+   Int_t cxlevel = fBranch->GetCompressionLevel();
+   Int_t cxAlgorithm = fBranch->GetCompressionAlgorithm();
+   if (cxlevel <= 0) {
+      fCompressedSize = 0;
+      return fCompressedSize;
+   }
+   Int_t nbuffers = 1 + (fObjlen - 1) / kMAXBUF;
+   Int_t buflen = fKeylen + fObjlen + 9 * nbuffers + 28;
+   if (!fOwnsCompressedBuffer) {
+      fSharedCompressedBufferRef = fCompressedBufferRef;
+      fCompressedBufferRef = 0;
+      fOwnsCompressedBuffer = kTRUE;
+   }
+   fCompressedBufferRef = R__InitializeReadBasketBuffer(fCompressedBufferRef, buflen, 0);
+   fCompressedSize = CompressPayload(cxlevel, cxAlgorithm);
+   return fCompressedSize;
+}
+
+//_______________________________________________________________________
+void TBasket::PrepareWriteBuffer()
+{
+   // Transfer fEntryOffset table at the end of fBuffer and set fObjlen.
+
+   fLast = fBufferRef->Length();
+   if (fEntryOffset) {
+      // Note: We might want to investigate the compression gain if we 
+      // transform the Offsets to fBuffer in entry length to optimize 
+      // compression algorithm.  The aggregate gain on a (random) CMS files
+      // is around 5.5%. So the code could something like:
+      //      for(Int_t z = fNevBuf; z > 0; --z) {
+      //         if (fEntryOffset[z]) fEntryOffset[z] = fEntryOffset[z] - fEntryOffset[z-1];
+      //      }
+      fBufferRef->WriteArray(fEntryOffset,fNevBuf+1);
+      if (fDisplacement) {
+         fBufferRef->WriteArray(fDisplacement,fNevBuf+1);
+         delete [] fDisplacement; fDisplacement = 0;
+      }
+   }
+   fObjlen = fBufferRef->Length() - fKeylen;
+}
+
+//_______________________________________________________________________
+Int_t TBasket::CompressPayload(Int_t cxlevel, Int_t cxAlgorithm)
+{
+   // Compress the payload of fBufferRef into fCompressedBufferRef (after the
+   // space reserved for the key header).  The compressed buffer must be large
+   // enough to hold the result.
+   //
+   // Returns the number of compressed bytes or 0 if the payload could not be
+   // compressed (or would not be smaller once compressed).
+
+   fCompressedBufferRef->SetWriteMode();
+   char *objbuf = fBufferRef->Buffer() + fKeylen;
+   char *bufcur = fCompressedBufferRef->Buffer() + fKeylen;
+   Int_t nbuffers = 1 + (fObjlen - 1) / kMAXBUF;
+   Int_t nout, bufmax;
+   Int_t noutot = 0;
+   Int_t nzip   = 0;
+   for (Int_t i = 0; i < nbuffers; ++i) {
+      if (i == nbuffers - 1) bufmax = fObjlen - nzip;
+      else bufmax = kMAXBUF;
+      //compress the buffer
+      R__zipMultipleAlgorithm(cxlevel, &bufmax, objbuf, &bufmax, bufcur, &nout, cxAlgorithm);
+      if (nout == 0 || nout >= fObjlen) {
+         return 0;
+      }
+      bufcur += nout;
+      noutot += nout;
+      objbuf += kMAXBUF;
+      nzip   += kMAXBUF;
+   }
+   return noutot;
+}
+
+//_______________________________________________________________________
+void TBasket::ReleasePrivateCompressedBuffer()
+{
+   // Delete the compressed buffer allocated by CompressBuffer and go back to
+   // the transient buffer shared by the baskets of the tree.
+
+   if (!fSharedCompressedBufferRef) return;
+   if (fBuffer == fCompressedBufferRef->Buffer()) fBuffer = 0;
+   delete fCompressedBufferRef;
+   fCompressedBufferRef = fSharedCompressedBufferRef;
+   fSharedCompressedBufferRef = 0;
+   fOwnsCompressedBuffer = kFALSE;
+}
+
@@ -1152,6 +1152,93 @@ TList* TBranch::GetBrowsables() {
    return fBrowsables;
 }
 
+//______________________________________________________________________________
+Int_t TBranch::GetBulkEntries(Long64_t entry, void *array, Int_t nentries)
+{
+   // Read into array the values of at most nentries consecutive entries,
+   // starting at entry, all taken from the basket containing entry.
+   //
+   // The function returns the number of entries read, n, so that the values
+   // of the entries entry to entry+n-1 are in array. It returns 0 if entry
+   // does not exist and -1 in case of I/O error or if the branch is not
+   // supported.
+   //
+   // The branch must have a single leaf of a basic type with a fixed number
+   // of elements per entry (for example "px/F" or "pos[3]/D", but not
+   // "hits[nhits]/F" nor an object), so that its baskets hold the entries
+   // back to back. array must be able to hold nentries*leaf->GetLenStatic()
+   // values of the type of the leaf. The values of the whole range are
+   // converted from the big endian format of the file by a single call to
+   // TBuffer::ReadFastArray (see TLeaf::ReadBasketBulk) instead of a
+   // TLeaf::ReadBasket call per entry, and the address of the branch is
+   // neither used nor filled. A typical loop is:
+   //
+   //    Float_t px[4096];
+   //    Long64_t entry = 0;
+   //    Int_t n;
+   //    while ((n = branch->GetBulkEntries(entry, px, 4096)) > 0) {
+   //       for (Int_t i = 0; i < n; ++i) hpx->Fill(px[i]);
+   //       entry += n;
+   //    }
+
+   if (nentries <= 0 || !array) {
+      return 0;
+   }
+   if ((entry < fFirstEntry) || (entry >= fEntryNumber)) {
+      return 0;
+   }
+   TLeaf *leaf = fNleaves == 1 ? (TLeaf*)fLeaves.UncheckedAt(0) : 0;
+   if (!leaf || leaf->GetLeafCount() || fEntryOffsetLen > 0) {
+      return -1;
+   }
+
+   TBasket *basket = fCurrentBasket;
+   if (!basket || entry < fFirstBasketEntry || entry >= fNextBasketEntry) {
+      fReadBasket = TMath::BinarySearch(fWriteBasket + 1, fBasketEntry, entry);
+      if (fReadBasket < 0) {
+         fNextBasketEntry = -1;
+         Error("GetBulkEntries", "In the branch %s, no basket contains the entry %lld\n", GetName(), entry);
+         return -1;
+      }
+      if (fReadBasket == fWriteBasket) {
+         fNextBasketEntry = fEntryNumber;
+      } else {
+         fNextBasketEntry = fBasketEntry[fReadBasket+1];
+      }
+      fFirstBasketEntry = fBasketEntry[fReadBasket];
+      basket = (TBasket*) fBaskets.UncheckedAt(fReadBasket);
+      if (!basket) {
+         basket = GetBasket(fReadBasket);
+      }
+      fCurrentBasket = basket;
+      if (!basket) {
+         fFirstBasketEntry = -1;
+         fNextBasketEntry = -1;
+         return -1;
+      }
+   }
+   TBuffer *buf = basket->GetBufferRef();
+   if (!buf || basket->GetEntryOffset() || buf->TestBit(TBufferFile::kNotDecompressed)) {
+      return -1;
+   }
+   Int_t entrySize = basket->GetNevBufSize();
+   if (entrySize != leaf->GetLenType() * leaf->GetLenStatic()) {
+      return -1;
+   }
+   if (R__unlikely(!buf->IsReading())) {
+      basket->SetReadMode();
+   }
+
+   Long64_t last = fNextBasketEntry;
+   if (last > entry + nentries) last = entry + nentries;
+   Int_t n = (Int_t)(last - entry);
+   buf->SetBufferOffset(basket->GetKeylen() + (Int_t)(entry - fFirstBasketEntry) * entrySize);
+   if (!leaf->ReadBasketBulk(*buf, array, n * leaf->GetLenStatic())) {
+      return -1;
+   }
+   return n;
+}
+
 //______________________________________________________________________________
 const char * TBranch::GetClassName() const 
 {
@@ -59,11 +59,23 @@ Begin_Html
 <li> <b>Subtract</b>() - if the lists are for the same TTree, removes the entries of the second
                list from the first list. If the lists are for TChains, loops over all
                sub-lists
+<li> <b>Intersect</b>() - keeps only the entries which are also in the second list
+               (for the same TTree), looping over the sub-lists like Subtract()
+<li> <b>ContainsRange</b>(first, last) - true if one of the entries first to last is
+               in the list; the blocks are checked a word at a time
 <li> <b>GetEntry(n)</b> - returns the n-th entry number 
 <li> <b>Next</b>()      - returns next entry number. Note, that this function is 
                 much faster than GetEntry, and it's called when GetEntry() is called
                 for 2 or more indices in a row.
+<li> <b>NextEntries</b>(n, entries) - returns the next n entry numbers at once, e.g. to
+                plan the reading of the baskets
 </ul>
+<p>
+  Add(), Subtract() and Intersect() combine the lists block by block: two short lists
+  of entries are merged as sorted arrays, otherwise the blocks are combined as
+  bits, 16 entries at a time. The persistent representation of the blocks does
+  not change.
+</p>
 
 <h4>TTree::Draw() and TChain::Draw()</h4>
 
@@ -551,6 +563,35 @@ Int_t TEntryList::Contains(Long64_t entry, TTree *tree)
 
 }
 
+//______________________________________________________________________________
+Bool_t TEntryList::ContainsRange(Long64_t first, Long64_t last)
+{
+//Returns true if at least one of the entries first to last (included) is in
+//the list, e.g. to know whether a basket holding these entries must be read.
+//For a list with sub-lists, the entries are those of the current sub-list,
+//as in Contains().
+
+   if (fBlocks) {
+      if (first < 0) first = 0;
+      Long64_t lastblock = last/kBlockSize;
+      if (lastblock >= fNBlocks) lastblock = fNBlocks-1;
+      TEntryListBlock *block = 0;
+      for (Long64_t i=first/kBlockSize; i<=lastblock; i++){
+         block = (TEntryListBlock*)fBlocks->UncheckedAt(i);
+         Long64_t offset = i*kBlockSize;
+         Int_t low = first > offset ? Int_t(first-offset) : 0;
+         Int_t high = last < offset+kBlockSize-1 ? Int_t(last-offset) : kBlockSize-1;
+         if (block->ContainsRange(low, high)) return kTRUE;
+      }
+      return kFALSE;
+   }
+   if (fLists) {
+      if (!fCurrent) fCurrent = (TEntryList*)fLists->First();
+      if (fCurrent) return fCurrent->ContainsRange(first, last);
+   }
+   return kFALSE;
+}
+
 //______________________________________________________________________________
 void TEntryList::DirectoryAutoAdd(TDirectory* dir)
 {
@@ -978,6 +1019,57 @@ Long64_t TEntryList::Next()
    }
 }
 
+//______________________________________________________________________________
+Int_t TEntryList::NextEntries(Int_t n, Long64_t *entries)
+{
+   //Put in entries the next n entry numbers, as n calls to Next() would, and
+   //return their number. Fewer entries are returned at the end of the list
+   //and, for a list with sub-lists, at the end of the current sub-list (the
+   //entries are those of the tree of GetCurrentList()); 0 when all the
+   //entries were returned.
+   //The bits of the blocks are scanned a word at a time, skipping the empty
+   //words, which makes this much faster than Next() for long lists.
+
+   if (n <= 0 || fN == fLastIndexQueried+1 || fN == 0) return 0;
+   Int_t k = 0;
+   if (fBlocks){
+      const Int_t kChunk = 1024;
+      Int_t local[kChunk];
+      Int_t iblock = fLastIndexReturned/kBlockSize;
+      TEntryListBlock *current_block = (TEntryListBlock*)fBlocks->UncheckedAt(iblock);
+      while (k < n && fLastIndexQueried+1 < fN){
+         Int_t nread = current_block->NextEntries(TMath::Min(n-k, kChunk), local);
+         if (nread == 0){
+            //this block is done, go to the next one
+            if (iblock >= fNBlocks-1) break;
+            iblock++;
+            current_block = (TEntryListBlock*)fBlocks->UncheckedAt(iblock);
+            current_block->ResetIndices();
+            continue;
+         }
+         Long64_t offset = Long64_t(iblock)*kBlockSize;
+         for (Int_t i=0; i<nread; i++)
+            entries[k+i] = local[i] + offset;
+         k += nread;
+         fLastIndexQueried += nread;
+         fLastIndexReturned = entries[k-1];
+      }
+      return k;
+   }
+   if (!fLists) return 0;
+   //the first entry may be in the next sub-list
+   Long64_t result = Next();
+   if (result < 0 || !fCurrent) return 0;
+   entries[k++] = result;
+   if (n > 1){
+      Int_t nread = fCurrent->NextEntries(n-1, entries+1);
+      k += nread;
+      fLastIndexQueried += nread;
+      fLastIndexReturned = entries[k-1];
+   }
+   return k;
+}
+
 
 //______________________________________________________________________________
 void TEntryList::OptimizeStorage()
@@ -1233,13 +1325,19 @@ void TEntryList::Subtract(const TEntryList *elist)
          //second list is also only for 1 tree
          if (!strcmp(elist->fTreeName.Data(),fTreeName.Data()) && 
              !strcmp(elist->fFileName.Data(),fFileName.Data())){
-            //same tree
-            Long64_t n2 = elist->GetN();
-            Long64_t entry;
-            for (Int_t i=0; i<n2; i++){
-               entry = (const_cast<TEntryList*>(elist))->GetEntry(i);
-               Remove(entry);
+            //same tree, subtract block by block
+            if (!elist->fBlocks) return;
+            Int_t nmin = TMath::Min(fNBlocks, elist->fNBlocks);
+            TEntryListBlock *block1 = 0;
+            TEntryListBlock *block2 = 0;
+            for (Int_t i=0; i<nmin; i++){
+               block1 = (TEntryListBlock*)fBlocks->UncheckedAt(i);
+               block2 = (TEntryListBlock*)elist->fBlocks->UncheckedAt(i);
+               Long64_t nold = block1->GetNPassed();
+               fN = fN - nold + block1->Subtract(block2);
             }
+            fLastIndexQueried = -1;
+            fLastIndexReturned = 0;
          } else {
             //different trees
             return;
@@ -1276,6 +1374,55 @@ void TEntryList::Subtract(const TEntryList *elist)
 
 }
 
+//______________________________________________________________________________
+void TEntryList::Intersect(const TEntryList *elist)
+{
+   //Keep only the entries of this entry list which are also contained in elist
+
+   TEntryList *templist = 0;
+   if (!fLists){
+      if (!fBlocks) return;
+      //find the list of elist for the same tree as this list
+      const TEntryList *other = 0;
+      if (!elist->fLists){
+         if (!strcmp(elist->fTreeName.Data(),fTreeName.Data()) && 
+             !strcmp(elist->fFileName.Data(),fFileName.Data()))
+            other = elist;
+      } else {
+         TIter next1(elist->GetLists());
+         while ((templist = (TEntryList*)next1())){
+            if (!strcmp(templist->fTreeName.Data(),fTreeName.Data()) && 
+                !strcmp(templist->fFileName.Data(),fFileName.Data())){
+               other = templist;
+               break;
+            }
+         }
+      }
+      //intersect block by block, the blocks missing in elist are empty
+      Int_t nother = (other && other->fBlocks) ? other->fNBlocks : 0;
+      TEntryListBlock empty;
+      TEntryListBlock *block1 = 0;
+      TEntryListBlock *block2 = 0;
+      fN = 0;
+      for (Int_t i=0; i<fNBlocks; i++){
+         block1 = (TEntryListBlock*)fBlocks->UncheckedAt(i);
+         block2 = i < nother ? (TEntryListBlock*)other->fBlocks->UncheckedAt(i) : &empty;
+         fN += block1->Intersect(block2);
+      }
+   } else {
+      //this list has sublists
+      TIter next2(fLists);
+      fN = 0;
+      while ((templist = (TEntryList*)next2())){
+         templist->Intersect(elist);
+         fN += templist->GetN();
+      }
+      fCurrent = 0;
+   }
+   fLastIndexQueried = -1;
+   fLastIndexReturned = 0;
+}
+
 //______________________________________________________________________________
 TEntryList operator||(TEntryList &elist1, TEntryList &elist2)
 {
@@ -39,9 +39,14 @@ Begin_Html
  <li> <b>Merge</b>() - adds all entries from one block to the other. If the first block 
              uses array representation, it's changed to bits representation only
              if the total number of passing entries is still less than kBlockSize
+ <li> <b>Intersect</b>(), <b>Subtract</b>() - keep only the entries which are (are not)
+             in the other block. Like Merge(), they work on whole 16 bits words
+             when one of the blocks uses bits representation.
+ <li> <b>ContainsRange</b>(first, last) - true if one of the entries first to last passes
  <li> <b>GetEntry(n)</b> - returns n-th non-zero entry.
  <li> <b>Next</b>()      - return next non-zero entry. In case of representation 1), Next()
                  is faster than GetEntry()
+ <li> <b>NextEntries</b>(n, entries) - returns the next n non-zero entries at once
 </ul>
 End_Html */
 
@@ -49,8 +54,42 @@ End_Html */
 #include "TEntryListBlock.h"
 #include "TString.h"
 
+#include <algorithm>
+
 ClassImp(TEntryListBlock)
 
+namespace {
+   enum EBitOper { kOr, kAnd, kAndNot };
+
+   //______________________________________________________________________________
+   inline Int_t CountBits(UInt_t word)
+   {
+      // Number of bits set in word.
+
+#if defined(__GNUC__)
+      return __builtin_popcount(word);
+#else
+      Int_t n = 0;
+      for (; word; word &= word-1) ++n;
+      return n;
+#endif
+   }
+
+   //______________________________________________________________________________
+   inline Int_t LowestBit(UInt_t word)
+   {
+      // Position of the lowest bit set in word (which must not be 0).
+
+#if defined(__GNUC__)
+      return __builtin_ctz(word);
+#else
+      Int_t n = 0;
+      for (; (word & 1) == 0; word >>= 1) ++n;
+      return n;
+#endif
+   }
+}
+
 //______________________________________________________________________________
 TEntryListBlock::TEntryListBlock()
 {
@@ -238,16 +277,48 @@ Int_t TEntryListBlock::Contains(Int_t entry)
    return 0;
 }
 
+//______________________________________________________________________________
+Bool_t TEntryListBlock::ContainsRange(Int_t first, Int_t last)
+{
+//true if the block contains at least one of the entries first to last (included)
+
+   if (first < 0) first = 0;
+   if (last >= kBlockSize*16) last = kBlockSize*16-1;
+   if (first > last) return kFALSE;
+   if (!fIndices)
+      return !fPassing;
+   if (fType==0){
+      //bits
+      Int_t i1 = first>>4;
+      Int_t i2 = last>>4;
+      UInt_t lowmask = (0xFFFF << (first & 15)) & 0xFFFF;
+      UInt_t highmask = 0xFFFF >> (15 - (last & 15));
+      if (i1==i2) return (fIndices[i1] & lowmask & highmask)!=0;
+      if (fIndices[i1] & lowmask) return kTRUE;
+      for (Int_t i=i1+1; i<i2; i++)
+         if (fIndices[i]) return kTRUE;
+      return (fIndices[i2] & highmask)!=0;
+   }
+   //list
+   UShort_t *low = std::lower_bound(fIndices, fIndices+fNPassed, first);
+   if (fPassing)
+      return low < fIndices+fNPassed && *low <= last;
+   //some entry of the range is not in the list of entries which don't pass
+   UShort_t *high = std::upper_bound(low, fIndices+fNPassed, last);
+   return high - low < last - first + 1;
+}
+
 //______________________________________________________________________________
 Int_t TEntryListBlock::Merge(TEntryListBlock *block)
 {
    //Merge with the other block
    //Returns the resulting number of entries in the block
 
-   Int_t i, j;
+   Int_t i;
    if (block->GetNPassed() == 0) return GetNPassed();
    if (GetNPassed() == 0){
       //this block is empty
+      if (fIndices) delete [] fIndices;
       fN = block->fN;
       fIndices = new UShort_t[fN];
       for (i=0; i<fN; i++)
@@ -260,111 +331,151 @@ Int_t TEntryListBlock::Merge(TEntryListBlock *block)
       fLastIndexQueried = -1;
       return fNPassed;
    }
-   if (fType==0){
-      //stored as bits
-      if (block->fType == 0){
-         for (i=0; i<kBlockSize*16; i++){
-            if (block->Contains(i))
-               Enter(i);
-         }
-      } else {
-         if (block->fPassing){
-            //the other block stores entries that pass
-            for (i=0; i<block->fNPassed; i++){
-               Enter(block->fIndices[i]);
-            }
-         } else {
-            //the other block stores entries that don't pass
-            if (block->fNPassed==0){
-               for (i=0; i<kBlockSize*16; i++){
-                  Enter(i);
-               }
-            }
-            for (j=0; j<block->fIndices[0]; j++)
-               Enter(j);
-            for (i=0; i<block->fNPassed-1; i++){
-               for (j=block->fIndices[i]+1; j<block->fIndices[i+1]; j++){
-                  Enter(j);
-               }
-            }
-            for (j=block->fIndices[block->fNPassed-1]+1; j<kBlockSize*16; j++)
-               Enter(j);
-         }
-      }
+   if (fType==1 && fPassing && block->fType==1 && block->fPassing &&
+       GetNPassed() + block->GetNPassed() <= kBlockSize){
+      //both blocks are short lists of passing entries: make a bigger list
+      UShort_t *newlist = new UShort_t[fNPassed + block->fNPassed];
+      UShort_t *newend = std::set_union(fIndices, fIndices+fNPassed,
+                                        block->fIndices, block->fIndices+block->fNPassed, newlist);
+      delete [] fIndices;
+      fIndices = newlist;
+      fNPassed = newend - newlist;
+      fN = fNPassed;
    } else {
-      //stored as a list
-      if (GetNPassed() + block->GetNPassed() > kBlockSize){
-         //change to bits
-         UShort_t *bits = new UShort_t[kBlockSize];
-         Transform(1, bits);
-         Merge(block);
-      } else {
-         //this is only possible if fPassing=1 in both blocks
-         if (block->fType==1){
-            //second block stored as a list
-            //make a bigger list
-            Int_t en = block->fNPassed;
-            Int_t newsize = fNPassed + en;
-            UShort_t *newlist = new UShort_t[newsize];
-            UShort_t *elst = block->fIndices;
-            Int_t newpos, elpos;
-            newpos = elpos = 0;
-            for (i=0; i<fNPassed; i++) {
-               while (elpos < en && fIndices[i] > elst[elpos]) {
-                  newlist[newpos] = elst[elpos];
-                  newpos++;
-                  elpos++;
-               }
-               if (fIndices[i] == elst[elpos]) elpos++;
-               newlist[newpos] = fIndices[i];
-               newpos++;
-            }
-            while (elpos < en) {
-               newlist[newpos] = elst[elpos];
-               newpos++;
-               elpos++;
-            }
-            delete [] fIndices;
-            fIndices = newlist;
-            fNPassed = newpos;
-            fN = fNPassed;
-         } else {
-            //second block is stored as bits
-
-            Int_t en = block->fNPassed;
-            Int_t newsize = fNPassed + en;
-            UShort_t *newlist = new UShort_t[newsize];
-            Int_t newpos, current;
-            newpos = current = 0;
-            for (i=0; i<kBlockSize*16; i++){
-               if (!block->Contains(i)) continue;
-               while(current < fNPassed && fIndices[current]<i){
-                  newlist[newpos] = fIndices[current];
-                  current++;
-                  newpos++;
-               }
-               if (fIndices[current]==i) current++;
-               newlist[newpos] = i;
-               newpos++;
-            }
-            while(current<fNPassed){
-               newlist[newpos] = fIndices[current];
-               newpos++;
-               current++;
-            }
-            delete [] fIndices;
-            fIndices = newlist;
-            fNPassed = newpos;
-            fN = fNPassed;
-         }
-      }
+      CombineBits(block, kOr);
+   }
+   fLastIndexQueried = -1;
+   fLastIndexReturned = -1;
+   OptimizeStorage();
+   return GetNPassed();
+}
+
+//______________________________________________________________________________
+Int_t TEntryListBlock::Intersect(TEntryListBlock *block)
+{
+   //Keep only the entries which are also in the other block
+   //Returns the resulting number of entries in the block
+
+   if (GetNPassed() == 0) return 0;
+   if (block->GetNPassed() == 0){
+      //the result is empty, go back to the state of a new block
+      if (fIndices) delete [] fIndices;
+      fIndices = 0;
+      fN = kBlockSize;
+      fNPassed = 0;
+      fType = -1;
+      fPassing = 1;
+   } else if (fType==1 && fPassing && block->fType==1 && block->fPassing){
+      UShort_t *newlist = new UShort_t[fNPassed < block->fNPassed ? fNPassed : block->fNPassed];
+      UShort_t *newend = std::set_intersection(fIndices, fIndices+fNPassed,
+                                               block->fIndices, block->fIndices+block->fNPassed, newlist);
+      delete [] fIndices;
+      fIndices = newlist;
+      fNPassed = newend - newlist;
+      fN = fNPassed;
+   } else {
+      CombineBits(block, kAnd);
+   }
+   fCurrent = 0;
+   fLastIndexQueried = -1;
+   fLastIndexReturned = -1;
+   OptimizeStorage();
+   return GetNPassed();
+}
+
+//______________________________________________________________________________
+Int_t TEntryListBlock::Subtract(TEntryListBlock *block)
+{
+   //Remove the entries which are in the other block
+   //Returns the resulting number of entries in the block
+
+   if (GetNPassed() == 0 || block->GetNPassed() == 0) return GetNPassed();
+   if (fType==1 && fPassing && block->fType==1 && block->fPassing){
+      UShort_t *newlist = new UShort_t[fNPassed];
+      UShort_t *newend = std::set_difference(fIndices, fIndices+fNPassed,
+                                             block->fIndices, block->fIndices+block->fNPassed, newlist);
+      delete [] fIndices;
+      fIndices = newlist;
+      fNPassed = newend - newlist;
+      fN = fNPassed;
+   } else {
+      CombineBits(block, kAndNot);
    }
+   fCurrent = 0;
    fLastIndexQueried = -1;
    fLastIndexReturned = -1;
    OptimizeStorage();
    return GetNPassed();
 }
 
+//______________________________________________________________________________
+void TEntryListBlock::FillBits(UShort_t *bits) const
+{
+   //Fill bits (kBlockSize words) with the bits representation of this block,
+   //whatever its current representation
+
+   Int_t i;
+   if (fType==0 && fIndices){
+      for (i=0; i<kBlockSize; i++)
+         bits[i] = fIndices[i];
+      return;
+   }
+   Bool_t all = fType==1 && !fPassing;
+   for (i=0; i<kBlockSize; i++)
+      bits[i] = all ? 0xFFFF : 0;
+   if (fType!=1 || !fIndices) return;
+   for (i=0; i<fNPassed; i++)
+      bits[fIndices[i]>>4] ^= 1<<(fIndices[i] & 15);
+}
+
+//______________________________________________________________________________
+void TEntryListBlock::CombineBits(const TEntryListBlock *block, Int_t oper)
+{
+   //Switch this block to bits representation and combine it, word by word,
+   //with the bits of the other block: oper is kOr (union), kAnd (intersection)
+   //or kAndNot (difference)
+
+   Int_t i;
+   if (!fIndices){
+      fIndices = new UShort_t[kBlockSize];
+      for (i=0; i<kBlockSize; i++)
+         fIndices[i] = 0;
+      fNPassed = 0;
+      fPassing = 1;
+      fType = 0;
+      fN = kBlockSize;
+   } else if (fType!=0){
+      UShort_t *bits = new UShort_t[kBlockSize];
+      Transform(1, bits);
+   }
+
+   const UShort_t *other = block->fIndices;
+   UShort_t *temp = 0;
+   if (block->fType!=0 || !other){
+      temp = new UShort_t[kBlockSize];
+      block->FillBits(temp);
+      other = temp;
+   }
+   //simple loops on the words, which the compiler can vectorize
+   switch (oper) {
+      case kOr:
+         for (i=0; i<kBlockSize; i++) fIndices[i] |= other[i];
+         break;
+      case kAnd:
+         for (i=0; i<kBlockSize; i++) fIndices[i] &= other[i];
+         break;
+      case kAndNot:
+         for (i=0; i<kBlockSize; i++) fIndices[i] &= ~other[i];
+         break;
+   }
+   delete [] temp;
+
+   Int_t npassed = 0;
+   for (i=0; i<kBlockSize; i++)
+      npassed += CountBits(fIndices[i]);
+   fNPassed = npassed;
+}
+
 //______________________________________________________________________________
 Int_t TEntryListBlock::GetNPassed()
 {
@@ -448,45 +559,57 @@ Int_t TEntryListBlock::Next()
 //Return the next non-zero entry
 //Faster than GetEntry() function
 
-   if (fLastIndexQueried==GetNPassed()-1){
-      fLastIndexQueried=-1;
+   Int_t entry;
+   if (NextEntries(1, &entry) == 0) return -1;
+   return entry;
+}
+
+//______________________________________________________________________________
+Int_t TEntryListBlock::NextEntries(Int_t n, Int_t *entries)
+{
+//Put in entries the next n non-zero entries (fewer if the end of the block
+//is reached) and return their number, like n calls to Next().
+//Returns 0, and resets the indices, when all the entries were returned.
+
+   Int_t remaining = GetNPassed()-1-fLastIndexQueried;
+   if (remaining <= 0){
+      fLastIndexQueried = -1;
       fLastIndexReturned = -1;
-      return -1;
+      return 0;
    }
+   if (n > remaining) n = remaining;
+   if (n <= 0) return 0;
 
+   Int_t k = 0;
    if (fType==0) {
-      //bits
-      Int_t i=0;
-      Int_t j=0;
-      fLastIndexReturned++;
-      i = fLastIndexReturned>>4;
-      j = fLastIndexReturned & 15;
-      Bool_t result=(fIndices[i] & (1<<j))!=0;
-      while (result==0){
-         if (j==15) {j=0; i++;}
-         else j++;
-         result = (fIndices[i] & (1<<j))!=0;
+      //bits: skip the empty words and extract the set bits of the others
+      Int_t next = fLastIndexReturned+1;
+      Int_t i = next>>4;
+      UInt_t word = (fIndices[i] >> (next & 15)) << (next & 15);
+      while (k<n) {
+         while (!word) word = fIndices[++i];
+         entries[k++] = i*16 + LowestBit(word);
+         word &= word-1;
       }
-      fLastIndexReturned = i*16+j;
-      fLastIndexQueried++;
-      return fLastIndexReturned;
-
-   } 
-   if (fType==1) {
-      fLastIndexQueried++;
-      if (fPassing){
-         fLastIndexReturned = fIndices[fLastIndexQueried];
-         return fIndices[fLastIndexQueried];
-      } else {
-         fLastIndexReturned++;
-         while (!Contains(fLastIndexReturned)){
-            fLastIndexReturned++;
-            }
-         return fLastIndexReturned;
+   } else if (fPassing) {
+      for (; k<n; k++)
+         entries[k] = fIndices[fLastIndexQueried+1+k];
+   } else {
+      //list of the entries which don't pass: return the gaps
+      Int_t entry = fLastIndexReturned+1;
+      Int_t pos = fIndices ? std::lower_bound(fIndices, fIndices+fNPassed, entry) - fIndices : 0;
+      while (k<n) {
+         if (pos<fNPassed && fIndices[pos]==entry) {
+            pos++;
+         } else {
+            entries[k++] = entry;
+         }
+         entry++;
       }
-      
    }
-   return -1;
+   fLastIndexQueried += n;
+   fLastIndexReturned = entries[n-1];
+   return n;
 }
 
 //______________________________________________________________________________
@@ -220,6 +220,26 @@ Long64_t TEntryListFromFile::Next()
    
 }
 
+//______________________________________________________________________________
+Int_t TEntryListFromFile::NextEntries(Int_t n, Long64_t *entries)
+{
+   //Returns the next n entries (fewer at the end of the list of the current
+   //file), see TEntryList::NextEntries().
+
+   if (n <= 0) return 0;
+   Long64_t retentry = Next();
+   if (retentry < 0 || !fCurrent) return 0;
+   entries[0] = retentry;
+   Int_t k = 1;
+   if (n > 1){
+      Int_t nread = fCurrent->NextEntries(n-1, entries+1);
+      k += nread;
+      fLastIndexQueried += nread;
+      fLastIndexReturned = entries[k-1];
+   }
+   return k;
+}
+
 //______________________________________________________________________________
 Int_t TEntryListFromFile::LoadList(Int_t listnumber)
 {
@@ -151,6 +151,16 @@ void TLeafB::ReadBasket(TBuffer &b)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TLeafB::ReadBasketBulk(TBuffer &b, void *array, Int_t n)
+{
+   // Read n consecutive values from the basket buffer into array, without
+   // going through the leaf buffer (see TBranch::GetBulkEntries).
+
+   b.ReadFastArray((Char_t*)array, n);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TLeafB::ReadBasketExport(TBuffer& b, TClonesArray* list, Int_t n)
 {
@@ -138,6 +138,16 @@ void TLeafD::ReadBasket(TBuffer &b)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TLeafD::ReadBasketBulk(TBuffer &b, void *array, Int_t n)
+{
+   // Read n consecutive values from the basket buffer into array, without
+   // going through the leaf buffer (see TBranch::GetBulkEntries).
+
+   b.ReadFastArray((Double_t*)array, n);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TLeafD::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
 {
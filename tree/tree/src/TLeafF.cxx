@@ -142,6 +142,16 @@ void TLeafF::ReadBasket(TBuffer &b)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TLeafF::ReadBasketBulk(TBuffer &b, void *array, Int_t n)
+{
+   // Read n consecutive values from the basket buffer into array, without
+   // going through the leaf buffer (see TBranch::GetBulkEntries).
+
+   b.ReadFastArray((Float_t*)array, n);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TLeafF::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
 {
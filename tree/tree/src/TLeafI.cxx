@@ -177,6 +177,16 @@ void TLeafI::ReadBasket(TBuffer &b)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TLeafI::ReadBasketBulk(TBuffer &b, void *array, Int_t n)
+{
+   // Read n consecutive values from the basket buffer into array, without
+   // going through the leaf buffer (see TBranch::GetBulkEntries).
+
+   b.ReadFastArray((Int_t*)array, n);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TLeafI::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
 {
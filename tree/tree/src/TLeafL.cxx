@@ -177,6 +177,16 @@ void TLeafL::ReadBasket(TBuffer &b)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TLeafL::ReadBasketBulk(TBuffer &b, void *array, Int_t n)
+{
+   // Read n consecutive values from the basket buffer into array, without
+   // going through the leaf buffer (see TBranch::GetBulkEntries).
+
+   b.ReadFastArray((Long64_t*)array, n);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TLeafL::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
 {
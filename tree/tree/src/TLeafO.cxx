@@ -148,6 +148,16 @@ void TLeafO::ReadBasket(TBuffer &b)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TLeafO::ReadBasketBulk(TBuffer &b, void *array, Int_t n)
+{
+   // Read n consecutive values from the basket buffer into array, without
+   // going through the leaf buffer (see TBranch::GetBulkEntries).
+
+   b.ReadFastArray((Bool_t*)array, n);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TLeafO::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
 {
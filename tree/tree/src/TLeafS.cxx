@@ -173,6 +173,16 @@ void TLeafS::ReadBasket(TBuffer &b)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TLeafS::ReadBasketBulk(TBuffer &b, void *array, Int_t n)
+{
+   // Read n consecutive values from the basket buffer into array, without
+   // going through the leaf buffer (see TBranch::GetBulkEntries).
+
+   b.ReadFastArray((Short_t*)array, n);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TLeafS::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
 {
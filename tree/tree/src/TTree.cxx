@@ -365,6 +365,9 @@
 #include "TBranchSTL.h"
 #include "TSchemaRuleSet.h"
 #include "TFileMergeInfo.h"
+#include "TThread.h"
+#include "TThreadPool.h"
+#include "Compression.h"
 
 #include <cstddef>
 #include <fstream>
@@ -372,9 +375,13 @@
 #include <string>
 #include <stdio.h>
 #include <limits.h>
+#include <vector>
+
+extern "C" int R__ZipMode;
 
 Int_t    TTree::fgBranchStyle = 1;  // Use new TBranch style with TBranchElement.
 Long64_t TTree::fgMaxTreeSize = 100000000000LL;
+Int_t    TTree::fgImplicitMT  = 0;  // Process, Draw and FlushBaskets run sequentially by default.
 
 TTree* gTree;
 
@@ -2390,6 +2397,35 @@ Int_t TTree::BuildIndex(const char* majorname, const char* minorname /* = "0" */
    return fTreeIndex->GetN();
 }
 
+//______________________________________________________________________________
+Int_t TTree::BuildZoneMap(const char* columns)
+{
+   // Build a zone map (TTreeZoneMap) of the expressions given in columns,
+   // separated by ':' (e.g. "run:lumi:trigger"): the minimum, the maximum
+   // and the OR of the bits of each expression in each cluster of the tree.
+   // TTree::Draw uses it to skip the clusters where its selection cannot be
+   // true, without reading their baskets. See TTreeZoneMap for the
+   // selections which can use it.
+   //
+   // The zone map is stored in the list of user info of the tree (replacing
+   // a previous one), and is saved in the file with the tree header, e.g.
+   // with tree.Write("", TObject::kOverwrite) for a file open in update mode.
+   // For a TChain, build a zone map for each of its trees.
+   //
+   // The return value is 1 if the zone map was built, 0 otherwise.
+
+   TObject *zones = GetPlayer()->BuildZoneMap(this, columns);
+   if (!zones) return 0;
+   TList *info = GetUserInfo();
+   TObject *old = info->FindObject(zones->GetName());
+   if (old) {
+      info->Remove(old);
+      delete old;
+   }
+   info->Add(zones);
+   return 1;
+}
+
 //______________________________________________________________________________
 TStreamerInfo* TTree::BuildStreamerInfo(TClass* cl, void* pointer /* = 0 */, Bool_t canOptimize /* = kTRUE */ )
 {
@@ -4543,11 +4579,99 @@ Int_t TTree::Fit(const char* funcname, const char* varexp, const char* selection
    return -1;
 }
 
+namespace {
+   struct TBasketCompressionDone {
+      TMutex     fMutex;
+      TCondition fCondition;
+      size_t     fPending;   // Number of baskets of the flush not yet compressed
+      TBasketCompressionDone(size_t pending) : fCondition(&fMutex), fPending(pending) {}
+   };
+
+   struct TBasketCompressionJob {
+      TBasket                *fBasket;
+      TBasketCompressionDone *fDone;
+   };
+
+   class TBasketCompressionTask : public TThreadPoolTaskImp<TBasketCompressionTask, TBasketCompressionJob> {
+   public:
+      bool runTask(TBasketCompressionJob job) {
+         job.fBasket->CompressBuffer();
+         TLockGuard lock(&job.fDone->fMutex);
+         if (--job.fDone->fPending == 0) job.fDone->fCondition.Signal();
+         return true;
+      }
+   };
+
+   typedef TThreadPool<TBasketCompressionTask, TBasketCompressionJob> TBasketCompressionPool_t;
+
+   TVirtualMutex            *gCompressionPoolMutex = 0;
+   TBasketCompressionPool_t *gCompressionPool = 0;
+   Int_t                     gCompressionPoolThreads = 0;
+   TBasketCompressionTask    gCompressionTask;
+
+   //___________________________________________________________________________
+   TBasketCompressionPool_t *R__GetCompressionPool(Int_t nthreads)
+   {
+      // Return the pool shared by the TTree::FlushBaskets of all the trees of
+      // the process, creating it at the first call and adding threads when
+      // more are requested. The pool lives until the end of the process.
+
+      R__LOCKGUARD2(gCompressionPoolMutex);
+      if (!gCompressionPool) {
+         TThread::Initialize();
+         gCompressionPool = new TBasketCompressionPool_t(nthreads);
+         gCompressionPoolThreads = nthreads;
+      }
+      for (; gCompressionPoolThreads < nthreads; ++gCompressionPoolThreads) {
+         gCompressionPool->AddThread();
+      }
+      return gCompressionPool;
+   }
+
+   //___________________________________________________________________________
+   void R__CollectPendingBaskets(TBranch *branch, std::vector<TBasket*> &baskets)
+   {
+      // Add to 'baskets' the baskets of branch (and of its sub-branches) which
+      // will be written by the next TBranch::FlushBaskets and which can be
+      // compressed concurrently (the very old compression algorithm uses a
+      // global state and is thus excluded).
+
+      if (branch->GetDirectory() && branch->GetCompressionLevel() > 0) {
+         Int_t algorithm = branch->GetCompressionAlgorithm();
+         if (algorithm == ROOT::kUseGlobalSetting) algorithm = R__ZipMode;
+         if (algorithm != ROOT::kUseGlobalSetting && algorithm != ROOT::kOldCompressionAlgo) {
+            TObjArray *lbaskets = branch->GetListOfBaskets();
+            Int_t maxbasket = branch->GetWriteBasket() + 1;
+            if (maxbasket > lbaskets->GetSize()) maxbasket = lbaskets->GetSize();
+            for (Int_t i = 0; i < maxbasket; ++i) {
+               TBasket *basket = (TBasket*)lbaskets->UncheckedAt(i);
+               if (basket && basket->IsA() == TBasket::Class() && basket->GetNevBuf()
+                   && branch->GetBasketSeek(i) == 0 && basket->GetBufferRef()->IsWriting()) {
+                  baskets.push_back(basket);
+               }
+            }
+         }
+      }
+      TObjArray *lb = branch->GetListOfBranches();
+      Int_t nb = lb->GetEntriesFast();
+      for (Int_t j = 0; j < nb; ++j) {
+         TBranch *sub = (TBranch*) lb->UncheckedAt(j);
+         if (sub) R__CollectPendingBaskets(sub, baskets);
+      }
+   }
+}
+
 //______________________________________________________________________________
 Int_t TTree::FlushBaskets() const
 {
    // Write to disk all the basket that have not yet been individually written.
    //
+   // When TTree::SetImplicitMT was called with more than one thread, the
+   // baskets of the different branches are first compressed concurrently
+   // (see TBasket::CompressBuffer) and then written sequentially, so that the
+   // content of the file does not depend on the number of threads. The
+   // compression threads are shared by all the trees and kept between flushes.
+   //
    // Return the number of bytes written or -1 in case of write error.
 
    if (!fDirectory) return 0;
@@ -4555,6 +4679,27 @@ Int_t TTree::FlushBaskets() const
    Int_t nerror = 0;
    TObjArray *lb = const_cast<TTree*>(this)->GetListOfBranches();
    Int_t nb = lb->GetEntriesFast();
+   if (fgImplicitMT > 1) {
+      // Compress the pending baskets concurrently, the loop below then only
+      // writes the already compressed buffers (in the usual order).
+      std::vector<TBasket*> baskets;
+      for (Int_t j = 0; j < nb; j++) {
+         TBranch* branch = (TBranch*) lb->UncheckedAt(j);
+         if (branch) R__CollectPendingBaskets(branch, baskets);
+      }
+      if (baskets.size() > 1) {
+         TBasketCompressionPool_t *pool = R__GetCompressionPool(fgImplicitMT);
+         TBasketCompressionDone done(baskets.size());
+         for (UInt_t i = 0; i < baskets.size(); ++i) {
+            TBasketCompressionJob job = { baskets[i], &done };
+            pool->PushTask(gCompressionTask, job);
+         }
+         TLockGuard lock(&done.fMutex);
+         while (done.fPending > 0) {
+            done.fCondition.Wait();
+         }
+      }
+   }
    for (Int_t j = 0; j < nb; j++) {
       TBranch* branch = (TBranch*) lb->UncheckedAt(j);
       if (branch) {
@@ -5154,6 +5299,16 @@ const char* TTree::GetFriendAlias(TTree* tree) const
    return 0;
 }
 
+//______________________________________________________________________________
+Int_t TTree::GetImplicitMT()
+{
+   // Static function returning the number of threads used by TTree::Process,
+   // TTree::Draw and TTree::FlushBaskets (see TTree::SetImplicitMT).
+   // A value of 0 or 1 means that the entries are processed sequentially.
+
+   return fgImplicitMT;
+}
+
 //______________________________________________________________________________
 TIterator* TTree::GetIteratorOnAllLeaves(Bool_t dir)
 {
@@ -6363,6 +6518,9 @@ Long64_t TTree::Process(TSelector* selector, Option_t* option, Long64_t nentries
    //  If the Tree (Chain) has an associated EventList, the loop is on the nentries
    //  of the EventList, starting at firstentry, otherwise the loop is on the
    //  specified Tree entries.
+   //
+   //  The entries can be processed by several threads in parallel, see
+   //  TTree::SetImplicitMT.
 
    GetPlayer();
    if (fPlayer) {
@@ -7747,6 +7905,56 @@ void TTree::SetFileNumber(Int_t number)
    fFileNumber = number;
 }
 
+//______________________________________________________________________________
+void TTree::SetImplicitMT(Int_t nthreads)
+{
+   // Enable or disable the multi-threaded event loop of TTree::Process
+   // and TTree::Draw and the parallel compression of the baskets in
+   // TTree::FlushBaskets.  (static function)
+   //
+   // nthreads = 0 or 1 : the entries are processed sequentially (default)
+   // nthreads > 1      : the entries are processed by nthreads threads
+   // nthreads < 0      : one thread per available cpu core is used
+   //
+   // When enabled, the entry range is split along the cluster boundaries of
+   // the tree (see TTree::GetClusterIterator) and each thread reads the
+   // clusters it picks from a shared queue with its own TFile, TTree and
+   // TSelector instances. The selector must then follow the PROOF protocol:
+   //  - Begin() and Terminate() are called on the selector passed to Process,
+   //  - SlaveBegin(), Init(), Process() and SlaveTerminate() are called on
+   //    per-thread instances created via the selector dictionary
+   //    (TClass::New), which receive the input list of the original selector,
+   //  - the objects in the output lists of the per-thread instances are
+   //    merged (via their Merge function) into the output list of the
+   //    original selector before Terminate() is called.
+   // TTree::Draw into a histogram with fixed binning (for example
+   // "x>>h(100,0,10)" or an existing histogram) fills per-thread copies of
+   // the histogram and adds them at the end of the loop.
+   //
+   // The sequential event loop is used whenever the tree is not read from
+   // a file, is a TChain, has friends or an entry/event list, when the
+   // selector is interpreted or cannot be instantiated, or when TTree::Draw
+   // needs the values of all the rows (automatic binning, graphs, lists).
+   //
+   // When writing, TTree::FlushBaskets (called by TTree::Fill at each
+   // cluster boundary, see TTree::SetAutoFlush, and by TTree::Write)
+   // compresses the pending baskets of all the branches on up to nthreads
+   // threads before writing them, in the usual order, to the file.  Each
+   // basket being compressed uses a private buffer for the duration of the
+   // flush.  Branches using the very old compression algorithm (see
+   // TBranch::SetCompressionAlgorithm) are compressed sequentially.
+
+   if (nthreads < 0) {
+      SysInfo_t info;
+      if (gSystem->GetSysInfo(&info) == 0 && info.fCpus > 0) {
+         nthreads = info.fCpus;
+      } else {
+         nthreads = 1;
+      }
+   }
+   fgImplicitMT = nthreads;
+}
+
 //______________________________________________________________________________
 void TTree::SetMakeClass(Int_t make) 
 {
@@ -7823,6 +8031,10 @@ void TTree::SetObject(const char* name, const char* title)
 void TTree::SetParallelUnzip(Bool_t opt, Float_t RelSize)
 {
    // Enable or disable parallel unzipping of Tree buffers.
+   // The baskets are unzipped in advance by a pool of threads shared by all
+   // the trees of the process, see TTreeCacheUnzip::SetUnzipPoolSize.
+   // RelSize is the fraction of the cache size used to keep the unzipped
+   // baskets waiting to be read.
 
    if (opt) TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
    else     TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kDisable);
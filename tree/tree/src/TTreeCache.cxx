@@ -231,17 +231,28 @@
 #include "TTreeCache.h"
 #include "TChain.h"
 #include "TList.h"
+#include "THashList.h"
 #include "TBranch.h"
 #include "TEventList.h"
+#include "TEntryList.h"
 #include "TObjString.h"
 #include "TRegexp.h"
 #include "TLeaf.h"
 #include "TFriendElement.h"
 #include "TFile.h"
+#include "TFilePrefetch.h"
+#include "TMath.h"
+#include "TSystem.h"
 #include <limits.h>
+#include <stdio.h>
+#include <vector>
 
 Int_t TTreeCache::fgLearnEntries = 100;
 
+// Name of the list of branches saved in the user info of the tree by
+// SaveLearnedBranches.
+static const char *gLearnedBranchesName = "TTreeCache_LearnedBranches";
+
 ClassImp(TTreeCache)
 
 //______________________________________________________________________________
@@ -267,7 +278,8 @@ TTreeCache::TTreeCache() : TFileCacheRead(),
    fFirstEntry(-1),
    fReadDirectionSet(kFALSE),
    fEnabled(kTRUE),
-   fPrefillType(TTreeCache::kNoPrefill)
+   fPrefillType(TTreeCache::kNoPrefill),
+   fEntryLookAhead(0)
 {
    // Default Constructor.
 }
@@ -295,7 +307,8 @@ TTreeCache::TTreeCache(TTree *tree, Int_t buffersize) : TFileCacheRead(tree->Get
    fFirstEntry(-1),
    fReadDirectionSet(kFALSE),
    fEnabled(kTRUE),
-   fPrefillType(TTreeCache::kNoPrefill)
+   fPrefillType(TTreeCache::kNoPrefill),
+   fEntryLookAhead(0)
 {
    // Constructor.
 
@@ -566,8 +579,11 @@ void TTreeCache::DropBranch(const char *bname, Bool_t subbranches /*= kFALSE*/)
 Bool_t TTreeCache::FillBuffer()
 {
    // Fill the cache buffer with the branches in the cache.
+   // Nothing is read for a memory mapped file (TFile option "MMAP"): the
+   // baskets are then taken from the map.
 
    if (fNbranches <= 0) return kFALSE;
+   if (fFile && fFile->IsMapped()) return kFALSE;
    TTree *tree = ((TBranch*)fBranches->UncheckedAt(0))->GetTree();
    Long64_t entry = tree->GetReadEntry();
    Long64_t fEntryCurrentMax = 0;
@@ -668,6 +684,11 @@ Bool_t TTreeCache::FillBuffer()
          chainOffset = chain->GetTreeOffset()[t];
       }
    }
+   // Same for a TEntryList, whose entries are local to the current tree
+   // (the current sub-list of the entry list of a TChain).
+   TEntryList *enlist = elist ? 0 : fTree->GetEntryList();
+   if (enlist && enlist->GetLists()) enlist = enlist->GetCurrentList();
+   if (enlist && (enlist->IsA() != TEntryList::Class() || enlist->GetLists())) enlist = 0;
 
    //clear cache buffer
    Int_t fNtotCurrentBuf = 0;
@@ -732,6 +753,9 @@ Bool_t TTreeCache::FillBuffer()
                   Long64_t emax = fEntryMax;
                   if (j<nb-1) emax = entries[j+1]-1;
                   if (!elist->ContainsRange(entries[j]+chainOffset,emax+chainOffset)) continue;
+               } else if (enlist) {
+                  Long64_t emax = j<nb-1 ? entries[j+1]-1 : fEntryMax;
+                  if (!enlist->ContainsRange(entries[j],emax)) continue;
                }
                if (pass==2 && !firstBasketSeen) {
                   // Okay, this has already been requested in the first pass.
@@ -851,11 +875,102 @@ Bool_t TTreeCache::FillBuffer()
          // only in reverse prefetching mode
          fFirstTime = kFALSE;
       }
+      if (!fIsLearning && !fReverseRead && fPrefetch) {
+         // Hand the buffer just registered to the prefetching thread,
+         // then request the following clusters.
+         SubmitPrefetch();
+         LookAhead();
+      }
    }
    fIsLearning = kFALSE;
    return kTRUE;
 }
 
+//_____________________________________________________________________________
+void TTreeCache::LookAhead()
+{
+   // In prefetching mode, request to the prefetching thread the baskets of
+   // the clusters following the ones in the cache (as many clusters as
+   // TFilePrefetch::GetLookAhead()), one block per cluster, so that they
+   // are read while the current cluster is processed. When FillBuffer
+   // reaches these clusters, TFilePrefetch finds the blocks it already has
+   // and does not read them again.
+
+   Int_t nclusters = fPrefetch->GetLookAhead();
+   if (nclusters <= 0 || fNbranches <= 0 || fEntryNext >= fEntryMax) return;
+
+   TTree *tree = ((TBranch*)fBranches->UncheckedAt(0))->GetTree();
+
+   // End of the look-ahead window
+   TTree::TClusterIterator clusterIter = tree->GetClusterIterator(fEntryNext);
+   Long64_t windowEnd = fEntryNext;
+   for (Int_t c = 0; c < nclusters && windowEnd < fEntryMax; ++c) {
+      clusterIter();
+      windowEnd = clusterIter.GetNextEntry();
+   }
+   if (windowEnd > fEntryMax) windowEnd = fEntryMax;
+
+   // Forget what was requested before a jump backward or forward.
+   if (fEntryLookAhead < fEntryNext || fEntryLookAhead > windowEnd) fEntryLookAhead = fEntryNext;
+
+   std::vector<Long64_t> pos;
+   std::vector<Int_t>    len;
+   clusterIter = tree->GetClusterIterator(fEntryLookAhead);
+   while (fEntryLookAhead < windowEnd) {
+      Long64_t clusterStart = clusterIter();
+      Long64_t clusterEnd = clusterIter.GetNextEntry();
+      if (clusterStart < fEntryLookAhead) clusterStart = fEntryLookAhead;
+      if (clusterEnd > windowEnd) clusterEnd = windowEnd;
+      if (clusterEnd <= clusterStart) break;
+
+      pos.clear();
+      len.clear();
+      for (Int_t i=0;i<fNbranches;i++) {
+         TBranch *b = (TBranch*)fBranches->UncheckedAt(i);
+         if (b->GetDirectory()==0) continue;
+         if (b->GetDirectory()->GetFile() != fFile) continue;
+         Int_t nb = b->GetMaxBaskets();
+         Int_t *lbaskets   = b->GetBasketBytes();
+         Long64_t *entries = b->GetBasketEntry();
+         if (!lbaskets || !entries) continue;
+         Int_t blistsize = b->GetListOfBaskets()->GetSize();
+         for (Int_t j=0;j<nb;j++) {
+            if (entries[j] >= clusterEnd) break;
+            if (j<nb-1 && entries[j+1] <= clusterStart) continue;
+            // This basket has already been read, skip it
+            if (j<blistsize && b->GetListOfBaskets()->UncheckedAt(j)) continue;
+            Long64_t bpos = b->GetBasketSeek(j);
+            Int_t blen = lbaskets[j];
+            if (bpos <= 0 || blen <= 0 || blen > fBufferSizeMin) continue;
+            pos.push_back(bpos);
+            len.push_back(blen);
+         }
+      }
+      fEntryLookAhead = clusterEnd;
+      if (pos.empty()) continue;
+
+      // Sort the baskets and merge the consecutive ones, as TFileCacheRead::Sort
+      Int_t n = pos.size();
+      std::vector<Int_t> index(n);
+      TMath::Sort(n, &pos[0], &index[0], kFALSE);
+      std::vector<Long64_t> bpos;
+      std::vector<Int_t>    blen;
+      for (Int_t k = 0; k < n; ++k) {
+         Long64_t p = pos[index[k]];
+         Int_t    l = len[index[k]];
+         if (!bpos.empty() && p < bpos.back() + blen.back()) continue; // duplicate
+         if (!bpos.empty() && p == bpos.back() + blen.back() && blen.back() <= 16000000) {
+            blen.back() += l;
+         } else {
+            bpos.push_back(p);
+            blen.push_back(l);
+         }
+      }
+      fPrefetch->ReadBlock(&bpos[0], &blen[0], bpos.size());
+      fPrefetchedBlocks++;
+   }
+}
+
 //_____________________________________________________________________________
 Double_t TTreeCache::GetEfficiency() const
 {
@@ -1032,6 +1147,7 @@ void TTreeCache::ResetCache()
 {
    // This will simply clear the cache
    TFileCacheRead::Prefetch(0,0);
+   fEntryLookAhead = 0;
 
    if (fEnablePrefetching) {
       fFirstTime = kTRUE;
@@ -1039,6 +1155,69 @@ void TTreeCache::ResetCache()
    }
 }
 
+//_____________________________________________________________________________
+Int_t TTreeCache::SaveLearnedBranches(const char *filename) const
+{
+   // Save the names of the branches in the cache, learned during the learning
+   // phase or added with AddBranch, so that a later job can start with them
+   // using LoadLearnedBranches instead of learning them again.
+   // Each name is saved once, even if several branches of the cache (for
+   // example of the different trees of a TChain) have the same name.
+   // If filename is given, the names are written to this text file, one per
+   // line. Otherwise they are stored as a TList of TObjString in the user
+   // info of the tree (see TTree::GetUserInfo). The user info is only saved
+   // with the tree header, so that the tree must then be written again, e.g.
+   //    cache->SaveLearnedBranches();
+   //    tree->Write("", TObject::kOverwrite);
+   // to a file opened in UPDATE mode. A warning is printed if the file of the
+   // tree is not writable, as the names would then be lost at the end of the
+   // job; a text file must be used instead.
+   // Return the number of branch names saved, -1 in case of error.
+
+   if (!fBrNames) return -1;
+   THashList unique;
+   TIter nextname(fBrNames);
+   TObject *name;
+   while ((name = nextname())) {
+      if (!unique.FindObject(name->GetName())) unique.Add(name);
+   }
+   if (filename && filename[0]) {
+      TString fname(filename);
+      gSystem->ExpandPathName(fname);
+      FILE *fp = fopen(fname.Data(), "w");
+      if (!fp) {
+         Error("SaveLearnedBranches", "cannot create file %s", fname.Data());
+         return -1;
+      }
+      fprintf(fp, "# Branches read from the tree %s\n", fTree ? fTree->GetName() : "");
+      TIter next(&unique);
+      TObject *os;
+      while ((os = next())) fprintf(fp, "%s\n", os->GetName());
+      fclose(fp);
+   } else {
+      if (!fTree || !fTree->GetTree()) return -1;
+      TDirectory *dir = fTree->GetTree()->GetDirectory();
+      if (!dir || !dir->IsWritable()) {
+         Warning("SaveLearnedBranches", "the file of the tree %s is not writable, the branch names "
+                 "will not be saved with it; use a text file instead", fTree->GetName());
+      }
+      TList *info = fTree->GetTree()->GetUserInfo();
+      TObject *old = info->FindObject(gLearnedBranchesName);
+      if (old) {
+         info->Remove(old);
+         delete old;
+      }
+      TList *names = new TList;
+      names->SetName(gLearnedBranchesName);
+      names->SetOwner();
+      TIter next(&unique);
+      TObject *os;
+      while ((os = next())) names->Add(new TObjString(os->GetName()));
+      info->Add(names);
+   }
+   return unique.GetSize();
+}
+
 //_____________________________________________________________________________
 void TTreeCache::SetEntryRange(Long64_t emin, Long64_t emax)
 {
@@ -1152,6 +1331,7 @@ void TTreeCache::UpdateBranches(TTree *tree)
    fEntryMax  = fTree->GetEntries();
 
    fEntryCurrent = -1;
+   fEntryLookAhead = 0;
 
    if (fBrNames->GetEntries() == 0 && fIsLearning) {
       // We still need to learn.
@@ -1221,3 +1401,62 @@ void TTreeCache::LearnPrefill()
    fEntryCurrent = ecurrentOld;
    fEntryNext = enextOld;
 }
+
+//_____________________________________________________________________________
+Int_t TTreeCache::LoadLearnedBranches(const char *filename)
+{
+   // Replace the branches in the cache by the ones saved by
+   // SaveLearnedBranches, and stop the learning phase: the baskets of these
+   // branches are prefetched from the first entry read, instead of being
+   // read one by one during the learning entries.
+   // If filename is given, the names are read from this text file, one per
+   // line (empty lines and lines starting with '#' are ignored); otherwise
+   // they are taken from the user info of the tree.
+   // The names of the branches which do not exist in the current tree are
+   // kept: a TChain caches them when it switches to a file containing them
+   // (see UpdateBranches), like the branches learned in its first file.
+   // Return the number of branches of the current tree put in the cache, -1
+   // if no list of branches was found.
+
+   if (!fTree) return -1;
+
+   TList names;
+   names.SetOwner();
+   if (filename && filename[0]) {
+      TString fname(filename);
+      gSystem->ExpandPathName(fname);
+      FILE *fp = fopen(fname.Data(), "r");
+      if (!fp) {
+         Error("LoadLearnedBranches", "cannot open file %s", fname.Data());
+         return -1;
+      }
+      TString line;
+      while (line.Gets(fp)) {
+         line = line.Strip(TString::kBoth);
+         if (line.IsNull() || line[0] == '#') continue;
+         names.Add(new TObjString(line));
+      }
+      fclose(fp);
+   } else {
+      TList *saved = fTree->GetTree() ? (TList*)fTree->GetTree()->GetUserInfo()->FindObject(gLearnedBranchesName) : 0;
+      if (!saved) return -1;
+      TIter next(saved);
+      TObject *os;
+      while ((os = next())) names.Add(new TObjString(os->GetName()));
+   }
+
+   StartLearningPhase();
+   TIter next(&names);
+   TObjString *os;
+   while ((os = (TObjString*)next())) {
+      if (fBrNames->FindObject(os->GetName())) continue;
+      fBrNames->Add(new TObjString(os->GetName()));
+      TBranch *b = fTree->GetBranch(os->GetName());
+      if (!b) continue;
+      fBranches->AddAtAndExpand(b, fNbranches);
+      fNbranches++;
+      if (gDebug > 0) printf("LoadLearnedBranches: registering branch: %s\n", b->GetName());
+   }
+   StopLearningPhase();
+   return fNbranches;
+}
@@ -23,17 +23,21 @@
 //////////////////////////////////////////////////////////////////////////
 // Parallel Unzipping                                                   //
 //                                                                      //
-// TTreeCache has been specialised in order to let additional threads   //
-//  free to unzip in advance its content. In this implementation we     //
-//  support up to 10 threads, but right now it makes more sense to      //
-//  limit their number to 1-2                                           //
+// TTreeCache has been specialised in order to unzip in advance its     //
+//  content. Each prefetched basket is unzipped by a separate task      //
+//  run by a pool of threads shared by all the TTreeCacheUnzip of the   //
+//  process (see TTreeCacheUnzip::SetUnzipPoolSize). The baskets are    //
+//  handed to the pool in the order in which they will be read (sorted  //
+//  by their first entry) as long as the unzipped blocks waiting to be  //
+//  used fit in the unzip buffer.                                       //
 //                                                                      //
 // The application reading data is carefully synchronized, in order to: //
-//  - if the block it wants is not unzipped, it self-unzips it without  //
-//     waiting                                                          //
+//  - if the block it wants is not unzipped (or still waiting in the    //
+//     pool queue), it self-unzips it without waiting                   //
 //  - if the block is being unzipped in parallel, it waits only         //
 //    for that unzip to finish                                          //
-//  - if the block has already been unzipped, it takes it               //
+//  - if the block has already been unzipped, it takes it, without      //
+//    copying the unzipped buffer                                       //
 //                                                                      //
 // This is supposed to cancel a part of the unzipping latency, at the   //
 //  expenses of cpu time.                                               //
@@ -50,35 +54,78 @@
 #include "TBranch.h"
 #include "TFile.h"
 #include "TEventList.h"
+#include "TSystem.h"
 #include "TVirtualMutex.h"
 #include "TThread.h"
+#include "TThreadPool.h"
 #include "TCondition.h"
 #include "TMath.h"
 #include "Bytes.h"
 
 #include "TEnv.h"
 
-#define THREADCNT 2
+#include <algorithm>
+#include <utility>
+
 extern "C" void R__unzip(Int_t *nin, UChar_t *bufin, Int_t *lout, char *bufout, Int_t *nout);
 extern "C" int R__unzip_header(Int_t *nin, UChar_t *bufin, Int_t *lout);
 
 TTreeCacheUnzip::EParUnzipMode TTreeCacheUnzip::fgParallel = TTreeCacheUnzip::kDisable;
+Int_t TTreeCacheUnzip::fgPoolSize = 0; // One thread per core.
 
 // The unzip cache does not consume memory by itself, it just allocates in advance
 // mem blocks which are then picked as they are by the baskets.
 // Hence there is no good reason to limit it too much
 Double_t TTreeCacheUnzip::fgRelBuffSize = .5;
 
+namespace {
+   struct TUnzipJob {
+      TTreeCacheUnzip *fCache;
+      Int_t            fIndex;
+      Int_t            fCycle;
+   };
+
+   class TUnzipTask : public TThreadPoolTaskImp<TUnzipTask, TUnzipJob> {
+   public:
+      bool runTask(TUnzipJob job) {
+         job.fCache->UnzipCache(job.fIndex, job.fCycle);
+         return true;
+      }
+   };
+
+   typedef TThreadPool<TUnzipTask, TUnzipJob> TUnzipPool_t;
+
+   TVirtualMutex *gUnzipPoolMutex = 0;
+   TUnzipPool_t  *gUnzipPool = 0;
+   Int_t          gUnzipPoolThreads = 0;
+   TUnzipTask     gUnzipTask;
+
+   //___________________________________________________________________________
+   TUnzipPool_t *R__GetUnzipPool()
+   {
+      // Return the pool shared by all the TTreeCacheUnzip of the process,
+      // creating it at the first call. The pool lives until the end of
+      // the process.
+
+      R__LOCKGUARD2(gUnzipPoolMutex);
+      if (!gUnzipPool) {
+         TThread::Initialize();
+         gUnzipPoolThreads = TTreeCacheUnzip::GetUnzipPoolSize();
+         gUnzipPool = new TUnzipPool_t(gUnzipPoolThreads);
+      }
+      return gUnzipPool;
+   }
+}
+
 ClassImp(TTreeCacheUnzip)
 
 //______________________________________________________________________________
 TTreeCacheUnzip::TTreeCacheUnzip() : TTreeCache(),
 
-   fActiveThread(kFALSE),
    fAsyncReading(kFALSE),
    fCycle(0),
-   fLastReadPos(0),
-   fBlocksToGo(0),
+   fNPendingTasks(0),
+   fNextToSchedule(0),
    fUnzipLen(0),
    fUnzipChunks(0),
    fUnzipStatus(0),
@@ -98,11 +145,10 @@ TTreeCacheUnzip::TTreeCacheUnzip() : TTreeCache(),
 
 //______________________________________________________________________________
 TTreeCacheUnzip::TTreeCacheUnzip(TTree *tree, Int_t buffersize) : TTreeCache(tree,buffersize),
-   fActiveThread(kFALSE),
    fAsyncReading(kFALSE),
    fCycle(0),
-   fLastReadPos(0),
-   fBlocksToGo(0),
+   fNPendingTasks(0),
+   fNextToSchedule(0),
    fUnzipLen(0),
    fUnzipChunks(0),
    fUnzipStatus(0),
@@ -127,7 +173,6 @@ void TTreeCacheUnzip::Init()
    fMutexList        = new TMutex(kTRUE);
    fIOMutex          = new TMutex(kTRUE);
 
-   fUnzipStartCondition   = new TCondition(fMutexList);
    fUnzipDoneCondition   = new TCondition(fMutexList);
 
    fTotalUnzipBytes = 0;
@@ -139,20 +184,13 @@ void TTreeCacheUnzip::Init()
       fParallel = kFALSE;
    }
    else if(fgParallel == kEnable || fgParallel == kForce) {
-      SysInfo_t info;
-      gSystem->GetSysInfo(&info);
-
       fUnzipBufferSize = Long64_t(fgRelBuffSize * GetBufferSize());
 
-      if(gDebug > 0)
-         Info("TTreeCacheUnzip", "Enabling Parallel Unzipping");
-
-      fParallel = kTRUE;
-
-      for (Int_t i = 0; i < 10; i++) fUnzipThread[i] = 0;
-
-      StartThreadUnzip(THREADCNT);
+      // With kEnable, unzipping in advance is only worth it with more than one core.
+      fParallel = (fgParallel == kForce || GetUnzipPoolSize() > 1);
 
+      if(gDebug > 0 && fParallel)
+         Info("TTreeCacheUnzip", "Enabling Parallel Unzipping");
    }
    else {
       Warning("TTreeCacheUnzip", "Parallel Option unknown");
@@ -169,26 +207,21 @@ void TTreeCacheUnzip::Init()
 //______________________________________________________________________________
 TTreeCacheUnzip::~TTreeCacheUnzip()
 {
-   // destructor. (in general called by the TFile destructor
    // destructor. (in general called by the TFile destructor)
 
+   WaitForPendingTasks();
    ResetCache();
 
-   if (IsActiveThread())
-      StopThreadUnzip();
-
-
    delete [] fUnzipLen;
 
-   delete fUnzipStartCondition;
    delete fUnzipDoneCondition;
 
-
    delete fMutexList;
    delete fIOMutex;
 
    delete [] fUnzipStatus;
    delete [] fUnzipChunks;
+   delete [] fCompBuffer;
 }
 
 //_____________________________________________________________________________
@@ -216,6 +249,8 @@ Bool_t TTreeCacheUnzip::FillBuffer()
 {
 
    if (fNbranches <= 0) return kFALSE;
+   // The baskets of a memory mapped file are taken from the map.
+   if (fFile && fFile->IsMapped()) return kFALSE;
    {
       // Fill the cache buffer with the branches in the cache.
       R__LOCKGUARD(fMutexList);
@@ -257,6 +292,9 @@ Bool_t TTreeCacheUnzip::FillBuffer()
       //clear cache buffer
       TFileCacheRead::Prefetch(0,0);
 
+      // First entry and request index of each registered basket
+      std::vector<std::pair<Long64_t,Int_t> > order;
+
       //store baskets
       for (Int_t i=0;i<fNbranches;i++) {
          TBranch *b = (TBranch*)fBranches->UncheckedAt(i);
@@ -286,7 +324,9 @@ Bool_t TTreeCacheUnzip::FillBuffer()
             }
             fNReadPref++;
 
+            Int_t nseek = fNseek;
             TFileCacheRead::Prefetch(pos,len);
+            if (fNseek > nseek) order.push_back(std::make_pair(entries[j], fNseek-1));
          }
          if (gDebug > 0) printf("Entry: %lld, registering baskets branch %s, fEntryNext=%lld, fNseek=%d, fNtot=%d\n",entry,((TBranch*)fBranches->UncheckedAt(i))->GetName(),fEntryNext,fNseek,fNtot);
       }
@@ -295,6 +335,13 @@ Bool_t TTreeCacheUnzip::FillBuffer()
       // Now fix the size of the status arrays
       ResetCache();
 
+      // The baskets are used entry by entry, not branch by branch: this is
+      // the order in which they are handed to the unzip pool.
+      std::stable_sort(order.begin(), order.end());
+      fUnzipOrder.clear();
+      fUnzipOrder.reserve(order.size());
+      for (UInt_t i = 0; i < order.size(); i++) fUnzipOrder.push_back(order[i].second);
+
       fIsLearning = kFALSE;
 
    }
@@ -361,60 +408,15 @@ Bool_t TTreeCacheUnzip::IsParallelUnzip()
    return kFALSE;
 }
 
-//_____________________________________________________________________________
-Bool_t TTreeCacheUnzip::IsActiveThread()
-{
-   // This indicates if the thread is active in this moment...
-   // this variable is very important because if we change it from true to
-   // false the thread will stop... ( see StopThreadTreeCacheUnzip() )
-   R__LOCKGUARD(fMutexList);
-
-   return fActiveThread;
-}
-
-//_____________________________________________________________________________
-Bool_t TTreeCacheUnzip::IsQueueEmpty()
-{
-   // It says if the queue is empty... useful to see if we have to process
-   // it.
-   R__LOCKGUARD(fMutexList);
-
-   if ( fIsLearning )
-      return kTRUE;
-
-   return kFALSE;
-}
-
-void TTreeCacheUnzip::WaitUnzipStartSignal()
-{
-   // Here the threads sleep waiting for some blocks to unzip
-
-   fUnzipStartCondition->TimedWaitRelative(2000);
-
-}
-//_____________________________________________________________________________
-void TTreeCacheUnzip::SendUnzipStartSignal(Bool_t broadcast)
-{
-   // This will send the signal corresponfing to the queue... normally used
-   // when we want to start processing the list of buffers.
-
-   if (gDebug > 0) Info("SendSignal", " fUnzipCondition->Signal()");
-
-   if (broadcast)
-      fUnzipStartCondition->Broadcast();
-   else 
-      fUnzipStartCondition->Signal();
-}
-
 //_____________________________________________________________________________
 Int_t TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::EParUnzipMode option)
 {
    // Static function that(de)activates multithreading unzipping
    // The possible options are:
-   // kEnable _Enable_ it, which causes an automatic detection and launches the
-   // additional thread if the number of cores in the machine is greater than one
-   // kDisable _Disable_ will not activate the additional thread.
-   // kForce _Force_ will start the additional thread even if there is only one core.
+   // kEnable _Enable_ it, which causes an automatic detection and hands the
+   // baskets to the unzip thread pool if the number of cores in the machine is greater than one
+   // kDisable _Disable_ will not unzip in advance.
+   // kForce _Force_ will use the unzip thread pool even if there is only one core.
    // the default will be taken as kEnable.
    // returns 0 if there was an error, 1 otherwise.
 
@@ -425,134 +427,75 @@ Int_t TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::EParUnzipMode option)
    return 0;
 }
 
-
-class TTreeCacheUnzipData {
-public:
-   TTreeCacheUnzip *fInstance;
-   Int_t            fCount;
-};
-
 //_____________________________________________________________________________
-Int_t TTreeCacheUnzip::StartThreadUnzip(Int_t nthreads)
+Int_t TTreeCacheUnzip::GetUnzipPoolSize()
 {
-   // The Thread is only a part of the TTreeCache but it is the part that
-   // waits for info in the queue and process it... unfortunatly, a Thread is
-   // not an object an we have to deal with it in the old C-Style way
-   // Returns 0 if the thread was initialized or 1 if it was already running
-   Int_t nt = nthreads;
-   if (nt > 10) nt = 10;
-
-   if (gDebug > 0)
-      Info("StartThreadUnzip", "Going to start %d threads.", nt);
-
-   for (Int_t i = 0; i < nt; i++) {
-      if (!fUnzipThread[i]) {
-         TString nm("UnzipLoop");
-         nm += i;
-
-         if (gDebug > 0)
-            Info("StartThreadUnzip", "Going to start thread '%s'", nm.Data());
-
-         TTreeCacheUnzipData *d = new TTreeCacheUnzipData;
-         d->fInstance = this;
-         d->fCount = i;
-
-         fUnzipThread[i] = new TThread(nm.Data(), UnzipLoop, (void*)d);
-         if (!fUnzipThread[i])
-            Error("TTreeCacheUnzip::StartThreadUnzip", " Unable to create new thread.");
-
-         fUnzipThread[i]->Run();
-
-         // There is at least one active thread
-         fActiveThread=kTRUE;
+   // Static function returning the number of threads of the pool unzipping
+   // the baskets of all the TTreeCacheUnzip of the process.
+   // By default this is the number of cores of the machine.
 
-      }
-   }
+   if (fgPoolSize > 0) return fgPoolSize;
 
-   return (fActiveThread == kTRUE);
+   SysInfo_t info;
+   if (gSystem->GetSysInfo(&info) == 0 && info.fCpus > 0)
+      return info.fCpus;
+   return 1;
 }
 
 //_____________________________________________________________________________
-Int_t TTreeCacheUnzip::StopThreadUnzip()
+void TTreeCacheUnzip::SetUnzipPoolSize(Int_t nthreads)
 {
-   // To stop the thread we only need to change the value of the variable
-   // fActiveThread to false and the loop will stop (of course, we will have)
-   // to do the cleaning after that.
-   // Note: The syncronization part is important here or we will try to delete
-   //       teh object while it's still processing the queue
-   fActiveThread = kFALSE;
-
-   for (Int_t i = 0; i < 1; i++) {
-      if(fUnzipThread[i]){
+   // Static function setting the number of threads of the unzip pool.
+   // If nthreads <= 0 one thread per core is used.
+   // The pool is created the first time a cache needs it: calling this
+   // function afterwards has no effect on the running pool.
 
-         SendUnzipStartSignal(kTRUE);
-
-         if (fUnzipThread[i]->Exists()) {
-            fUnzipThread[i]->Join();
-            delete fUnzipThread[i];
-         }
-      }
+   fgPoolSize = nthreads > 0 ? nthreads : 0;
+}
 
+//_____________________________________________________________________________
+void TTreeCacheUnzip::ScheduleUnzip()
+{
+   // Hand to the unzip pool the next blocks, in the order in which they
+   // will be used, as long as the unzipped blocks waiting to be picked up
+   // fit in fUnzipBufferSize.
+   // Must be called with fMutexList held.
+
+   if (!fParallel || fIsLearning || !fIsTransferred || !fNseek) return;
+
+   TUnzipPool_t *pool = R__GetUnzipPool();
+   const Int_t maxPending = 2*gUnzipPoolThreads;
+   const Bool_t ordered = ((Int_t)fUnzipOrder.size() == fNseek);
+
+   while (fNextToSchedule < fNseek && fNPendingTasks < maxPending &&
+          fTotalUnzipBytes < fUnzipBufferSize) {
+      Int_t idx = ordered ? fUnzipOrder[fNextToSchedule] : fNextToSchedule;
+      fNextToSchedule++;
+      if (fUnzipStatus[idx] != kUntouched || fSeekLen[idx] <= 256) continue;
+
+      fUnzipStatus[idx] = kQueued;
+      fNPendingTasks++;
+
+      TUnzipJob job;
+      job.fCache = this;
+      job.fIndex = idx;
+      job.fCycle = fCycle;
+      pool->PushTask(gUnzipTask, job);
    }
-
-   return 1;
 }
 
-
-
 //_____________________________________________________________________________
-void* TTreeCacheUnzip::UnzipLoop(void *arg)
+void TTreeCacheUnzip::WaitForPendingTasks()
 {
-   // This is a static function.
-   // This is the call that will be executed in the Thread generated by
-   // StartThreadTreeCacheUnzip... what we want to do is to inflate the next
-   // series of buffers leaving them in the second cache.
-   // Returns 0 when it finishes
-   TTreeCacheUnzipData *d = (TTreeCacheUnzipData *)arg;
-   TTreeCacheUnzip *unzipMng = d->fInstance;
-
-   TThread::SetCancelOn();
-   TThread::SetCancelDeferred();
-
-   Int_t thrnum = d->fCount;
-   Int_t startindex = thrnum;
-   Int_t locbuffsz = 16384;
-   char *locbuff = new char[16384];
-   Int_t res = 0;
-   Int_t myCycle = 0;
-
-   while( unzipMng->IsActiveThread() ) {
-      res = 1;
-
-      {
-         R__LOCKGUARD(unzipMng->fMutexList);
-         if (myCycle != unzipMng->fCycle) startindex = thrnum;
-         myCycle = unzipMng->fCycle;
-         if (unzipMng->fNseek) startindex = startindex % unzipMng->fNseek;
-         else startindex = -1;
-      }
-
-
-      if (startindex >= 0)
-         res = unzipMng->UnzipCache(startindex, locbuffsz, locbuff);
-
-      {
-         R__LOCKGUARD(unzipMng->fMutexList);
+   // Invalidate the tasks of this cache still queued in the unzip pool and
+   // wait for the running ones to finish. After this call no thread of the
+   // pool is accessing this cache.
 
-         if(!unzipMng->IsActiveThread()) break;
-
-         if ((res == 1) || (!unzipMng->fIsTransferred)) {
-            unzipMng->WaitUnzipStartSignal();
-            startindex = unzipMng->fLastReadPos+3+thrnum;
-         }
-      }
-
-
-   }
+   R__LOCKGUARD(fMutexList);
 
-   delete d;
-   delete [] locbuff;
-   return (void *)0;
+   fCycle++;
+   while (fNPendingTasks > 0)
+      fUnzipDoneCondition->TimedWaitRelative(200);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -609,8 +552,8 @@ void TTreeCacheUnzip::ResetCache()
    // Note: This method is completely different from TTreeCache::ResetCache(),
    // in that method we were cleaning the prefetching buffer while here we
    // delete the information about the unzipped buffers
+   // The tasks of the previous cycle still in the pool will discard their work.
 
-   {
    R__LOCKGUARD(fMutexList);
 
    if (gDebug > 0)
@@ -624,47 +567,51 @@ void TTreeCacheUnzip::ResetCache()
          if (fUnzipChunks[i]) delete [] fUnzipChunks[i];
          fUnzipChunks[i] = 0;
       }
-      if (fUnzipStatus) fUnzipStatus[i] = 0;
-
+      if (fUnzipStatus) fUnzipStatus[i] = kUntouched;
    }
 
-   while (fActiveBlks.size()) fActiveBlks.pop();
-
-   if(fNseekMax < fNseek){
-      if (gDebug > 0)
-         Info("ResetCache", "Changing fNseekMax from:%d to:%d", fNseekMax, fNseek);
-
-      Byte_t *aUnzipStatus = new Byte_t[fNseek];
-      memset(aUnzipStatus, 0, fNseek*sizeof(Byte_t));
+   ExpandUnzipArrays();
 
-      Int_t *aUnzipLen = new Int_t[fNseek];
-      memset(aUnzipLen, 0, fNseek*sizeof(Int_t));
+   fNextToSchedule = 0;
+   fTotalUnzipBytes = 0;
+}
 
-      char **aUnzipChunks = new char *[fNseek];
-      memset(aUnzipChunks, 0, fNseek*sizeof(char *));
+//_____________________________________________________________________________
+void TTreeCacheUnzip::ExpandUnzipArrays()
+{
+   // Make the per-block arrays big enough for fNseek blocks, keeping the
+   // state of the blocks already known.
+   // Must be called with fMutexList held.
 
-      if (fUnzipStatus) delete [] fUnzipStatus;
-      if (fUnzipLen) delete [] fUnzipLen;
-      if (fUnzipChunks) delete [] fUnzipChunks;
+   if (fNseekMax >= fNseek) return;
 
-      fUnzipStatus  = aUnzipStatus;
-      fUnzipLen  = aUnzipLen;
-      fUnzipChunks = aUnzipChunks;
+   if (gDebug > 0)
+      Info("ExpandUnzipArrays", "Changing fNseekMax from:%d to:%d", fNseekMax, fNseek);
 
-      fNseekMax  = fNseek;
-   }
+   Byte_t *aUnzipStatus = new Byte_t[fNseek];
+   memset(aUnzipStatus, 0, fNseek*sizeof(Byte_t));
 
+   Int_t *aUnzipLen = new Int_t[fNseek];
+   memset(aUnzipLen, 0, fNseek*sizeof(Int_t));
 
+   char **aUnzipChunks = new char *[fNseek];
+   memset(aUnzipChunks, 0, fNseek*sizeof(char *));
 
-   fLastReadPos = 0;
-   fTotalUnzipBytes = 0;
-   fBlocksToGo = fNseek;
+   for (Int_t i = 0; i < fNseekMax; i++) {
+      aUnzipStatus[i] = fUnzipStatus[i];
+      aUnzipLen[i] = fUnzipLen[i];
+      aUnzipChunks[i] = fUnzipChunks[i];
    }
 
+   delete [] fUnzipStatus;
+   delete [] fUnzipLen;
+   delete [] fUnzipChunks;
 
-   SendUnzipStartSignal(kTRUE);
-
+   fUnzipStatus  = aUnzipStatus;
+   fUnzipLen  = aUnzipLen;
+   fUnzipChunks = aUnzipChunks;
 
+   fNseekMax  = fNseek;
 }
 
 //_____________________________________________________________________________
@@ -677,186 +624,78 @@ Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_
    // but instead we will return the inflated buffer.
    // Note!! : If *buf == 0 we will allocate the buffer and it will be the
    // responsability of the caller to free it... it is useful for example
-   // to pass it to the creator of TBuffer
+   // to pass it to the creator of TBuffer. In that case a block unzipped
+   // by the pool is handed over without being copied.
    Int_t res = 0;
    Int_t loc = -1;
 
    {
       R__LOCKGUARD(fMutexList);
 
-
       // We go straight to TTreeCache/TfileCacheRead, in order to get the info we need
       //  pointer to the original zipped chunk
       //  its index in the original unsorted offsets lists
-      //  
-      // Actually there are situations in which copying the buffer is not
-      // useful. But the choice is among doing once more a small memcpy or a binary search in a large array. I prefer the former.
-      // Also, here we prefer not to trigger the (re)population of the chunks in the TFileCacheRead. That is
-      // better to be done in the main thread.
-
-      // And now loc is the position of the chunk in the array of the sorted chunks
-      Int_t myCycle = fCycle;
-
-
-      if (fParallel && !fIsLearning) {
-
-
-         if(fNseekMax < fNseek){
-            if (gDebug > 0)
-               Info("GetUnzipBuffer", "Changing fNseekMax from:%d to:%d", fNseekMax, fNseek);
-
-            Byte_t *aUnzipStatus = new Byte_t[fNseek];
-            memset(aUnzipStatus, 0, fNseek*sizeof(Byte_t));
-
-            Int_t *aUnzipLen = new Int_t[fNseek];
-            memset(aUnzipLen, 0, fNseek*sizeof(Int_t));
-
-            char **aUnzipChunks = new char *[fNseek];
-            memset(aUnzipChunks, 0, fNseek*sizeof(char *));
-
-            for (Int_t i = 0; i < fNseekMax; i++) {
-               aUnzipStatus[i] = fUnzipStatus[i];
-               aUnzipLen[i] = fUnzipLen[i];
-               aUnzipChunks[i] = fUnzipChunks[i];
-            }
-
-            if (fUnzipStatus) delete [] fUnzipStatus;
-            if (fUnzipLen) delete [] fUnzipLen;
-            if (fUnzipChunks) delete [] fUnzipChunks;
-
-            fUnzipStatus  = aUnzipStatus;
-            fUnzipLen  = aUnzipLen;
-            fUnzipChunks = aUnzipChunks;
-
-            fNseekMax  = fNseek;
-         }
-
-
-
-
+      // Here we prefer not to trigger the (re)population of the chunks in the
+      // TFileCacheRead: this is done by the miss path below, in the main thread.
 
+      if (fParallel && !fIsLearning && fIsTransferred) {
 
+         ExpandUnzipArrays();
 
+         // And now loc is the position of the chunk in the array of the sorted chunks
+         Int_t myCycle = fCycle;
          loc = (Int_t)TMath::BinarySearch(fNseek,fSeekSort,pos);
-         if ( (fCycle == myCycle) && (loc >= 0) && (loc < fNseek) && (pos == fSeekSort[loc]) ) {
+         if ( (loc >= 0) && (loc < fNseek) && (pos == fSeekSort[loc]) ) {
 
             // The buffer is, at minimum, in the file cache. We must know its index in the requests list
             // In order to get its info
             Int_t seekidx = fSeekIndex[loc];
 
-            fLastReadPos = seekidx;
-
-            do {
-
-
-
-
-               // If the block is ready we get it immediately.
-               // And also we don't have to alloc the blks. This is supposed to be
-               // the main thread of the app.
-               if ((fUnzipStatus[seekidx] == 2) && (fUnzipChunks[seekidx]) && (fUnzipLen[seekidx] > 0)) {
-
-                  //if (gDebug > 0)
-                  //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheHIT Block wanted: %d  len:%d req_len:%d fNseek:%d", seekidx, fUnzipLen[seekidx], len,  fNseek);
-
-                  if(!(*buf)) {
-                     *buf = fUnzipChunks[seekidx];
-                     fUnzipChunks[seekidx] = 0;
-                     fTotalUnzipBytes -= fUnzipLen[seekidx];
-                     SendUnzipStartSignal(kFALSE);
-                     *free = kTRUE;
-                  }
-                  else {
-                     memcpy(*buf, fUnzipChunks[seekidx], fUnzipLen[seekidx]);
-	             delete fUnzipChunks[seekidx];
-                     fTotalUnzipBytes -= fUnzipLen[seekidx];
-                     fUnzipChunks[seekidx] = 0;
-                     SendUnzipStartSignal(kFALSE);
-                     *free = kFALSE;
-                  }
-
-                  fNFound++;
-
-                  return fUnzipLen[seekidx];
-               }
-
-               // If the status of the unzipped chunk is pending
-               // we wait on the condvar, hoping that the next signal is the good one
-               if ( fUnzipStatus[seekidx] == 1 ) {
-                  //fMutexList->UnLock();
-                  fUnzipDoneCondition->TimedWaitRelative(200);
-                  //fMutexList->Lock();
-
-                  if ( myCycle != fCycle ) {
-                     if (gDebug > 0)
-                        Info("GetUnzipBuffer", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                             IsActiveThread(), fNseek, fIsLearning);
-
-                     fLastReadPos = 0;
-
-                     seekidx = -1;
-                     break;
-                  }
-
-               }
-
-            } while ( fUnzipStatus[seekidx] == 1 );
-
-            //if (gDebug > 0)
-            //   Info("GetUnzipBuffer", "------- Block wanted: %d  status: %d len: %d chunk: %llx ", seekidx, fUnzipStatus[seekidx], fUnzipLen[seekidx], fUnzipChunks[seekidx]);
-
-            // Here the block is not pending. It could be done or aborted or not yet being processed.
-            if ( (seekidx >= 0) && (fUnzipStatus[seekidx] == 2) && (fUnzipChunks[seekidx]) && (fUnzipLen[seekidx] > 0) ) {
+            // If the block is being unzipped we wait for that task only
+            Bool_t stalled = kFALSE;
+            while (fUnzipStatus[seekidx] == kProgress && myCycle == fCycle) {
+               stalled = kTRUE;
+               fUnzipDoneCondition->TimedWaitRelative(200);
+            }
 
-               //if (gDebug > 0)
-               //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheLateHIT Block wanted: %d  len:%d fNseek:%d", seekidx, fUnzipLen[seekidx], fNseek);
+            if ( (myCycle == fCycle) && (fUnzipStatus[seekidx] == kFinished) &&
+                 (fUnzipChunks[seekidx]) && (fUnzipLen[seekidx] > 0) ) {
 
+               Int_t uzlen = fUnzipLen[seekidx];
                if(!(*buf)) {
                   *buf = fUnzipChunks[seekidx];
-                  fUnzipChunks[seekidx] = 0;
-                  fTotalUnzipBytes -= fUnzipLen[seekidx];
-                  SendUnzipStartSignal(kFALSE);
                   *free = kTRUE;
                }
                else {
-                  memcpy(*buf, fUnzipChunks[seekidx], fUnzipLen[seekidx]);
-                  delete fUnzipChunks[seekidx];
-                  fTotalUnzipBytes -= fUnzipLen[seekidx];
-                  fUnzipChunks[seekidx] = 0;
-                  SendUnzipStartSignal(kFALSE);
+                  memcpy(*buf, fUnzipChunks[seekidx], uzlen);
+                  delete [] fUnzipChunks[seekidx];
                   *free = kFALSE;
                }
+               fUnzipChunks[seekidx] = 0;
+               fUnzipLen[seekidx] = 0;
+               fTotalUnzipBytes -= uzlen;
 
+               if (stalled) fNStalls++;
+               else fNFound++;
 
-               fNStalls++;
+               // Some room was freed: keep the pool busy
+               ScheduleUnzip();
 
-               return fUnzipLen[seekidx];
+               return uzlen;
             }
-            else {
-               // This is a complete miss. We want to avoid the threads
-               // to try unzipping this block in the future.
-               fUnzipStatus[seekidx] = 2;
-               fUnzipChunks[seekidx] = 0;
-
-               if ((fTotalUnzipBytes < fUnzipBufferSize) && fBlocksToGo)
-                  SendUnzipStartSignal(kFALSE);
 
-               //if (gDebug > 0)
-               //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheMISS Block wanted: %d  len:%d fNseek:%d", seekidx, len, fNseek);
+            if (myCycle == fCycle) {
+               // This is a complete miss, possibly of a block still queued
+               // in the pool. We want to avoid the pool to unzip this block.
+               fUnzipStatus[seekidx] = kFinished;
+            } else {
+               loc = -1;
             }
 
-
-
          } else {
             loc = -1;
-            //fLastReadPos = 0;
             fIsTransferred = kFALSE;
          }
-
-      } else {
-         // We need to reset it for new transferences...
-         //ResetCache();
-         //TFileCacheRead::Prefetch(0,0);
       }
 
    } // scope of the lock!
@@ -881,7 +720,6 @@ Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_
 
       res = 0;
       if (!ReadBufferExt(fCompBuffer, pos, len, loc)) {
-         //Info("GetUnzipBuffer", "++++++++++++++++++++ CacheMISS %d %d", loc, fNseek);
          fFile->Seek(pos);
          res = fFile->ReadBuffer(fCompBuffer, len);
       }
@@ -901,6 +739,13 @@ Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_
       fNMissed++;
    }
 
+   {
+      // The first miss after FillBuffer has transferred the cache content:
+      // from now on the pool can unzip in advance.
+      R__LOCKGUARD(fMutexList);
+      ScheduleUnzip();
+   }
+
    return res;
 
 }
@@ -1029,219 +874,114 @@ Int_t TTreeCacheUnzip::UnzipBuffer(char **dest, char *src)
 }
 
 //_____________________________________________________________________________
-Int_t TTreeCacheUnzip::UnzipCache(Int_t &startindex, Int_t &locbuffsz, char *&locbuff)
+Int_t TTreeCacheUnzip::UnzipCache(Int_t index, Int_t cycle)
 {
-   // This inflates all the buffers in the cache.. passing the data to a new
+   // This inflates the block 'index' of the cache, as requested for the
+   // cache content identified by 'cycle', passing the data to a new
    // buffer that will only wait there to be read...
-   // We can not inflate all the buffers in the cache so we will try to do
-   // it until the cache gets full... there is a member called fUnzipBufferSize which will
-   // tell us the max size we can allocate for this cache.
-   //
-   // note that we will  unzip in the order they were put into the cache not
-   // the order of the transference so it has to be read in that order or the
-   // pre-unzipping will be useless.
-   //
-   // startindex is used as start index to check for blks to be unzipped
-   //
-   // returns 0 in normal conditions or -1 if error, 1 if it would like to sleep
-   //
-   // This func is supposed to compete among an indefinite number of threads to get a chunk to inflate
-   // in order to accommodate multiple unzippers
+   // This is executed by the threads of the unzip pool, see ScheduleUnzip.
    // Since everything is so async, we cannot use a fixed buffer, we are forced to keep
    // the individual chunks as separate blocks, whose summed size does not exceed the maximum
-   // allowed. The pointers are kept globally in the array fUnzipChunks
-   Int_t myCycle;
+   // allowed. The pointers are kept in the array fUnzipChunks
+   //
+   // returns 0 in normal conditions or -1 if error, 1 if the block was
+   // not to be unzipped any more.
+
    const Int_t hlen=128;
    Int_t objlen=0, keylen=0;
    Int_t nbytes=0;
    Int_t readbuf = 0;
-
-   Int_t idxtounzip = -1;
+   char *locbuff = 0;
    Long64_t rdoffs = 0;
    Int_t rdlen = 0;
    {
       R__LOCKGUARD(fMutexList);
 
-      if (!IsActiveThread() || !fNseek || fIsLearning || !fIsTransferred) {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
+      if (cycle != fCycle || index >= fNseekMax || fUnzipStatus[index] != kQueued) {
+         // The cache content changed or the main thread already took care of it
+         fNPendingTasks--;
+         fUnzipDoneCondition->Broadcast();
          return 1;
       }
 
-      // To synchronize with the 'paging'
-      myCycle = fCycle;
+      fUnzipStatus[index] = kProgress;
+      rdoffs = fSeek[index];
+      rdlen = fSeekLen[index];
 
-      // Try to look for a blk to unzip
-      idxtounzip = -1;
-      rdoffs = 0;
-      rdlen = 0;
-      if (fTotalUnzipBytes < fUnzipBufferSize) {
+      // The copy of the compressed block is done with fMutexList held, so
+      // that the file cache content cannot change under our feet
+      Int_t loc = -1;
+      locbuff = new char[rdlen];
+      readbuf = ReadBufferExt(locbuff, rdoffs, rdlen, loc);
 
+      if (readbuf > 0) {
+         GetRecordHeader(locbuff, hlen, nbytes, objlen, keylen);
 
-         if (fBlocksToGo > 0) {
-            for (Int_t ii=0; ii < fNseek; ii++) {
-               Int_t reqi = (startindex+ii) % fNseek;
-               if (!fUnzipStatus[reqi] && (fSeekLen[reqi] > 256)   ) {
-                  // We found a chunk which is not unzipped nor pending
-                  fUnzipStatus[reqi] = 1; // Set it as pending
-                  idxtounzip = reqi;
+         Int_t len = (objlen > nbytes-keylen)? keylen+objlen : nbytes;
 
-                  rdoffs = fSeek[idxtounzip];
-                  rdlen = fSeekLen[idxtounzip];
-                  break;
-               }
-            }
-	    if (idxtounzip < 0) fBlocksToGo = 0;
+         // If the single unzipped chunk is really too big, leave it to
+         // the main thread, which will unzip it synchronously
+         if (len > 4*fUnzipBufferSize) {
+            if (gDebug > 0)
+               Info("UnzipCache", "Block %d is too big, skipping.", index);
+            readbuf = 0;
          }
-
-
-      }
-
-   } // lock scope
-
-
-
-   if (idxtounzip < 0) {
-      if (gDebug > 0)
-         Info("UnzipCache", "Nothing to do... startindex:%d fTotalUnzipBytes:%lld fUnzipBufferSize:%lld fNseek:%d",
-              startindex, fTotalUnzipBytes, fUnzipBufferSize, fNseek );
-      return 1;
-   }
-
-
-   // And here we have a new blk to unzip
-   startindex = idxtounzip+THREADCNT;
-
-
-   if (!IsActiveThread() || !fNseek || fIsLearning ) {
-      if (gDebug > 0)
-         Info("UnzipCache", "Sudden Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-              IsActiveThread(), fNseek, fIsLearning);
-      return 1;
-   }
-
-   Int_t loc = -1;
-
-   // Prepare a static tmp buf of adequate size
-   if(locbuffsz < rdlen) {
-      if (locbuff) delete [] locbuff;
-      locbuffsz = rdlen;
-      locbuff = new char[locbuffsz];
-      //memset(locbuff, 0, locbuffsz);
-   } else
-      if(locbuffsz > rdlen*3) {
-         if (locbuff) delete [] locbuff;
-         locbuffsz = rdlen*2;
-         locbuff = new char[locbuffsz];
-         //memset(locbuff, 0, locbuffsz);
-      }
-
-
-      if (gDebug > 0) 
-      Info("UnzipCache", "Going to unzip block %d", idxtounzip);
-
-      readbuf = ReadBufferExt(locbuff, rdoffs, rdlen, loc);
-
-   {
-      R__LOCKGUARD(fMutexList);
-
-      if ( (myCycle != fCycle) || !fIsTransferred )  {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-         fUnzipDoneCondition->Signal();
-         
-         startindex = 0;
-         return 1;
+      } else if (gDebug > 0) {
+         Info("UnzipCache", "Block %d not done. rdoffs=%lld rdlen=%d readbuf=%d", index, rdoffs, rdlen, readbuf);
       }
 
-
       if (readbuf <= 0) {
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-         if (gDebug > 0)
-            Info("UnzipCache", "Block %d not done. rdoffs=%lld rdlen=%d readbuf=%d", idxtounzip, rdoffs, rdlen, readbuf);
-         return -1;
+         fUnzipStatus[index] = kFinished;
+         fUnzipChunks[index] = 0;
+         fUnzipLen[index] = 0;
+         fNPendingTasks--;
+         ScheduleUnzip();
+         fUnzipDoneCondition->Broadcast();
+         delete [] locbuff;
+         return readbuf < 0 ? -1 : 0;
       }
-
-
-      GetRecordHeader(locbuff, hlen, nbytes, objlen, keylen);
-
-      Int_t len = (objlen > nbytes-keylen)? keylen+objlen : nbytes;
-
-      // If the single unzipped chunk is really too big, reset it to not processable
-      // I.e. mark it as done but set the pointer to 0
-      // This block will be unzipped synchronously in the main thread
-      if (len > 4*fUnzipBufferSize) {
-
-         //if (gDebug > 0)
-            Info("UnzipCache", "Block %d is too big, skipping.", idxtounzip);
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-
-         fUnzipDoneCondition->Signal();
-         return 0;
-      }
-
    } // Scope of the lock
 
-   // Unzip it into a new blk
+   // Unzip it into a new blk, without holding any lock
    char *ptr = 0;
-   Int_t loclen = 0;
-
-   loclen = UnzipBuffer(&ptr, locbuff);
-
-   if ((loclen > 0) && (loclen == objlen+keylen)) {
-      R__LOCKGUARD(fMutexList);
-
-      if ( (myCycle != fCycle)  || !fIsTransferred) {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
-         delete [] ptr;
+   Int_t loclen = UnzipBuffer(&ptr, locbuff);
+   delete [] locbuff;
 
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
+   R__LOCKGUARD(fMutexList);
 
-         startindex = 0;
-         fUnzipDoneCondition->Signal();
-         return 1;
-      }
+   if (cycle != fCycle) {
+      // The cache was reset in the meantime: its arrays are not ours any more
+      if (gDebug > 0)
+         Info("UnzipCache", "Sudden paging Break!!! fNseek: %d, fIsLearning:%d", fNseek, fIsLearning);
+      delete [] ptr;
+      fNPendingTasks--;
+      fUnzipDoneCondition->Broadcast();
+      return 1;
+   }
 
-      fUnzipStatus[idxtounzip] = 2; // Set it as done
-      fUnzipChunks[idxtounzip] = ptr;
-      fUnzipLen[idxtounzip] = loclen;
+   fUnzipStatus[index] = kFinished;
+   if ((loclen > 0) && (loclen == objlen+keylen)) {
+      fUnzipChunks[index] = ptr;
+      fUnzipLen[index] = loclen;
       fTotalUnzipBytes += loclen;
 
-      fActiveBlks.push(idxtounzip);
-
       if (gDebug > 0)
          Info("UnzipCache", "reqi:%d, rdoffs:%lld, rdlen: %d, loclen:%d",
-              idxtounzip, rdoffs, rdlen, loclen);
+              index, rdoffs, rdlen, loclen);
 
       fNUnzip++;
+   } else {
+      // The main thread will try again by itself
+      Info("UnzipCache", "loclen:%d objlen:%d readbuf:%d", loclen, objlen, readbuf);
+      delete [] ptr;
+      fUnzipChunks[index] = 0;
+      fUnzipLen[index] = 0;
    }
-   else {
-      R__LOCKGUARD(fMutexList);
-      Info("argh", "loclen:%d objlen:%d loc:%d readbuf:%d", loclen, objlen, loc, readbuf);
-      fUnzipStatus[idxtounzip] = 2; // Set it as done
-      fUnzipChunks[idxtounzip] = 0;
-      fUnzipLen[idxtounzip] = 0;
-   }
-
 
-   fUnzipDoneCondition->Signal();
+   fNPendingTasks--;
+   ScheduleUnzip();
+   fUnzipDoneCondition->Broadcast();
 
-   delete [] ptr;
    return 0;
 }
 
@@ -21,6 +21,7 @@
 #pragma link C++ class TTreeIndex-;
 #pragma link C++ class TChainIndex+;
 #pragma link C++ class TChainIndex::TChainIndexEntry+;
+#pragma link C++ class TTreeZoneMap+;
 #pragma link C++ class TTreeFormulaManager;
 #pragma link C++ class TTreeDrawArgsParser+;
 #pragma link C++ class TTreePerfStats+;
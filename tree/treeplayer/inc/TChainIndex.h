@@ -60,6 +60,7 @@ protected:
 
    std::pair<TVirtualIndex*, Int_t> GetSubTreeIndex(Int_t major, Int_t minor) const;
    void ReleaseSubTreeIndex(TVirtualIndex* index, Int_t treeNo) const;
+   Bool_t BuildIndices(const std::vector<Int_t> &trees, Int_t nthreads);
    void DeleteIndices();
 
 public:
@@ -67,6 +67,7 @@ protected:
    virtual void      ClearFormula();
    virtual Bool_t    CompileVariables(const char *varexp="", const char *selection="");
    virtual void      InitArrays(Int_t newsize);
+   virtual void      InitLoop();
 
 private:
    TSelectorDraw(const TSelectorDraw&);             // not implemented
@@ -77,6 +78,7 @@ public:
    virtual ~TSelectorDraw();
 
    virtual void      Begin(TTree *tree);
+   virtual Bool_t    BeginWorker(const TSelectorDraw *master, TTree *tree);
    virtual Int_t     GetAction() const {return fAction;}
    virtual Bool_t    GetCleanElist() const {return fCleanElist;}
    virtual Int_t     GetDimension() const {return fDimension;}
@@ -88,6 +90,8 @@ public:
    TTreeFormula     *GetSelect() const    {return fSelect;}
    virtual Long64_t  GetSelectedRows() const {return fSelectedRows;}
    TTree            *GetTree() const {return fTree;}
+   virtual Bool_t    IsParallelizable() const;
+   virtual void      MergeWorker(TSelectorDraw *worker);
    TTreeFormula     *GetVar(Int_t i) const;
    // See TSelectorDraw::GetVar
    TTreeFormula     *GetVar1() const {return GetVar(0);}
@@ -117,6 +121,7 @@ public:
    virtual void      TakeAction();
    virtual void      TakeEstimate();
    virtual void      Terminate();
+   virtual void      TerminateWorker();
 
    ClassDef(TSelectorDraw,1);  //A specialized TSelector for TTree::Draw
 };
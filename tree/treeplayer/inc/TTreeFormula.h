@@ -124,6 +124,10 @@ protected:
    TList                    *fDimensionSetup; //! list of dimension setups, for delayed creation of the dimension information.
    std::vector<std::string>  fAliasesUsed;    //! List of aliases used during the parsing of the expression.
 
+   void                     *fJitFunc;        //! Function compiled by the interpreter JIT to evaluate the formula, 0 if interpreted
+   Bool_t                    fJitChecked;     //! True if the compilation of the formula was already attempted
+   static Int_t              fgJit;           //  1 if formulas are compiled on their first evaluation, -1 if not yet read from gEnv
+
    TTreeFormula(const char *name, const char *formula, TTree *tree, const std::vector<std::string>& aliases);
    void Init(const char *name, const char *formula);
    Bool_t      BranchHasMethod(TLeaf* leaf, TBranch* branch, const char* method,const char* params, Long64_t readentry) const;
@@ -168,6 +172,7 @@ public:
    virtual Int_t       DefinedVariable(TString &variable, Int_t &action);
    virtual TClass*     EvalClass() const;
    virtual Double_t    EvalInstance(Int_t i=0, const char *stringStack[]=0);
+           Bool_t      EvalJitOperand(Int_t i, Int_t instance, Bool_t willLoad, Double_t &value);
    virtual const char *EvalStringInstance(Int_t i=0);
    virtual void*       EvalObject(Int_t i=0);
    // EvalInstance should be const.  See comment on GetNdata()
@@ -184,12 +189,17 @@ public:
    //the mutable keyword.
    //NOTE: Also modify the code in PrintValue which current goes around this limitation :(
    virtual Bool_t      IsInteger(Bool_t fast=kTRUE) const;
+           Bool_t      IsJitted() const { return fJitFunc != 0; }
+   static  Bool_t      IsJitEnabled();
            Bool_t      IsQuickLoad() const { return fQuickLoad; }
+           Bool_t      JitCompile();
    virtual Bool_t      IsString() const;
    virtual Bool_t      Notify() { UpdateFormulaLeaves(); return kTRUE; }
    virtual char       *PrintValue(Int_t mode=0) const;
    virtual char       *PrintValue(Int_t mode, Int_t instance, const char *decform = "9.9") const;
    virtual void        SetAxis(TAxis *axis=0);
+   static  void        SetJit(Bool_t enable = kTRUE);
+           void        SetJitSkipped(Bool_t willLoad) { if (willLoad) fDidBooleanOptimization = kTRUE; }
            void        SetQuickLoad(Bool_t quick) { fQuickLoad = quick; }
    virtual void        SetTree(TTree *tree) {fTree = tree;}
    virtual void        ResetLoading();
@@ -31,6 +31,11 @@
 
 class TTreeIndex : public TVirtualIndex {
 
+public:
+   enum {
+      kCompactIndex = BIT(14)   // Write the index delta encoded (see SetCompact and Streamer)
+   };
+
 protected:
    TString        fMajorName;           // Index major name
    TString        fMinorName;           // Index minor name
@@ -42,6 +47,8 @@ protected:
    TTreeFormula  *fMajorFormulaParent;  //! Pointer to major TreeFormula in Parent tree (if any)
    TTreeFormula  *fMinorFormulaParent;  //! Pointer to minor TreeFormula in Parent tree (if any)
 
+   Bool_t         Init(const TTree *T, const char *majorname, const char *minorname);
+
 private:
    TTreeIndex(const TTreeIndex&);            // Not implemented.
    TTreeIndex &operator=(const TTreeIndex&); // Not implemented.
@@ -63,11 +70,16 @@ public:
    virtual TTreeFormula  *GetMinorFormula();
    virtual TTreeFormula  *GetMajorFormulaParent(const TTree *parent);
    virtual TTreeFormula  *GetMinorFormulaParent(const TTree *parent);
+   Bool_t                 IsCompact()       const {return TestBit(kCompactIndex);}
    virtual void           Print(Option_t *option="") const;
+   void                   SetCompact(Bool_t compact = kTRUE) {SetBit(kCompactIndex, compact);}
    virtual void           UpdateFormulaLeaves(const TTree *parent);
    virtual void           SetTree(const TTree *T);
-   
-   ClassDef(TTreeIndex,1);  //A Tree Index with majorname and minorname.
+
+   static Int_t           BuildIndices(Int_t n, TTree **trees, const char *majorname, const char *minorname,
+                                       TTreeIndex **indices, Int_t nthreads);
+
+   ClassDef(TTreeIndex,2);  //A Tree Index with majorname and minorname.
 };
 
 #endif
@@ -65,11 +65,13 @@ protected:
    void           TakeAction(Int_t nfill, Int_t &npoints, Int_t &action, TObject *obj, Option_t *option);
    void           TakeEstimate(Int_t nfill, Int_t &npoints, Int_t action, TObject *obj, Option_t *option);
    void           DeleteSelectorFromFile();
+   Bool_t         ProcessParallel(TSelector *selector, Int_t nthreads, Long64_t nentries, Long64_t firstentry);
    
 public:
    TTreePlayer();
    virtual ~TTreePlayer();   
    virtual TVirtualIndex *BuildIndex(const TTree *T, const char *majorname, const char *minorname);
+   virtual TObject       *BuildZoneMap(TTree *T, const char *columns);
    virtual TTree    *CopyTree(const char *selection, Option_t *option
                               ,Long64_t nentries, Long64_t firstentry);
    virtual Long64_t  DrawScript(const char* wrapperPrefix,
@@ -0,0 +1,81 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TTreeZoneMap
+#define ROOT_TTreeZoneMap
+
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeZoneMap                                                         //
+//                                                                      //
+// Minimum, maximum and OR of the bits of some expressions in each      //
+// cluster of a TTree, used to skip the clusters where a selection      //
+// cannot be true.                                                      //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ROOT_TNamed
+#include "TNamed.h"
+#endif
+
+#include <vector>
+
+class TTree;
+class TObjArray;
+
+class TTreeZoneMap : public TNamed {
+
+protected:
+   Long64_t       fEntries;     // Number of entries of the tree when the map was built
+   Int_t          fNzones;      // Number of zones (clusters of the tree)
+   Int_t          fNcolumns;    // Number of indexed expressions
+   Int_t          fNvalues;     // fNzones*fNcolumns
+   Long64_t      *fZoneFirst;   //[fNzones] First entry of each zone
+   TObjArray     *fColumns;     // Indexed expressions (TObjString)
+   Double_t      *fMin;         //[fNvalues] Minimum of each expression in each zone
+   Double_t      *fMax;         //[fNvalues] Maximum of each expression in each zone
+   Long64_t      *fBits;        //[fNvalues] OR of the values, as integers, of each expression in each zone
+
+   std::vector<Int_t>    fSelColumn;  //! Expression tested by each term of the selection
+   std::vector<Int_t>    fSelOper;    //! Comparison (or bit test) of each term
+   std::vector<Double_t> fSelValue;   //! Value compared to the expression by each term
+   std::vector<Long64_t> fSelMask;    //! Bits tested by each bit test term
+
+   Bool_t         CanPass(Int_t zone) const;
+
+private:
+   TTreeZoneMap(const TTreeZoneMap&);            // Not implemented.
+   TTreeZoneMap &operator=(const TTreeZoneMap&); // Not implemented.
+
+public:
+   TTreeZoneMap();
+   TTreeZoneMap(TTree *tree, const char *columns);
+   virtual ~TTreeZoneMap();
+
+   Int_t          FindZone(Long64_t entry) const;
+   const char    *GetColumn(Int_t i) const;
+   Long64_t       GetEntries() const {return fEntries;}
+   Double_t       GetMaximum(Int_t zone, Int_t column) const {return fMax[zone*fNcolumns+column];}
+   Double_t       GetMinimum(Int_t zone, Int_t column) const {return fMin[zone*fNcolumns+column];}
+   Long64_t       GetBits(Int_t zone, Int_t column) const {return fBits[zone*fNcolumns+column];}
+   Int_t          GetNcolumns() const {return fNcolumns;}
+   Long64_t       GetNextEntry(Long64_t entry) const;
+   Int_t          GetNzones() const {return fNzones;}
+   Long64_t       GetZoneFirst(Int_t zone) const {return zone < fNzones ? fZoneFirst[zone] : fEntries;}
+   static TTreeZoneMap *GetZoneMap(TTree *tree);
+   Bool_t         MayPass(Long64_t first, Long64_t last) const;
+   virtual void   Print(Option_t *option="") const;
+   Int_t          SetSelection(const char *selection);
+
+   ClassDef(TTreeZoneMap,1);  //Per cluster minimum, maximum and bits of some expressions of a TTree
+};
+
+#endif
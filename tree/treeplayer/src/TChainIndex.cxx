@@ -17,6 +17,7 @@
 
 #include "TChainIndex.h"
 #include "TChain.h"
+#include "TChainElement.h"
 #include "TTreeFormula.h"
 #include "TTreeIndex.h"
 #include "TFile.h"
@@ -45,6 +46,11 @@ TChainIndex::TChainIndex(const TTree *T, const char *majorname, const char *mino
    // If any of those requirements isn't met the object becomes a zombie.
    // If some subtrees don't have indices the indices are created and stored inside this
    // TChainIndex.
+   // When TTree::SetImplicitMT(nthreads) has been called, the missing indices
+   // are built concurrently, each thread opening the file of one tree of the
+   // chain (see TTreeIndex::BuildIndices). The trees with friends, or of a
+   // chain with friends, are indexed one after the other as the friends are
+   // only attached to the tree loaded by the chain.
 
    fTree = 0;
    fMajorFormulaParent = fMinorFormulaParent = 0;
@@ -61,6 +67,9 @@ TChainIndex::TChainIndex(const TTree *T, const char *majorname, const char *mino
    fMajorName          = majorname;
    fMinorName          = minorname;
    Int_t i = 0;
+   Int_t nthreads = TTree::GetImplicitMT();
+   if (chain->GetListOfFriends() && chain->GetListOfFriends()->GetSize()) nthreads = 0;
+   std::vector<Int_t> tobuild;
 
    // Go through all the trees and check if they have indeces. If not then build them.
    for (i = 0; i < chain->GetNtrees(); i++) {
@@ -79,6 +88,13 @@ TChainIndex::TChainIndex(const TTree *T, const char *majorname, const char *mino
             return;
          }
       }
+      TList *friends = chain->GetTree()->GetListOfFriends();
+      if (!index && nthreads > 1 && !(friends && friends->GetSize())) {
+         // built below, with the other missing indices
+         tobuild.push_back(i);
+         fEntries.push_back(entry);
+         continue;
+      }
       if (!index) {
          chain->GetTree()->BuildIndex(majorname, minorname);
          index = chain->GetTree()->GetTreeIndex();
@@ -104,6 +120,13 @@ TChainIndex::TChainIndex(const TTree *T, const char *majorname, const char *mino
       fEntries.push_back(entry);
    }
 
+   if (!tobuild.empty() && !BuildIndices(tobuild, nthreads)) {
+      DeleteIndices();
+      MakeZombie();
+      Error("TChainIndex", "Error creating a tree index on a tree in the chain");
+      return;
+   }
+
    // Check if the indices of different trees are in order. If not then return an error.
    for (i = 0; i < Int_t(fEntries.size() - 1); i++) {
       if (fEntries[i].fMaxIndexValue > fEntries[i+1].fMinIndexValue) {
@@ -146,6 +169,57 @@ void TChainIndex::Append(const TVirtualIndex *index, Bool_t delaySort )
    }
 }
 
+//______________________________________________________________________________
+Bool_t TChainIndex::BuildIndices(const std::vector<Int_t> &trees, Int_t nthreads)
+{
+   // Build the indices of the trees of the chain numbered in trees, nthreads
+   // at a time, and keep them in fEntries. Each tree is read from its own
+   // copy of its file, opened and closed here. Returns kFALSE if an index
+   // cannot be built.
+
+   TChain *chain = (TChain*)fTree;
+   TObjArray *elements = chain->GetListOfFiles();
+   Bool_t ok = kTRUE;
+   for (size_t first = 0; first < trees.size() && ok; first += nthreads) {
+      size_t last = first + nthreads;
+      if (last > trees.size()) last = trees.size();
+      Int_t n = last - first;
+      std::vector<TFile*> files(n, (TFile*)0);
+      std::vector<TTree*> subtrees(n, (TTree*)0);
+      std::vector<TTreeIndex*> indices(n, (TTreeIndex*)0);
+      for (Int_t k = 0; k < n && ok; ++k) {
+         TChainElement *element = (TChainElement*)elements->At(trees[first + k]);
+         {
+            TDirectory::TContext ctxt(0);
+            files[k] = TFile::Open(element->GetTitle(), "READ");
+         }
+         if (files[k] && !files[k]->IsZombie()) files[k]->GetObject(element->GetName(), subtrees[k]);
+         if (!subtrees[k]) {
+            Error("TChainIndex", "Cannot read the tree %s of the file %s", element->GetName(), element->GetTitle());
+            ok = kFALSE;
+         }
+      }
+      if (ok) {
+         TTreeIndex::BuildIndices(n, &subtrees[0], fMajorName, fMinorName, &indices[0], nthreads);
+      }
+      for (Int_t k = 0; k < n; ++k) {
+         TTreeIndex *index = indices[k];
+         if (index) {
+            index->SetTree(0);
+            fEntries[trees[first + k]].fTreeIndex = index;
+         }
+         if (!index || index->IsZombie() || index->GetN() == 0) {
+            ok = kFALSE;
+         } else {
+            fEntries[trees[first + k]].fMinIndexValue = index->GetIndexValues()[0];
+            fEntries[trees[first + k]].fMaxIndexValue = index->GetIndexValues()[index->GetN() - 1];
+         }
+         delete files[k];
+      }
+   }
+   return ok;
+}
+
 //______________________________________________________________________________
 void TChainIndex::DeleteIndices()
 {
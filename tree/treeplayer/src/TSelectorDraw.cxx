@@ -883,6 +883,59 @@ void TSelectorDraw::Begin(TTree *tree)
    }
    if (hkeep) delete [] varexp;
    if (hnamealloc) delete [] hnamealloc;
+
+   InitLoop();
+}
+
+//______________________________________________________________________________
+Bool_t TSelectorDraw::BeginWorker(const TSelectorDraw *master, TTree *tree)
+{
+   // Prepare this selector to process, in a separate thread, a part of the
+   // entries of the TTree::Draw set up by the Begin function of master.
+   // This is only valid if master->IsParallelizable() returns true.
+   // The variables and the selection are compiled for tree and the entries
+   // are filled into an empty copy of the master histogram, which is
+   // added to the master histogram by MergeWorker.
+
+   SetStatus(0);
+   fSelectedRows = 0;
+   fTree         = tree;
+   fOption       = master->fOption;
+   fAction       = 0;
+
+   TObject *obj = master->fInput ? master->fInput->FindObject("varexp") : 0;
+   TString varexp = obj ? obj->GetTitle() : "";
+   for (Ssiz_t k = varexp.Length() - 1; k > 0; --k) {
+      if (varexp[k] == '>' && varexp[k-1] == '>') {
+         varexp.Remove(k - 1);
+         break;
+      }
+   }
+   obj = master->fInput ? master->fInput->FindObject("selection") : 0;
+   const char *selection = obj ? obj->GetTitle() : "";
+
+   if (!CompileVariables(varexp, selection) || fDimension != master->fDimension) {
+      SetStatus(-1);
+      return kFALSE;
+   }
+
+   TH1 *hist = (TH1*)master->fObject->Clone();
+   hist->SetDirectory(0);
+   hist->Reset();
+   fObject = hist;
+   fAction = master->fAction;
+
+   InitLoop();
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+void TSelectorDraw::InitLoop()
+{
+   // Reset the per-loop buffers once the variables and the action
+   // have been set up.
+
+   Int_t i;
    for (i = 0; i < fValSize; ++i)
       fVarMultiple[i] = kFALSE;
    fSelectMultiple = kFALSE;
@@ -1109,6 +1162,47 @@ UInt_t TSelectorDraw::SplitNames(const TString &varexp, std::vector<TString> &na
 }
 
 
+//______________________________________________________________________________
+Bool_t TSelectorDraw::IsParallelizable() const
+{
+   // Return kTRUE if the result of the current TTree::Draw is fully
+   // determined by the fills of a histogram with fixed binning, so that
+   // the entries can be processed by several threads each filling its own
+   // copy of the histogram (see TTree::SetImplicitMT).
+   // This is not the case when the histogram limits are computed from the
+   // data, when the histogram has alphanumeric labels, when the histogram
+   // is updated on the screen during the loop, nor for the graphs, the
+   // event lists and the displays that need all the selected rows.
+
+   if (fAction != 1 && fAction != 2 && fAction != 3 && fAction != 4 && fAction != 23) return kFALSE;
+   if (fObjEval || fTreeElist || fTree->GetUpdate()) return kFALSE;
+
+   TH1 *hist = dynamic_cast<TH1*>(fObject);
+   if (!hist || hist->GetBuffer()) return kFALSE;
+   TAxis *axes[3] = { hist->GetXaxis(), hist->GetYaxis(), hist->GetZaxis() };
+   for (Int_t i = 0; i < 3; ++i) {
+      if (axes[i]->CanExtend() || axes[i]->GetLabels()) return kFALSE;
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+void TSelectorDraw::MergeWorker(TSelectorDraw *worker)
+{
+   // Add the histogram filled by worker (see BeginWorker) to the histogram
+   // of this selector and delete it.
+
+   worker->TerminateWorker();
+   TH1 *hist = (TH1*)worker->fObject;
+   if (hist) {
+      ((TH1*)fObject)->Add(hist);
+      delete hist;
+      worker->fObject = 0;
+   }
+   fSelectedRows += worker->fSelectedRows;
+   worker->fSelectedRows = 0;
+}
+
 //______________________________________________________________________________
 Bool_t TSelectorDraw::Notify()
 {
@@ -1737,6 +1831,16 @@ void TSelectorDraw::TakeEstimate()
    }
 }
 
+//______________________________________________________________________________
+void TSelectorDraw::TerminateWorker()
+{
+   // Called at the end of the loop of a selector set up by BeginWorker.
+   // Fill the histogram with the remaining buffered rows.
+
+   if (fNfill) TakeAction();
+   fNfill = 0;
+}
+
 //______________________________________________________________________________
 void TSelectorDraw::Terminate()
 {
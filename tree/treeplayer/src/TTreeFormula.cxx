@@ -45,6 +45,7 @@
 #include "TFormLeafInfoReference.h"
 
 #include "TEntryList.h"
+#include "TEnv.h"
 
 #include <ctype.h>
 #include <stdio.h>
@@ -56,6 +57,8 @@
 const Int_t kMaxLen     = 1024;
 R__EXTERN TTree *gTree;
 
+Int_t TTreeFormula::fgJit = -1;
+
 
 
 ClassImp(TTreeFormula)
@@ -128,7 +131,7 @@ public:
 
 //______________________________________________________________________________
 TTreeFormula::TTreeFormula(): TFormula(), fQuickLoad(kFALSE), fNeedLoading(kTRUE),
-   fDidBooleanOptimization(kFALSE), fDimensionSetup(0)
+   fDidBooleanOptimization(kFALSE), fDimensionSetup(0), fJitFunc(0), fJitChecked(kFALSE)
 
 {
    // Tree Formula default constructor
@@ -159,7 +162,7 @@ TTreeFormula::TTreeFormula(): TFormula(), fQuickLoad(kFALSE), fNeedLoading(kTRUE
 //______________________________________________________________________________
 TTreeFormula::TTreeFormula(const char *name,const char *expression, TTree *tree)
    :TFormula(), fTree(tree), fQuickLoad(kFALSE), fNeedLoading(kTRUE),
-    fDidBooleanOptimization(kFALSE), fDimensionSetup(0)
+    fDidBooleanOptimization(kFALSE), fDimensionSetup(0), fJitFunc(0), fJitChecked(kFALSE)
 {
    // Normal TTree Formula Constuctor
 
@@ -170,7 +173,8 @@ TTreeFormula::TTreeFormula(const char *name,const char *expression, TTree *tree)
 TTreeFormula::TTreeFormula(const char *name,const char *expression, TTree *tree,
                            const std::vector<std::string>& aliases)
    :TFormula(), fTree(tree), fQuickLoad(kFALSE), fNeedLoading(kTRUE),
-    fDidBooleanOptimization(kFALSE), fDimensionSetup(0), fAliasesUsed(aliases)
+    fDidBooleanOptimization(kFALSE), fDimensionSetup(0), fAliasesUsed(aliases),
+    fJitFunc(0), fJitChecked(kFALSE)
 {
    // Constructor used during the expansion of an alias
    Init(name,expression);
@@ -3927,6 +3931,17 @@ Double_t TTreeFormula::EvalInstance(Int_t instance, const char *stringStackArg[]
       }
    }
 
+   if (!fJitChecked) {
+      fJitChecked = kTRUE;
+      if (IsJitEnabled()) JitCompile();
+   }
+   if (fJitFunc) {
+      const Bool_t willLoad = (instance==0 || fNeedLoading); fNeedLoading = kFALSE;
+      if (willLoad) fDidBooleanOptimization = kFALSE;
+      typedef Double_t (*JitFunc_t)(TTreeFormula*, Int_t, Bool_t);
+      return ((JitFunc_t)fJitFunc)(this, instance, willLoad);
+   }
+
    Double_t tab[kMAXFOUND];
    const Int_t kMAXSTRINGFOUND = 10;
    const char *stringStackLocal[kMAXSTRINGFOUND];
@@ -4313,6 +4328,290 @@ Double_t TTreeFormula::EvalInstance(Int_t instance, const char *stringStackArg[]
    return result;
 }
 
+//______________________________________________________________________________
+Bool_t TTreeFormula::EvalJitOperand(Int_t i, Int_t instance, Bool_t willLoad, Double_t &value)
+{
+   // Evaluate the tree variable, alias or alternate found at position i of
+   // the operation list. This is called by the function generated by
+   // JitCompile, the same way EvalInstance evaluates these operands.
+   // Returns false if the whole formula must evaluate to 0 because the
+   // instance is out of the range of one of the arrays.
+
+   value = 0;
+   const Int_t oper = GetOper()[i];
+   const Int_t action = oper >> kTFOperShift;
+
+   if (action == kDefinedVariable) {
+      const Int_t code = (oper & kTFOperMask);
+      switch (fLookupType[code]) {
+         case kIndexOfEntry: value = (Double_t)fTree->GetReadEntry(); return kTRUE;
+         case kIndexOfLocalEntry: value = (Double_t)fTree->GetTree()->GetReadEntry(); return kTRUE;
+         case kEntries:      value = (Double_t)fTree->GetEntries(); return kTRUE;
+         case kLength:       value = fManager->fNdata; return kTRUE;
+         case kLengthFunc:   value = ((TTreeFormula*)fAliases.UncheckedAt(i))->GetNdata(); return kTRUE;
+         case kIteration:    value = instance; return kTRUE;
+         case kSum:          value = Summing((TTreeFormula*)fAliases.UncheckedAt(i)); return kTRUE;
+         case kMin:          value = FindMin((TTreeFormula*)fAliases.UncheckedAt(i)); return kTRUE;
+         case kMax:          value = FindMax((TTreeFormula*)fAliases.UncheckedAt(i)); return kTRUE;
+
+         case kDirect:     { TT_EVAL_INIT_LOOP; value = leaf->GetValue(real_instance); return kTRUE; }
+         case kMethod:     { TT_EVAL_INIT_LOOP; value = GetValueFromMethod(code,leaf); return kTRUE; }
+         case kDataMember: { TT_EVAL_INIT_LOOP; value = ((TFormLeafInfo*)fDataMembers.UncheckedAt(code))->
+                                    GetValue(leaf,real_instance); return kTRUE; }
+         case kTreeMember: { TREE_EVAL_INIT_LOOP; value = ((TFormLeafInfo*)fDataMembers.UncheckedAt(code))->
+                                    GetValue((TLeaf*)0x0,real_instance); return kTRUE; }
+         case kEntryList: { TEntryList *elist = (TEntryList*)fExternalCuts.At(code);
+            value = elist->Contains(fTree->GetReadEntry());
+            return kTRUE;}
+         case -1: break;
+         default: return kTRUE;
+      }
+      switch (fCodes[code]) {
+         case -2: {
+            TCutG *gcut = (TCutG*)fExternalCuts.At(code);
+            TTreeFormula *fx = (TTreeFormula *)gcut->GetObjectX();
+            TTreeFormula *fy = (TTreeFormula *)gcut->GetObjectY();
+            Double_t xcut = fx->EvalInstance(instance);
+            Double_t ycut = fy->EvalInstance(instance);
+            value = gcut->IsInside(xcut,ycut);
+            return kTRUE;
+         }
+         case -1: {
+            TCutG *gcut = (TCutG*)fExternalCuts.At(code);
+            TTreeFormula *fx = (TTreeFormula *)gcut->GetObjectX();
+            value = fx->EvalInstance(instance);
+            return kTRUE;
+         }
+         default: return kTRUE;
+      }
+   }
+
+   switch (action) {
+      case kAlias: {
+         TTreeFormula *subform = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i));
+         R__ASSERT(subform);
+         subform->fDidBooleanOptimization = fDidBooleanOptimization;
+         value = subform->EvalInstance(instance);
+         return kTRUE;
+      }
+      case kMinIf:
+      case kMaxIf: {
+         TTreeFormula *primary = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i));
+         TTreeFormula *condition = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i+1));
+         value = (action == kMinIf) ? FindMin(primary,condition) : FindMax(primary,condition);
+         return kTRUE;
+      }
+      case kAlternate: {
+         TTreeFormula *primary = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i));
+         // Use the alternate value (the next operation) when the instance
+         // is out of the range of the primary formula.
+         if (instance < primary->GetNdata()) {
+            value = primary->EvalInstance(instance);
+            return kTRUE;
+         }
+         return EvalJitOperand(i+1, instance, willLoad, value);
+      }
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeFormula::IsJitEnabled()
+{
+   // Return true if the formulas are compiled by the interpreter JIT on their
+   // first evaluation. The default is taken from the resource
+   // TTreeFormula.Jit (default: no) and can be changed with SetJit.
+
+   if (fgJit < 0) fgJit = gEnv->GetValue("TTreeFormula.Jit", 0) ? 1 : 0;
+   return fgJit > 0;
+}
+
+//______________________________________________________________________________
+void TTreeFormula::SetJit(Bool_t enable)
+{
+   // Enable or disable the compilation of the formulas by the interpreter
+   // JIT (see JitCompile). This affects the formulas not yet evaluated.
+
+   fgJit = enable ? 1 : 0;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeFormula::JitCompile()
+{
+   // Translate the operation list of the formula into a C++ function and
+   // compile it with the interpreter JIT. Once compiled, EvalInstance calls
+   // this function instead of interpreting the operation list.
+   //
+   // The arithmetic, the comparisons, the mathematical functions and the
+   // boolean short-circuits (&&, || and the ternary operator) are compiled
+   // into native code. The leaves (including their array indexing), the
+   // aliases, the alternates, Sum$, Min$, Max$, the graphical cuts and the
+   // entry lists are evaluated through EvalJitOperand, which shares the
+   // logic of EvalInstance.
+   // Formulas using strings, external function calls or an operation
+   // unknown to the translator are not compiled and stay interpreted.
+   // Identical operation lists share the same compiled function.
+   //
+   // Returns true if the formula is now evaluated by a compiled function.
+
+   if (fJitFunc) return kTRUE;
+   if (fNoper < 2 || fAxis || !gInterpreter) return kFALSE;
+
+   // Jump targets and stack depth at these targets.
+   std::vector<Int_t> depthAt(fNoper+1,-1);
+   TString body;
+   Int_t pos = 0;
+   Int_t maxpos = 0;
+   Bool_t reachable = kTRUE;
+
+   for (Int_t i = 0; i < fNoper; ++i) {
+      if (depthAt[i] >= 0) {
+         if (!reachable) pos = depthAt[i];
+         body += TString::Format("L%d:\n", i);
+         reachable = kTRUE;
+      }
+      if (!reachable) continue;
+
+      const Int_t oper = GetOper()[i];
+      const Int_t action = oper >> kTFOperShift;
+      const Int_t param = oper & kTFOperMask;
+      TString a = TString::Format("t%d", pos-2);
+      TString b = TString::Format("t%d", pos-1);
+      const char *unary = 0;
+      const char *binary = 0;
+
+      switch (action) {
+         case kConstant: {
+            Double_t value = fConst[param];
+            if (!TMath::Finite(value)) return kFALSE;
+            body += TString::Format("   t%d = %.17g;\n", pos, value);
+            ++pos;
+            break;
+         }
+         case kDefinedVariable:
+         case kAlias:
+         case kAlternate:
+         case kMinIf:
+         case kMaxIf:
+            body += TString::Format("   if (!f->EvalJitOperand(%d,instance,willLoad,t%d)) return 0;\n", i, pos);
+            ++pos;
+            // The condition of Min$/Max$ and the alternate value are
+            // handled by EvalJitOperand.
+            if (action != kDefinedVariable && action != kAlias) ++i;
+            break;
+
+         case kAdd        : binary = "$a + $b"; break;
+         case kSubstract  : binary = "$a - $b"; break;
+         case kMultiply   : binary = "$a * $b"; break;
+         case kDivide     : binary = "($b == 0) ? 0 : $a / $b"; break;
+         case kModulo     : binary = "Double_t(((Long64_t)$a) % ((Long64_t)$b))"; break;
+         case katan2      : binary = "TMath::ATan2($a,$b)"; break;
+         case kfmod       : binary = "fmod($a,$b)"; break;
+         case kpow        : binary = "TMath::Power($a,$b)"; break;
+         case kmin        : binary = "TMath::Min($a,$b)"; break;
+         case kmax        : binary = "TMath::Max($a,$b)"; break;
+         case kAnd        : binary = "($a != 0 && $b != 0) ? 1 : 0"; break;
+         case kOr         : binary = "($a != 0 || $b != 0) ? 1 : 0"; break;
+         case kEqual      : binary = "($a == $b) ? 1 : 0"; break;
+         case kNotEqual   : binary = "($a != $b) ? 1 : 0"; break;
+         case kLess       : binary = "($a <  $b) ? 1 : 0"; break;
+         case kGreater    : binary = "($a >  $b) ? 1 : 0"; break;
+         case kLessThan   : binary = "($a <= $b) ? 1 : 0"; break;
+         case kGreaterThan: binary = "($a >= $b) ? 1 : 0"; break;
+         case kBitAnd     : binary = "((Long64_t) $a) & ((Long64_t) $b)"; break;
+         case kBitOr      : binary = "((Long64_t) $a) | ((Long64_t) $b)"; break;
+         case kLeftShift  : binary = "((Long64_t) $a) << ((Long64_t) $b)"; break;
+         case kRightShift : binary = "((Long64_t) $a) >> ((Long64_t) $b)"; break;
+
+         case kcos  : unary = "TMath::Cos($b)"; break;
+         case ksin  : unary = "TMath::Sin($b)"; break;
+         case ktan  : unary = "(TMath::Cos($b) == 0) ? 0 : TMath::Tan($b)"; break;
+         case kacos : unary = "(TMath::Abs($b) > 1) ? 0 : TMath::ACos($b)"; break;
+         case kasin : unary = "(TMath::Abs($b) > 1) ? 0 : TMath::ASin($b)"; break;
+         case katan : unary = "TMath::ATan($b)"; break;
+         case kcosh : unary = "TMath::CosH($b)"; break;
+         case ksinh : unary = "TMath::SinH($b)"; break;
+         case ktanh : unary = "(TMath::CosH($b) == 0) ? 0 : TMath::TanH($b)"; break;
+         case kacosh: unary = "($b < 1) ? 0 : TMath::ACosH($b)"; break;
+         case kasinh: unary = "TMath::ASinH($b)"; break;
+         case katanh: unary = "(TMath::Abs($b) > 1) ? 0 : TMath::ATanH($b)"; break;
+         case ksq   : unary = "$b * $b"; break;
+         case ksqrt : unary = "TMath::Sqrt(TMath::Abs($b))"; break;
+         case klog  : unary = "($b > 0) ? TMath::Log($b) : 0"; break;
+         case kexp  : unary = "($b < -700) ? 0 : (($b > 700) ? TMath::Exp(700) : TMath::Exp($b))"; break;
+         case klog10: unary = "($b > 0) ? TMath::Log10($b) : 0"; break;
+         case kabs  : unary = "TMath::Abs($b)"; break;
+         case ksign : unary = "($b < 0) ? -1 : 1"; break;
+         case kint  : unary = "Double_t(Int_t($b))"; break;
+         case kSignInv: unary = "-1 * $b"; break;
+         case kNot  : unary = "($b != 0) ? 0 : 1"; break;
+
+         case kpi   : body += TString::Format("   t%d = TMath::ACos(-1);\n", pos); ++pos; break;
+         case krndm : body += TString::Format("   t%d = gRandom->Rndm(1);\n", pos); ++pos; break;
+
+         case kJump:
+            depthAt[param+1] = pos;
+            body += TString::Format("   goto L%d;\n", param+1);
+            reachable = kFALSE;
+            break;
+         case kJumpIf:
+            --pos;
+            depthAt[param+1] = pos;
+            body += TString::Format("   if (!t%d) { f->SetJitSkipped(willLoad); goto L%d; }\n", pos, param+1);
+            break;
+         case kBoolOptimize: {
+            // && skips its right part if the left part is false, || if it is true.
+            Int_t op = param % 10;
+            Int_t target = i + param / 10 + 1;
+            if (op != 1 && op != 2) break;
+            if (target > fNoper) return kFALSE;
+            depthAt[target] = pos;
+            body += TString::Format("   if (%st%d) { t%d = %d; f->SetJitSkipped(willLoad); goto L%d; }\n",
+                                    op == 1 ? "!" : "", pos-1, pos-1, op == 1 ? 0 : 1, target);
+            break;
+         }
+         case kEnd:
+            body += "   return t0;\n";
+            reachable = kFALSE;
+            break;
+
+         default:
+            // Strings, function calls, ...: keep the interpreter.
+            return kFALSE;
+      }
+      if (binary) {
+         if (pos < 2) return kFALSE;
+         TString expr(binary);
+         expr.ReplaceAll("$a", a);
+         expr.ReplaceAll("$b", b);
+         body += TString::Format("   %s = %s;\n", a.Data(), expr.Data());
+         --pos;
+      } else if (unary) {
+         if (pos < 1) return kFALSE;
+         TString expr(unary);
+         expr.ReplaceAll("$b", b);
+         body += TString::Format("   %s = %s;\n", b.Data(), expr.Data());
+      }
+      if (pos < 0) return kFALSE;
+      if (pos > maxpos) maxpos = pos;
+   }
+   if (depthAt[fNoper] >= 0) body += TString::Format("L%d:\n", fNoper);
+   body += "   return t0;\n";
+   if (maxpos == 0) return kFALSE;
+
+   TString decl("   Double_t t0 = 0");
+   for (Int_t k = 1; k < maxpos; ++k) decl += TString::Format(", t%d = 0", k);
+   decl += ";\n";
+   body.Prepend(decl);
+
+   // Each distinct operation list is compiled only once (see TInterpreter::CompileFunction).
+   fJitFunc = (void*)gInterpreter->CompileFunction("R__TTreeFormula_jit",
+                                                   "Double_t $name(TTreeFormula *f, Int_t instance, Bool_t willLoad)",
+                                                   body, "TTreeFormula.h TMath.h TRandom.h");
+   if (gDebug > 0 && !fJitFunc) Info("JitCompile", "could not compile formula %s", GetTitle());
+   return fJitFunc != 0;
+}
+
 //______________________________________________________________________________
 TFormLeafInfo *TTreeFormula::GetLeafInfo(Int_t code) const
 {
@@ -4947,6 +5246,9 @@ Bool_t TTreeFormula::StringToNumber(Int_t oper)
          SetAction(oper, kDefinedVariable, code );
          fNval++;
          fNstring--;
+         // The operation list changed, the compiled version is stale.
+         fJitFunc = 0;
+         fJitChecked = kFALSE;
          return kTRUE;
       }
    }
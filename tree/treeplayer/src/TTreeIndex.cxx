@@ -17,10 +17,315 @@
 
 #include "TTreeIndex.h"
 #include "TTree.h"
+#include "TChain.h"
+#include "TFile.h"
 #include "TMath.h"
+#include "TThread.h"
+#include "TThreadPool.h"
+
+#include <algorithm>
+#include <vector>
 
 ClassImp(TTreeIndex)
 
+namespace {
+
+// Minimum number of entries per thread for the index to be sorted by several
+// threads (see R__SortIndex); smaller indices are sorted serially, faster
+// than the threads can be started.
+const Long64_t kMinEntriesPerSortThread = 10000;
+
+//______________________________________________________________________________
+void R__EvalIndexValues(TTree *tree, TTreeFormula *major, TTreeFormula *minor,
+                        Long64_t first, Long64_t last, Long64_t *w)
+{
+   // Set w[i] to the index value (major<<31 + minor) of the entries i
+   // from first to last (excluded) of tree.
+
+   Int_t current = -1;
+   for (Long64_t i=first;i<last;i++) {
+      Long64_t centry = tree->LoadTree(i);
+      if (centry < 0) break;
+      if (tree->GetTreeNumber() != current) {
+         current = tree->GetTreeNumber();
+         major->UpdateFormulaLeaves();
+         minor->UpdateFormulaLeaves();
+      }
+      Double_t majord = major->EvalInstance();
+      Double_t minord = minor->EvalInstance();
+      Long64_t majorv = (Long64_t)majord;
+      Long64_t minorv = (Long64_t)minord;
+      w[i]  = majorv<<31;
+      w[i] += minorv;
+   }
+}
+
+//______________________________________________________________________________
+class TIndexValueCompare {
+   // Order the entries by index value, then by entry number.
+
+private:
+   const Long64_t *fValues;   // Index value of each entry
+
+public:
+   TIndexValueCompare(const Long64_t *values) : fValues(values) {}
+   bool operator()(Long64_t a, Long64_t b) const {
+      return fValues[a] < fValues[b] || (fValues[a] == fValues[b] && a < b);
+   }
+};
+
+//______________________________________________________________________________
+void R__SortIndexSerial(Long64_t n, const Long64_t *w, Long64_t *index)
+{
+   // Set in index the entries 0 to n-1 sorted by index value w, then by
+   // entry number, as done by all the ways of building the index.
+
+   for (Long64_t i = 0; i < n; ++i) index[i] = i;
+   std::sort(index, index + n, TIndexValueCompare(w));
+}
+
+//______________________________________________________________________________
+class TIndexBuildTask : public TThreadPoolTaskImp<TIndexBuildTask, Int_t> {
+   // Evaluation of the index values of some ranges of entries of a tree,
+   // in one thread of TTreeIndex::TTreeIndex or TTreeIndex::BuildIndices.
+   // If fIndex is set, the index of all the entries is then sorted.
+
+public:
+   TFile                 *fFile;         // File opened for this thread (if any)
+   TTree                 *fTree;         // Tree read by this thread
+   TTreeFormula          *fMajor;        // Major formula on fTree
+   TTreeFormula          *fMinor;        // Minor formula on fTree
+   std::vector<Long64_t>  fFirst;        // First entry of each range
+   std::vector<Long64_t>  fLast;         // Last entry (excluded) of each range
+   Long64_t              *fValues;       // Index values, by entry
+   Long64_t               fN;            // Number of entries, when sorting
+   Long64_t              *fIndex;        // Sorted entry numbers (if sorting)
+   Long64_t              *fIndexValues;  // Sorted index values (if sorting)
+
+   TIndexBuildTask() : fFile(0), fTree(0), fMajor(0), fMinor(0), fValues(0),
+                       fN(0), fIndex(0), fIndexValues(0) {}
+
+   bool runTask(Int_t /* slot */) {
+      for (size_t r = 0; r < fFirst.size(); ++r) {
+         fTree->SetCacheEntryRange(fFirst[r], fLast[r]);
+         R__EvalIndexValues(fTree, fMajor, fMinor, fFirst[r], fLast[r], fValues);
+      }
+      if (fIndex) {
+         R__SortIndexSerial(fN, fValues, fIndex);
+         for (Long64_t i = 0; i < fN; i++) fIndexValues[i] = fValues[fIndex[i]];
+      }
+      return true;
+   }
+};
+
+//______________________________________________________________________________
+class TIndexSortTask : public TThreadPoolTaskImp<TIndexSortTask, Int_t> {
+   // Sort of a part of the entries by index value (if fMiddle < 0), or
+   // merge of two consecutive sorted parts, in one thread of R__SortIndex.
+
+public:
+   const Long64_t *fValues;   // Index values, by entry
+   Long64_t       *fIn;       // Entry numbers to sort or merge
+   Long64_t       *fOut;      // Merged entry numbers
+   Long64_t        fBegin;    // First element of the part(s)
+   Long64_t        fMiddle;   // First element of the second part (merge only)
+   Long64_t        fEnd;      // End of the part(s)
+
+   TIndexSortTask() : fValues(0), fIn(0), fOut(0), fBegin(0), fMiddle(-1), fEnd(0) {}
+
+   bool runTask(Int_t /* slot */) {
+      TIndexValueCompare compare(fValues);
+      if (fMiddle < 0) {
+         std::sort(fIn + fBegin, fIn + fEnd, compare);
+      } else {
+         std::merge(fIn + fBegin, fIn + fMiddle, fIn + fMiddle, fIn + fEnd, fOut + fBegin, compare);
+      }
+      return true;
+   }
+};
+
+//______________________________________________________________________________
+template <class Task>
+void R__RunIndexTasks(std::vector<Task> &tasks, Int_t nthreads)
+{
+   // Run the tasks with at most nthreads threads.
+
+   if (tasks.empty()) return;
+   if ((size_t)nthreads > tasks.size()) nthreads = tasks.size();
+   TThread::Initialize();
+   TThreadPool<Task, Int_t> pool(nthreads);
+   for (size_t i = 0; i < tasks.size(); ++i) {
+      pool.PushTask(tasks[i], i);
+   }
+   pool.Stop(kTRUE);
+}
+
+//______________________________________________________________________________
+void R__SortIndex(Long64_t n, const Long64_t *w, Long64_t *index, Int_t nthreads)
+{
+   // Set in index the entries 0 to n-1 sorted by index value w. The entries
+   // are cut in nthreads parts sorted concurrently, which are then merged
+   // two by two, concurrently too.
+
+   std::vector<Long64_t> bounds;
+   for (Int_t k = 0; k <= nthreads; ++k) bounds.push_back(n*k/nthreads);
+   for (Long64_t i = 0; i < n; ++i) index[i] = i;
+
+   std::vector<TIndexSortTask> sorts(nthreads);
+   for (Int_t k = 0; k < nthreads; ++k) {
+      sorts[k].fValues = w;
+      sorts[k].fIn     = index;
+      sorts[k].fBegin  = bounds[k];
+      sorts[k].fEnd    = bounds[k+1];
+   }
+   R__RunIndexTasks(sorts, nthreads);
+
+   Long64_t *buffer = new Long64_t[n];
+   Long64_t *in = index, *out = buffer;
+   while (bounds.size() > 2) {
+      size_t nparts = bounds.size() - 1;
+      std::vector<TIndexSortTask> merges;
+      std::vector<Long64_t> merged;
+      for (size_t k = 0; k < nparts; k += 2) {
+         TIndexSortTask merge;
+         merge.fValues = w;
+         merge.fIn     = in;
+         merge.fOut    = out;
+         merge.fBegin  = bounds[k];
+         merge.fMiddle = bounds[k+1];
+         merge.fEnd    = k+1 < nparts ? bounds[k+2] : bounds[k+1];
+         merges.push_back(merge);
+         merged.push_back(bounds[k]);
+      }
+      merged.push_back(n);
+      R__RunIndexTasks(merges, merges.size());
+      std::swap(in, out);
+      bounds.swap(merged);
+   }
+   if (in != index) std::copy(in, in + n, index);
+   delete [] buffer;
+}
+
+//______________________________________________________________________________
+Bool_t R__EvalIndexValuesParallel(TTree *tree, const TString &majorname, const TString &minorname,
+                                  Long64_t *w, Int_t nthreads)
+{
+   // Fill w with the index values of all the entries of tree with nthreads
+   // threads, each one opening its own copy of the file of the tree and
+   // evaluating the index expressions for a share of the clusters of the
+   // tree. Return kFALSE, without side effects, if the tree cannot be read
+   // this way (a TChain, a tree with friends, or a tree not read from a
+   // file).
+
+   if (tree->InheritsFrom(TChain::Class())) return kFALSE;
+   if (tree->GetListOfFriends() && tree->GetListOfFriends()->GetSize()) return kFALSE;
+   TFile *curfile = tree->GetCurrentFile();
+   if (!curfile || curfile->IsWritable()) return kFALSE;
+
+   Long64_t nentries = tree->GetEntries();
+   std::vector<Long64_t> first, last;
+   TTree::TClusterIterator clusterIter = tree->GetClusterIterator(0);
+   Long64_t start;
+   while ((start = clusterIter()) < nentries) {
+      Long64_t end = clusterIter.GetNextEntry();
+      if (end <= start) break;
+      if (end > nentries) end = nentries;
+      first.push_back(start);
+      last.push_back(end);
+   }
+   if (first.size() < 2) return kFALSE;
+   if ((size_t)nthreads > first.size()) nthreads = first.size();
+
+   // Path of the tree in its file.
+   TString treename = tree->GetName();
+   TDirectory *dir = tree->GetDirectory();
+   if (dir && dir != curfile) {
+      TString path = dir->GetPath();
+      Ssiz_t pos = path.Index(":/");
+      if (pos != kNPOS && pos + 2 < path.Length()) {
+         treename.Prepend(TString(path(pos + 2, path.Length())) + "/");
+      }
+   }
+
+   // Set up the per-thread trees and formulas; thread i evaluates the
+   // clusters i, i+nthreads, ...
+   std::vector<TIndexBuildTask> tasks(nthreads);
+   Bool_t ok = kTRUE;
+   for (Int_t i = 0; i < nthreads && ok; ++i) {
+      TIndexBuildTask &task = tasks[i];
+      {
+         TDirectory::TContext ctxt(0);
+         task.fFile = TFile::Open(curfile->GetName(), "READ");
+      }
+      if (task.fFile && !task.fFile->IsZombie()) task.fFile->GetObject(treename, task.fTree);
+      if (!task.fTree) {
+         ok = kFALSE;
+         break;
+      }
+      TList *aliases = tree->GetListOfAliases();
+      if (aliases) {
+         TIter nextAlias(aliases);
+         while (TObject *alias = nextAlias()) {
+            task.fTree->SetAlias(alias->GetName(), alias->GetTitle());
+         }
+      }
+      if (tree->GetCacheSize() > 0) task.fTree->SetCacheSize(tree->GetCacheSize());
+      task.fMajor = new TTreeFormula("Major", majorname.Data(), task.fTree);
+      task.fMinor = new TTreeFormula("Minor", minorname.Data(), task.fTree);
+      task.fMajor->SetQuickLoad(kTRUE);
+      task.fMinor->SetQuickLoad(kTRUE);
+      if (task.fMajor->GetNdim() != 1 || task.fMinor->GetNdim() != 1) {
+         ok = kFALSE;
+         break;
+      }
+      task.fValues = w;
+      for (size_t c = i; c < first.size(); c += nthreads) {
+         task.fFirst.push_back(first[c]);
+         task.fLast.push_back(last[c]);
+      }
+   }
+
+   if (ok) R__RunIndexTasks(tasks, nthreads);
+
+   for (Int_t i = 0; i < nthreads; ++i) {
+      delete tasks[i].fMajor;
+      delete tasks[i].fMinor;
+      delete tasks[i].fFile;
+   }
+   return ok;
+}
+
+//______________________________________________________________________________
+void R__WriteVarint(std::vector<UChar_t> &bytes, ULong64_t value)
+{
+   // Append value to bytes, 7 bits per byte, the high bit of a byte
+   // telling whether more bytes follow.
+
+   while (value >= 0x80) {
+      bytes.push_back((UChar_t)(value | 0x80));
+      value >>= 7;
+   }
+   bytes.push_back((UChar_t)value);
+}
+
+//______________________________________________________________________________
+ULong64_t R__ReadVarint(const UChar_t *&p, const UChar_t *end)
+{
+   // Read a value written by R__WriteVarint and move p after it.
+
+   ULong64_t value = 0;
+   Int_t shift = 0;
+   while (p < end) {
+      UChar_t byte = *p++;
+      if (shift < 64) value |= (ULong64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) break;
+      shift += 7;
+   }
+   return value;
+}
+
+} // anonymous namespace
+
 //______________________________________________________________________________
 TTreeIndex::TTreeIndex(): TVirtualIndex()
 {
@@ -96,8 +401,18 @@ TTreeIndex::TTreeIndex(const TTree *T, const char *majorname, const char *minorn
    //
    // It is possible to play with different TreeIndex in the same Tree.
    // see comments in TTree::SetTreeIndex.
+   //
+   //    Building the index with several threads
+   //    ---------------------------------------
+   // When TTree::SetImplicitMT(nthreads) has been called, the expressions
+   // are evaluated with nthreads threads, each one reading a share of the
+   // clusters of the tree from its own copy of the file, and the entries
+   // are sorted in nthreads parts which are then merged, also concurrently.
+   // The expressions are evaluated by the calling thread for a TChain, a
+   // tree with friends or a tree in a file open for writing. Entries with
+   // the same index value are sorted by entry number.
 
-   fTree               = (TTree*)T;
+   fTree               = 0;
    fN                  = 0;
    fIndexValues        = 0;
    fIndex              = 0;
@@ -105,14 +420,46 @@ TTreeIndex::TTreeIndex(const TTree *T, const char *majorname, const char *minorn
    fMinorFormula       = 0;
    fMajorFormulaParent = 0;
    fMinorFormulaParent = 0;
+   if (!Init(T, majorname, minorname)) return;
+
+   Int_t nthreads = TTree::GetImplicitMT();
+   Long64_t *w = new Long64_t[fN];
+   Long64_t i;
+   if (nthreads <= 1 || !R__EvalIndexValuesParallel(fTree, fMajorName, fMinorName, w, nthreads)) {
+      Long64_t oldEntry = fTree->GetReadEntry();
+      R__EvalIndexValues(fTree, fMajorFormula, fMinorFormula, 0, fN, w);
+      fTree->LoadTree(oldEntry);
+   }
+   fIndex = new Long64_t[fN];
+   if (nthreads > 1 && fN > kMinEntriesPerSortThread*nthreads) {
+      R__SortIndex(fN, w, fIndex, nthreads);
+   } else {
+      R__SortIndexSerial(fN, w, fIndex);
+   }
+   fIndexValues = new Long64_t[fN];
+   for (i=0;i<fN;i++) {
+      fIndexValues[i] = w[fIndex[i]];
+   }
+
+   delete [] w;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeIndex::Init(const TTree *T, const char *majorname, const char *minorname)
+{
+   // Set the tree, the names and the formulas of the index, before building
+   // it. Returns kFALSE, making this index a zombie, if the index cannot be
+   // built.
+
+   fTree               = (TTree*)T;
    fMajorName          = majorname;
    fMinorName          = minorname;
-   if (!T) return;
+   if (!T) return kFALSE;
    fN = T->GetEntries();
    if (fN <= 0) {
       MakeZombie();
       Error("TreeIndex","Cannot build a TreeIndex with a Tree having no entries");
-      return;
+      return kFALSE;
    }
 
    GetMajorFormula();
@@ -120,12 +467,12 @@ TTreeIndex::TTreeIndex(const TTree *T, const char *majorname, const char *minorn
    if (!fMajorFormula || !fMinorFormula) {
       MakeZombie();
       Error("TreeIndex","Cannot build the index with major=%s, minor=%s",fMajorName.Data(), fMinorName.Data());
-      return;
+      return kFALSE;
    }
    if ((fMajorFormula->GetNdim() != 1) || (fMinorFormula->GetNdim() != 1)) {
       MakeZombie();
       Error("TreeIndex","Cannot build the index with major=%s, minor=%s",fMajorName.Data(), fMinorName.Data());
-      return;
+      return kFALSE;
    }
    // accessing array elements should be OK
    //if ((fMajorFormula->GetMultiplicity() != 0) || (fMinorFormula->GetMultiplicity() != 0)) {
@@ -133,35 +480,59 @@ TTreeIndex::TTreeIndex(const TTree *T, const char *majorname, const char *minorn
    //   Error("TreeIndex","Cannot build the index with major=%s, minor=%s that cannot be arrays",fMajorName.Data(), fMinorName.Data());
    //   return;
    //}
+   return kTRUE;
+}
 
-   Long64_t *w = new Long64_t[fN];
-   Long64_t i;
-   Long64_t oldEntry = fTree->GetReadEntry();
-   Int_t current = -1;
-   for (i=0;i<fN;i++) {
-      Long64_t centry = fTree->LoadTree(i);
-      if (centry < 0) break;
-      if (fTree->GetTreeNumber() != current) {
-         current = fTree->GetTreeNumber();
-         fMajorFormula->UpdateFormulaLeaves();
-         fMinorFormula->UpdateFormulaLeaves();
+//______________________________________________________________________________
+Int_t TTreeIndex::BuildIndices(Int_t n, TTree **trees, const char *majorname, const char *minorname,
+                               TTreeIndex **indices, Int_t nthreads)
+{
+   // Build the indices of the n trees with major and minor names (see the
+   // constructor) concurrently, one tree per thread with at most nthreads
+   // threads. Each tree must be read from its own file (e.g. the trees of
+   // a TChain opened separately), as each of them is read by one thread.
+   // The formulas are made by the calling thread.
+   //
+   // indices[i] is set to the index of trees[i], 0 if it cannot be built.
+   // The indices are not attached to the trees (see TTree::SetTreeIndex).
+   // Returns the number of indices built.
+
+   std::vector<TIndexBuildTask> tasks;
+   tasks.reserve(n);
+   for (Int_t i = 0; i < n; ++i) {
+      TTreeIndex *index = new TTreeIndex();
+      if (!index->Init(trees[i], majorname, minorname)) {
+         delete index;
+         indices[i] = 0;
+         continue;
       }
-      Double_t majord = fMajorFormula->EvalInstance();
-      Double_t minord = fMinorFormula->EvalInstance();
-      Long64_t majorv = (Long64_t)majord;
-      Long64_t minorv = (Long64_t)minord;
-      w[i]  = majorv<<31;
-      w[i] += minorv;
+      indices[i] = index;
+      index->fIndex = new Long64_t[index->fN];
+      index->fIndexValues = new Long64_t[index->fN];
+      TIndexBuildTask task;
+      task.fTree        = index->fTree;
+      task.fMajor       = index->fMajorFormula;
+      task.fMinor       = index->fMinorFormula;
+      task.fValues      = new Long64_t[index->fN];
+      task.fN           = index->fN;
+      task.fIndex       = index->fIndex;
+      task.fIndexValues = index->fIndexValues;
+      task.fFirst.push_back(0);
+      task.fLast.push_back(index->fN);
+      tasks.push_back(task);
    }
-   fIndex = new Long64_t[fN];
-   TMath::Sort(fN,w,fIndex,0);
-   fIndexValues = new Long64_t[fN];
-   for (i=0;i<fN;i++) {
-      fIndexValues[i] = w[fIndex[i]];
+   R__RunIndexTasks(tasks, nthreads);
+   for (size_t i = 0; i < tasks.size(); ++i) {
+      delete [] tasks[i].fValues;
    }
-
-   delete [] w;
-   fTree->LoadTree(oldEntry);
+   // The formulas are made again if needed, so that the trees can be
+   // deleted before the indices.
+   for (Int_t i = 0; i < n; ++i) {
+      if (!indices[i]) continue;
+      delete indices[i]->fMajorFormula; indices[i]->fMajorFormula = 0;
+      delete indices[i]->fMinorFormula; indices[i]->fMinorFormula = 0;
+   }
+   return tasks.size();
 }
 
 //______________________________________________________________________________
@@ -446,18 +817,50 @@ void TTreeIndex::Streamer(TBuffer &R__b)
    // Stream an object of class TTreeIndex.
    // Note that this Streamer should be changed to an automatic Streamer
    // once TStreamerInfo supports an index of type Long64_t
+   //
+   // If SetCompact() was called, the sorted index values are written as
+   // differences to the previous value and the entry numbers as (zigzag
+   // encoded) differences to the previous entry number, each with as few
+   // bytes as possible (7 bits per byte). For the usual run/event indices
+   // this is 2 to 3 bytes per entry instead of 16. The index is read back
+   // with a single pass on the bytes, without sorting.
+   // Since version 2 a flag telling if the index is compact is written
+   // before the arrays; versions of ROOT reading only version 1 report
+   // an error for such indices.
 
    UInt_t R__s, R__c;
    if (R__b.IsReading()) {
-      Version_t R__v = R__b.ReadVersion(&R__s, &R__c); if (R__v) { }
+      Version_t R__v = R__b.ReadVersion(&R__s, &R__c);
       TVirtualIndex::Streamer(R__b);
       fMajorName.Streamer(R__b);
       fMinorName.Streamer(R__b);
       R__b >> fN;
+      Bool_t compact = kFALSE;
+      if (R__v > 1) R__b >> compact;
+      SetBit(kCompactIndex, compact);
       fIndexValues = new Long64_t[fN];
-      R__b.ReadFastArray(fIndexValues,fN);
       fIndex      = new Long64_t[fN];
-      R__b.ReadFastArray(fIndex,fN);
+      if (compact) {
+         Int_t nbytes;
+         R__b >> nbytes;
+         UChar_t *bytes = new UChar_t[nbytes];
+         R__b.ReadFastArray(bytes, nbytes);
+         const UChar_t *p = bytes;
+         const UChar_t *end = bytes + nbytes;
+         // The differences wrap around: add them as unsigned numbers.
+         ULong64_t value = 0, entry = 0;
+         for (Long64_t i = 0; i < fN; i++) {
+            value += R__ReadVarint(p, end);
+            ULong64_t delta = R__ReadVarint(p, end);
+            entry += (delta >> 1) ^ (0 - (delta & 1));
+            fIndexValues[i] = (Long64_t)value;
+            fIndex[i] = (Long64_t)entry;
+         }
+         delete [] bytes;
+      } else {
+         R__b.ReadFastArray(fIndexValues,fN);
+         R__b.ReadFastArray(fIndex,fN);
+      }
       R__b.CheckByteCount(R__s, R__c, TTreeIndex::IsA());
    } else {
       R__c = R__b.WriteVersion(TTreeIndex::IsA(), kTRUE);
@@ -465,8 +868,29 @@ void TTreeIndex::Streamer(TBuffer &R__b)
       fMajorName.Streamer(R__b);
       fMinorName.Streamer(R__b);
       R__b << fN;
-      R__b.WriteFastArray(fIndexValues, fN);
-      R__b.WriteFastArray(fIndex, fN);
+      Bool_t compact = TestBit(kCompactIndex);
+      R__b << compact;
+      if (compact) {
+         std::vector<UChar_t> bytes;
+         bytes.reserve(3*fN);
+         // The values are sorted but the difference of two values of
+         // opposite signs may not fit in a Long64_t: compute the
+         // differences as unsigned numbers.
+         ULong64_t value = 0, entry = 0;
+         for (Long64_t i = 0; i < fN; i++) {
+            R__WriteVarint(bytes, (ULong64_t)fIndexValues[i] - value);
+            ULong64_t delta = (ULong64_t)fIndex[i] - entry;
+            R__WriteVarint(bytes, (delta << 1) ^ (ULong64_t)((Long64_t)delta >> 63));
+            value = (ULong64_t)fIndexValues[i];
+            entry = (ULong64_t)fIndex[i];
+         }
+         Int_t nbytes = bytes.size();
+         R__b << nbytes;
+         if (nbytes) R__b.WriteFastArray(&bytes[0], nbytes);
+      } else {
+         R__b.WriteFastArray(fIndexValues, fN);
+         R__b.WriteFastArray(fIndex, fN);
+      }
       R__b.SetByteCount(R__c, kTRUE);
    }
 }
@@ -72,11 +72,16 @@
 #include "TTreeProxyGenerator.h"
 #include "TTreeIndex.h"
 #include "TChainIndex.h"
+#include "TTreeZoneMap.h"
 #include "TRefProxy.h"
 #include "TRefArrayProxy.h"
 #include "TVirtualMonitoring.h"
 #include "TTreeCache.h"
 #include "TStyle.h"
+#include "TSelectorCint.h"
+#include "TThread.h"
+#include "TThreadPool.h"
+#include "TMutex.h"
 
 #include "HFitInterface.h"
 #include "Foption.h"
@@ -152,6 +157,20 @@ TVirtualIndex *TTreePlayer::BuildIndex(const TTree *T, const char *majorname, co
    return new TTreeIndex(T,majorname,minorname);
 }
 
+//______________________________________________________________________________
+TObject *TTreePlayer::BuildZoneMap(TTree *T, const char *columns)
+{
+   // Build the zone map of the tree (see TTree::BuildZoneMap), 0 in case
+   // of failure.
+
+   TTreeZoneMap *zones = new TTreeZoneMap(T, columns);
+   if (zones->IsZombie()) {
+      delete zones;
+      return 0;
+   }
+   return zones;
+}
+
 //______________________________________________________________________________
 TTree *TTreePlayer::CopyTree(const char *selection, Option_t *, Long64_t nentries,
                              Long64_t firstentry)
@@ -2135,6 +2154,18 @@ Long64_t TTreePlayer::Process(TSelector *selector,Option_t *option, Long64_t nen
    selector->SetOption(option);
 
    selector->Begin(fTree);       //<===call user initialization function
+
+   Int_t nthreads = TTree::GetImplicitMT();
+   if (nthreads > 1 && selector->GetAbort() != TSelector::kAbortProcess
+       && (selector->Version() != 0 || selector->GetStatus() != -1)
+       && ProcessParallel(selector, nthreads, nentries, firstentry)) {
+      selector->Terminate();     //<==call user termination function
+      fTree->SetNotify(0);
+      if (gMonitoringWriter)
+         gMonitoringWriter->SendProcessingStatus("DONE");
+      return selector->GetStatus();
+   }
+
    selector->SlaveBegin(fTree);  //<===call user initialization function
    if (selector->Version() >= 2)
       selector->Init(fTree);
@@ -2184,13 +2215,54 @@ Long64_t TTreePlayer::Process(TSelector *selector,Option_t *option, Long64_t nen
       fSelectorUpdate = selector;
       UpdateFormulaLeaves();
 
+      // The clusters where the selection of TTree::Draw cannot be true,
+      // according to the zone map of the tree, are skipped.
+      const char *selection = 0;
+      TSelectorDraw *draw = dynamic_cast<TSelectorDraw*>(selector);
+      if (draw && draw->GetSelect() && !fTree->GetEventList() && !fTree->GetEntryList()) {
+         selection = draw->GetSelect()->GetTitle();
+         if (!selection[0]) selection = 0;
+      }
+      TTree *zoneTree = 0;
+      TTreeZoneMap *zones = 0;
+
+      // The entry numbers of the entry list of a TTree are taken by batches.
+      TEntryList *enlist = fTree->InheritsFrom(TChain::Class()) ? 0 : fTree->GetEntryList();
+      const Int_t kBatch = 256;
+      Long64_t batch[kBatch];
+      Int_t nbatch = 0, ibatch = 0;
+
       for (entry=firstentry;entry<firstentry+nentries;entry++) {
-         entryNumber = fTree->GetEntryNumber(entry);
+         if (enlist) {
+            if (ibatch == nbatch) {
+               // GetEntryNumber positions the list on entry.
+               ibatch = nbatch = 0;
+               batch[0] = fTree->GetEntryNumber(entry);
+               if (batch[0] >= 0) nbatch = 1 + enlist->NextEntries(kBatch-1, batch+1);
+            }
+            entryNumber = ibatch < nbatch ? batch[ibatch++] : -1;
+         } else {
+            entryNumber = fTree->GetEntryNumber(entry);
+         }
          if (entryNumber < 0) break;
          if (timer && timer->ProcessEvents()) break;
          if (gROOT->IsInterrupted()) break;
          localEntry = fTree->LoadTree(entryNumber);
          if (localEntry < 0) break;
+         if (selection) {
+            if (fTree->GetTree() != zoneTree) {
+               zoneTree = fTree->GetTree();
+               zones = TTreeZoneMap::GetZoneMap(zoneTree);
+               if (zones && zones->SetSelection(selection) == 0) zones = 0;
+            }
+            if (zones) {
+               Long64_t next = zones->GetNextEntry(localEntry);
+               if (next > localEntry) {
+                  entry += next - localEntry - 1;
+                  continue;
+               }
+            }
+         }
          if(useCutFill) {
             if (selector->ProcessCut(localEntry))
                selector->ProcessFill(localEntry); //<==call user analysis function
@@ -2203,6 +2275,7 @@ Long64_t TTreePlayer::Process(TSelector *selector,Option_t *option, Long64_t nen
          if (selector->GetAbort() == TSelector::kAbortFile) {
             // Skip to the next file.
             entry += fTree->GetTree()->GetEntries() - localEntry;
+            ibatch = nbatch;
             // Reset the abort status.
             selector->ResetAbort();
          }
@@ -2230,6 +2303,284 @@ Long64_t TTreePlayer::Process(TSelector *selector,Option_t *option, Long64_t nen
    return selector->GetStatus();
 }
 
+namespace {
+
+//______________________________________________________________________________
+class TClusterQueue {
+   // List of the entry ranges (clusters) to be processed by the threads
+   // of TTreePlayer::ProcessParallel. Each thread picks the next cluster
+   // when it is done with the previous one, so that the load is balanced
+   // even when the processing time varies from cluster to cluster.
+
+private:
+   std::vector<Long64_t> fStart;   // First entry of each cluster
+   std::vector<Long64_t> fEnd;     // Last entry (excluded) of each cluster
+   size_t                fNext;    // Index of the next cluster to be processed
+   Bool_t                fAbort;   // True if the loop must be stopped
+   TMutex                fMutex;   // Protect fNext and fAbort
+
+public:
+   TClusterQueue() : fNext(0), fAbort(kFALSE) {}
+
+   void Abort() { TLockGuard lock(&fMutex); fAbort = kTRUE; }
+   void Add(Long64_t start, Long64_t end) { fStart.push_back(start); fEnd.push_back(end); }
+   Bool_t Next(Long64_t &start, Long64_t &end) {
+      TLockGuard lock(&fMutex);
+      if (fAbort || fNext >= fStart.size()) return kFALSE;
+      start = fStart[fNext];
+      end   = fEnd[fNext];
+      ++fNext;
+      return kTRUE;
+   }
+   size_t Size() const { return fStart.size(); }
+};
+
+//______________________________________________________________________________
+class TTreeProcessorTask : public TThreadPoolTaskImp<TTreeProcessorTask, Int_t> {
+   // Event loop run in one thread of TTreePlayer::ProcessParallel on
+   // the thread's own copy of the file, the tree and the selector.
+
+public:
+   TFile         *fFile;      // File opened for this thread
+   TTree         *fTree;      // Tree read by this thread
+   TSelector     *fSelector;  // Selector instance of this thread
+   TClusterQueue *fQueue;     // Clusters shared by all threads
+   Bool_t         fBegun;     // True once SlaveBegin of fSelector was called
+   Bool_t         fFailed;    // True if the event loop could not read an entry
+
+   TTreeProcessorTask() : fFile(0), fTree(0), fSelector(0), fQueue(0), fBegun(kFALSE), fFailed(kFALSE) {}
+
+   bool runTask(Int_t /* slot */) {
+      Bool_t useCutFill = fSelector->Version() == 0;
+      Long64_t first, last;
+      while (fQueue->Next(first, last)) {
+         fTree->SetCacheEntryRange(first, last);
+         for (Long64_t entry = first; entry < last; ++entry) {
+            if (gROOT->IsInterrupted()) {
+               fQueue->Abort();
+               return true;
+            }
+            Long64_t localEntry = fTree->LoadTree(entry);
+            if (localEntry < 0) {
+               fFailed = kTRUE;
+               fQueue->Abort();
+               return false;
+            }
+            if (useCutFill) {
+               if (fSelector->ProcessCut(localEntry))
+                  fSelector->ProcessFill(localEntry); //<==call user analysis function
+            } else {
+               fSelector->Process(localEntry);        //<==call user analysis function
+            }
+            if (fSelector->GetAbort() != TSelector::kContinue) {
+               // There is a single file, aborting the file stops the loop.
+               fQueue->Abort();
+               return true;
+            }
+         }
+      }
+      return true;
+   }
+};
+
+//______________________________________________________________________________
+void R__MergeSelectorOutput(TList *output, TList *workerOutput)
+{
+   // Move the objects of the output list of a thread into output, merging
+   // them with the objects of the same name already present (via the
+   // Merge function of their class).
+
+   TList objs;
+   objs.AddAll(workerOutput);
+   TIter next(&objs);
+   while (TObject *obj = next()) {
+      TObject *target = output->FindObject(obj->GetName());
+      if (!target) {
+         workerOutput->Remove(obj);
+         output->Add(obj);
+      } else if (target->IsA()->GetMerge()) {
+         TList inputs;
+         inputs.Add(obj);
+         ROOT::MergeFunc_t func = target->IsA()->GetMerge();
+         if (func(target, &inputs, 0) < 0) {
+            ::Error("TTreePlayer::ProcessParallel", "calling Merge() on '%s'", target->GetName());
+         }
+      } else {
+         ::Warning("TTreePlayer::ProcessParallel", "the output object '%s' of class %s cannot be merged, only the first copy is kept",
+                   obj->GetName(), obj->ClassName());
+      }
+   }
+}
+
+} // anonymous namespace
+
+//______________________________________________________________________________
+Bool_t TTreePlayer::ProcessParallel(TSelector *selector, Int_t nthreads, Long64_t nentries, Long64_t firstentry)
+{
+   // Process the entries [firstentry, firstentry+nentries) with nthreads
+   // threads (see TTree::SetImplicitMT). Called by Process after
+   // selector->Begin(); return kFALSE, without side effects, if the entries
+   // must be processed sequentially.
+   //
+   // The entry range is split along the cluster boundaries of the tree.
+   // Each thread opens its own copy of the file and the tree and runs the
+   // event loop on its own selector, picking clusters from a shared queue
+   // until all of them are processed. The per-thread selectors are set up
+   // and terminated in the calling thread and their output is then merged
+   // into the output of selector. If a thread fails to read an entry or
+   // its selector aborts the processing, selector is aborted as well.
+   // If the threads cannot be set up, the selectors already begun are
+   // terminated and kFALSE is returned.
+
+   if (fTree->InheritsFrom(TChain::Class())) return kFALSE;
+   if (fTree->GetEventList() || fTree->GetEntryList()) return kFALSE;
+   if (fTree->GetListOfFriends() && fTree->GetListOfFriends()->GetSize()) return kFALSE;
+   TFile *curfile = fTree->GetCurrentFile();
+   if (!curfile || curfile->IsWritable()) return kFALSE;
+
+   TSelectorDraw *draw = dynamic_cast<TSelectorDraw*>(selector);
+   if (draw) {
+      if (!draw->IsParallelizable()) return kFALSE;
+   } else {
+      TClass *cl = selector->IsA();
+      if (cl->InheritsFrom(TSelectorCint::Class()) || !cl->IsLoaded() || !cl->HasDefaultConstructor())
+         return kFALSE;
+   }
+
+   nentries = GetEntriesToProcess(firstentry, nentries);
+   Long64_t lastentry = firstentry + nentries;
+
+   // The clusters which cannot pass the selection of TTree::Draw are not
+   // queued (see TTreeZoneMap).
+   TTreeZoneMap *zones = 0;
+   if (draw && draw->GetSelect() && draw->GetSelect()->GetTitle()[0]) {
+      zones = TTreeZoneMap::GetZoneMap(fTree);
+      if (zones && zones->SetSelection(draw->GetSelect()->GetTitle()) == 0) zones = 0;
+   }
+
+   TClusterQueue queue;
+   TTree::TClusterIterator clusterIter = fTree->GetClusterIterator(firstentry);
+   Long64_t start;
+   while ((start = clusterIter()) < lastentry) {
+      Long64_t end = clusterIter.GetNextEntry();
+      if (end <= start) break;
+      if (start < firstentry) start = firstentry;
+      if (end > lastentry) end = lastentry;
+      if (zones && !zones->MayPass(start, end)) continue;
+      queue.Add(start, end);
+   }
+   if (queue.Size() < 2) return kFALSE;
+   if ((size_t)nthreads > queue.Size()) nthreads = queue.Size();
+
+   // Path of the tree in its file.
+   TString treename = fTree->GetName();
+   TDirectory *dir = fTree->GetDirectory();
+   if (dir && dir != curfile) {
+      TString path = dir->GetPath();
+      Ssiz_t pos = path.Index(":/");
+      if (pos != kNPOS && pos + 2 < path.Length()) {
+         treename.Prepend(TString(path(pos + 2, path.Length())) + "/");
+      }
+   }
+
+   TThread::Initialize();
+
+   // Set up the per-thread trees and selectors.
+   std::vector<TTreeProcessorTask> tasks(nthreads);
+   Bool_t ok = kTRUE;
+   for (Int_t i = 0; i < nthreads && ok; ++i) {
+      TTreeProcessorTask &task = tasks[i];
+      task.fQueue = &queue;
+      {
+         TDirectory::TContext ctxt(0);
+         task.fFile = TFile::Open(curfile->GetName(), "READ");
+      }
+      if (task.fFile && !task.fFile->IsZombie()) task.fFile->GetObject(treename, task.fTree);
+      if (!task.fTree) {
+         ok = kFALSE;
+         break;
+      }
+      TTree *tree = task.fTree;
+      tree->SetWeight(fTree->GetWeight());
+      tree->SetEstimate(fTree->GetEstimate());
+      TList *aliases = fTree->GetListOfAliases();
+      if (aliases) {
+         TIter nextAlias(aliases);
+         while (TObject *alias = nextAlias()) {
+            tree->SetAlias(alias->GetName(), alias->GetTitle());
+         }
+      }
+      if (fTree->GetCacheSize() > 0) tree->SetCacheSize(fTree->GetCacheSize());
+
+      if (draw) {
+         TSelectorDraw *worker = new TSelectorDraw();
+         task.fSelector = worker;
+         tree->SetNotify(worker);
+         ok = worker->BeginWorker(draw, tree);
+         if (ok) worker->Notify();
+      } else {
+         TSelector *worker = (TSelector*)selector->IsA()->New();
+         task.fSelector = worker;
+         if (!worker) {
+            ok = kFALSE;
+            break;
+         }
+         worker->SetInputList(selector->GetInputList());
+         worker->SetOption(selector->GetOption());
+         tree->SetNotify(worker);
+         worker->SlaveBegin(tree);  //<===call user initialization function
+         task.fBegun = kTRUE;
+         if (worker->Version() >= 2)
+            worker->Init(tree);
+         worker->Notify();
+         ok = worker->GetAbort() != TSelector::kAbortProcess
+              && (worker->Version() != 0 || worker->GetStatus() != -1);
+      }
+   }
+
+   if (ok) {
+      if (gMonitoringWriter)
+         gMonitoringWriter->SendProcessingStatus("STARTED",kTRUE);
+
+      TThreadPool<TTreeProcessorTask, Int_t> pool(nthreads);
+      for (Int_t i = 0; i < nthreads; ++i) {
+         pool.PushTask(tasks[i], i);
+      }
+      pool.Stop(kTRUE);
+
+      // Collect the results.
+      Bool_t failed = kFALSE, aborted = kFALSE;
+      for (Int_t i = 0; i < nthreads; ++i) {
+         failed  |= tasks[i].fFailed;
+         aborted |= tasks[i].fSelector->GetAbort() == TSelector::kAbortProcess;
+         if (draw) {
+            draw->MergeWorker((TSelectorDraw*)tasks[i].fSelector);
+         } else {
+            tasks[i].fSelector->SlaveTerminate();   //<==call user termination function
+            R__MergeSelectorOutput(selector->GetOutputList(), tasks[i].fSelector->GetOutputList());
+         }
+      }
+      if (failed) {
+         selector->Abort(Form("cannot read all the entries of %s", fTree->GetName()));
+      } else if (aborted) {
+         selector->Abort("the processing was aborted by a thread");
+      }
+   } else {
+      for (Int_t i = 0; i < nthreads; ++i) {
+         if (tasks[i].fBegun) tasks[i].fSelector->SlaveTerminate();   //<==call user termination function
+      }
+      Warning("ProcessParallel", "could not set up the threads to process %s, processing it sequentially",
+              fTree->GetName());
+   }
+
+   for (Int_t i = 0; i < nthreads; ++i) {
+      if (tasks[i].fTree) tasks[i].fTree->SetNotify(0);
+      delete tasks[i].fSelector;
+      delete tasks[i].fFile;
+   }
+   return ok;
+}
+
 //______________________________________________________________________________
 void TTreePlayer::RecursiveRemove(TObject *obj)
 {
@@ -0,0 +1,511 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeZoneMap                                                         //
+//                                                                      //
+// A zone map keeps, for each cluster (zone) of a TTree and for a few   //
+// expressions chosen by the user, the minimum and the maximum of the   //
+// expression in the zone and the OR of its values converted to         //
+// integers (a bitmap of the bits set in the zone, e.g. for trigger     //
+// words). It is built with TTree::BuildZoneMap and stored in the user  //
+// info of the tree, so it is saved with the tree header.               //
+//                                                                      //
+//   tree->BuildZoneMap("run:lumi:trigger");                            //
+//   tree->Write("", TObject::kOverwrite);                              //
+//                                                                      //
+// TTree::Draw (and Project) uses the zone map of each tree it reads to //
+// skip the clusters where its selection cannot be true, without        //
+// reading nor decompressing their baskets. The selection terms used    //
+// are the ones combined with && at the top level of the selection and  //
+// having one of the forms                                              //
+//    expr OP number, number OP expr  (OP one of < <= > >= == !=)       //
+//    expr & mask, (expr & mask) != 0, expr                             //
+// where expr is one of the indexed expressions (blanks are ignored).   //
+// As in C, & binds less tightly than the comparisons: the parentheses  //
+// of (expr & mask) != 0 are required, expr & mask != 0 is not used.    //
+// The other terms are ignored, and a selection with a top level ||     //
+// does not skip anything. The same test is available for user loops   //
+// through SetSelection and GetNextEntry:                               //
+//                                                                      //
+//   TTreeZoneMap *zones = TTreeZoneMap::GetZoneMap(tree);              //
+//   zones->SetSelection("run==1234 && (trigger&0x4)");                 //
+//   for (Long64_t e = zones->GetNextEntry(0); e < n;                   //
+//        e = zones->GetNextEntry(e+1)) { ... }                         //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTreeZoneMap.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+#include "TObjArray.h"
+#include "TObjString.h"
+#include "TList.h"
+#include "TMath.h"
+
+#include <ctype.h>
+#include <limits>
+#include <stdlib.h>
+
+ClassImp(TTreeZoneMap)
+
+namespace {
+   enum EZoneOper { kLess, kLessEqual, kGreater, kGreaterEqual, kEqual, kNotEqual, kBitTest };
+
+   //______________________________________________________________________________
+   TString StripParentheses(const TString &expr)
+   {
+      // Return expr without blanks and without the parentheses enclosing
+      // all of it.
+
+      TString s(expr);
+      s.ReplaceAll(" ", "");
+      s.ReplaceAll("\t", "");
+      while (s.Length() >= 2 && s[0] == '(' && s[s.Length()-1] == ')') {
+         Int_t depth = 0;
+         for (Int_t i = 0; i < s.Length()-1; ++i) {
+            if (s[i] == '(') ++depth;
+            else if (s[i] == ')') --depth;
+            if (depth == 0) return s;
+         }
+         s = s(1, s.Length()-2);
+      }
+      return s;
+   }
+
+   //______________________________________________________________________________
+   Bool_t SplitConjunction(const TString &s, std::vector<TString> &terms)
+   {
+      // Split s at its top level &&. Return false if s has a top level ||
+      // or a conditional expression, or unbalanced parentheses.
+
+      Int_t depth = 0;
+      Int_t start = 0;
+      for (Int_t i = 0; i < s.Length(); ++i) {
+         char c = s[i];
+         if (c == '(' || c == '[') ++depth;
+         else if (c == ')' || c == ']') --depth;
+         if (depth < 0) return kFALSE;
+         if (depth > 0) continue;
+         if (c == '?' || (c == '|' && i+1 < s.Length() && s[i+1] == '|')) return kFALSE;
+         if (c == '&' && i+1 < s.Length() && s[i+1] == '&') {
+            terms.push_back(s(start, i-start));
+            start = i+2;
+            ++i;
+         }
+      }
+      if (depth != 0) return kFALSE;
+      terms.push_back(s(start, s.Length()-start));
+      return kTRUE;
+   }
+
+   //______________________________________________________________________________
+   Bool_t ParseNumber(const TString &s, Double_t &value)
+   {
+      // Return true if s is a finite decimal numerical constant, set in
+      // value. Words accepted by strtod (inf, nan, infinity) and hexadecimal
+      // constants are names or expressions for TTreeFormula, not numbers.
+
+      if (s.IsNull()) return kFALSE;
+      for (Int_t i = 0; i < s.Length(); ++i) {
+         char c = s[i];
+         if (!isdigit((unsigned char)c) && c != '.' && c != '+' && c != '-' && c != 'e' && c != 'E')
+            return kFALSE;
+      }
+      if (!isdigit((unsigned char)s[0]) && s[0] != '.' && s[0] != '+' && s[0] != '-') return kFALSE;
+      char *end = 0;
+      value = strtod(s.Data(), &end);
+      return end && *end == 0 && TMath::Finite(value);
+   }
+
+   //______________________________________________________________________________
+   Bool_t ParseMask(const TString &s, Long64_t &mask)
+   {
+      // Return true if s is an integer constant (decimal, octal or hexadecimal).
+
+      if (s.IsNull() || s[0] == '-') return kFALSE;
+      char *end = 0;
+      mask = (Long64_t)strtoull(s.Data(), &end, 0);
+      return end && *end == 0;
+   }
+
+   //______________________________________________________________________________
+   Int_t FindComparison(const TString &s, Int_t &oper, Int_t &length)
+   {
+      // Return the position of the only top level comparison operator of s,
+      // -1 if there is none, -2 if s cannot be used (shifts, several
+      // comparisons, a comparison with a top level & or |, which bind
+      // less tightly: a&4!=0 is a&(4!=0)).
+
+      Int_t depth = 0;
+      Int_t found = -1;
+      Bool_t bitOper = kFALSE;
+      for (Int_t i = 0; i < s.Length(); ++i) {
+         char c = s[i];
+         if (c == '(' || c == '[') { ++depth; continue; }
+         if (c == ')' || c == ']') { --depth; continue; }
+         if (depth > 0) continue;
+         char next = i+1 < s.Length() ? s[i+1] : 0;
+         if (c == '&' || c == '|') { bitOper = kTRUE; continue; }
+         Int_t op = -1, len = 1;
+         if (c == '<' || c == '>') {
+            if (next == c) return -2;
+            if (next == '=') len = 2;
+            op = c == '<' ? (len == 2 ? kLessEqual : kLess) : (len == 2 ? kGreaterEqual : kGreater);
+         } else if (c == '=' && next == '=') {
+            op = kEqual; len = 2;
+         } else if (c == '!' && next == '=') {
+            op = kNotEqual; len = 2;
+         }
+         if (op < 0) continue;
+         if (found >= 0) return -2;
+         found = i;
+         oper = op;
+         length = len;
+         i += len-1;
+      }
+      if (found >= 0 && bitOper) return -2;
+      return found;
+   }
+}
+
+//______________________________________________________________________________
+TTreeZoneMap::TTreeZoneMap() : TNamed(),
+   fEntries(0), fNzones(0), fNcolumns(0), fNvalues(0), fZoneFirst(0),
+   fColumns(0), fMin(0), fMax(0), fBits(0)
+{
+   // Default constructor for TTreeZoneMap.
+}
+
+//______________________________________________________________________________
+TTreeZoneMap::TTreeZoneMap(TTree *tree, const char *columns) : TNamed("TTreeZoneMap", columns),
+   fEntries(0), fNzones(0), fNcolumns(0), fNvalues(0), fZoneFirst(0),
+   fColumns(0), fMin(0), fMax(0), fBits(0)
+{
+   // Build the zone map of the expressions given in columns, separated by
+   // ':' as in TTree::Draw, for each cluster of tree. This reads the
+   // branches used by the expressions for all the entries of the tree.
+   // An expression may be an array: its minimum and maximum are then taken
+   // over all its elements. An expression not set in a zone (e.g. an empty
+   // array) or NaN, makes the zone pass any test on the expression.
+   // For a TChain, a zone map must be built for each of its trees.
+
+   if (!tree) return;
+   if (tree->GetTree() != tree) {
+      MakeZombie();
+      Error("TTreeZoneMap", "Cannot build a zone map for the chain %s, build one for each of its trees", tree->GetName());
+      return;
+   }
+   fEntries = tree->GetEntries();
+   if (fEntries <= 0) {
+      MakeZombie();
+      Error("TTreeZoneMap", "Cannot build a zone map for a tree having no entries");
+      return;
+   }
+
+   // The expressions, split at the ':' which are not part of a '::'.
+   fColumns = new TObjArray();
+   fColumns->SetOwner();
+   TString list(columns);
+   Int_t start = 0;
+   for (Int_t i = 0; i <= list.Length(); ++i) {
+      if (i < list.Length()) {
+         if (list[i] != ':') continue;
+         if (i+1 < list.Length() && list[i+1] == ':') { ++i; continue; }
+      }
+      TString column = TString(list(start, i-start)).Strip(TString::kBoth);
+      if (!column.IsNull()) fColumns->Add(new TObjString(column));
+      start = i+1;
+   }
+   fNcolumns = fColumns->GetEntriesFast();
+   if (fNcolumns == 0) {
+      MakeZombie();
+      Error("TTreeZoneMap", "No expression given for the zone map");
+      return;
+   }
+
+   std::vector<TTreeFormula*> formulas(fNcolumns);
+   Bool_t ok = kTRUE;
+   for (Int_t c = 0; c < fNcolumns; ++c) {
+      formulas[c] = new TTreeFormula("ZoneMap", GetColumn(c), tree);
+      if (formulas[c]->GetNdim() != 1 || formulas[c]->IsString()) {
+         Error("TTreeZoneMap", "Cannot build the zone map of the expression %s", GetColumn(c));
+         ok = kFALSE;
+      }
+   }
+   if (!ok) {
+      for (Int_t c = 0; c < fNcolumns; ++c) delete formulas[c];
+      MakeZombie();
+      return;
+   }
+
+   // The zones are the clusters of the tree.
+   std::vector<Long64_t> zones;
+   TTree::TClusterIterator clusterIter = tree->GetClusterIterator(0);
+   Long64_t first;
+   while ((first = clusterIter()) < fEntries) {
+      zones.push_back(first);
+      if (clusterIter.GetNextEntry() <= first) break;
+   }
+   fNzones = zones.size();
+   fNvalues = fNzones*fNcolumns;
+   fZoneFirst = new Long64_t[fNzones];
+   for (Int_t z = 0; z < fNzones; ++z) fZoneFirst[z] = zones[z];
+
+   const Double_t inf = std::numeric_limits<Double_t>::infinity();
+   fMin  = new Double_t[fNvalues];
+   fMax  = new Double_t[fNvalues];
+   fBits = new Long64_t[fNvalues];
+   // Zones or expressions whose range, or bits, are not known.
+   std::vector<Bool_t> anyRange(fNvalues, kFALSE);
+   std::vector<Bool_t> anyBits(fNvalues, kFALSE);
+   for (Int_t k = 0; k < fNvalues; ++k) {
+      fMin[k] = inf;
+      fMax[k] = -inf;
+      fBits[k] = 0;
+   }
+
+   Long64_t oldEntry = tree->GetReadEntry();
+   Int_t zone = 0;
+   for (Long64_t entry = 0; entry < fEntries; ++entry) {
+      if (tree->LoadTree(entry) < 0) break;
+      while (zone+1 < fNzones && entry >= fZoneFirst[zone+1]) ++zone;
+      for (Int_t c = 0; c < fNcolumns; ++c) {
+         Int_t k = zone*fNcolumns + c;
+         TTreeFormula *formula = formulas[c];
+         Int_t ndata = formula->GetNdata();
+         for (Int_t i = 0; i < ndata; ++i) {
+            Double_t v = formula->EvalInstance(i);
+            if (TMath::IsNaN(v)) {
+               anyRange[k] = kTRUE;
+               anyBits[k] = kTRUE;
+               continue;
+            }
+            if (v < fMin[k]) fMin[k] = v;
+            if (v > fMax[k]) fMax[k] = v;
+            // TTreeFormula applies the bit operators to the values converted to Long64_t.
+            if (v == TMath::Floor(v) && TMath::Abs(v) < 9.2e18) fBits[k] |= (Long64_t)v;
+            else anyBits[k] = kTRUE;
+         }
+      }
+   }
+   if (oldEntry >= 0) tree->LoadTree(oldEntry);
+   for (Int_t c = 0; c < fNcolumns; ++c) delete formulas[c];
+
+   for (Int_t k = 0; k < fNvalues; ++k) {
+      if (anyRange[k] || fMin[k] > fMax[k]) {
+         fMin[k] = -inf;
+         fMax[k] = inf;
+         anyBits[k] = kTRUE;
+      }
+      if (anyBits[k]) fBits[k] = -1;
+   }
+}
+
+//______________________________________________________________________________
+TTreeZoneMap::~TTreeZoneMap()
+{
+   // Destructor.
+
+   delete [] fZoneFirst;
+   delete [] fMin;
+   delete [] fMax;
+   delete [] fBits;
+   delete fColumns;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeZoneMap::CanPass(Int_t zone) const
+{
+   // Return false if one of the terms of the selection (see SetSelection)
+   // is false for all the entries of the zone.
+
+   for (size_t t = 0; t < fSelColumn.size(); ++t) {
+      Int_t k = zone*fNcolumns + fSelColumn[t];
+      Double_t v = fSelValue[t];
+      switch (fSelOper[t]) {
+         case kLess:         if (fMin[k] >= v) return kFALSE; break;
+         case kLessEqual:    if (fMin[k] > v)  return kFALSE; break;
+         case kGreater:      if (fMax[k] <= v) return kFALSE; break;
+         case kGreaterEqual: if (fMax[k] < v)  return kFALSE; break;
+         case kEqual:        if (v < fMin[k] || v > fMax[k]) return kFALSE; break;
+         case kNotEqual:     if (fMin[k] == v && fMax[k] == v) return kFALSE; break;
+         case kBitTest:      if ((fBits[k] & fSelMask[t]) == 0) return kFALSE; break;
+      }
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Int_t TTreeZoneMap::FindZone(Long64_t entry) const
+{
+   // Return the zone containing entry, -1 if entry is not covered by the map.
+
+   if (entry < 0 || entry >= fEntries || fNzones == 0) return -1;
+   Long64_t zone = TMath::BinarySearch((Long64_t)fNzones, fZoneFirst, entry);
+   return zone < 0 ? -1 : (Int_t)zone;
+}
+
+//______________________________________________________________________________
+const char *TTreeZoneMap::GetColumn(Int_t i) const
+{
+   // Return the i-th indexed expression.
+
+   if (!fColumns || i < 0 || i >= fColumns->GetEntriesFast()) return "";
+   return fColumns->UncheckedAt(i)->GetName();
+}
+
+//______________________________________________________________________________
+Long64_t TTreeZoneMap::GetNextEntry(Long64_t entry) const
+{
+   // Return the first entry, starting at entry, of a zone where the
+   // selection given to SetSelection may be true. This is entry itself if
+   // its zone may pass, and GetEntries() if no zone after entry may pass.
+   // The entries not covered by the map (added to the tree after the map
+   // was built) are always returned.
+
+   if (fSelColumn.empty()) return entry;
+   Int_t zone = FindZone(entry);
+   if (zone < 0) return entry;
+   Int_t first = zone;
+   while (zone < fNzones && !CanPass(zone)) ++zone;
+   if (zone == first) return entry;
+   return GetZoneFirst(zone);
+}
+
+//______________________________________________________________________________
+TTreeZoneMap *TTreeZoneMap::GetZoneMap(TTree *tree)
+{
+   // Return the zone map stored in the user info of tree (the current tree
+   // for a TChain), 0 if there is none or if it does not match the tree.
+
+   if (!tree || !tree->GetTree()) return 0;
+   TTree *t = tree->GetTree();
+   TList *info = t->GetUserInfo();
+   TTreeZoneMap *zones = dynamic_cast<TTreeZoneMap*>(info->FindObject("TTreeZoneMap"));
+   if (!zones || zones->GetEntries() > t->GetEntries()) return 0;
+   return zones;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeZoneMap::MayPass(Long64_t first, Long64_t last) const
+{
+   // Return true if the selection given to SetSelection may be true for one
+   // of the entries in [first,last).
+
+   if (fSelColumn.empty() || last > fEntries) return kTRUE;
+   Int_t zone = FindZone(first);
+   if (zone < 0) return kTRUE;
+   for (; zone < fNzones && GetZoneFirst(zone) < last; ++zone) {
+      if (CanPass(zone)) return kTRUE;
+   }
+   return kFALSE;
+}
+
+//______________________________________________________________________________
+void TTreeZoneMap::Print(Option_t *option) const
+{
+   // Print the indexed expressions and their range over the whole tree.
+   // With option "all" the range and bits of each zone are printed.
+
+   TString opt = option;
+   opt.ToLower();
+   printf("Zone map of %d zones, %lld entries\n", fNzones, fEntries);
+   for (Int_t c = 0; c < fNcolumns; ++c) {
+      Double_t xmin = 0, xmax = 0;
+      for (Int_t z = 0; z < fNzones; ++z) {
+         if (z == 0 || fMin[z*fNcolumns+c] < xmin) xmin = fMin[z*fNcolumns+c];
+         if (z == 0 || fMax[z*fNcolumns+c] > xmax) xmax = fMax[z*fNcolumns+c];
+      }
+      printf("   %-20s: min=%g max=%g\n", GetColumn(c), xmin, xmax);
+   }
+   if (!opt.Contains("all")) return;
+   for (Int_t z = 0; z < fNzones; ++z) {
+      printf("Zone %d, entries %lld to %lld\n", z, fZoneFirst[z], GetZoneFirst(z+1)-1);
+      for (Int_t c = 0; c < fNcolumns; ++c) {
+         Int_t k = z*fNcolumns + c;
+         printf("   %-20s: min=%g max=%g bits=0x%llx\n", GetColumn(c), fMin[k], fMax[k], (ULong64_t)fBits[k]);
+      }
+   }
+}
+
+//______________________________________________________________________________
+Int_t TTreeZoneMap::SetSelection(const char *selection)
+{
+   // Extract from selection the terms which can be tested with the zone
+   // map (see the class description) and use them in GetNextEntry and
+   // MayPass. Return the number of terms used; if it is 0, all the zones
+   // pass.
+
+   fSelColumn.clear();
+   fSelOper.clear();
+   fSelValue.clear();
+   fSelMask.clear();
+   std::vector<TString> terms;
+   if (!selection || !SplitConjunction(StripParentheses(selection), terms)) return 0;
+
+   std::vector<TString> columns(fNcolumns);
+   for (Int_t c = 0; c < fNcolumns; ++c) columns[c] = StripParentheses(GetColumn(c));
+
+   for (size_t t = 0; t < terms.size(); ++t) {
+      TString term = StripParentheses(terms[t]);
+      // A single expression is true when it is not 0.
+      Int_t oper = kNotEqual, length = 0;
+      Double_t value = 0;
+      TString expr = term;
+      Int_t pos = FindComparison(term, oper, length);
+      if (pos == -2) continue;
+      if (pos >= 0) {
+         TString lhs = StripParentheses(term(0, pos));
+         TString rhs = StripParentheses(term(pos+length, term.Length()-pos-length));
+         if (ParseNumber(rhs, value)) {
+            expr = lhs;
+         } else if (ParseNumber(lhs, value)) {
+            expr = rhs;
+            switch (oper) {
+               case kLess:         oper = kGreater;      break;
+               case kLessEqual:    oper = kGreaterEqual; break;
+               case kGreater:      oper = kLess;         break;
+               case kGreaterEqual: oper = kLessEqual;    break;
+            }
+         } else {
+            continue;
+         }
+      }
+      Int_t column = -1;
+      for (Int_t c = 0; c < fNcolumns && column < 0; ++c) {
+         if (expr == columns[c]) column = c;
+      }
+      Long64_t mask = 0;
+      if (column < 0) {
+         // A bit test: 'expr & mask' alone or compared with != 0.
+         if (pos >= 0 && !(oper == kNotEqual && value == 0)) continue;
+         Int_t amp = expr.First('&');
+         if (amp <= 0 || expr.Index("&", amp+1) != kNPOS) continue;
+         TString left = StripParentheses(expr(0, amp));
+         TString right = StripParentheses(expr(amp+1, expr.Length()-amp-1));
+         TString bitexpr;
+         if (ParseMask(right, mask)) bitexpr = left;
+         else if (ParseMask(left, mask)) bitexpr = right;
+         else continue;
+         for (Int_t c = 0; c < fNcolumns && column < 0; ++c) {
+            if (bitexpr == columns[c]) column = c;
+         }
+         if (column < 0) continue;
+         oper = kBitTest;
+      }
+      fSelColumn.push_back(column);
+      fSelOper.push_back(oper);
+      fSelValue.push_back(value);
+      fSelMask.push_back(mask);
+   }
+   return fSelColumn.size();
+}